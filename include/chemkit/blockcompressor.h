@@ -0,0 +1 @@
+#include "../../src/io/blockcompressor.h"
@@ -0,0 +1 @@
+#include "../../src/io/decompressionsource.h"
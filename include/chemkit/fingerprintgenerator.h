@@ -0,0 +1 @@
+#include "../../src/io/fingerprintgenerator.h"
@@ -0,0 +1 @@
+#include "../../src/io/linetokenizer.h"
@@ -481,6 +481,43 @@ int xdropen(XDR *xdrs, const char *filename, const char *type) {
     return xdrid;
 }
 
+/*_________________________________________________________________________
+ |
+ | xdrmemopen - open xdr stream over a block of memory
+ |
+ | Like xdropen but the stream reads from (or writes to) the size bytes
+ | at addr rather than a file, so xdr3dfcoord can be used on data that
+ | has already been read into memory. Close the stream with xdrclose.
+ |
+*/
+
+int xdrmemopen(XDR *xdrs, char *addr, unsigned int size, const char *type) {
+    enum xdr_op lmode;
+    int xdrid;
+
+    if (xdrs == NULL) {
+	return 0;
+    }
+    xdrid = 1;
+    while (xdrid < MAXID && xdridptr[xdrid] != NULL) {
+	xdrid++;
+    }
+    if (xdrid == MAXID) {
+	return 0;
+    }
+    if (*type == 'w' || *type == 'W') {
+	lmode = XDR_ENCODE;
+	xdrmodes[xdrid] = 'w';
+    } else {
+	lmode = XDR_DECODE;
+	xdrmodes[xdrid] = 'r';
+    }
+    xdrfiles[xdrid] = NULL;
+    xdridptr[xdrid] = xdrs;
+    xdrmem_create(xdrs, addr, size, lmode);
+    return xdrid;
+}
+
 /*_________________________________________________________________________
  |
  | xdrclose - close a xdr file
@@ -502,7 +539,9 @@ int xdrclose(XDR *xdrs) {
 	if (xdridptr[xdrid] == xdrs) {
 	    
 	    xdr_destroy(xdrs);
-	    fclose(xdrfiles[xdrid]);
+	    if (xdrfiles[xdrid] != NULL) {
+		fclose(xdrfiles[xdrid]);
+	    }
 	    xdridptr[xdrid] = NULL;
 	    return 1;
 	}
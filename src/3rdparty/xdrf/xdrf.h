@@ -9,6 +9,7 @@ extern "C" {
 #endif
 
 int xdropen(XDR *xdrs, const char *filename, const char *type);
+int xdrmemopen(XDR *xdrs, char *addr, unsigned int size, const char *type);
 int xdrclose(XDR *xdrs) ;
 int xdr3dfcoord(XDR *xdrs, float *fp, int *size, float *precision) ;
 
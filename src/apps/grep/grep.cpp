@@ -133,9 +133,9 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    // read input file
-    chemkit::MoleculeFile inputFile(fileName);
-    if(!inputFile.read()){
+    // open input file
+    chemkit::MoleculeFile inputFile;
+    if(!inputFile.open(fileName)){
         std::cerr << "Error: failed to read input file: " << inputFile.errorString() << std::endl;
         return -1;
     }
@@ -158,27 +158,34 @@ int main(int argc, char *argv[])
     query.setMolecule(patternMolecule);
     query.setFlags(flags);
 
+    // create output file
     chemkit::MoleculeFile outputFile;
+    if(!namesOnly){
+        outputFile.setFormat(inputFile.formatName());
+        if(!outputFile.create(std::cout)){
+            std::cerr << "Error: failed to write output file: " << outputFile.errorString() << std::endl;
+            return -1;
+        }
+    }
 
-    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, inputFile.molecules()){
+    // search molecules one at a time
+    while(boost::shared_ptr<chemkit::Molecule> molecule = inputFile.readMolecule()){
         bool match = query.matches(molecule.get());
 
         if((match && !invertMatch) || (!match && invertMatch)){
-            outputFile.addMolecule(molecule);
+            if(namesOnly){
+                std::cout << molecule->name() << "\n";
+            }
+            else if(!outputFile.writeMolecule(molecule)){
+                std::cerr << "Error: failed to write output file: " << outputFile.errorString() << std::endl;
+                return -1;
+            }
         }
     }
 
-    if(namesOnly){
-        foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, outputFile.molecules()){
-            std::cout << molecule->name() << "\n";
-        }
-    }
-    else{
-        bool ok = outputFile.write(std::cout, inputFile.formatName());
-        if(!ok){
-            std::cerr << "Error: failed to write output file: " << outputFile.errorString() << std::endl;
-            return -1;
-        }
+    if(!namesOnly && !outputFile.close()){
+        std::cerr << "Error: failed to write output file: " << outputFile.errorString() << std::endl;
+        return -1;
     }
 
     return 0;
@@ -0,0 +1,386 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include <string>
+#include <vector>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <chemkit/chemkit.h>
+#include <chemkit/foreach.h>
+#include <chemkit/molecule.h>
+#include <chemkit/lineformat.h>
+#include <chemkit/fingerprint.h>
+#include <chemkit/moleculefile.h>
+#include <chemkit/fingerprintindex.h>
+#include <chemkit/fingerprintdatabase.h>
+#include <chemkit/fingerprintgenerator.h>
+
+namespace {
+
+// Records the time taken by each phase of the search.
+class PhaseTimer
+{
+public:
+    PhaseTimer()
+        : m_start(boost::posix_time::microsec_clock::universal_time())
+    {
+    }
+
+    void finish(const std::string &phase)
+    {
+        boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+        m_phases.push_back(std::make_pair(phase, (now - m_start).total_microseconds() / 1.0e6));
+        m_start = now;
+    }
+
+    void print(std::ostream &output) const
+    {
+        double total = 0;
+        for(size_t i = 0; i < m_phases.size(); i++){
+            output << std::left << std::setw(12) << m_phases[i].first << std::right
+                   << std::fixed << std::setprecision(3) << m_phases[i].second << " s\n";
+            total += m_phases[i].second;
+        }
+        output << std::left << std::setw(12) << "total" << std::right
+               << std::fixed << std::setprecision(3) << total << " s\n";
+    }
+
+private:
+    boost::posix_time::ptime m_start;
+    std::vector<std::pair<std::string, double> > m_phases;
+};
+
+// Adds the fingerprint for each molecule read from the input file to
+// the database along with its name.
+class DatabaseBuilder
+{
+public:
+    DatabaseBuilder(const std::string &fingerprint,
+                    chemkit::FingerprintDatabase *database)
+        : m_fingerprint(fingerprint),
+          m_database(database)
+    {
+    }
+
+    void operator()(const boost::shared_ptr<chemkit::Molecule> &molecule) const
+    {
+        m_database->addFingerprint(molecule->fingerprint(m_fingerprint), molecule->name());
+    }
+
+private:
+    std::string m_fingerprint;
+    chemkit::FingerprintDatabase *m_database;
+};
+
+// Returns a molecule read from the InChI or SMILES in formula.
+boost::shared_ptr<chemkit::Molecule> readFormula(const std::string &formula, std::string &errorString)
+{
+    std::string format;
+    if(boost::algorithm::starts_with(formula, "InChI=") || isdigit(formula[0])){
+        format = "inchi";
+    }
+    else{
+        format = "smiles";
+    }
+
+    boost::scoped_ptr<chemkit::LineFormat> lineFormat(chemkit::LineFormat::create(format));
+    if(!lineFormat){
+        errorString = "failed to create line format.";
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    boost::shared_ptr<chemkit::Molecule> molecule(lineFormat->read(formula));
+    if(!molecule){
+        errorString = lineFormat->errorString();
+    }
+
+    return molecule;
+}
+
+} // end anonymous namespace
+
+void printHelp(char *argv[], const boost::program_options::options_description &options)
+{
+    std::cout << "Usage: " << argv[0] << " [OPTIONS] QUERY DATABASE\n";
+    std::cout << "       " << argv[0] << " [OPTIONS] --query-file FILE DATABASE\n";
+    std::cout << "\n";
+    std::cout << "Search for the molecules in DATABASE most similar to QUERY.\n";
+    std::cout << "QUERY is a line representation (e.g. InChI or SMILES) of a\n";
+    std::cout << "molecule and DATABASE is a molecule file. Molecules are compared\n";
+    std::cout << "by the tanimoto coefficient of their fingerprints.\n";
+    std::cout << "\n";
+    std::cout << "Each match is written on its own line as the query, the position\n";
+    std::cout << "of the match in DATABASE starting at 1, its name and the tanimoto\n";
+    std::cout << "coefficient separated by tabs.\n";
+    std::cout << "\n";
+    std::cout << "The fingerprints and names for DATABASE can be saved with\n";
+    std::cout << "--save-index and used for later searches with --load-index in\n";
+    std::cout << "place of DATABASE. The index records the fingerprint it was\n";
+    std::cout << "built with and can only be searched with the same fingerprint.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << options << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    std::string formula;
+    std::string fileName;
+    std::string queryFileName;
+    std::string fingerprintName;
+    std::string loadIndexFileName;
+    std::string saveIndexFileName;
+    size_t count;
+    chemkit::Real threshold;
+    size_t threadCount;
+
+    boost::program_options::options_description options;
+    options.add_options()
+        ("formula",
+            boost::program_options::value<std::string>(&formula),
+            "Input formula to search for.")
+        ("file",
+            boost::program_options::value<std::string>(&fileName),
+            "Input file to search.")
+        ("fingerprint,f",
+            boost::program_options::value<std::string>(&fingerprintName)->default_value("fp2"),
+            "Fingerprint to compare molecules with.")
+        ("query-file,q",
+            boost::program_options::value<std::string>(&queryFileName),
+            "Search for each molecule in the file.")
+        ("count,k",
+            boost::program_options::value<size_t>(&count)->default_value(10),
+            "Number of matches to return for each query. If zero all matches are returned.")
+        ("threshold,t",
+            boost::program_options::value<chemkit::Real>(&threshold)->default_value(0),
+            "Minimum tanimoto coefficient for a match.")
+        ("load-index,l",
+            boost::program_options::value<std::string>(&loadIndexFileName),
+            "Read the database fingerprints from the index file.")
+        ("save-index,s",
+            boost::program_options::value<std::string>(&saveIndexFileName),
+            "Write the database fingerprints to the index file.")
+        ("threads,j",
+            boost::program_options::value<size_t>(&threadCount)->default_value(0),
+            "Number of threads used to calculate fingerprints. If zero the number of processors is used.")
+        ("timings",
+            "Write the time taken by each phase to standard error.")
+        ("help,h",
+            "Shows this help message");
+
+    boost::program_options::positional_options_description positionalOptions;
+    positionalOptions.add("formula", 1).add("file", 1);
+
+    boost::program_options::variables_map variables;
+    boost::program_options::store(
+        boost::program_options::command_line_parser(argc, argv)
+            .options(options)
+            .positional(positionalOptions).run(),
+        variables);
+    boost::program_options::notify(variables);
+
+    // with a query file the only positional argument is the database
+    if(!queryFileName.empty() && fileName.empty()){
+        std::swap(formula, fileName);
+    }
+
+    if(variables.count("help")){
+        printHelp(argv, options);
+        return 0;
+    }
+    else if(formula.empty() && queryFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: no query given." << std::endl;
+        return -1;
+    }
+    else if(!formula.empty() && !queryFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: both a query and a query file given." << std::endl;
+        return -1;
+    }
+    else if(fileName.empty() && loadIndexFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: no input file given." << std::endl;
+        return -1;
+    }
+    else if(!fileName.empty() && !loadIndexFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: both an input file and an index file given." << std::endl;
+        return -1;
+    }
+
+    bool timings = variables.find("timings") != variables.end();
+    PhaseTimer timer;
+
+    // create fingerprint
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create(fingerprintName));
+    if(!fingerprint){
+        std::cerr << "Error: fingerprint '" << fingerprintName << "' is not supported." << std::endl;
+        return -1;
+    }
+
+    // read queries
+    std::vector<chemkit::Bitset> queries;
+    std::vector<std::string> queryNames;
+    if(!formula.empty()){
+        std::string errorString;
+        boost::shared_ptr<chemkit::Molecule> molecule = readFormula(formula, errorString);
+        if(!molecule){
+            std::cerr << "Error: failed to read query molecule: " << errorString << std::endl;
+            return -1;
+        }
+
+        queries.push_back(fingerprint->value(molecule.get()));
+        queryNames.push_back(formula);
+    }
+    else{
+        chemkit::MoleculeFile queryFile(queryFileName);
+        if(!queryFile.read()){
+            std::cerr << "Error: failed to read query file: " << queryFile.errorString() << std::endl;
+            return -1;
+        }
+
+        chemkit::FingerprintGenerator generator(fingerprintName);
+        if(threadCount){
+            generator.setThreadCount(threadCount);
+        }
+        if(!generator.generate(&queryFile)){
+            std::cerr << "Error: failed to calculate fingerprints: " << generator.errorString() << std::endl;
+            return -1;
+        }
+
+        foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, queryFile.molecules()){
+            queries.push_back(molecule->fingerprint(fingerprintName));
+
+            if(molecule->name().empty()){
+                queryNames.push_back(boost::lexical_cast<std::string>(queryNames.size() + 1));
+            }
+            else{
+                queryNames.push_back(molecule->name());
+            }
+        }
+    }
+
+    timer.finish("queries");
+
+    // load or build the database
+    chemkit::FingerprintDatabase database;
+
+    if(!loadIndexFileName.empty()){
+        if(!database.read(loadIndexFileName)){
+            std::cerr << "Error: failed to read index file '" << loadIndexFileName << "': "
+                      << database.errorString() << std::endl;
+            return -1;
+        }
+        else if(database.type() != fingerprintName ||
+                (!database.isEmpty() && database.fingerprintSize() != fingerprint->size())){
+            std::cerr << "Error: index file '" << loadIndexFileName << "' does not contain "
+                      << fingerprintName << " fingerprints." << std::endl;
+            return -1;
+        }
+
+        timer.finish("load");
+    }
+    else{
+        chemkit::MoleculeFile inputFile(fileName);
+
+        chemkit::FingerprintGenerator generator(fingerprintName);
+        if(threadCount){
+            generator.setThreadCount(threadCount);
+        }
+        if(!generator.generate(&inputFile, DatabaseBuilder(fingerprintName, &database))){
+            std::cerr << "Error: failed to calculate fingerprints: " << generator.errorString() << std::endl;
+            return -1;
+        }
+
+        database.setType(fingerprintName);
+
+        timer.finish("fingerprint");
+    }
+
+    if(!saveIndexFileName.empty()){
+        if(!database.write(saveIndexFileName)){
+            std::cerr << "Error: failed to write index file '" << saveIndexFileName << "': "
+                      << database.errorString() << std::endl;
+            return -1;
+        }
+
+        timer.finish("save");
+    }
+
+    // search the database for each query in parallel
+    const chemkit::FingerprintIndex *index = database.index();
+    std::vector<std::vector<chemkit::FingerprintIndex::Match> > results;
+    if(count == 0){
+        results = index->search(queries, threshold);
+    }
+    else{
+        results = index->nearest(queries, count, threshold);
+    }
+
+    timer.finish("search");
+
+    // write matches
+    std::cout << std::fixed << std::setprecision(4);
+    for(size_t i = 0; i < results.size(); i++){
+        foreach(const chemkit::FingerprintIndex::Match &match, results[i]){
+            std::cout << queryNames[i] << "\t"
+                      << match.first + 1 << "\t"
+                      << database.name(match.first) << "\t"
+                      << match.second << "\n";
+        }
+    }
+    std::cout.flush();
+
+    timer.finish("output");
+
+    if(timings){
+        std::cerr << "queries:     " << queries.size() << "\n";
+        std::cerr << "molecules:   " << database.size() << "\n";
+        timer.print(std::cerr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,425 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include <cctype>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <limits>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <chemkit/chemkit.h>
+#include <chemkit/element.h>
+#include <chemkit/unitcell.h>
+#include <chemkit/topology.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/topologyfile.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+
+typedef std::pair<size_t, size_t> IndexRange;
+
+void printHelp(char *argv[], const boost::program_options::options_description &options)
+{
+    std::cout << "Usage: " << argv[0] << " [OPTIONS] inputFile outputFile\n";
+    std::cout << "\n";
+    std::cout << "Copies the frames of a trajectory file to a new file, possibly\n";
+    std::cout << "with a different file format. Frames are read and written one\n";
+    std::cout << "at a time so the whole trajectory is never loaded into memory.\n";
+    std::cout << "\n";
+    std::cout << "Atoms can be selected by index (e.g. \"0-99,150,200-\"), residue\n";
+    std::cout << "name and element. Only atoms matching all of the given criteria\n";
+    std::cout << "are written. Residue names and elements require a topology,\n";
+    std::cout << "either from the input file or given with --topology.\n";
+    std::cout << "\n";
+    std::cout << "Options:\n";
+    std::cout << options << "\n";
+}
+
+// parses a comma separated list of zero-based, inclusive index
+// ranges (e.g. "0-99,150,200-") into ranges
+bool parseIndexRanges(const std::string &text, std::vector<IndexRange> &ranges)
+{
+    std::vector<std::string> tokens;
+    boost::split(tokens, text, boost::is_any_of(","));
+
+    try {
+        for(size_t i = 0; i < tokens.size(); i++){
+            std::string token = boost::trim_copy(tokens[i]);
+            size_t dash = token.find('-');
+
+            IndexRange range;
+            if(dash == std::string::npos){
+                range.first = boost::lexical_cast<size_t>(token);
+                range.second = range.first;
+            }
+            else{
+                std::string begin = token.substr(0, dash);
+                std::string end = token.substr(dash + 1);
+
+                range.first = begin.empty() ? 0 : boost::lexical_cast<size_t>(begin);
+                range.second = end.empty() ? std::numeric_limits<size_t>::max() : boost::lexical_cast<size_t>(end);
+            }
+
+            ranges.push_back(range);
+        }
+    }
+    catch(boost::bad_lexical_cast &){
+        return false;
+    }
+
+    return true;
+}
+
+// returns the element symbol for an atom type. two letter symbols
+// are only used when the second letter is lower case so that names
+// such as "CA" (alpha carbon) and "HW1" map to carbon and hydrogen.
+std::string elementSymbol(const std::string &type)
+{
+    size_t begin = type.find_first_not_of("0123456789");
+    if(begin == std::string::npos){
+        return std::string();
+    }
+
+    if(begin + 1 < type.size() && islower(type[begin + 1])){
+        std::string symbol = type.substr(begin, 2);
+        symbol[0] = toupper(symbol[0]);
+
+        if(chemkit::Element::isValidSymbol(symbol)){
+            return symbol;
+        }
+    }
+
+    return std::string(1, static_cast<char>(toupper(type[begin])));
+}
+
+int main(int argc, char *argv[])
+{
+    std::string inputFileName;
+    std::string inputFormatName;
+    std::string outputFileName;
+    std::string outputFormatName;
+    std::string topologyFileName;
+    std::string atomsString;
+    std::string residuesString;
+    std::string elementsString;
+    size_t stride = 1;
+    double beginTime = 0;
+    double endTime = 0;
+
+    boost::program_options::options_description options;
+    options.add_options()
+        ("input-file",
+            boost::program_options::value<std::string>(&inputFileName),
+            "The input file.")
+        ("output-file",
+            boost::program_options::value<std::string>(&outputFileName),
+            "The output file.")
+        ("input-format,i",
+            boost::program_options::value<std::string>(&inputFormatName),
+            "Sets the input format.")
+        ("output-format,o",
+            boost::program_options::value<std::string>(&outputFormatName),
+            "Sets the output format.")
+        ("topology,t",
+            boost::program_options::value<std::string>(&topologyFileName),
+            "Sets the topology file for the input trajectory.")
+        ("atoms,a",
+            boost::program_options::value<std::string>(&atomsString),
+            "Selects atoms by index range (e.g. \"0-99,150\").")
+        ("residues,r",
+            boost::program_options::value<std::string>(&residuesString),
+            "Selects atoms by residue name (e.g. \"ALA,GLY\").")
+        ("elements,e",
+            boost::program_options::value<std::string>(&elementsString),
+            "Selects atoms by element (e.g. \"C,N,O\").")
+        ("invert-selection,v",
+            "Writes the atoms not matching the selection.")
+        ("stride,s",
+            boost::program_options::value<size_t>(&stride),
+            "Writes every n-th frame.")
+        ("begin,b",
+            boost::program_options::value<double>(&beginTime),
+            "Skips frames before this time.")
+        ("end,E",
+            boost::program_options::value<double>(&endTime),
+            "Stops after the last frame at or before this time.")
+        ("help,h",
+            "Shows this help message");
+
+    boost::program_options::positional_options_description positionalOptions;
+    positionalOptions.add("input-file", 1).add("output-file", 1);
+
+    boost::program_options::variables_map variables;
+    try {
+        boost::program_options::store(
+            boost::program_options::command_line_parser(argc, argv)
+                .options(options)
+                .positional(positionalOptions).run(),
+            variables);
+        boost::program_options::notify(variables);
+    }
+    catch(boost::program_options::error &e){
+        printHelp(argv, options);
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    if(variables.count("help")){
+        printHelp(argv, options);
+        return 0;
+    }
+    else if(inputFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: No input file specified." << std::endl;
+        return -1;
+    }
+    else if(outputFileName.empty()){
+        printHelp(argv, options);
+        std::cerr << "Error: No output file specified." << std::endl;
+        return -1;
+    }
+    else if(stride == 0){
+        std::cerr << "Error: Stride must be greater than zero." << std::endl;
+        return -1;
+    }
+
+    bool invertSelection = variables.count("invert-selection") > 0;
+    bool hasBeginTime = variables.count("begin") > 0;
+    bool hasEndTime = variables.count("end") > 0;
+
+    // parse selection
+    std::vector<IndexRange> atomRanges;
+    if(!atomsString.empty() && !parseIndexRanges(atomsString, atomRanges)){
+        std::cerr << "Error: Invalid atom index ranges: " << atomsString << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> residueNames;
+    if(!residuesString.empty()){
+        boost::split(residueNames, residuesString, boost::is_any_of(","));
+    }
+
+    std::vector<std::string> elementSymbols;
+    if(!elementsString.empty()){
+        boost::split(elementSymbols, elementsString, boost::is_any_of(","));
+    }
+
+    // open input
+    chemkit::TrajectoryFile inputFile;
+    if(!inputFormatName.empty() && !inputFile.setFormat(inputFormatName)){
+        std::cerr << "Error: Input format '" << inputFormatName << "' is not supported." << std::endl;
+        return -1;
+    }
+
+    if(!topologyFileName.empty()){
+        chemkit::TopologyFile topologyFile(topologyFileName);
+        if(!topologyFile.read()){
+            std::cerr << "Error: Failed to read topology file: " << topologyFile.errorString() << std::endl;
+            return -1;
+        }
+
+        inputFile.setTopology(topologyFile.topology());
+    }
+
+    bool ok = false;
+    if(inputFileName == "-"){
+        ok = inputFile.open(std::cin);
+    }
+    else{
+        ok = inputFile.open(inputFileName);
+    }
+
+    if(!ok){
+        std::cerr << "Error: Failed to open input file: " << inputFile.errorString() << std::endl;
+        return -1;
+    }
+
+    // setup output
+    chemkit::TrajectoryFile outputFile;
+    if(!outputFormatName.empty() && !outputFile.setFormat(outputFormatName)){
+        std::cerr << "Error: Output format '" << outputFormatName << "' is not supported." << std::endl;
+        return -1;
+    }
+
+    chemkit::Trajectory inputTrajectory;
+    chemkit::TrajectoryFrame *inputFrame = inputTrajectory.addFrame();
+    chemkit::Trajectory outputTrajectory;
+    chemkit::TrajectoryFrame *outputFrame = outputTrajectory.addFrame();
+
+    std::vector<size_t> selection;
+    size_t atomCount = 0;
+    size_t frameIndex = 0;
+    bool created = false;
+
+    while(inputFile.readFrame(inputFrame)){
+        chemkit::Real time = inputFrame->time();
+
+        // time window, frames are assumed to be in time order
+        if(hasBeginTime && time < beginTime){
+            continue;
+        }
+        else if(hasEndTime && time > endTime){
+            break;
+        }
+
+        if(frameIndex++ % stride != 0){
+            continue;
+        }
+
+        // the selection is made once the size of the frames is known
+        if(!created){
+            boost::shared_ptr<chemkit::Topology> topology = inputFile.topology();
+            if((!residueNames.empty() || !elementSymbols.empty()) && !topology){
+                std::cerr << "Error: Selecting by residue or element requires a topology." << std::endl;
+                return -1;
+            }
+            else if(topology && topology->size() != inputFrame->size()){
+                std::cerr << "Error: Topology size does not match the trajectory." << std::endl;
+                return -1;
+            }
+
+            atomCount = inputFrame->size();
+
+            for(size_t i = 0; i < atomCount; i++){
+                bool selected = true;
+
+                if(!atomRanges.empty()){
+                    bool inRange = false;
+                    for(size_t j = 0; j < atomRanges.size() && !inRange; j++){
+                        inRange = i >= atomRanges[j].first && i <= atomRanges[j].second;
+                    }
+
+                    selected = inRange;
+                }
+
+                if(selected && !residueNames.empty()){
+                    selected = std::find(residueNames.begin(),
+                                         residueNames.end(),
+                                         topology->residueName(i)) != residueNames.end();
+                }
+
+                if(selected && !elementSymbols.empty()){
+                    selected = std::find(elementSymbols.begin(),
+                                         elementSymbols.end(),
+                                         elementSymbol(topology->type(i))) != elementSymbols.end();
+                }
+
+                if(selected != invertSelection){
+                    selection.push_back(i);
+                }
+            }
+
+            outputTrajectory.resize(selection.size());
+
+            // topology for the selected atoms
+            if(topology){
+                boost::shared_ptr<chemkit::Topology> outputTopology(new chemkit::Topology(selection.size()));
+                for(size_t i = 0; i < selection.size(); i++){
+                    outputTopology->setType(i, topology->type(selection[i]));
+                    outputTopology->setMass(i, topology->mass(selection[i]));
+                    outputTopology->setCharge(i, topology->charge(selection[i]));
+                    outputTopology->setResidueName(i, topology->residueName(selection[i]));
+                }
+
+                outputFile.setTopology(outputTopology);
+            }
+
+            if(outputFileName == "-"){
+                ok = outputFile.create(std::cout);
+            }
+            else{
+                ok = outputFile.create(outputFileName);
+            }
+
+            if(!ok){
+                std::cerr << "Error: Failed to create output file: " << outputFile.errorString() << std::endl;
+                return -1;
+            }
+
+            created = true;
+        }
+        else if(inputFrame->size() != atomCount){
+            std::cerr << "Error: The number of atoms changes between frames." << std::endl;
+            return -1;
+        }
+
+        // copy the selected atoms
+        for(size_t i = 0; i < selection.size(); i++){
+            outputFrame->setPosition(i, inputFrame->position(selection[i]));
+        }
+
+        outputFrame->setTime(time);
+
+        const chemkit::UnitCell *cell = inputFrame->unitCell();
+        if(cell){
+            outputFrame->setUnitCell(new chemkit::UnitCell(cell->x(), cell->y(), cell->z()));
+        }
+        else{
+            outputFrame->setUnitCell(0);
+        }
+
+        if(!outputFile.writeFrame(outputFrame)){
+            std::cerr << "Error: Failed to write frame: " << outputFile.errorString() << std::endl;
+            return -1;
+        }
+    }
+
+    if(!inputFile.errorString().empty()){
+        std::cerr << "Error: Failed to read input file: " << inputFile.errorString() << std::endl;
+        return -1;
+    }
+
+    // create an empty output file if no frames were selected
+    if(!created){
+        ok = outputFileName == "-" ? outputFile.create(std::cout) : outputFile.create(outputFileName);
+        if(!ok){
+            std::cerr << "Error: Failed to create output file: " << outputFile.errorString() << std::endl;
+            return -1;
+        }
+    }
+
+    if(!outputFile.close()){
+        std::cerr << "Error: Failed to write output file: " << outputFile.errorString() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
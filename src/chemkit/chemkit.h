@@ -88,6 +88,16 @@
     #define CHEMKIT_OVERRIDE
 #endif
 
+// Define a macro for specifying the alignment of a class. It should
+// be placed between the class keyword and the class's name.
+#if defined(__GNUC__) || defined(__clang__)
+    #define CHEMKIT_ALIGN(alignment) __attribute__((aligned(alignment)))
+#elif defined(_MSC_VER)
+    #define CHEMKIT_ALIGN(alignment) __declspec(align(alignment))
+#else
+    #define CHEMKIT_ALIGN(alignment)
+#endif
+
 namespace chemkit {
 
 /// Typedef for a real number.
@@ -38,11 +38,146 @@
 
 #include "chemkit.h"
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
 #include <boost/thread.hpp>
 
 namespace chemkit {
 namespace concurrent {
 
+namespace detail {
+
+// Shared state for the worker threads started by blockingFor(). Each
+// worker repeatedly claims the next block of indices until the whole
+// range has been handed out. The function is called with the index
+// and the number of the worker calling it.
+template<typename Function>
+class BlockingForTask
+{
+public:
+    BlockingForTask(size_t size, size_t blockSize, const Function &function)
+        : m_size(size),
+          m_blockSize(blockSize),
+          m_next(0),
+          m_function(function)
+    {
+    }
+
+    void run(size_t thread)
+    {
+        for(;;){
+            size_t begin;
+
+            {
+                boost::lock_guard<boost::mutex> lock(m_mutex);
+                begin = m_next;
+                m_next = std::min(m_size, m_next + m_blockSize);
+            }
+
+            if(begin >= m_size){
+                break;
+            }
+
+            size_t end = std::min(m_size, begin + m_blockSize);
+            for(size_t i = begin; i < end; i++){
+                m_function(i, thread);
+            }
+        }
+    }
+
+private:
+    size_t m_size;
+    size_t m_blockSize;
+    size_t m_next;
+    boost::mutex m_mutex;
+    const Function &m_function;
+};
+
+// Adapts a function taking only an index to be called by
+// BlockingForTask.
+template<typename Function>
+class IndexFunction
+{
+public:
+    IndexFunction(const Function &function)
+        : m_function(function)
+    {
+    }
+
+    void operator()(size_t index, size_t thread) const
+    {
+        CHEMKIT_UNUSED(thread);
+
+        m_function(index);
+    }
+
+private:
+    const Function &m_function;
+};
+
+} // end detail namespace
+
+/// Returns the number of threads that concurrent operations should
+/// use. This is equal to the number of hardware threads available
+/// or \c 1 if that cannot be determined.
+inline size_t idealThreadCount()
+{
+    size_t count = boost::thread::hardware_concurrency();
+
+    return count > 0 ? count : 1;
+}
+
+/// Calls \p function with each index in the range [0, \p size) and
+/// the number of the thread making the call, which is in the range
+/// [0, \p threadCount). Otherwise this is the same as blockingFor().
+///
+/// Calls with the same thread number are never made at the same
+/// time, so \p function can use the thread number to select objects
+/// that are not safe to share between threads.
+///
+/// \internal
+template<typename Function>
+inline void blockingForThreads(size_t size, const Function &function, size_t threadCount = idealThreadCount())
+{
+    threadCount = std::max(size_t(1), std::min(threadCount, size));
+
+    if(threadCount == 1){
+        for(size_t i = 0; i < size; i++){
+            function(i, 0);
+        }
+
+        return;
+    }
+
+    size_t blockSize = std::max(size_t(1), size / (threadCount * 8));
+    detail::BlockingForTask<Function> task(size, blockSize, function);
+
+    // the calling thread works as well as the extra threads
+    boost::thread_group threads;
+    for(size_t i = 1; i < threadCount; i++){
+        threads.create_thread(boost::bind(&detail::BlockingForTask<Function>::run, &task, i));
+    }
+
+    task.run(0);
+    threads.join_all();
+}
+
+/// Calls \p function with each index in the range [0, \p size) using
+/// up to \p threadCount threads and blocks until every call has
+/// returned. Indices are handed out to the threads in small blocks
+/// so uneven workloads are balanced between them.
+///
+/// The calls are made in an unspecified order and \p function must
+/// be safe to call from multiple threads at once.
+///
+/// \internal
+template<typename Function>
+inline void blockingFor(size_t size, const Function &function, size_t threadCount = idealThreadCount())
+{
+    blockingForThreads(size, detail::IndexFunction<Function>(function), threadCount);
+}
+
 /// Runs \p function asynchronously in a separate thread. Returns a
 /// future containing the value returned from \p function.
 ///
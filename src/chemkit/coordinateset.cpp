@@ -47,6 +47,11 @@ namespace chemkit {
 /// \class CoordinateSet coordinateset.h chemkit/coordinateset.h
 /// \ingroup chemkit
 /// \brief The CoordinateSet class contains a set of coordinates.
+///
+/// Coordinate sets can also be created with a function that loads
+/// cartesian coordinates on first access. This is used by file
+/// formats to avoid decoding every conformer of a large file when
+/// only a few of them are used. Loading is not thread-safe.
 
 // --- Construction and Destruction ---------------------------------------- //
 /// Create a new coordinate set with no coordinates.
@@ -77,12 +82,28 @@ CoordinateSet::CoordinateSet(DiagramCoordinates *coordinates)
     m_diagramCoordinates = coordinates;
 }
 
+/// Creates a new coordinate set with cartesian coordinates which
+/// are loaded by calling \p function the first time they are
+/// accessed. The function should return a new set of coordinates,
+/// or \c 0 if they cannot be loaded.
+CoordinateSet::CoordinateSet(const boost::function<CartesianCoordinates* ()> &function)
+{
+    m_type = Cartesian;
+    m_cartesianCordinates = 0;
+    m_loadFunction = function;
+}
+
 /// Creates a new coordinate set as a copy of \p other.
 CoordinateSet::CoordinateSet(const CoordinateSet &other)
 {
     m_type = None;
 
-    if(other.type() == Cartesian){
+    if(!other.isLoaded()){
+        m_type = Cartesian;
+        m_cartesianCordinates = 0;
+        m_loadFunction = other.m_loadFunction;
+    }
+    else if(other.type() == Cartesian){
         setCoordinates(new CartesianCoordinates(*other.cartesianCoordinates()));
     }
     else if(other.type() == Internal){
@@ -101,8 +122,13 @@ CoordinateSet::~CoordinateSet()
 
 // --- Properties ---------------------------------------------------------- //
 /// Returns the type of coordinates that the coordinate set contains.
+///
+/// For coordinate sets created with a load function this loads the
+/// coordinates and returns \c None if they could not be loaded.
 CoordinateSet::Type CoordinateSet::type() const
 {
+    load();
+
     return m_type;
 }
 
@@ -110,6 +136,8 @@ CoordinateSet::Type CoordinateSet::type() const
 /// set.
 size_t CoordinateSet::size() const
 {
+    load();
+
     switch(m_type){
         case Cartesian: return m_cartesianCordinates->size();
         case Internal: return m_internalCoordinates->size();
@@ -159,6 +187,8 @@ void CoordinateSet::setCoordinates(DiagramCoordinates *coordinates)
 /// cartesian coordinates.
 CartesianCoordinates* CoordinateSet::cartesianCoordinates() const
 {
+    load();
+
     if(m_type == Cartesian){
         return m_cartesianCordinates;
     }
@@ -190,9 +220,19 @@ DiagramCoordinates* CoordinateSet::diagramCoordinates() const
     return 0;
 }
 
+/// Returns \c true if the coordinates have been loaded. This is
+/// only \c false for coordinate sets created with a load function
+/// whose coordinates have not been accessed yet.
+bool CoordinateSet::isLoaded() const
+{
+    return m_loadFunction.empty();
+}
+
 /// Clears the coordinates stored in the coordinate set.
 void CoordinateSet::clear()
 {
+    m_loadFunction.clear();
+
     if(m_type == Cartesian){
         delete m_cartesianCordinates;
         m_cartesianCordinates = 0;
@@ -213,6 +253,8 @@ void CoordinateSet::clear()
 /// Returns the 3D cartesian position of the point at \p index.
 Point3 CoordinateSet::position(size_t index) const
 {
+    load();
+
     if(m_type == Cartesian){
         return m_cartesianCordinates->position(index);
     }
@@ -231,11 +273,38 @@ Point3 CoordinateSet::position(size_t index) const
     return Point3();
 }
 
+// --- Internal Methods ---------------------------------------------------- //
+// Calls the load function (if any) and stores the coordinates it
+// returns. The type is set to None if loading fails.
+void CoordinateSet::load() const
+{
+    if(m_loadFunction.empty()){
+        return;
+    }
+
+    CoordinateSet *self = const_cast<CoordinateSet *>(this);
+
+    boost::function<CartesianCoordinates* ()> function;
+    function.swap(self->m_loadFunction);
+
+    self->m_cartesianCordinates = function();
+    if(!m_cartesianCordinates){
+        self->m_type = None;
+    }
+}
+
 // --- Operators ----------------------------------------------------------- //
 CoordinateSet& CoordinateSet::operator=(const CoordinateSet &other)
 {
     if(this != &other){
-        if(other.type() == None){
+        if(!other.isLoaded()){
+            clear();
+
+            m_type = Cartesian;
+            m_cartesianCordinates = 0;
+            m_loadFunction = other.m_loadFunction;
+        }
+        else if(other.type() == None){
             clear();
         }
         else if(other.type() == Cartesian){
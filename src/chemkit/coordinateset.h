@@ -40,6 +40,8 @@
 
 #include "point3.h"
 
+#include <boost/function.hpp>
+
 namespace chemkit {
 
 class DiagramCoordinates;
@@ -62,6 +64,7 @@ public:
     explicit CoordinateSet(CartesianCoordinates *coordinates);
     explicit CoordinateSet(InternalCoordinates *coordinates);
     explicit CoordinateSet(DiagramCoordinates *coordinates);
+    explicit CoordinateSet(const boost::function<CartesianCoordinates* ()> &function);
     CoordinateSet(const CoordinateSet &other);
     ~CoordinateSet();
 
@@ -75,6 +78,7 @@ public:
     CartesianCoordinates* cartesianCoordinates() const;
     InternalCoordinates* internalCoordinates() const;
     DiagramCoordinates* diagramCoordinates() const;
+    bool isLoaded() const;
     void clear();
 
     // position
@@ -83,6 +87,9 @@ public:
     // operators
     CoordinateSet& operator=(const CoordinateSet &other);
 
+private:
+    void load() const;
+
 private:
     Type m_type;
     union {
@@ -90,6 +97,7 @@ private:
         InternalCoordinates *m_internalCoordinates;
         DiagramCoordinates *m_diagramCoordinates;
     };
+    boost::function<CartesianCoordinates* ()> m_loadFunction;
 };
 
 } // end chemkit namespace
@@ -37,6 +37,7 @@
 
 #include "molecule.h"
 #include "pluginmanager.h"
+#include "moleculeprivate.h"
 
 namespace chemkit {
 
@@ -74,8 +75,17 @@ namespace chemkit {
 /// Bitset fingerprint = uracil.fingerprint("fp2");
 /// \endcode
 ///
+/// Fingerprints which are folded from a larger set of hashed features
+/// can also return the number of times each bit was set with counts()
+/// and the unfolded features with features().
+///
 /// \see Bitset, Molecule::fingerprint()
 
+/// \typedef Fingerprint::FeatureCounts
+///
+/// Typedef for a list of feature identifiers and the number of times
+/// each occurs in a molecule, sorted by identifier.
+
 // --- Construction and Destruction ---------------------------------------- //
 /// Creates a new fingerprint with \p name.
 Fingerprint::Fingerprint(const std::string &name)
@@ -106,6 +116,33 @@ size_t Fingerprint::size() const
     return value(&molecule).size();
 }
 
+// --- Options ------------------------------------------------------------- //
+/// Sets an option for the fingerprint.
+void Fingerprint::setOption(const std::string &name, const Variant &value)
+{
+    m_options[name] = value;
+}
+
+/// Returns the value of an option for the fingerprint.
+Variant Fingerprint::option(const std::string &name) const
+{
+    VariantMap::const_iterator location = m_options.find(name);
+    if(location != m_options.end()){
+        return location->second;
+    }
+    else{
+        return defaultOption(name);
+    }
+}
+
+/// Returns the default value for the option with \p name.
+Variant Fingerprint::defaultOption(const std::string &name) const
+{
+    CHEMKIT_UNUSED(name);
+
+    return Variant();
+}
+
 // --- Fingerprint --------------------------------------------------------- //
 /// Returns the fingerprint value as a bitset.
 Bitset Fingerprint::value(const Molecule *molecule) const
@@ -115,6 +152,71 @@ Bitset Fingerprint::value(const Molecule *molecule) const
     return Bitset();
 }
 
+/// Returns the fingerprint value for \p molecule using the value
+/// cached in the molecule if there is one. Otherwise the value is
+/// calculated with value() and stored in the molecule. The cached
+/// value is discarded when an atom or bond in the molecule changes.
+///
+/// Only fingerprints using the default options are cached. If any
+/// option has been set this is equivalent to calling value().
+///
+/// This method may be called from multiple threads at once as long
+/// as each thread works on different molecules.
+///
+/// \see Molecule::fingerprint()
+Bitset Fingerprint::cachedValue(const Molecule *molecule) const
+{
+    if(!m_options.empty()){
+        return value(molecule);
+    }
+
+    std::map<std::string, Bitset> &cache = molecule->d->fingerprints;
+    std::map<std::string, Bitset>::const_iterator iter = cache.find(m_name);
+    if(iter != cache.end()){
+        return iter->second;
+    }
+
+    Bitset fingerprint = value(molecule);
+    cache[m_name] = fingerprint;
+
+    return fingerprint;
+}
+
+/// Returns the number of times each bit in the fingerprint is set
+/// for the molecule.
+///
+/// The default implementation returns \c 1 for each bit set in
+/// value() and \c 0 for all others.
+std::vector<size_t> Fingerprint::counts(const Molecule *molecule) const
+{
+    Bitset fingerprint = value(molecule);
+
+    std::vector<size_t> counts(fingerprint.size(), 0);
+    for(size_t i = fingerprint.find_first(); i != Bitset::npos; i = fingerprint.find_next(i)){
+        counts[i] = 1;
+    }
+
+    return counts;
+}
+
+/// Returns the features in the molecule along with the number of
+/// times each occurs. Unlike value() the features are not folded
+/// into the size of the fingerprint.
+///
+/// The default implementation returns the index of each bit set in
+/// value() with a count of \c 1.
+Fingerprint::FeatureCounts Fingerprint::features(const Molecule *molecule) const
+{
+    Bitset fingerprint = value(molecule);
+
+    FeatureCounts features;
+    for(size_t i = fingerprint.find_first(); i != Bitset::npos; i = fingerprint.find_next(i)){
+        features.push_back(std::make_pair(static_cast<boost::uint32_t>(i), size_t(1)));
+    }
+
+    return features;
+}
+
 // --- Similarity ---------------------------------------------------------- //
 /// Returns the tanimoto coefficent between \p a and \p b.
 Real Fingerprint::tanimotoCoefficient(const Bitset &a, const Bitset &b)
@@ -40,9 +40,14 @@
 
 #include <string>
 #include <vector>
+#include <utility>
+
+#include <boost/cstdint.hpp>
 
 #include "bitset.h"
 #include "plugin.h"
+#include "variant.h"
+#include "variantmap.h"
 
 namespace chemkit {
 
@@ -51,6 +56,9 @@ class Molecule;
 class CHEMKIT_EXPORT Fingerprint
 {
 public:
+    // typedefs
+    typedef std::vector<std::pair<boost::uint32_t, size_t> > FeatureCounts;
+
     // construction and destruction
     virtual ~Fingerprint();
 
@@ -58,8 +66,15 @@ public:
     std::string name() const;
     virtual size_t size() const;
 
+    // options
+    void setOption(const std::string &name, const Variant &value);
+    Variant option(const std::string &name) const;
+
     // fingerprint
     virtual Bitset value(const Molecule *molecule) const;
+    Bitset cachedValue(const Molecule *molecule) const;
+    virtual std::vector<size_t> counts(const Molecule *molecule) const;
+    virtual FeatureCounts features(const Molecule *molecule) const;
 
     // similarity
     static Real tanimotoCoefficient(const Bitset &a, const Bitset &b);
@@ -70,9 +85,11 @@ public:
 
 protected:
     Fingerprint(const std::string &name);
+    virtual Variant defaultOption(const std::string &name) const;
 
 private:
     std::string m_name;
+    VariantMap m_options;
 };
 
 } // end chemkit namespace
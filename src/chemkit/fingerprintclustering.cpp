@@ -0,0 +1,444 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintclustering.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+
+#include "foreach.h"
+#include "popcount.h"
+#include "concurrent.h"
+#include "fingerprintindex.h"
+
+namespace chemkit {
+
+namespace {
+
+// number of fingerprints scored by each task in a maxmin iteration
+const size_t MaxMinBlockSize = 4096;
+
+// similarity marking a fingerprint that has already been picked. this
+// is greater than any tanimoto coefficient.
+const Real PickedSimilarity = 2;
+
+// Finds the neighbors of each fingerprint.
+class NeighborFinder
+{
+public:
+    NeighborFinder(const FingerprintIndex *index,
+                   Real threshold,
+                   std::vector<std::vector<boost::uint32_t> > &neighbors)
+        : m_index(index),
+          m_threshold(threshold),
+          m_neighbors(neighbors)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        std::vector<FingerprintIndex::Match> matches = m_index->neighbors(i, m_threshold);
+
+        std::vector<boost::uint32_t> &neighbors = m_neighbors[i];
+        neighbors.reserve(matches.size());
+        for(size_t j = 0; j < matches.size(); j++){
+            neighbors.push_back(static_cast<boost::uint32_t>(matches[j].first));
+        }
+    }
+
+private:
+    const FingerprintIndex *m_index;
+    Real m_threshold;
+    std::vector<std::vector<boost::uint32_t> > &m_neighbors;
+};
+
+// Orders fingerprints by decreasing neighbor count and then by
+// increasing index.
+class NeighborCountCompare
+{
+public:
+    NeighborCountCompare(const std::vector<std::vector<boost::uint32_t> > &neighbors)
+        : m_neighbors(neighbors)
+    {
+    }
+
+    bool operator()(size_t a, size_t b) const
+    {
+        size_t countA = m_neighbors[a].size();
+        size_t countB = m_neighbors[b].size();
+
+        if(countA != countB){
+            return countA > countB;
+        }
+
+        return a < b;
+    }
+
+private:
+    const std::vector<std::vector<boost::uint32_t> > &m_neighbors;
+};
+
+void appendCluster(std::vector<FingerprintClustering::Cluster> &clusters,
+                   const FingerprintClustering::Cluster &cluster)
+{
+    clusters.push_back(cluster);
+}
+
+// The least similar fingerprint found in a block of a maxmin
+// iteration.
+struct MaxMinCandidate
+{
+    size_t index;
+    Real similarity;
+};
+
+// Returns true if candidate a is a better pick than b. Ties go to the
+// fingerprint with the lower index so that the picks do not depend
+// on the number of threads.
+bool isBetterCandidate(const MaxMinCandidate &a, const MaxMinCandidate &b)
+{
+    if(a.similarity != b.similarity){
+        return a.similarity < b.similarity;
+    }
+
+    return a.index < b.index;
+}
+
+// Updates the similarity of each fingerprint in a block to its most
+// similar pick after a new fingerprint has been picked and finds the
+// least similar fingerprint in the block.
+class MaxMinUpdater
+{
+public:
+    MaxMinUpdater(const FingerprintIndex *index,
+                  const std::vector<boost::uint32_t> &order,
+                  const std::vector<boost::uint32_t> &bitCounts,
+                  std::vector<Real> &similarities,
+                  std::vector<MaxMinCandidate> &candidates,
+                  size_t pick)
+        : m_index(index),
+          m_order(order),
+          m_bitCounts(bitCounts),
+          m_similarities(similarities),
+          m_candidates(candidates),
+          m_pick(pick)
+    {
+    }
+
+    void operator()(size_t block) const
+    {
+        size_t wordCount = (m_index->fingerprintSize() + 63) / 64;
+        const boost::uint64_t *pickWords = m_index->fingerprintWords(m_pick);
+        size_t pickCount = m_bitCounts[m_pick];
+
+        MaxMinCandidate best;
+        best.index = m_order.size();
+        best.similarity = PickedSimilarity;
+
+        size_t begin = block * MaxMinBlockSize;
+        size_t end = std::min(m_order.size(), begin + MaxMinBlockSize);
+
+        for(size_t i = begin; i < end; i++){
+            size_t index = m_order[i];
+            Real &similarity = m_similarities[index];
+            if(similarity == PickedSimilarity){
+                continue;
+            }
+
+            // the coefficient is at most min(a, b) / max(a, b) so it
+            // only needs to be calculated if that is larger than the
+            // current similarity
+            size_t count = m_bitCounts[index];
+            size_t maximum = std::max(count, pickCount);
+            Real bound = maximum ? Real(std::min(count, pickCount)) / Real(maximum) : Real(0);
+
+            if(similarity < bound){
+                Real coefficient = popcount::tanimotoCoefficient(pickWords,
+                                                                 m_index->fingerprintWords(index),
+                                                                 wordCount);
+                similarity = std::max(similarity, coefficient);
+            }
+
+            MaxMinCandidate candidate;
+            candidate.index = index;
+            candidate.similarity = similarity;
+
+            if(isBetterCandidate(candidate, best)){
+                best = candidate;
+            }
+        }
+
+        m_candidates[block] = best;
+    }
+
+private:
+    const FingerprintIndex *m_index;
+    const std::vector<boost::uint32_t> &m_order;
+    const std::vector<boost::uint32_t> &m_bitCounts;
+    std::vector<Real> &m_similarities;
+    std::vector<MaxMinCandidate> &m_candidates;
+    size_t m_pick;
+};
+
+} // end anonymous namespace
+
+// === FingerprintClusteringPrivate ======================================== //
+class FingerprintClusteringPrivate
+{
+public:
+    const FingerprintIndex *index;
+    size_t threadCount;
+};
+
+// === FingerprintClustering =============================================== //
+/// \class FingerprintClustering fingerprintclustering.h chemkit/fingerprintclustering.h
+/// \ingroup chemkit
+/// \brief The FingerprintClustering class clusters and picks
+///        diverse subsets of the fingerprints in an index.
+///
+/// Butina clustering with butina() groups each fingerprint with the
+/// fingerprints within a tanimoto coefficient threshold of a cluster
+/// centroid. Diverse subsets are picked with the MaxMin algorithm by
+/// maxMin().
+///
+/// Both algorithms run their similarity calculations in parallel and
+/// use the bit counts of the fingerprints to skip calculations whose
+/// result cannot matter. The fingerprints are identified by their
+/// index in the FingerprintIndex.
+///
+/// For example, to cluster a set of fingerprints:
+/// \code
+/// chemkit::FingerprintIndex index(1021);
+/// foreach(const chemkit::Bitset &fingerprint, fingerprints){
+///     index.addFingerprint(fingerprint);
+/// }
+///
+/// chemkit::FingerprintClustering clustering(&index);
+/// std::vector<chemkit::FingerprintClustering::Cluster> clusters =
+///     clustering.butina(0.7);
+/// \endcode
+///
+/// \see FingerprintIndex
+
+/// \typedef FingerprintClustering::Cluster
+///
+/// Typedef for a list of fingerprint indices in a cluster. The first
+/// index is the cluster centroid.
+
+/// \typedef FingerprintClustering::ClusterCallback
+///
+/// Typedef for a function called with each cluster as it is formed.
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new clustering object for the fingerprints in \p index.
+/// The index must not be modified while it is in use.
+FingerprintClustering::FingerprintClustering(const FingerprintIndex *index)
+    : d(new FingerprintClusteringPrivate)
+{
+    d->index = index;
+    d->threadCount = concurrent::idealThreadCount();
+}
+
+/// Destroys the clustering object.
+FingerprintClustering::~FingerprintClustering()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the fingerprint index being clustered.
+const FingerprintIndex* FingerprintClustering::index() const
+{
+    return d->index;
+}
+
+/// Sets the maximum number of threads used to \p count. The default
+/// is the number of hardware threads available.
+void FingerprintClustering::setThreadCount(size_t count)
+{
+    d->threadCount = std::max(size_t(1), count);
+}
+
+/// Returns the maximum number of threads used.
+size_t FingerprintClustering::threadCount() const
+{
+    return d->threadCount;
+}
+
+// --- Clustering ---------------------------------------------------------- //
+/// Clusters the fingerprints using the Butina algorithm and returns
+/// the clusters.
+///
+/// \see butina(Real threshold, const ClusterCallback &callback)
+std::vector<FingerprintClustering::Cluster> FingerprintClustering::butina(Real threshold) const
+{
+    std::vector<Cluster> clusters;
+    butina(threshold, boost::bind(appendCluster, boost::ref(clusters), _1));
+
+    return clusters;
+}
+
+/// Clusters the fingerprints using the Butina algorithm and calls
+/// \p callback with each cluster as it is formed.
+///
+/// The neighbors of each fingerprint, the other fingerprints with a
+/// tanimoto coefficient of at least \p threshold, are found first.
+/// Then, in order of decreasing neighbor count, each fingerprint not
+/// yet in a cluster becomes the centroid of a new cluster containing
+/// its neighbors which are not yet in a cluster. The members of each
+/// cluster follow the centroid from most to least similar. Every
+/// fingerprint is in exactly one cluster and fingerprints with no
+/// neighbors form singleton clusters.
+///
+/// The neighbor lists are kept in memory while clustering and use
+/// four bytes per neighbor.
+void FingerprintClustering::butina(Real threshold, const ClusterCallback &callback) const
+{
+    size_t size = d->index->size();
+    if(size == 0){
+        return;
+    }
+
+    std::vector<std::vector<boost::uint32_t> > neighbors(size);
+    concurrent::blockingFor(size, NeighborFinder(d->index, threshold, neighbors), d->threadCount);
+
+    std::vector<size_t> order(size);
+    for(size_t i = 0; i < size; i++){
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), NeighborCountCompare(neighbors));
+
+    std::vector<bool> clustered(size, false);
+    Cluster cluster;
+
+    foreach(size_t centroid, order){
+        if(clustered[centroid]){
+            continue;
+        }
+
+        cluster.clear();
+        cluster.push_back(centroid);
+        clustered[centroid] = true;
+
+        foreach(boost::uint32_t neighbor, neighbors[centroid]){
+            if(!clustered[neighbor]){
+                cluster.push_back(neighbor);
+                clustered[neighbor] = true;
+            }
+        }
+
+        // the neighbor list is no longer needed
+        std::vector<boost::uint32_t>().swap(neighbors[centroid]);
+
+        callback(cluster);
+    }
+}
+
+// --- Diversity Selection ------------------------------------------------- //
+/// Picks \p count diverse fingerprints using the MaxMin algorithm and
+/// returns their indices in the order they were picked.
+///
+/// The fingerprint at \p first is picked first. Each following pick
+/// is the fingerprint whose greatest tanimoto coefficient with any of
+/// the fingerprints already picked is the smallest. Ties are broken
+/// by picking the fingerprint with the lowest index.
+///
+/// If \p count is larger than the number of fingerprints every
+/// fingerprint is returned.
+std::vector<size_t> FingerprintClustering::maxMin(size_t count, size_t first) const
+{
+    std::vector<size_t> picks;
+
+    size_t size = d->index->size();
+    if(size == 0 || count == 0 || first >= size){
+        return picks;
+    }
+
+    count = std::min(count, size);
+    picks.reserve(count);
+
+    // group the fingerprints by bit count. the index stores them in
+    // the same order so the fingerprints are read in memory order.
+    size_t wordCount = (d->index->fingerprintSize() + 63) / 64;
+    std::vector<boost::uint32_t> bitCounts(size);
+    std::vector<size_t> offsets(d->index->fingerprintSize() + 2, 0);
+    for(size_t i = 0; i < size; i++){
+        bitCounts[i] = static_cast<boost::uint32_t>(popcount::count(d->index->fingerprintWords(i), wordCount));
+        offsets[bitCounts[i] + 1]++;
+    }
+    for(size_t i = 1; i < offsets.size(); i++){
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<boost::uint32_t> order(size);
+    for(size_t i = 0; i < size; i++){
+        order[offsets[bitCounts[i]]++] = static_cast<boost::uint32_t>(i);
+    }
+
+    // greatest similarity of each fingerprint to any pick so far
+    std::vector<Real> similarities(size, Real(-1));
+
+    size_t blockCount = (size + MaxMinBlockSize - 1) / MaxMinBlockSize;
+    std::vector<MaxMinCandidate> candidates(blockCount);
+
+    size_t pick = first;
+    for(;;){
+        picks.push_back(pick);
+        similarities[pick] = PickedSimilarity;
+
+        if(picks.size() == count){
+            break;
+        }
+
+        concurrent::blockingFor(blockCount,
+                                MaxMinUpdater(d->index, order, bitCounts, similarities, candidates, pick),
+                                d->threadCount);
+
+        MaxMinCandidate best = candidates[0];
+        for(size_t i = 1; i < blockCount; i++){
+            if(isBetterCandidate(candidates[i], best)){
+                best = candidates[i];
+            }
+        }
+
+        pick = best.index;
+    }
+
+    return picks;
+}
+
+} // end chemkit namespace
@@ -0,0 +1,82 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FINGERPRINTCLUSTERING_H
+#define CHEMKIT_FINGERPRINTCLUSTERING_H
+
+#include "chemkit.h"
+
+#include <vector>
+
+#include <boost/function.hpp>
+
+namespace chemkit {
+
+class FingerprintIndex;
+class FingerprintClusteringPrivate;
+
+class CHEMKIT_EXPORT FingerprintClustering
+{
+public:
+    // typedefs
+    typedef std::vector<size_t> Cluster;
+    typedef boost::function<void (const Cluster &)> ClusterCallback;
+
+    // construction and destruction
+    FingerprintClustering(const FingerprintIndex *index);
+    ~FingerprintClustering();
+
+    // properties
+    const FingerprintIndex* index() const;
+    void setThreadCount(size_t count);
+    size_t threadCount() const;
+
+    // clustering
+    std::vector<Cluster> butina(Real threshold) const;
+    void butina(Real threshold, const ClusterCallback &callback) const;
+
+    // diversity selection
+    std::vector<size_t> maxMin(size_t count, size_t first = 0) const;
+
+private:
+    CHEMKIT_DISABLE_COPY(FingerprintClustering)
+
+private:
+    FingerprintClusteringPrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_FINGERPRINTCLUSTERING_H
@@ -0,0 +1,790 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintindex.h"
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "popcount.h"
+#include "concurrent.h"
+
+namespace chemkit {
+
+namespace {
+
+const char IndexMagic[] = "CKFPIDX1";
+const boost::uint32_t FormatVersion = 1;
+const boost::uint32_t ByteOrderMark = 0x01020304;
+
+const size_t HeaderSize = 64;
+
+// Returns size rounded up to a whole number of 64-byte cache lines.
+size_t alignedSize(size_t size)
+{
+    return (size + 63) & ~size_t(63);
+}
+
+// Writes size bytes from data followed by zeros up to the next
+// multiple of 64 bytes.
+void writeAligned(std::ostream &output, const void *data, size_t size)
+{
+    static const char padding[64] = { 0 };
+
+    if(size){
+        output.write(static_cast<const char *>(data), size);
+    }
+
+    output.write(padding, alignedSize(size) - size);
+}
+
+// Returns true if match a ranks before match b. Matches are ranked
+// by decreasing coefficient and then by increasing index.
+bool isBetterMatch(const FingerprintIndex::Match &a, const FingerprintIndex::Match &b)
+{
+    if(a.second != b.second){
+        return a.second > b.second;
+    }
+
+    return a.first < b.first;
+}
+
+// Runs a threshold search for each query in a batch.
+class ThresholdSearcher
+{
+public:
+    ThresholdSearcher(const FingerprintIndex *index,
+                      const std::vector<Bitset> &queries,
+                      Real threshold,
+                      std::vector<std::vector<FingerprintIndex::Match> > &results)
+        : m_index(index),
+          m_queries(queries),
+          m_threshold(threshold),
+          m_results(results)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_results[i] = m_index->search(m_queries[i], m_threshold);
+    }
+
+private:
+    const FingerprintIndex *m_index;
+    const std::vector<Bitset> &m_queries;
+    Real m_threshold;
+    std::vector<std::vector<FingerprintIndex::Match> > &m_results;
+};
+
+// Runs a nearest neighbor search for each query in a batch.
+class NearestSearcher
+{
+public:
+    NearestSearcher(const FingerprintIndex *index,
+                    const std::vector<Bitset> &queries,
+                    size_t count,
+                    Real threshold,
+                    std::vector<std::vector<FingerprintIndex::Match> > &results)
+        : m_index(index),
+          m_queries(queries),
+          m_count(count),
+          m_threshold(threshold),
+          m_results(results)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_results[i] = m_index->nearest(m_queries[i], m_count, m_threshold);
+    }
+
+private:
+    const FingerprintIndex *m_index;
+    const std::vector<Bitset> &m_queries;
+    size_t m_count;
+    Real m_threshold;
+    std::vector<std::vector<FingerprintIndex::Match> > &m_results;
+};
+
+} // end anonymous namespace
+
+// === FingerprintIndexPrivate ============================================= //
+class FingerprintIndexPrivate
+{
+public:
+    void setFingerprintSize(size_t size);
+    std::vector<boost::uint64_t> toWords(const Bitset &fingerprint) const;
+    void scoreBucket(const boost::uint64_t *query, size_t bitCount, Real *coefficients) const;
+    std::vector<FingerprintIndex::Match> search(const boost::uint64_t *query, Real threshold) const;
+    void detach();
+    void update();
+
+    size_t fingerprintSize;
+    size_t wordCount;
+    size_t count;
+    bool sorted;
+    bool mapped;
+
+    // fingerprint words, stored one after another in order of
+    // increasing bit count once the index has been sorted
+    std::vector<boost::uint64_t> words;
+
+    // bit count of the fingerprint at each position
+    std::vector<boost::uint32_t> bitCounts;
+
+    // index of the fingerprint at each position and position of the
+    // fingerprint with each index
+    std::vector<boost::uint32_t> indices;
+    std::vector<boost::uint32_t> positions;
+
+    // position of the first fingerprint with each bit count
+    std::vector<boost::uint64_t> offsets;
+
+    // the data that is searched, either the vectors above or the
+    // index data passed to map()
+    const boost::uint64_t *wordData;
+    const boost::uint32_t *indexData;
+    const boost::uint32_t *positionData;
+    const boost::uint64_t *offsetData;
+
+    // held while the fingerprints are grouped by bit count so that
+    // the first searches may be run from several threads at once
+    boost::mutex sortMutex;
+};
+
+void FingerprintIndexPrivate::setFingerprintSize(size_t size)
+{
+    fingerprintSize = size;
+
+    // pad each fingerprint to a whole number of 512-bit blocks
+    wordCount = std::max(size_t(1), (size + 511) / 512) * 8;
+}
+
+// Returns the words for fingerprint padded to the index's word count.
+std::vector<boost::uint64_t> FingerprintIndexPrivate::toWords(const Bitset &fingerprint) const
+{
+    std::vector<boost::uint64_t> words(wordCount, 0);
+
+    for(size_t i = fingerprint.find_first(); i < fingerprintSize && i != Bitset::npos; i = fingerprint.find_next(i)){
+        words[i / 64] |= boost::uint64_t(1) << (i % 64);
+    }
+
+    return words;
+}
+
+// Calculates the coefficients between query and each fingerprint
+// with bitCount bits set.
+void FingerprintIndexPrivate::scoreBucket(const boost::uint64_t *query, size_t bitCount, Real *coefficients) const
+{
+    size_t begin = offsetData[bitCount];
+    size_t end = offsetData[bitCount + 1];
+
+    popcount::tanimotoCoefficients(query,
+                                   wordData + begin * wordCount,
+                                   wordCount,
+                                   end - begin,
+                                   coefficients);
+}
+
+// Returns each fingerprint with a coefficient of at least threshold
+// with query sorted from most to least similar. The index must be
+// sorted and not empty.
+std::vector<FingerprintIndex::Match> FingerprintIndexPrivate::search(const boost::uint64_t *query, Real threshold) const
+{
+    std::vector<FingerprintIndex::Match> matches;
+
+    size_t queryCount = popcount::count(query, wordCount);
+
+    // only fingerprints with between threshold * a and a / threshold
+    // bits set can have a coefficient above the threshold
+    size_t first = 0;
+    size_t last = fingerprintSize;
+    if(threshold > 0){
+        if(queryCount == 0){
+            return matches;
+        }
+
+        first = static_cast<size_t>(std::ceil(threshold * queryCount - 1e-9));
+        last = std::min(last, static_cast<size_t>(std::floor(queryCount / threshold + 1e-9)));
+    }
+
+    std::vector<Real> coefficients;
+    for(size_t bitCount = first; bitCount <= last; bitCount++){
+        size_t begin = offsetData[bitCount];
+        size_t end = offsetData[bitCount + 1];
+        if(begin == end){
+            continue;
+        }
+
+        coefficients.resize(end - begin);
+        scoreBucket(query, bitCount, &coefficients[0]);
+
+        for(size_t i = begin; i < end; i++){
+            Real coefficient = coefficients[i - begin];
+
+            if(coefficient >= threshold){
+                matches.push_back(FingerprintIndex::Match(indexData[i], coefficient));
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), isBetterMatch);
+
+    return matches;
+}
+
+// Copies mapped index data to the vectors so that it can be modified.
+void FingerprintIndexPrivate::detach()
+{
+    if(!mapped){
+        return;
+    }
+
+    words.assign(wordData, wordData + count * wordCount);
+    indices.assign(indexData, indexData + count);
+    positions.assign(positionData, positionData + count);
+    offsets.assign(offsetData, offsetData + fingerprintSize + 2);
+
+    bitCounts.resize(count);
+    for(size_t i = 0; i <= fingerprintSize; i++){
+        std::fill(bitCounts.begin() + offsets[i], bitCounts.begin() + offsets[i + 1], i);
+    }
+
+    mapped = false;
+    update();
+}
+
+// Points the searched data at the vectors.
+void FingerprintIndexPrivate::update()
+{
+    wordData = words.empty() ? 0 : &words[0];
+    indexData = indices.empty() ? 0 : &indices[0];
+    positionData = positions.empty() ? 0 : &positions[0];
+    offsetData = &offsets[0];
+}
+
+// === FingerprintIndex ==================================================== //
+/// \class FingerprintIndex fingerprintindex.h chemkit/fingerprintindex.h
+/// \ingroup chemkit
+/// \brief The FingerprintIndex class provides fast similarity
+///        searches over a collection of fingerprints.
+///
+/// Fingerprints are added to the index with addFingerprint() and are
+/// identified by the order in which they were added. The index can
+/// then be searched for all of the fingerprints within a tanimoto
+/// coefficient threshold of a query with search() or for the most
+/// similar fingerprints to a query with nearest().
+///
+/// The fingerprints are stored in a single contiguous block of memory
+/// grouped by the number of bits they have set. The tanimoto
+/// coefficient between two fingerprints with \c a and \c b bits set
+/// is at most <tt>min(a, b) / max(a, b)</tt> so searches only score
+/// the groups of fingerprints which could possibly match.
+///
+/// For example, to find the ten molecules most similar to a query
+/// molecule using the FP2 fingerprint:
+/// \code
+/// chemkit::Fingerprint *fp2 = chemkit::Fingerprint::create("fp2");
+///
+/// chemkit::FingerprintIndex index(1021);
+/// foreach(const chemkit::Molecule *molecule, molecules){
+///     index.addFingerprint(fp2->value(molecule));
+/// }
+///
+/// std::vector<chemkit::FingerprintIndex::Match> matches =
+///     index.nearest(fp2->value(query), 10);
+/// \endcode
+///
+/// The index is grouped by bit count the first time it is searched
+/// after fingerprints have been added. Searches of an index that
+/// is not being modified are safe to run from multiple threads.
+///
+/// An index can be saved with write() and later searched in place,
+/// for example from a memory-mapped file, with map(). The saved
+/// index uses the byte order of the machine that wrote it.
+///
+/// \see Fingerprint, FixedFingerprint
+
+/// \typedef FingerprintIndex::Match
+///
+/// A search result made up of the index of the matching fingerprint
+/// and its tanimoto coefficient with the query.
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new, empty fingerprint index for fingerprints with
+/// \p fingerprintSize bits.
+FingerprintIndex::FingerprintIndex(size_t fingerprintSize)
+    : d(new FingerprintIndexPrivate)
+{
+    d->setFingerprintSize(fingerprintSize);
+    d->count = 0;
+    d->sorted = true;
+    d->mapped = false;
+    d->offsets.assign(fingerprintSize + 2, 0);
+    d->update();
+}
+
+/// Destroys the fingerprint index.
+FingerprintIndex::~FingerprintIndex()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the number of bits in each fingerprint in the index.
+size_t FingerprintIndex::fingerprintSize() const
+{
+    return d->fingerprintSize;
+}
+
+/// Returns the number of fingerprints in the index.
+size_t FingerprintIndex::size() const
+{
+    return d->count;
+}
+
+/// Returns \c true if the index contains no fingerprints.
+bool FingerprintIndex::isEmpty() const
+{
+    return size() == 0;
+}
+
+// --- Fingerprints -------------------------------------------------------- //
+/// Adds \p fingerprint to the index and returns its index. Bits past
+/// the fingerprint size of the index are ignored.
+size_t FingerprintIndex::addFingerprint(const Bitset &fingerprint)
+{
+    std::vector<boost::uint64_t> words = d->toWords(fingerprint);
+
+    return addFingerprint(&words[0]);
+}
+
+/// Adds the fingerprint with the bits in \p words to the index and
+/// returns its index. The first bit of the fingerprint is the least
+/// significant bit of the first word. \p words must contain at least
+/// <tt>(fingerprintSize() + 63) / 64</tt> words.
+size_t FingerprintIndex::addFingerprint(const boost::uint64_t *words)
+{
+    d->detach();
+
+    size_t index = d->count;
+    size_t begin = d->words.size();
+    size_t fingerprintWordCount = (d->fingerprintSize + 63) / 64;
+
+    d->words.resize(begin + d->wordCount, 0);
+    std::copy(words, words + fingerprintWordCount, d->words.begin() + begin);
+
+    // clear the bits past the end of the fingerprint
+    if(d->fingerprintSize % 64){
+        d->words[begin + fingerprintWordCount - 1] &= (boost::uint64_t(1) << (d->fingerprintSize % 64)) - 1;
+    }
+
+    d->bitCounts.push_back(popcount::count(&d->words[begin], d->wordCount));
+    d->indices.push_back(index);
+    d->positions.push_back(index);
+    d->count++;
+    d->sorted = false;
+    d->update();
+
+    return index;
+}
+
+/// Returns the fingerprint at \p index.
+Bitset FingerprintIndex::fingerprint(size_t index) const
+{
+    Bitset fingerprint(d->fingerprintSize);
+
+    const boost::uint64_t *words = fingerprintWords(index);
+    for(size_t i = 0; i < d->fingerprintSize; i++){
+        if(words[i / 64] & (boost::uint64_t(1) << (i % 64))){
+            fingerprint.set(i);
+        }
+    }
+
+    return fingerprint;
+}
+
+/// Returns the words of the fingerprint at \p index. The first bit of
+/// the fingerprint is the least significant bit of the first word.
+const boost::uint64_t* FingerprintIndex::fingerprintWords(size_t index) const
+{
+    return d->wordData + d->positionData[index] * d->wordCount;
+}
+
+/// Reserves space for \p size fingerprints in the index.
+void FingerprintIndex::reserve(size_t size)
+{
+    d->detach();
+
+    d->words.reserve(size * d->wordCount);
+    d->bitCounts.reserve(size);
+    d->indices.reserve(size);
+    d->positions.reserve(size);
+}
+
+/// Removes all of the fingerprints from the index.
+void FingerprintIndex::clear()
+{
+    d->words.clear();
+    d->bitCounts.clear();
+    d->indices.clear();
+    d->positions.clear();
+    d->offsets.assign(d->fingerprintSize + 2, 0);
+    d->count = 0;
+    d->sorted = true;
+    d->mapped = false;
+    d->update();
+}
+
+// --- Searching ----------------------------------------------------------- //
+/// Returns each fingerprint with a tanimoto coefficient of at least
+/// \p threshold with \p query. The matches are sorted from most to
+/// least similar.
+std::vector<FingerprintIndex::Match> FingerprintIndex::search(const Bitset &query, Real threshold) const
+{
+    sort();
+
+    if(isEmpty()){
+        return std::vector<Match>();
+    }
+
+    std::vector<boost::uint64_t> queryWords = d->toWords(query);
+
+    return d->search(&queryWords[0], threshold);
+}
+
+/// Runs a threshold search for each of the fingerprints in
+/// \p queries. The searches are run in parallel.
+///
+/// \see search(const Bitset &query, Real threshold)
+std::vector<std::vector<FingerprintIndex::Match> > FingerprintIndex::search(const std::vector<Bitset> &queries, Real threshold) const
+{
+    sort();
+
+    std::vector<std::vector<Match> > results(queries.size());
+    concurrent::blockingFor(queries.size(), ThresholdSearcher(this, queries, threshold, results));
+
+    return results;
+}
+
+/// Returns each other fingerprint in the index with a tanimoto
+/// coefficient of at least \p threshold with the fingerprint at
+/// \p index. The matches are sorted from most to least similar.
+///
+/// This is equivalent to searching for fingerprint(index) and then
+/// removing \p index from the results.
+std::vector<FingerprintIndex::Match> FingerprintIndex::neighbors(size_t index, Real threshold) const
+{
+    sort();
+
+    std::vector<Match> matches = d->search(fingerprintWords(index), threshold);
+
+    for(std::vector<Match>::iterator iter = matches.begin(); iter != matches.end(); ++iter){
+        if(iter->first == index){
+            matches.erase(iter);
+            break;
+        }
+    }
+
+    return matches;
+}
+
+/// Returns the \p count fingerprints most similar to \p query with a
+/// tanimoto coefficient of at least \p threshold. The matches are
+/// sorted from most to least similar and fingerprints with equal
+/// coefficients are ordered by their index.
+std::vector<FingerprintIndex::Match> FingerprintIndex::nearest(const Bitset &query, size_t count, Real threshold) const
+{
+    sort();
+
+    // heap of the best matches found so far with the worst at the top
+    std::vector<Match> matches;
+    if(isEmpty() || count == 0){
+        return matches;
+    }
+
+    std::vector<boost::uint64_t> queryWords = d->toWords(query);
+    size_t queryCount = popcount::count(&queryWords[0], d->wordCount);
+
+    // visit the groups of fingerprints in order of decreasing upper
+    // bound by walking outwards from the query's bit count
+    size_t below = queryCount + 1;
+    size_t above = queryCount + 1;
+    std::vector<Real> coefficients;
+
+    for(;;){
+        bool hasBelow = below > 0;
+        bool hasAbove = above <= d->fingerprintSize;
+        if(!hasBelow && !hasAbove){
+            break;
+        }
+
+        Real belowBound = hasBelow && queryCount ? Real(below - 1) / queryCount : Real(0);
+        Real aboveBound = hasAbove ? Real(queryCount) / above : Real(0);
+
+        size_t bitCount;
+        Real bound;
+        if(hasBelow && (!hasAbove || belowBound >= aboveBound)){
+            bitCount = --below;
+            bound = belowBound;
+        }
+        else{
+            bitCount = above++;
+            bound = aboveBound;
+        }
+
+        if(bound < threshold ||
+           (matches.size() == count && bound < matches.front().second)){
+            break;
+        }
+
+        size_t begin = d->offsetData[bitCount];
+        size_t end = d->offsetData[bitCount + 1];
+        if(begin == end){
+            continue;
+        }
+
+        coefficients.resize(end - begin);
+        d->scoreBucket(&queryWords[0], bitCount, &coefficients[0]);
+
+        for(size_t i = begin; i < end; i++){
+            Match match(d->indexData[i], coefficients[i - begin]);
+
+            if(match.second < threshold){
+                continue;
+            }
+            else if(matches.size() < count){
+                matches.push_back(match);
+                std::push_heap(matches.begin(), matches.end(), isBetterMatch);
+            }
+            else if(isBetterMatch(match, matches.front())){
+                std::pop_heap(matches.begin(), matches.end(), isBetterMatch);
+                matches.back() = match;
+                std::push_heap(matches.begin(), matches.end(), isBetterMatch);
+            }
+        }
+    }
+
+    std::sort_heap(matches.begin(), matches.end(), isBetterMatch);
+
+    return matches;
+}
+
+/// Runs a nearest neighbor search for each of the fingerprints in
+/// \p queries. The searches are run in parallel.
+///
+/// \see nearest(const Bitset &query, size_t count, Real threshold)
+std::vector<std::vector<FingerprintIndex::Match> > FingerprintIndex::nearest(const std::vector<Bitset> &queries, size_t count, Real threshold) const
+{
+    sort();
+
+    std::vector<std::vector<Match> > results(queries.size());
+    concurrent::blockingFor(queries.size(), NearestSearcher(this, queries, count, threshold, results));
+
+    return results;
+}
+
+// --- Input and Output --------------------------------------------------- //
+/// Writes the index to \p output in the form read by map(). Returns
+/// \c false if the index cannot be written.
+///
+/// The data starts with a 64-byte header followed by the bit count
+/// offsets, the index of the fingerprint at each position, the
+/// position of each fingerprint and the fingerprint words. Each
+/// section is padded to a multiple of 64 bytes.
+bool FingerprintIndex::write(std::ostream &output) const
+{
+    sort();
+
+    boost::uint64_t header[HeaderSize / 8] = { 0 };
+    std::memcpy(header, IndexMagic, 8);
+    boost::uint32_t version[2] = { FormatVersion, ByteOrderMark };
+    std::memcpy(&header[1], version, 8);
+    header[2] = d->fingerprintSize;
+    header[3] = d->count;
+    header[4] = d->wordCount;
+
+    output.write(reinterpret_cast<const char *>(header), HeaderSize);
+    writeAligned(output, d->offsetData, (d->fingerprintSize + 2) * sizeof(boost::uint64_t));
+    writeAligned(output, d->indexData, d->count * sizeof(boost::uint32_t));
+    writeAligned(output, d->positionData, d->count * sizeof(boost::uint32_t));
+    writeAligned(output, d->wordData, d->count * d->wordCount * sizeof(boost::uint64_t));
+
+    return !output.fail();
+}
+
+/// Uses the index written by write() in the \p size bytes at \p data
+/// without copying it. The fingerprint size of the index is set to
+/// the size in the data. Returns \c false if \p data does not contain
+/// a valid index or is not aligned to 8 bytes.
+///
+/// The data must stay valid and unchanged until the index is cleared
+/// or destroyed. Adding fingerprints to a mapped index copies the
+/// data first.
+bool FingerprintIndex::map(const char *data, size_t size)
+{
+    if(size < HeaderSize ||
+       reinterpret_cast<size_t>(data) % 8 != 0 ||
+       std::memcmp(data, IndexMagic, 8) != 0){
+        return false;
+    }
+
+    const boost::uint64_t *header = reinterpret_cast<const boost::uint64_t *>(data);
+    boost::uint32_t version[2];
+    std::memcpy(version, &header[1], 8);
+    if(version[0] != FormatVersion || version[1] != ByteOrderMark){
+        return false;
+    }
+
+    // the sizes are checked against the data one section at a time so
+    // that a corrupt header cannot overflow the size arithmetic
+    size_t available = size - HeaderSize;
+
+    boost::uint64_t fingerprintSize = header[2];
+    if(available / sizeof(boost::uint64_t) < 2 ||
+       fingerprintSize > available / sizeof(boost::uint64_t) - 2){
+        return false;
+    }
+    size_t offsetsSize = alignedSize((fingerprintSize + 2) * sizeof(boost::uint64_t));
+    if(offsetsSize > available){
+        return false;
+    }
+    available -= offsetsSize;
+
+    boost::uint64_t count = header[3];
+    if(count > std::numeric_limits<boost::uint32_t>::max() ||
+       count > available / (2 * sizeof(boost::uint32_t))){
+        return false;
+    }
+    size_t indicesSize = alignedSize(count * sizeof(boost::uint32_t));
+    if(indicesSize > available / 2){
+        return false;
+    }
+    available -= 2 * indicesSize;
+
+    size_t wordCount = std::max(size_t(1), (fingerprintSize + 511) / 512) * 8;
+    if(header[4] != wordCount ||
+       (count > 0 && wordCount > available / sizeof(boost::uint64_t) / count)){
+        return false;
+    }
+
+    const boost::uint64_t *offsets = reinterpret_cast<const boost::uint64_t *>(data + HeaderSize);
+    if(offsets[0] != 0 || offsets[fingerprintSize + 1] != count){
+        return false;
+    }
+    for(size_t i = 0; i <= fingerprintSize; i++){
+        if(offsets[i] > offsets[i + 1]){
+            return false;
+        }
+    }
+
+    // the indices and positions must be inverse permutations of each
+    // other so that every lookup stays within the index
+    const boost::uint32_t *indices = reinterpret_cast<const boost::uint32_t *>(data + HeaderSize + offsetsSize);
+    const boost::uint32_t *positions = indices + indicesSize / sizeof(boost::uint32_t);
+    for(size_t i = 0; i < count; i++){
+        if(indices[i] >= count || positions[indices[i]] != i){
+            return false;
+        }
+    }
+
+    clear();
+    d->setFingerprintSize(fingerprintSize);
+    d->offsets.assign(fingerprintSize + 2, 0);
+    d->count = count;
+    d->mapped = true;
+    d->offsetData = offsets;
+    d->indexData = indices;
+    d->positionData = positions;
+    d->wordData = reinterpret_cast<const boost::uint64_t *>(data + HeaderSize + offsetsSize + 2 * indicesSize);
+
+    return true;
+}
+
+/// Returns \c true if the index is searching data passed to map().
+bool FingerprintIndex::isMapped() const
+{
+    return d->mapped;
+}
+
+// --- Internal Methods ---------------------------------------------------- //
+// Groups the fingerprints by bit count. This is a stable counting
+// sort so fingerprints with the same bit count stay in index order.
+void FingerprintIndex::sort() const
+{
+    boost::lock_guard<boost::mutex> lock(d->sortMutex);
+
+    if(d->sorted){
+        return;
+    }
+
+    std::vector<boost::uint64_t> &offsets = d->offsets;
+    offsets.assign(d->fingerprintSize + 2, 0);
+    for(size_t i = 0; i < d->bitCounts.size(); i++){
+        offsets[d->bitCounts[i] + 1]++;
+    }
+    for(size_t i = 1; i < offsets.size(); i++){
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<boost::uint64_t> words(d->words.size());
+    std::vector<boost::uint32_t> bitCounts(d->bitCounts.size());
+    std::vector<boost::uint32_t> indices(d->indices.size());
+    std::vector<boost::uint64_t> next(offsets.begin(), offsets.end() - 1);
+
+    for(size_t i = 0; i < d->indices.size(); i++){
+        size_t position = next[d->bitCounts[i]]++;
+
+        std::copy(d->words.begin() + i * d->wordCount,
+                  d->words.begin() + (i + 1) * d->wordCount,
+                  words.begin() + position * d->wordCount);
+        bitCounts[position] = d->bitCounts[i];
+        indices[position] = d->indices[i];
+        d->positions[d->indices[i]] = position;
+    }
+
+    d->words.swap(words);
+    d->bitCounts.swap(bitCounts);
+    d->indices.swap(indices);
+    d->sorted = true;
+    d->update();
+}
+
+} // end chemkit namespace
@@ -0,0 +1,99 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FINGERPRINTINDEX_H
+#define CHEMKIT_FINGERPRINTINDEX_H
+
+#include "chemkit.h"
+
+#include <vector>
+#include <utility>
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+
+#include "bitset.h"
+
+namespace chemkit {
+
+class FingerprintIndexPrivate;
+
+class CHEMKIT_EXPORT FingerprintIndex
+{
+public:
+    // typedefs
+    typedef std::pair<size_t, Real> Match;
+
+    // construction and destruction
+    FingerprintIndex(size_t fingerprintSize);
+    ~FingerprintIndex();
+
+    // properties
+    size_t fingerprintSize() const;
+    size_t size() const;
+    bool isEmpty() const;
+
+    // fingerprints
+    size_t addFingerprint(const Bitset &fingerprint);
+    size_t addFingerprint(const boost::uint64_t *words);
+    Bitset fingerprint(size_t index) const;
+    const boost::uint64_t* fingerprintWords(size_t index) const;
+    void reserve(size_t size);
+    void clear();
+
+    // searching
+    std::vector<Match> search(const Bitset &query, Real threshold) const;
+    std::vector<std::vector<Match> > search(const std::vector<Bitset> &queries, Real threshold) const;
+    std::vector<Match> neighbors(size_t index, Real threshold) const;
+    std::vector<Match> nearest(const Bitset &query, size_t count, Real threshold = 0) const;
+    std::vector<std::vector<Match> > nearest(const std::vector<Bitset> &queries, size_t count, Real threshold = 0) const;
+
+    // input and output
+    bool write(std::ostream &output) const;
+    bool map(const char *data, size_t size);
+    bool isMapped() const;
+
+private:
+    CHEMKIT_DISABLE_COPY(FingerprintIndex)
+
+    void sort() const;
+
+private:
+    FingerprintIndexPrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_FINGERPRINTINDEX_H
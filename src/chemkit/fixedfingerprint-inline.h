@@ -0,0 +1,271 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FIXEDFINGERPRINT_INLINE_H
+#define CHEMKIT_FIXEDFINGERPRINT_INLINE_H
+
+#include "fixedfingerprint.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "popcount.h"
+
+namespace chemkit {
+
+// === FixedFingerprint ==================================================== //
+/// \class FixedFingerprint fixedfingerprint.h chemkit/fixedfingerprint.h
+/// \ingroup chemkit
+/// \brief The FixedFingerprint class represents a fingerprint with
+///        a fixed number of bits.
+///
+/// Unlike Bitset, the bits of a FixedFingerprint are stored inline
+/// in 64-bit words padded to a multiple of 512 bits and the object is
+/// aligned to 64 bytes. An array of fixed fingerprints is therefore
+/// a single contiguous block of memory which can be compared against
+/// a query without any indirection. The similarity methods count bits
+/// with the processor's popcnt instruction when it is available.
+///
+/// The Fp2FixedFingerprint and PubChemFixedFingerprint typedefs are
+/// provided for the 1021-bit FP2 and 881-bit PubChem fingerprints.
+///
+/// For example, to find the similarity between a query molecule and
+/// a set of molecules:
+/// \code
+/// chemkit::Fingerprint *fp2 = chemkit::Fingerprint::create("fp2");
+///
+/// chemkit::Fp2FixedFingerprint query(fp2->value(molecule));
+///
+/// std::vector<chemkit::Fp2FixedFingerprint> fingerprints;
+/// foreach(const chemkit::Molecule *other, molecules){
+///     fingerprints.push_back(chemkit::Fp2FixedFingerprint(fp2->value(other)));
+/// }
+///
+/// std::vector<chemkit::Real> similarities =
+///     chemkit::Fp2FixedFingerprint::tanimotoCoefficients(query, fingerprints);
+/// \endcode
+///
+/// \see Fingerprint, Bitset
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new fingerprint with no bits set.
+template<size_t Size>
+inline FixedFingerprint<Size>::FixedFingerprint()
+{
+    reset();
+}
+
+/// Creates a new fingerprint with the bits set in \p bitset. Bits
+/// past the size of the fingerprint are ignored.
+template<size_t Size>
+inline FixedFingerprint<Size>::FixedFingerprint(const Bitset &bitset)
+{
+    reset();
+
+    for(size_t i = bitset.find_first(); i < Size && i != Bitset::npos; i = bitset.find_next(i)){
+        set(i);
+    }
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the number of bits in the fingerprint.
+template<size_t Size>
+inline size_t FixedFingerprint<Size>::size() const
+{
+    return Size;
+}
+
+/// Returns the number of bits set in the fingerprint.
+template<size_t Size>
+inline size_t FixedFingerprint<Size>::count() const
+{
+    return popcount::count(m_words, WordCount);
+}
+
+/// Returns \c true if no bits are set in the fingerprint.
+template<size_t Size>
+inline bool FixedFingerprint<Size>::isEmpty() const
+{
+    for(size_t i = 0; i < WordCount; i++){
+        if(m_words[i]){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Returns a pointer to the words containing the bits of the
+/// fingerprint. Bit \c i is stored in word \c i / 64 at position
+/// \c i % 64. The padding bits past size() are always zero.
+template<size_t Size>
+inline const boost::uint64_t* FixedFingerprint<Size>::words() const
+{
+    return m_words;
+}
+
+// --- Bits ---------------------------------------------------------------- //
+/// Sets the bit at \p index to \p value.
+template<size_t Size>
+inline void FixedFingerprint<Size>::set(size_t index, bool value)
+{
+    assert(index < Size);
+
+    boost::uint64_t mask = boost::uint64_t(1) << (index % 64);
+
+    if(value){
+        m_words[index / 64] |= mask;
+    }
+    else{
+        m_words[index / 64] &= ~mask;
+    }
+}
+
+/// Returns \c true if the bit at \p index is set.
+template<size_t Size>
+inline bool FixedFingerprint<Size>::test(size_t index) const
+{
+    assert(index < Size);
+
+    return (m_words[index / 64] >> (index % 64)) & 1;
+}
+
+/// Clears all of the bits in the fingerprint.
+template<size_t Size>
+inline void FixedFingerprint<Size>::reset()
+{
+    std::fill(m_words, m_words + WordCount, boost::uint64_t(0));
+}
+
+/// Returns the fingerprint as a bitset with size() bits.
+template<size_t Size>
+inline Bitset FixedFingerprint<Size>::toBitset() const
+{
+    Bitset bitset(Size);
+
+    for(size_t i = 0; i < Size; i++){
+        if(test(i)){
+            bitset.set(i);
+        }
+    }
+
+    return bitset;
+}
+
+// --- Operators ----------------------------------------------------------- //
+/// Returns \c true if the bit at \p index is set.
+template<size_t Size>
+inline bool FixedFingerprint<Size>::operator[](size_t index) const
+{
+    return test(index);
+}
+
+/// Returns \c true if the fingerprint has the same bits set as
+/// \p other.
+template<size_t Size>
+inline bool FixedFingerprint<Size>::operator==(const FixedFingerprint &other) const
+{
+    return std::equal(m_words, m_words + WordCount, other.m_words);
+}
+
+/// Returns \c true if the fingerprint does not have the same bits
+/// set as \p other.
+template<size_t Size>
+inline bool FixedFingerprint<Size>::operator!=(const FixedFingerprint &other) const
+{
+    return !(*this == other);
+}
+
+// --- Similarity ---------------------------------------------------------- //
+/// Returns the number of bits set in both \p a and \p b.
+template<size_t Size>
+inline size_t FixedFingerprint<Size>::intersectionCount(const FixedFingerprint &a, const FixedFingerprint &b)
+{
+    return popcount::intersectionCount(a.m_words, b.m_words, WordCount);
+}
+
+/// Returns the number of bits set in either \p a or \p b.
+template<size_t Size>
+inline size_t FixedFingerprint<Size>::unionCount(const FixedFingerprint &a, const FixedFingerprint &b)
+{
+    return popcount::unionCount(a.m_words, b.m_words, WordCount);
+}
+
+/// Returns the tanimoto coefficient between \p a and \p b. The
+/// coefficient is \c 0 if neither fingerprint has any bits set.
+template<size_t Size>
+inline Real FixedFingerprint<Size>::tanimotoCoefficient(const FixedFingerprint &a, const FixedFingerprint &b)
+{
+    return popcount::tanimotoCoefficient(a.m_words, b.m_words, WordCount);
+}
+
+/// Calculates the tanimoto coefficient between \p query and each of
+/// the \p count fingerprints in the array at \p fingerprints and
+/// writes them to \p coefficients.
+template<size_t Size>
+inline void FixedFingerprint<Size>::tanimotoCoefficients(const FixedFingerprint &query,
+                                                         const FixedFingerprint *fingerprints,
+                                                         size_t count,
+                                                         Real *coefficients)
+{
+    if(count == 0){
+        return;
+    }
+
+    popcount::tanimotoCoefficients(query.m_words,
+                                   fingerprints[0].m_words,
+                                   WordCount,
+                                   count,
+                                   coefficients);
+}
+
+/// Returns the tanimoto coefficients between \p query and each of
+/// the fingerprints in \p fingerprints.
+template<size_t Size>
+inline std::vector<Real> FixedFingerprint<Size>::tanimotoCoefficients(const FixedFingerprint &query,
+                                                                      const std::vector<FixedFingerprint> &fingerprints)
+{
+    std::vector<Real> coefficients(fingerprints.size());
+
+    if(!fingerprints.empty()){
+        tanimotoCoefficients(query, &fingerprints[0], fingerprints.size(), &coefficients[0]);
+    }
+
+    return coefficients;
+}
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_FIXEDFINGERPRINT_INLINE_H
@@ -0,0 +1,106 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FIXEDFINGERPRINT_H
+#define CHEMKIT_FIXEDFINGERPRINT_H
+
+#include "chemkit.h"
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "bitset.h"
+
+namespace chemkit {
+
+template<size_t Size>
+class CHEMKIT_ALIGN(64) FixedFingerprint
+{
+public:
+    // enumerations
+    enum {
+        BitCount = Size,
+        WordCount = ((Size + 511) / 512) * 8
+    };
+
+    // construction and destruction
+    FixedFingerprint();
+    explicit FixedFingerprint(const Bitset &bitset);
+
+    // properties
+    size_t size() const;
+    size_t count() const;
+    bool isEmpty() const;
+    const boost::uint64_t* words() const;
+
+    // bits
+    void set(size_t index, bool value = true);
+    bool test(size_t index) const;
+    void reset();
+    Bitset toBitset() const;
+
+    // operators
+    bool operator[](size_t index) const;
+    bool operator==(const FixedFingerprint &other) const;
+    bool operator!=(const FixedFingerprint &other) const;
+
+    // similarity
+    static size_t intersectionCount(const FixedFingerprint &a, const FixedFingerprint &b);
+    static size_t unionCount(const FixedFingerprint &a, const FixedFingerprint &b);
+    static Real tanimotoCoefficient(const FixedFingerprint &a, const FixedFingerprint &b);
+    static void tanimotoCoefficients(const FixedFingerprint &query,
+                                     const FixedFingerprint *fingerprints,
+                                     size_t count,
+                                     Real *coefficients);
+    static std::vector<Real> tanimotoCoefficients(const FixedFingerprint &query,
+                                                  const std::vector<FixedFingerprint> &fingerprints);
+
+private:
+    boost::uint64_t m_words[WordCount];
+};
+
+/// Typedef for a fixed fingerprint the size of the FP2 fingerprint.
+typedef FixedFingerprint<1021> Fp2FixedFingerprint;
+
+/// Typedef for a fixed fingerprint the size of the PubChem
+/// fingerprint.
+typedef FixedFingerprint<881> PubChemFixedFingerprint;
+
+} // end chemkit namespace
+
+#include "fixedfingerprint-inline.h"
+
+#endif // CHEMKIT_FIXEDFINGERPRINT_H
@@ -0,0 +1,649 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "gaussianshape.h"
+
+#include <cmath>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <Eigen/Geometry>
+#include <Eigen/Eigenvalues>
+
+#include "atom.h"
+#include "foreach.h"
+#include "molecule.h"
+#include "constants.h"
+
+namespace chemkit {
+
+namespace {
+
+typedef Eigen::Array<Real, Eigen::Dynamic, 1> RealArray;
+
+// height of each atomic gaussian
+const Real GaussianHeight = 2.828427124746190; // 2 * sqrt(2)
+
+// a gaussian is skipped when its exponent with every gaussian in the
+// other shape is above this at the distance to that shape's bounding
+// sphere
+const Real ExponentCutoff = 16;
+
+// step sizes used when aligning shapes
+const Real InitialTranslationStep = 0.5;
+const Real InitialRotationStep = 0.2;
+const Real MinimumStep = 1e-3;
+const size_t StartingAlignmentSteps = 10;
+const size_t MaximumAlignmentSteps = 100;
+
+// alignment stops once a step improves the overlap by less than this
+// fraction
+const Real ConvergenceTolerance = 1e-5;
+
+// The exponent and weight of the overlap between each pair of
+// gaussians in two shapes. These only depend on the gaussians' radii
+// so they are calculated once and reused while a shape is moved.
+class OverlapTable
+{
+public:
+    OverlapTable(const std::vector<Real> &alpha, const std::vector<Real> &otherAlpha);
+
+    std::vector<Real> exponents;
+    std::vector<Real> weights;
+    std::vector<Real> minimumExponents;
+};
+
+OverlapTable::OverlapTable(const std::vector<Real> &alpha, const std::vector<Real> &otherAlpha)
+    : exponents(alpha.size() * otherAlpha.size()),
+      weights(alpha.size() * otherAlpha.size()),
+      minimumExponents(alpha.size())
+{
+    const Real scale = GaussianHeight * GaussianHeight * std::pow(chemkit::constants::Pi, Real(1.5));
+
+    for(size_t i = 0; i < alpha.size(); i++){
+        Real minimum = std::numeric_limits<Real>::max();
+
+        for(size_t j = 0; j < otherAlpha.size(); j++){
+            Real sum = alpha[i] + otherAlpha[j];
+            Real exponent = alpha[i] * otherAlpha[j] / sum;
+
+            exponents[i * otherAlpha.size() + j] = exponent;
+            weights[i * otherAlpha.size() + j] = scale / (sum * std::sqrt(sum));
+            minimum = std::min(minimum, exponent);
+        }
+
+        minimumExponents[i] = minimum;
+    }
+}
+
+} // end anonymous namespace
+
+// === GaussianShapePrivate ================================================ //
+class GaussianShapePrivate
+{
+public:
+    GaussianShapePrivate();
+
+    void applyTransform(const GaussianShapePrivate *source,
+                        const Eigen::Matrix<Real, 3, 3> &rotation,
+                        const Vector3 &translation);
+    Point3 center() const;
+    Eigen::Matrix<Real, 3, 3> principalAxes() const;
+    Real overlap(const GaussianShapePrivate *shape) const;
+    Real overlap(const GaussianShapePrivate *shape,
+                 const OverlapTable &table,
+                 std::vector<Real> *gradient = 0) const;
+    Real gaussianOverlap(size_t index, const Point3 &position, Real alpha) const;
+    Real optimize(const GaussianShapePrivate *target,
+                  const OverlapTable &table,
+                  Eigen::Matrix<Real, 3, 3> &rotation,
+                  Vector3 &translation,
+                  size_t steps) const;
+
+    // the position and exponent of each gaussian are stored in
+    // separate arrays so that the overlap calculation is vectorized
+    std::vector<Real> x;
+    std::vector<Real> y;
+    std::vector<Real> z;
+    std::vector<Real> alpha;
+    std::vector<Real> radii;
+
+    Eigen::Matrix<Real, 3, 3> rotation;
+    Vector3 translation;
+
+    Real volume;
+};
+
+GaussianShapePrivate::GaussianShapePrivate()
+    : rotation(Eigen::Matrix<Real, 3, 3>::Identity()),
+      translation(Vector3::Zero()),
+      volume(0)
+{
+}
+
+// Sets the gaussians to those in source moved by rotation and then
+// translation.
+void GaussianShapePrivate::applyTransform(const GaussianShapePrivate *source,
+                                          const Eigen::Matrix<Real, 3, 3> &rotation,
+                                          const Vector3 &translation)
+{
+    size_t size = source->x.size();
+
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+
+    for(size_t i = 0; i < size; i++){
+        Point3 position = rotation * Point3(source->x[i], source->y[i], source->z[i]) + translation;
+
+        x[i] = position.x();
+        y[i] = position.y();
+        z[i] = position.z();
+    }
+}
+
+Point3 GaussianShapePrivate::center() const
+{
+    if(x.empty()){
+        return Point3::Zero();
+    }
+
+    Point3 sum = Point3::Zero();
+    for(size_t i = 0; i < x.size(); i++){
+        sum += Point3(x[i], y[i], z[i]);
+    }
+
+    return sum / Real(x.size());
+}
+
+// Returns the principal axes of the gaussian positions as the columns
+// of a rotation matrix, ordered by increasing spread.
+Eigen::Matrix<Real, 3, 3> GaussianShapePrivate::principalAxes() const
+{
+    Point3 center = this->center();
+
+    Eigen::Matrix<Real, 3, 3> covariance = Eigen::Matrix<Real, 3, 3>::Zero();
+    for(size_t i = 0; i < x.size(); i++){
+        Vector3 offset = Point3(x[i], y[i], z[i]) - center;
+        covariance += offset * offset.transpose();
+    }
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix<Real, 3, 3> > solver(covariance);
+    Eigen::Matrix<Real, 3, 3> axes = solver.eigenvectors();
+
+    // make the axes right-handed so they form a proper rotation
+    if(axes.determinant() < 0){
+        axes.col(2) = -axes.col(2);
+    }
+
+    return axes;
+}
+
+// Returns the overlap volume between the gaussians and those in shape.
+Real GaussianShapePrivate::overlap(const GaussianShapePrivate *shape) const
+{
+    OverlapTable table(alpha, shape->alpha);
+
+    return overlap(shape, table);
+}
+
+// Returns the overlap volume between the gaussians and those in shape
+// using the pair exponents and weights in table. If gradient is not
+// null it is set to the gradient of the overlap with respect to the
+// position of each gaussian, stored as x, y and z for each gaussian.
+//
+// The overlap between gaussians i and j with exponents a and b at a
+// distance r is:
+//
+//   p^2 * (pi / (a + b))^(3/2) * exp(-a * b / (a + b) * r^2)
+//
+// For each gaussian the terms for all of the gaussians in shape are
+// calculated together as array expressions, which Eigen vectorizes
+// including the exponential.
+Real GaussianShapePrivate::overlap(const GaussianShapePrivate *shape,
+                                   const OverlapTable &table,
+                                   std::vector<Real> *gradient) const
+{
+    size_t size = x.size();
+    size_t shapeSize = shape->x.size();
+
+    if(gradient){
+        gradient->assign(3 * size, 0);
+    }
+
+    if(size == 0 || shapeSize == 0){
+        return 0;
+    }
+
+    Eigen::Map<const RealArray> shapeX(&shape->x[0], shapeSize);
+    Eigen::Map<const RealArray> shapeY(&shape->y[0], shapeSize);
+    Eigen::Map<const RealArray> shapeZ(&shape->z[0], shapeSize);
+
+    // the terms for each row are kept in a local buffer so that
+    // overlaps with the same shape can be calculated concurrently
+    RealArray v(shapeSize);
+
+    // a gaussian is only skipped if it is too far away from the other
+    // shape's bounding sphere to overlap with any of its gaussians,
+    // otherwise the terms for all of the pairs in its row are calculated
+    Point3 shapeCenter = shape->center();
+    Real shapeRadius = 0;
+    for(size_t j = 0; j < shapeSize; j++){
+        shapeRadius = std::max(shapeRadius, (Point3(shape->x[j], shape->y[j], shape->z[j]) - shapeCenter).norm());
+    }
+
+    Real overlap = 0;
+    for(size_t i = 0; i < size; i++){
+        Real xi = x[i];
+        Real yi = y[i];
+        Real zi = z[i];
+
+        Real distance = (Point3(xi, yi, zi) - shapeCenter).norm() - shapeRadius;
+        if(distance > 0 && table.minimumExponents[i] * distance * distance > ExponentCutoff){
+            continue;
+        }
+
+        Eigen::Map<const RealArray> k(&table.exponents[i * shapeSize], shapeSize);
+        Eigen::Map<const RealArray> w(&table.weights[i * shapeSize], shapeSize);
+
+        v = w * (-k * ((shapeX - xi).square() + (shapeY - yi).square() + (shapeZ - zi).square())).exp();
+
+        overlap += v.sum();
+
+        if(gradient){
+            // derivative of each term is -2 * k * (ri - rj) * term
+            v *= k;
+            (*gradient)[3 * i + 0] = -2 * (v * (xi - shapeX)).sum();
+            (*gradient)[3 * i + 1] = -2 * (v * (yi - shapeY)).sum();
+            (*gradient)[3 * i + 2] = -2 * (v * (zi - shapeZ)).sum();
+        }
+    }
+
+    return overlap;
+}
+
+// Returns the overlap volume between the gaussian at index and a
+// gaussian at position with exponent alpha.
+Real GaussianShapePrivate::gaussianOverlap(size_t index, const Point3 &position, Real alpha) const
+{
+    const Real scale = GaussianHeight * GaussianHeight * std::pow(chemkit::constants::Pi, Real(1.5));
+
+    Real sum = this->alpha[index] + alpha;
+    Real exponent = this->alpha[index] * alpha / sum;
+    Real distanceSquared = (Point3(x[index], y[index], z[index]) - position).squaredNorm();
+
+    return scale / (sum * std::sqrt(sum)) * std::exp(-exponent * distanceSquared);
+}
+
+// Maximizes the overlap between the gaussians moved by rotation and
+// translation and the gaussians in target by gradient ascent over
+// rigid body moves for at most steps steps. On return rotation and
+// translation contain the best transform found and its overlap is
+// returned.
+Real GaussianShapePrivate::optimize(const GaussianShapePrivate *target,
+                                    const OverlapTable &table,
+                                    Eigen::Matrix<Real, 3, 3> &rotation,
+                                    Vector3 &translation,
+                                    size_t steps) const
+{
+    GaussianShapePrivate moved;
+    moved.alpha = alpha;
+    moved.applyTransform(this, rotation, translation);
+
+    std::vector<Real> gradient;
+    std::vector<Real> newGradient;
+    Real overlap = moved.overlap(target, table, &gradient);
+
+    Real translationStep = InitialTranslationStep;
+    Real rotationStep = InitialRotationStep;
+
+    for(size_t step = 0; step < steps; step++){
+        // net force and torque about the center from the gradient
+        Point3 center = moved.center();
+        Vector3 force = Vector3::Zero();
+        Vector3 torque = Vector3::Zero();
+        for(size_t i = 0; i < moved.x.size(); i++){
+            Vector3 g(gradient[3 * i + 0], gradient[3 * i + 1], gradient[3 * i + 2]);
+
+            force += g;
+            torque += (Point3(moved.x[i], moved.y[i], moved.z[i]) - center).cross(g);
+        }
+
+        Real forceNorm = force.norm();
+        Real torqueNorm = torque.norm();
+        if(forceNorm < 1e-12 && torqueNorm < 1e-12){
+            break;
+        }
+
+        // take the largest step along the force and torque that
+        // increases the overlap
+        bool improved = false;
+        while(translationStep > MinimumStep || rotationStep > MinimumStep){
+            Eigen::Matrix<Real, 3, 3> stepRotation = Eigen::Matrix<Real, 3, 3>::Identity();
+            if(torqueNorm > 1e-12){
+                stepRotation = Eigen::AngleAxis<Real>(rotationStep, torque / torqueNorm).toRotationMatrix();
+            }
+
+            Vector3 stepTranslation = Vector3::Zero();
+            if(forceNorm > 1e-12){
+                stepTranslation = translationStep * force / forceNorm;
+            }
+
+            // rotate about the center and then translate
+            Eigen::Matrix<Real, 3, 3> newRotation = stepRotation * rotation;
+            Vector3 newTranslation = stepRotation * (translation - center) + center + stepTranslation;
+
+            moved.applyTransform(this, newRotation, newTranslation);
+            Real newOverlap = moved.overlap(target, table, &newGradient);
+
+            if(newOverlap > overlap){
+                improved = newOverlap - overlap > ConvergenceTolerance * overlap;
+                rotation = newRotation;
+                translation = newTranslation;
+                overlap = newOverlap;
+                gradient.swap(newGradient);
+                translationStep *= 1.5;
+                rotationStep *= 1.5;
+                break;
+            }
+
+            translationStep *= 0.5;
+            rotationStep *= 0.5;
+        }
+
+        if(!improved){
+            break;
+        }
+    }
+
+    return overlap;
+}
+
+// === GaussianShape ======================================================= //
+/// \class GaussianShape gaussianshape.h chemkit/gaussianshape.h
+/// \ingroup chemkit
+/// \brief The GaussianShape class represents the shape of a molecule
+///        as a set of atom-centered gaussians.
+///
+/// Each atom is represented by a spherical gaussian whose integral is
+/// equal to the volume of a sphere with the atom's van der Waals
+/// radius. The overlap volume between two shapes is calculated
+/// analytically from the pairwise overlaps of their gaussians,
+/// following the method of Grant and Pickup. The volume of a shape is
+/// taken as its overlap with itself.
+///
+/// The shape tanimoto coefficient between two shapes is calculated
+/// with tanimotoCoefficient(). It only compares the shapes in their
+/// current positions. The align() method first moves a shape to best
+/// overlap with another shape. The const methods do not modify the
+/// shape so one query shape can be compared with many other shapes
+/// from several threads at once.
+///
+/// For example, to calculate the shape similarity between two
+/// conformers:
+/// \code
+/// chemkit::GaussianShape query(queryMolecule);
+/// chemkit::GaussianShape shape(molecule);
+///
+/// chemkit::Real similarity = shape.align(&query);
+/// \endcode
+///
+/// \see MoleculeAligner
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new, empty shape.
+GaussianShape::GaussianShape()
+    : d(new GaussianShapePrivate)
+{
+}
+
+/// Creates a new shape with a gaussian for each heavy atom in
+/// \p molecule. Hydrogen atoms are not included.
+GaussianShape::GaussianShape(const Molecule *molecule)
+    : d(new GaussianShapePrivate)
+{
+    foreach(const Atom *atom, molecule->atoms()){
+        if(!atom->is(Atom::Hydrogen)){
+            addGaussian(atom->position(), atom->vanDerWaalsRadius());
+        }
+    }
+}
+
+/// Creates a new shape as a copy of \p shape.
+GaussianShape::GaussianShape(const GaussianShape &shape)
+    : d(new GaussianShapePrivate(*shape.d))
+{
+}
+
+/// Destroys the shape.
+GaussianShape::~GaussianShape()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the number of gaussians in the shape.
+size_t GaussianShape::size() const
+{
+    return d->x.size();
+}
+
+/// Returns \c true if the shape contains no gaussians.
+bool GaussianShape::isEmpty() const
+{
+    return size() == 0;
+}
+
+/// Returns the position of the gaussian at \p index.
+Point3 GaussianShape::position(size_t index) const
+{
+    return Point3(d->x[index], d->y[index], d->z[index]);
+}
+
+/// Returns the radius of the gaussian at \p index.
+Real GaussianShape::radius(size_t index) const
+{
+    return d->radii[index];
+}
+
+/// Returns the center of the gaussian positions.
+Point3 GaussianShape::center() const
+{
+    return d->center();
+}
+
+/// Returns the volume of the shape. This is equal to the overlap of
+/// the shape with itself and so includes the overlaps between the
+/// shape's own gaussians rather than subtracting them.
+Real GaussianShape::volume() const
+{
+    return d->volume;
+}
+
+// --- Shape --------------------------------------------------------------- //
+/// Adds a gaussian at \p position for a sphere with \p radius.
+void GaussianShape::addGaussian(const Point3 &position, Real radius)
+{
+    // choose the exponent so that the integral of the gaussian is
+    // equal to the volume of the sphere
+    Real sphereVolume = (4.0 / 3.0) * chemkit::constants::Pi * radius * radius * radius;
+    Real alpha = chemkit::constants::Pi * std::pow(GaussianHeight / sphereVolume, Real(2.0 / 3.0));
+
+    // the volume is updated here rather than when it is requested so
+    // that the const methods do not modify the shape. the new gaussian
+    // adds its overlap with itself and twice its overlap with each of
+    // the existing gaussians.
+    Real volumeChange = 0;
+    for(size_t i = 0; i < d->x.size(); i++){
+        volumeChange += 2 * d->gaussianOverlap(i, position, alpha);
+    }
+
+    d->x.push_back(position.x());
+    d->y.push_back(position.y());
+    d->z.push_back(position.z());
+    d->alpha.push_back(alpha);
+    d->radii.push_back(radius);
+    d->volume += volumeChange + d->gaussianOverlap(d->x.size() - 1, position, alpha);
+}
+
+/// Removes all of the gaussians from the shape.
+void GaussianShape::clear()
+{
+    d->x.clear();
+    d->y.clear();
+    d->z.clear();
+    d->alpha.clear();
+    d->radii.clear();
+    d->rotation.setIdentity();
+    d->translation.setZero();
+    d->volume = 0;
+}
+
+/// Moves the shape by \p rotation followed by \p translation.
+/// \p rotation must be a proper rotation matrix. The volume of the
+/// shape is not changed.
+void GaussianShape::transform(const Eigen::Matrix<Real, 3, 3> &rotation, const Vector3 &translation)
+{
+    GaussianShapePrivate source(*d);
+    d->applyTransform(&source, rotation, translation);
+
+    d->rotation = rotation * d->rotation;
+    d->translation = rotation * d->translation + translation;
+}
+
+/// Returns the rotation applied to the shape by transform() and
+/// align() since it was created.
+///
+/// A position \c p in the original shape is moved to
+/// <tt>rotationMatrix() * p + displacementVector()</tt>. This can be
+/// used to apply the same move to the molecule's atoms.
+Eigen::Matrix<Real, 3, 3> GaussianShape::rotationMatrix() const
+{
+    return d->rotation;
+}
+
+/// Returns the translation applied to the shape by transform() and
+/// align() since it was created.
+///
+/// \see rotationMatrix()
+Vector3 GaussianShape::displacementVector() const
+{
+    return d->translation;
+}
+
+// --- Similarity ---------------------------------------------------------- //
+/// Returns the overlap volume between the shape and \p shape.
+Real GaussianShape::overlap(const GaussianShape *shape) const
+{
+    return d->overlap(shape->d);
+}
+
+/// Returns the shape tanimoto coefficient between the shape and
+/// \p shape in their current positions. This is the overlap volume
+/// divided by the volume of their union and ranges from \c 0 for no
+/// overlap to \c 1 for identical shapes.
+Real GaussianShape::tanimotoCoefficient(const GaussianShape *shape) const
+{
+    Real overlap = this->overlap(shape);
+    Real union_ = volume() + shape->volume() - overlap;
+
+    return union_ > 0 ? overlap / union_ : Real(0);
+}
+
+/// Moves the shape to maximize its overlap with \p shape and returns
+/// the shape tanimoto coefficient between them.
+///
+/// The shapes are first superimposed by their centers and principal
+/// axes in each of the four right-handed orientations. The overlap
+/// from each starting orientation is improved by a few steps of
+/// gradient ascent over rotations and translations and then the best
+/// of these is optimized until it converges.
+Real GaussianShape::align(const GaussianShape *shape)
+{
+    if(isEmpty() || shape->isEmpty()){
+        return 0;
+    }
+
+    Point3 center = d->center();
+    Point3 targetCenter = shape->d->center();
+    Eigen::Matrix<Real, 3, 3> axes = d->principalAxes();
+    Eigen::Matrix<Real, 3, 3> targetAxes = shape->d->principalAxes();
+
+    static const Real flips[4][3] = {
+        {  1,  1,  1 },
+        {  1, -1, -1 },
+        { -1,  1, -1 },
+        { -1, -1,  1 }
+    };
+
+    OverlapTable table(d->alpha, shape->d->alpha);
+
+    Real bestOverlap = -1;
+    Eigen::Matrix<Real, 3, 3> bestRotation = Eigen::Matrix<Real, 3, 3>::Identity();
+    Vector3 bestTranslation = Vector3::Zero();
+
+    for(size_t i = 0; i < 4; i++){
+        Eigen::Matrix<Real, 3, 3> flip = Vector3(flips[i][0], flips[i][1], flips[i][2]).asDiagonal();
+
+        Eigen::Matrix<Real, 3, 3> rotation = targetAxes * flip * axes.transpose();
+        Vector3 translation = targetCenter - rotation * center;
+
+        Real overlap = d->optimize(shape->d, table, rotation, translation, StartingAlignmentSteps);
+        if(overlap > bestOverlap){
+            bestOverlap = overlap;
+            bestRotation = rotation;
+            bestTranslation = translation;
+        }
+    }
+
+    d->optimize(shape->d, table, bestRotation, bestTranslation, MaximumAlignmentSteps);
+
+    transform(bestRotation, bestTranslation);
+
+    return tanimotoCoefficient(shape);
+}
+
+// --- Operators ----------------------------------------------------------- //
+GaussianShape& GaussianShape::operator=(const GaussianShape &shape)
+{
+    if(this != &shape){
+        *d = *shape.d;
+    }
+
+    return *this;
+}
+
+} // end chemkit namespace
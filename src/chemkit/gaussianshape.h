@@ -0,0 +1,89 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_GAUSSIANSHAPE_H
+#define CHEMKIT_GAUSSIANSHAPE_H
+
+#include "chemkit.h"
+
+#include <Eigen/Core>
+
+#include "point3.h"
+#include "vector3.h"
+
+namespace chemkit {
+
+class Molecule;
+class GaussianShapePrivate;
+
+class CHEMKIT_EXPORT GaussianShape
+{
+public:
+    // construction and destruction
+    GaussianShape();
+    GaussianShape(const Molecule *molecule);
+    GaussianShape(const GaussianShape &shape);
+    ~GaussianShape();
+
+    // properties
+    size_t size() const;
+    bool isEmpty() const;
+    Point3 position(size_t index) const;
+    Real radius(size_t index) const;
+    Point3 center() const;
+    Real volume() const;
+
+    // shape
+    void addGaussian(const Point3 &position, Real radius);
+    void clear();
+    void transform(const Eigen::Matrix<Real, 3, 3> &rotation, const Vector3 &translation);
+    Eigen::Matrix<Real, 3, 3> rotationMatrix() const;
+    Vector3 displacementVector() const;
+
+    // similarity
+    Real overlap(const GaussianShape *shape) const;
+    Real tanimotoCoefficient(const GaussianShape *shape) const;
+    Real align(const GaussianShape *shape);
+
+    // operators
+    GaussianShape& operator=(const GaussianShape &shape);
+
+private:
+    GaussianShapePrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_GAUSSIANSHAPE_H
@@ -36,17 +36,65 @@
 #include "lineformat.h"
 
 #include <map>
+#include <limits>
 
 #include <boost/format.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include "foreach.h"
 #include "molecule.h"
 #include "variantmap.h"
+#include "concurrent.h"
 #include "pluginmanager.h"
 
 namespace chemkit {
 
+namespace {
+
+// minimum number of formulas for each extra thread used by readBatch()
+const size_t batchBlockSize = 64;
+
+// Parses a batch of formulas in parallel. Each worker thread uses its
+// own line format object, which keeps its parser state between
+// formulas. The first error seen by each worker is kept so that
+// readBatch() can report the error for the earliest formula that
+// failed.
+class BatchReader
+{
+public:
+    BatchReader(const std::vector<LineFormat *> &formats,
+                const std::vector<std::string> &formulas,
+                std::vector<Molecule *> &molecules,
+                std::vector<std::pair<size_t, std::string> > &errors)
+        : m_formats(formats),
+          m_formulas(formulas),
+          m_molecules(molecules),
+          m_errors(errors)
+    {
+    }
+
+    void operator()(size_t index, size_t thread) const
+    {
+        LineFormat *format = m_formats[thread];
+
+        m_molecules[index] = format->read(m_formulas[index]);
+
+        if(!m_molecules[index] && index < m_errors[thread].first){
+            m_errors[thread] = std::make_pair(index, format->errorString());
+        }
+    }
+
+private:
+    const std::vector<LineFormat *> &m_formats;
+    const std::vector<std::string> &m_formulas;
+    std::vector<Molecule *> &m_molecules;
+    std::vector<std::pair<size_t, std::string> > &m_errors;
+};
+
+} // end anonymous namespace
+
 // === LineFormatPrivate =================================================== //
 class LineFormatPrivate
 {
@@ -132,6 +180,62 @@ std::string LineFormat::write(const Molecule *molecule)
     return std::string();
 }
 
+/// Reads each formula in \p formulas and returns the molecules in
+/// the same order. The molecule for a formula that could not be read
+/// is \c 0 and errorString() describes the first such formula. The
+/// caller takes ownership of the returned molecules.
+///
+/// The formulas are read in parallel. Each thread reads with its own
+/// copy of the line format (with the same options) so line formats
+/// that keep parser state between calls to read() may reuse it.
+std::vector<Molecule *> LineFormat::readBatch(const std::vector<std::string> &formulas)
+{
+    std::vector<Molecule *> molecules(formulas.size());
+
+    // create a line format for each worker thread
+    size_t threadCount = std::min(concurrent::idealThreadCount(),
+                                  (formulas.size() + batchBlockSize - 1) / batchBlockSize);
+
+    std::vector<LineFormat *> formats(1, this);
+    while(formats.size() < threadCount){
+        LineFormat *format = create(name());
+        if(!format){
+            break;
+        }
+
+        foreach(const VariantMap::value_type &option, d->options){
+            format->setOption(option.first, option.second);
+        }
+
+        formats.push_back(format);
+    }
+
+    std::vector<std::pair<size_t, std::string> > errors(formats.size(),
+        std::make_pair(std::numeric_limits<size_t>::max(), std::string()));
+
+    concurrent::blockingForThreads(formulas.size(),
+                                    BatchReader(formats, formulas, molecules, errors),
+                                    formats.size());
+
+    for(size_t i = 1; i < formats.size(); i++){
+        delete formats[i];
+    }
+
+    // report the error for the earliest formula that failed
+    std::pair<size_t, std::string> firstError = errors[0];
+    for(size_t i = 1; i < errors.size(); i++){
+        if(errors[i].first < firstError.first){
+            firstError = errors[i];
+        }
+    }
+
+    if(firstError.first < formulas.size()){
+        setErrorString(firstError.second);
+    }
+
+    return molecules;
+}
+
 // --- Error Handling ------------------------------------------------------ //
 void LineFormat::setErrorString(const std::string &error)
 {
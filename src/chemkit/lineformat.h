@@ -65,6 +65,7 @@ public:
     // input and output
     virtual Molecule* read(const std::string &formula);
     virtual std::string write(const Molecule *molecule);
+    std::vector<Molecule *> readBatch(const std::vector<std::string> &formulas);
 
     // error handling
     std::string errorString() const;
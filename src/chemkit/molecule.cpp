@@ -316,18 +316,26 @@ Variant Molecule::descriptor(const std::string &name) const
 
 /// Returns the binary fingerprint for \p name.
 ///
+/// The fingerprint is cached in the molecule and later calls return
+/// the cached value until an atom or bond in the molecule is changed.
+///
 /// A list of supported fingerprints is available at:
 /// http://wiki.chemkit.org/Features#Fingerprints
 ///
-/// \see Fingerprint
+/// \see Fingerprint, Fingerprint::cachedValue()
 Bitset Molecule::fingerprint(const std::string &name) const
 {
+    std::map<std::string, Bitset>::const_iterator iter = d->fingerprints.find(name);
+    if(iter != d->fingerprints.end()){
+        return iter->second;
+    }
+
     boost::scoped_ptr<Fingerprint> fingerprint(Fingerprint::create(name));
     if(!fingerprint){
         return Bitset();
     }
 
-    return fingerprint->value(this);
+    return fingerprint->cachedValue(this);
 }
 
 /// Returns the total molar mass of the molecule. Mass is in g/mol.
@@ -358,6 +366,19 @@ Variant Molecule::data(const std::string &name) const
     return Variant();
 }
 
+/// Returns the names of all of the data set for the molecule.
+std::vector<std::string> Molecule::dataNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(d->data.size());
+
+    for(VariantMap::const_iterator iter = d->data.begin(); iter != d->data.end(); ++iter){
+        names.push_back(iter->first);
+    }
+
+    return names;
+}
+
 // --- Structure ----------------------------------------------------------- //
 /// Adds a new atom of the given \p element to the molecule.
 ///
@@ -1122,6 +1143,9 @@ void Molecule::notifyWatchers(MoleculeWatcher::ChangeType type)
 
 void Molecule::notifyWatchers(const Atom *atom, MoleculeWatcher::ChangeType type)
 {
+    // any change to an atom invalidates the cached fingerprints
+    d->fingerprints.clear();
+
     foreach(MoleculeWatcher *watcher, d->watchers){
         watcher->atomChanged(atom, type);
     }
@@ -1129,6 +1153,8 @@ void Molecule::notifyWatchers(const Atom *atom, MoleculeWatcher::ChangeType type
 
 void Molecule::notifyWatchers(const Bond *bond, MoleculeWatcher::ChangeType type)
 {
+    d->fingerprints.clear();
+
     foreach(MoleculeWatcher *watcher, d->watchers){
         watcher->bondChanged(bond, type);
     }
@@ -93,6 +93,7 @@ public:
     Real mass() const;
     void setData(const std::string &name, const Variant &value);
     Variant data(const std::string &name) const;
+    std::vector<std::string> dataNames() const;
 
     // structure
     Atom* addAtom(const Element &element);
@@ -182,6 +183,7 @@ private:
 
     friend class Atom;
     friend class Bond;
+    friend class Fingerprint;
     friend class MoleculeWatcher;
 
 private:
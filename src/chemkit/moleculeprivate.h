@@ -43,6 +43,7 @@
 #include <vector>
 
 #include "bond.h"
+#include "bitset.h"
 #include "point3.h"
 #include "isotope.h"
 #include "variantmap.h"
@@ -76,6 +77,7 @@ public:
     std::vector<std::vector<Bond *> > atomBonds;
     std::vector<Bond::BondOrderType> bondOrders;
     std::vector<boost::shared_ptr<CoordinateSet> > coordinateSets;
+    std::map<std::string, Bitset> fingerprints;
 };
 
 } // end chemkit namespace
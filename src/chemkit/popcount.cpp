@@ -0,0 +1,259 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "popcount.h"
+
+// The kernels are compiled twice on x86 with GCC and Clang: once for
+// any processor and once for processors with the popcnt instruction.
+// The version to use is chosen at run-time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CHEMKIT_POPCOUNT_DISPATCH
+    #define CHEMKIT_POPCOUNT_TARGET __attribute__((target("popcnt")))
+    #define CHEMKIT_POPCOUNT_INLINE inline __attribute__((always_inline))
+#else
+    #define CHEMKIT_POPCOUNT_INLINE inline
+#endif
+
+namespace chemkit {
+
+namespace popcount {
+
+namespace {
+
+// the number of words in the 1024-bit blocks used by FixedFingerprint
+// for the fp2 and pubchem fingerprints
+const size_t blockWordCount = 16;
+
+// Returns the number of set bits in word.
+CHEMKIT_POPCOUNT_INLINE size_t bitCount(boost::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+CHEMKIT_POPCOUNT_INLINE size_t countKernel(const boost::uint64_t *words, size_t size)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < size; i++){
+        count += bitCount(words[i]);
+    }
+
+    return count;
+}
+
+CHEMKIT_POPCOUNT_INLINE size_t intersectionCountKernel(const boost::uint64_t *a,
+                                                       const boost::uint64_t *b,
+                                                       size_t size)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < size; i++){
+        count += bitCount(a[i] & b[i]);
+    }
+
+    return count;
+}
+
+CHEMKIT_POPCOUNT_INLINE size_t unionCountKernel(const boost::uint64_t *a,
+                                                const boost::uint64_t *b,
+                                                size_t size)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < size; i++){
+        count += bitCount(a[i] | b[i]);
+    }
+
+    return count;
+}
+
+// Scores query against count fingerprints stored one after another.
+// Size is a compile-time constant for the common fingerprint widths
+// so that the inner loop is fully unrolled.
+template<size_t Size>
+CHEMKIT_POPCOUNT_INLINE void tanimotoKernel(const boost::uint64_t *query,
+                                            const boost::uint64_t *fingerprints,
+                                            size_t size,
+                                            size_t count,
+                                            Real *coefficients)
+{
+    if(Size != 0){
+        size = Size;
+    }
+
+    for(size_t i = 0; i < count; i++){
+        const boost::uint64_t *fingerprint = fingerprints + i * size;
+
+        size_t intersection = 0;
+        size_t union_ = 0;
+        for(size_t j = 0; j < size; j++){
+            intersection += bitCount(query[j] & fingerprint[j]);
+            union_ += bitCount(query[j] | fingerprint[j]);
+        }
+
+        coefficients[i] = union_ ? Real(intersection) / Real(union_) : Real(0);
+    }
+}
+
+CHEMKIT_POPCOUNT_INLINE void tanimotoKernel(const boost::uint64_t *query,
+                                            const boost::uint64_t *fingerprints,
+                                            size_t size,
+                                            size_t count,
+                                            Real *coefficients)
+{
+    if(size == blockWordCount){
+        tanimotoKernel<blockWordCount>(query, fingerprints, size, count, coefficients);
+    }
+    else{
+        tanimotoKernel<0>(query, fingerprints, size, count, coefficients);
+    }
+}
+
+#ifdef CHEMKIT_POPCOUNT_DISPATCH
+CHEMKIT_POPCOUNT_TARGET size_t countHardware(const boost::uint64_t *words, size_t size)
+{
+    return countKernel(words, size);
+}
+
+CHEMKIT_POPCOUNT_TARGET size_t intersectionCountHardware(const boost::uint64_t *a,
+                                                         const boost::uint64_t *b,
+                                                         size_t size)
+{
+    return intersectionCountKernel(a, b, size);
+}
+
+CHEMKIT_POPCOUNT_TARGET size_t unionCountHardware(const boost::uint64_t *a,
+                                                  const boost::uint64_t *b,
+                                                  size_t size)
+{
+    return unionCountKernel(a, b, size);
+}
+
+CHEMKIT_POPCOUNT_TARGET void tanimotoHardware(const boost::uint64_t *query,
+                                              const boost::uint64_t *fingerprints,
+                                              size_t size,
+                                              size_t count,
+                                              Real *coefficients)
+{
+    tanimotoKernel(query, fingerprints, size, count, coefficients);
+}
+
+// Returns true if the processor supports the popcnt instruction.
+bool hasPopcountInstruction()
+{
+    static const bool supported = __builtin_cpu_supports("popcnt");
+
+    return supported;
+}
+#endif
+
+} // end anonymous namespace
+
+/// Returns the number of set bits in the \p size words at \p words.
+size_t count(const boost::uint64_t *words, size_t size)
+{
+#ifdef CHEMKIT_POPCOUNT_DISPATCH
+    if(hasPopcountInstruction()){
+        return countHardware(words, size);
+    }
+#endif
+
+    return countKernel(words, size);
+}
+
+/// Returns the number of bits set in both \p a and \p b which are
+/// each \p size words long.
+size_t intersectionCount(const boost::uint64_t *a, const boost::uint64_t *b, size_t size)
+{
+#ifdef CHEMKIT_POPCOUNT_DISPATCH
+    if(hasPopcountInstruction()){
+        return intersectionCountHardware(a, b, size);
+    }
+#endif
+
+    return intersectionCountKernel(a, b, size);
+}
+
+/// Returns the number of bits set in either \p a or \p b which are
+/// each \p size words long.
+size_t unionCount(const boost::uint64_t *a, const boost::uint64_t *b, size_t size)
+{
+#ifdef CHEMKIT_POPCOUNT_DISPATCH
+    if(hasPopcountInstruction()){
+        return unionCountHardware(a, b, size);
+    }
+#endif
+
+    return unionCountKernel(a, b, size);
+}
+
+/// Returns the tanimoto coefficient between \p a and \p b which are
+/// each \p size words long. The coefficient is \c 0 if neither has
+/// any bits set.
+Real tanimotoCoefficient(const boost::uint64_t *a, const boost::uint64_t *b, size_t size)
+{
+    Real coefficient;
+    tanimotoCoefficients(a, b, size, 1, &coefficient);
+
+    return coefficient;
+}
+
+/// Calculates the tanimoto coefficient between \p query and each of
+/// the \p count fingerprints stored one after another at
+/// \p fingerprints and writes them to \p coefficients. The query and
+/// each fingerprint are \p size words long.
+void tanimotoCoefficients(const boost::uint64_t *query,
+                          const boost::uint64_t *fingerprints,
+                          size_t size,
+                          size_t count,
+                          Real *coefficients)
+{
+#ifdef CHEMKIT_POPCOUNT_DISPATCH
+    if(hasPopcountInstruction()){
+        tanimotoHardware(query, fingerprints, size, count, coefficients);
+        return;
+    }
+#endif
+
+    tanimotoKernel(query, fingerprints, size, count, coefficients);
+}
+
+} // end popcount namespace
+
+} // end chemkit namespace
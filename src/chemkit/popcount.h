@@ -0,0 +1,61 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_POPCOUNT_H
+#define CHEMKIT_POPCOUNT_H
+
+#include "chemkit.h"
+
+#include <boost/cstdint.hpp>
+
+namespace chemkit {
+
+namespace popcount {
+
+CHEMKIT_EXPORT size_t count(const boost::uint64_t *words, size_t size);
+CHEMKIT_EXPORT size_t intersectionCount(const boost::uint64_t *a, const boost::uint64_t *b, size_t size);
+CHEMKIT_EXPORT size_t unionCount(const boost::uint64_t *a, const boost::uint64_t *b, size_t size);
+CHEMKIT_EXPORT Real tanimotoCoefficient(const boost::uint64_t *a, const boost::uint64_t *b, size_t size);
+CHEMKIT_EXPORT void tanimotoCoefficients(const boost::uint64_t *query,
+                                         const boost::uint64_t *fingerprints,
+                                         size_t size,
+                                         size_t count,
+                                         Real *coefficients);
+
+} // end popcount namespace
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_POPCOUNT_H
@@ -0,0 +1,608 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "blockcompressedfile.h"
+
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+#ifndef CHEMKIT_OS_WIN32
+#include <boost/iostreams/filter/zlib.hpp>
+#endif
+
+#include <chemkit/concurrent.h>
+
+// A block compressed file is a series of gzip members (blocks) which
+// each hold at most 65280 bytes of uncompressed data. This is the
+// BGZF layout used by samtools and tabix, so the files can also be
+// read by any gzip tool. All values are stored little-endian. Each
+// block starts with a gzip header containing a "BC" extra field:
+//
+//   31 | 139 | 8 (deflate) | 4 (FEXTRA) | mtime (u32) | xfl (u8) | os (u8)
+//      | xlen = 6 (u16) | 'B' | 'C' | slen = 2 (u16) | block size - 1 (u16)
+//
+// followed by the raw deflate data and the gzip footer:
+//
+//   crc32 (u32) | uncompressed size (u32)
+//
+// Positions in the uncompressed data are given as virtual offsets
+// which store the offset of the block in the file in the upper 48
+// bits and the offset within the block's data in the lower 16 bits.
+
+namespace {
+
+const size_t HeaderSize = chemkit::BlockCompressedFile::HeaderSize;
+const size_t FooterSize = chemkit::BlockCompressedFile::FooterSize;
+
+// --- Binary Encoding ----------------------------------------------------- //
+void appendUInt16(std::string &data, boost::uint16_t value)
+{
+    data.push_back(static_cast<char>(value & 0xff));
+    data.push_back(static_cast<char>((value >> 8) & 0xff));
+}
+
+void appendUInt32(std::string &data, boost::uint32_t value)
+{
+    for(int i = 0; i < 4; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+boost::uint16_t readUInt16(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    return static_cast<boost::uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+boost::uint32_t readUInt32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint32_t value = 0;
+    for(int i = 3; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+// --- Block Decoding ------------------------------------------------------ //
+// Decompresses the block into data which must have room for the
+// block's uncompressed size.
+bool decompressBlock(const char *block, size_t blockSize, char *data)
+{
+#ifndef CHEMKIT_OS_WIN32
+    size_t dataSize = chemkit::BlockCompressedFile::blockDataSize(block, blockSize);
+
+    if(dataSize == 0){
+        return true;
+    }
+
+    try {
+        boost::iostreams::zlib_params parameters;
+        parameters.noheader = true;
+        parameters.calculate_crc = true;
+
+        boost::iostreams::filtering_istreambuf stream;
+        stream.push(boost::iostreams::zlib_decompressor(parameters));
+        stream.push(boost::iostreams::array_source(block + HeaderSize, blockSize - HeaderSize - FooterSize));
+
+        // the inflated data must be exactly the size in the footer
+        std::streamsize size = stream.sgetn(data, dataSize);
+        if(size != static_cast<std::streamsize>(dataSize) ||
+           stream.sgetc() != std::char_traits<char>::eof()){
+            return false;
+        }
+
+        // the crc is calculated by zlib as the data is decompressed
+        boost::uint32_t crc = stream.component<boost::iostreams::zlib_decompressor>(0)->crc();
+
+        return crc == readUInt32(block + blockSize - FooterSize);
+    }
+    catch(std::exception &){
+        return false;
+    }
+#else
+    CHEMKIT_UNUSED(block);
+    CHEMKIT_UNUSED(blockSize);
+    CHEMKIT_UNUSED(data);
+
+    return false;
+#endif
+}
+
+// Decompresses a set of blocks in parallel. Each block is written to
+// its own range of the output so the blocks are independent.
+class BlockDecompressor
+{
+public:
+    BlockDecompressor(const char *blocks,
+                      const std::vector<std::pair<size_t, size_t> > &offsets,
+                      char *data,
+                      std::vector<char> &failed)
+        : m_blocks(blocks),
+          m_offsets(offsets),
+          m_data(data),
+          m_failed(failed)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        size_t blockOffset = m_offsets[index].first;
+        size_t blockSize = m_offsets[index + 1].first - blockOffset;
+
+        if(!decompressBlock(m_blocks + blockOffset, blockSize, m_data + m_offsets[index].second)){
+            m_failed[index] = true;
+        }
+    }
+
+private:
+    const char *m_blocks;
+    const std::vector<std::pair<size_t, size_t> > &m_offsets;
+    char *m_data;
+    std::vector<char> &m_failed;
+};
+
+} // end anonymous namespace
+
+namespace chemkit {
+
+// === BlockCompressedFilePrivate ========================================== //
+class BlockCompressedFilePrivate
+{
+public:
+    std::string fileName;
+    boost::iostreams::mapped_file_source file;
+    boost::uint64_t blockOffset;
+    std::string block;
+    std::string errorString;
+};
+
+// === BlockCompressedFile ================================================= //
+/// \class BlockCompressedFile blockcompressedfile.h chemkit/blockcompressedfile.h
+/// \ingroup chemkit-io
+/// \brief The BlockCompressedFile class provides random access to
+///        block compressed files.
+///
+/// A block compressed file is a gzip file made of many small,
+/// independently compressed members called blocks. The files use
+/// the same layout as the BGZF files used by samtools and can be
+/// decompressed by any gzip tool. Block compressed files are written
+/// by appending the ".bgz" suffix to the file name when writing a
+/// file (see BlockCompressor).
+///
+/// Because each block can be decompressed on its own, data can be
+/// read from any position in the file by decompressing only the
+/// blocks that contain it. Positions in the uncompressed data are
+/// given as virtual offsets (see virtualOffset()). This is used by
+/// MoleculeFile to index and fetch records from compressed files.
+///
+/// The following example reads 100 bytes starting 20 bytes into the
+/// block at offset 1000 in the file:
+/// \code
+/// BlockCompressedFile file("library.sdf.bgz");
+/// file.open();
+///
+/// std::string data;
+/// file.read(BlockCompressedFile::virtualOffset(1000, 20), 100, data);
+/// \endcode
+///
+/// \see BlockCompressor, MoleculeFile::createIndex()
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new block compressed file object.
+BlockCompressedFile::BlockCompressedFile()
+    : d(new BlockCompressedFilePrivate)
+{
+    d->blockOffset = 0;
+}
+
+/// Creates a new block compressed file object for \p fileName.
+BlockCompressedFile::BlockCompressedFile(const std::string &fileName)
+    : d(new BlockCompressedFilePrivate)
+{
+    d->fileName = fileName;
+    d->blockOffset = 0;
+}
+
+/// Destroys the block compressed file object.
+BlockCompressedFile::~BlockCompressedFile()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Sets the file name to \p fileName.
+void BlockCompressedFile::setFileName(const std::string &fileName)
+{
+    d->fileName = fileName;
+}
+
+/// Returns the file name.
+std::string BlockCompressedFile::fileName() const
+{
+    return d->fileName;
+}
+
+/// Returns the size of the compressed file in bytes. Returns \c 0 if
+/// the file is not open.
+boost::uint64_t BlockCompressedFile::size() const
+{
+    return d->file.is_open() ? d->file.size() : 0;
+}
+
+// --- File ---------------------------------------------------------------- //
+/// Opens the file. Returns \c false if the file cannot be opened or
+/// if it is not block compressed.
+bool BlockCompressedFile::open()
+{
+    close();
+
+    if(d->fileName.empty()){
+        d->errorString = "No file name set for reading.";
+        return false;
+    }
+
+    try {
+        d->file.open(d->fileName);
+    }
+    catch(std::exception &){
+        d->errorString = "Failed to open file for reading.";
+        return false;
+    }
+
+    if(blockSize(0) == 0){
+        d->errorString = "File is not block compressed.";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+/// Opens the file with \p fileName.
+bool BlockCompressedFile::open(const std::string &fileName)
+{
+    setFileName(fileName);
+
+    return open();
+}
+
+/// Returns \c true if the file is open.
+bool BlockCompressedFile::isOpen() const
+{
+    return d->file.is_open();
+}
+
+/// Closes the file.
+void BlockCompressedFile::close()
+{
+    d->file.close();
+    d->block.clear();
+    d->blockOffset = 0;
+}
+
+// --- Blocks -------------------------------------------------------------- //
+/// Returns the compressed size of the block at \p offset in the
+/// file. Returns \c 0 if there is no valid block at \p offset.
+size_t BlockCompressedFile::blockSize(boost::uint64_t offset) const
+{
+    if(offset >= size()){
+        return 0;
+    }
+
+    return blockSize(d->file.data() + offset, static_cast<size_t>(size() - offset));
+}
+
+/// Returns the uncompressed size of the block at \p offset in the
+/// file. Returns \c 0 if there is no valid block at \p offset.
+size_t BlockCompressedFile::blockDataSize(boost::uint64_t offset) const
+{
+    size_t size = blockSize(offset);
+    if(size == 0){
+        return 0;
+    }
+
+    return blockDataSize(d->file.data() + offset, size);
+}
+
+/// Decompresses \p count blocks starting with the block at \p offset
+/// in the file and appends their data to \p data. The blocks are
+/// decompressed in parallel. Returns \c false if fewer than \p count
+/// blocks remain or if a block cannot be decompressed.
+bool BlockCompressedFile::readBlocks(boost::uint64_t offset, size_t count, std::string &data)
+{
+    boost::uint64_t end = offset;
+    for(size_t i = 0; i < count; i++){
+        size_t size = blockSize(end);
+        if(size == 0){
+            d->errorString = "Invalid compressed block.";
+            return false;
+        }
+
+        end += size;
+    }
+
+    if(count > 0 && !decompressBlocks(d->file.data() + offset, static_cast<size_t>(end - offset), data)){
+        d->errorString = "Failed to decompress block.";
+        return false;
+    }
+
+    return true;
+}
+
+// --- Input --------------------------------------------------------------- //
+/// Reads \p size bytes of uncompressed data starting at the virtual
+/// \p offset into \p data. Only the blocks containing the data are
+/// decompressed. Returns \c false if the data cannot be read.
+///
+/// The last block read is cached so reading nearby positions one
+/// after another only decompresses each block once.
+bool BlockCompressedFile::read(boost::uint64_t offset, size_t size, std::string &data)
+{
+    data.clear();
+
+    if(!isOpen()){
+        d->errorString = "File is not open for reading.";
+        return false;
+    }
+
+    boost::uint64_t blockOffset = offset >> 16;
+    size_t dataOffset = static_cast<size_t>(offset & 0xffff);
+
+    while(data.size() < size){
+        size_t blockSize = this->blockSize(blockOffset);
+        if(blockSize == 0){
+            d->errorString = "Invalid compressed block.";
+            return false;
+        }
+
+        if(d->block.empty() || d->blockOffset != blockOffset){
+            d->block.clear();
+
+            if(!decompressBlocks(d->file.data() + blockOffset, blockSize, d->block)){
+                d->block.clear();
+                d->errorString = "Failed to decompress block.";
+                return false;
+            }
+
+            d->blockOffset = blockOffset;
+        }
+
+        if(dataOffset > d->block.size()){
+            d->errorString = "Invalid virtual offset.";
+            return false;
+        }
+
+        size_t length = std::min(d->block.size() - dataOffset, size - data.size());
+        data.append(d->block, dataOffset, length);
+
+        blockOffset += blockSize;
+        dataOffset = 0;
+    }
+
+    return true;
+}
+
+// --- Error Handling ------------------------------------------------------ //
+/// Returns a string describing the last error that occurred.
+std::string BlockCompressedFile::errorString() const
+{
+    return d->errorString;
+}
+
+// --- Static Methods ------------------------------------------------------ //
+/// Returns the virtual offset for the position \p dataOffset bytes
+/// into the uncompressed data of the block at \p blockOffset in the
+/// file.
+boost::uint64_t BlockCompressedFile::virtualOffset(boost::uint64_t blockOffset, size_t dataOffset)
+{
+    return (blockOffset << 16) | (dataOffset & 0xffff);
+}
+
+/// Returns the compressed size of the block starting at \p block
+/// which has \p size bytes available. Returns \c 0 if \p block does
+/// not start with a valid block header, if the block is truncated or
+/// if its uncompressed size is larger than a block allows.
+size_t BlockCompressedFile::blockSize(const char *block, size_t size)
+{
+    if(!isBlockHeader(block, size)){
+        return 0;
+    }
+
+    size_t blockSize = readUInt16(block + 16) + 1;
+    if(blockSize < HeaderSize + FooterSize || blockSize > size){
+        return 0;
+    }
+
+    // the uncompressed size comes from the file so it is checked
+    // before any memory is allocated for it
+    if(blockDataSize(block, blockSize) > MaximumBlockSize){
+        return 0;
+    }
+
+    return blockSize;
+}
+
+/// Returns the uncompressed size of the block starting at \p block
+/// with the compressed size \p blockSize.
+size_t BlockCompressedFile::blockDataSize(const char *block, size_t blockSize)
+{
+    return readUInt32(block + blockSize - 4);
+}
+
+/// Compresses \p size bytes of \p data into a single block which is
+/// stored in \p block. Returns \c false if \p size is larger than
+/// MaximumDataSize.
+bool BlockCompressedFile::compressBlock(const char *data, size_t size, std::string &block)
+{
+    block.clear();
+
+    if(size > MaximumDataSize){
+        return false;
+    }
+
+#ifndef CHEMKIT_OS_WIN32
+    static const char header[] = {
+        31, static_cast<char>(139), 8, 4, 0, 0, 0, 0, 0, static_cast<char>(255), 6, 0, 'B', 'C', 2, 0
+    };
+
+    block.append(header, sizeof(header));
+    appendUInt16(block, 0);
+
+    boost::iostreams::zlib_params parameters;
+    parameters.noheader = true;
+    parameters.calculate_crc = true;
+
+    boost::iostreams::filtering_ostream stream;
+    stream.push(boost::iostreams::zlib_compressor(parameters));
+    stream.push(boost::iostreams::back_inserter(block));
+    stream.write(data, size);
+    stream.flush();
+
+    boost::uint32_t crc = stream.component<boost::iostreams::zlib_compressor>(0)->crc();
+    stream.reset();
+
+    appendUInt32(block, crc);
+    appendUInt32(block, static_cast<boost::uint32_t>(size));
+
+    // deflate never expands the data enough to overflow a block
+    if(block.size() > MaximumBlockSize){
+        block.clear();
+        return false;
+    }
+
+    // store the block size
+    boost::uint16_t blockSize = static_cast<boost::uint16_t>(block.size() - 1);
+    block[16] = static_cast<char>(blockSize & 0xff);
+    block[17] = static_cast<char>((blockSize >> 8) & 0xff);
+
+    return true;
+#else
+    CHEMKIT_UNUSED(data);
+
+    return false;
+#endif
+}
+
+/// Decompresses the blocks in the \p size bytes at \p blocks and
+/// appends their data to \p data. The blocks are decompressed in
+/// parallel. Returns \c false if \p blocks does not contain a whole
+/// number of valid blocks.
+bool BlockCompressedFile::decompressBlocks(const char *blocks, size_t size, std::string &data)
+{
+    // find the location of each block and its data
+    std::vector<std::pair<size_t, size_t> > offsets;
+
+    size_t blockOffset = 0;
+    size_t dataOffset = data.size();
+    while(blockOffset < size){
+        size_t blockSize = BlockCompressedFile::blockSize(blocks + blockOffset, size - blockOffset);
+        if(blockSize == 0){
+            return false;
+        }
+
+        offsets.push_back(std::make_pair(blockOffset, dataOffset));
+        blockOffset += blockSize;
+        dataOffset += blockDataSize(blocks + offsets.back().first, blockSize);
+    }
+
+    // end of the last block
+    offsets.push_back(std::make_pair(blockOffset, dataOffset));
+
+    size_t start = data.size();
+    data.resize(dataOffset);
+    if(data.size() == start){
+        return true;
+    }
+
+    size_t blockCount = offsets.size() - 1;
+    std::vector<char> failed(blockCount, false);
+    chemkit::concurrent::blockingFor(blockCount, BlockDecompressor(blocks, offsets, &data[0], failed));
+
+    if(std::find(failed.begin(), failed.end(), true) != failed.end()){
+        data.resize(start);
+        return false;
+    }
+
+    return true;
+}
+
+/// Returns \c true if the \p size bytes at \p data start with a
+/// block header.
+bool BlockCompressedFile::isBlockHeader(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    return size >= HeaderSize &&
+           bytes[0] == 31 &&
+           bytes[1] == 139 &&
+           bytes[2] == 8 &&
+           (bytes[3] & 4) != 0 &&
+           readUInt16(data + 10) == 6 &&
+           bytes[12] == 'B' &&
+           bytes[13] == 'C' &&
+           readUInt16(data + 14) == 2;
+}
+
+/// Returns \c true if the file with \p fileName is block compressed.
+bool BlockCompressedFile::isBlockCompressed(const std::string &fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+    if(!file.is_open()){
+        return false;
+    }
+
+    char header[HeaderSize];
+    file.read(header, HeaderSize);
+    if(file.gcount() != static_cast<std::streamsize>(HeaderSize)){
+        return false;
+    }
+
+    return isBlockHeader(header, HeaderSize);
+}
+
+} // end chemkit namespace
@@ -0,0 +1,102 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_BLOCKCOMPRESSEDFILE_H
+#define CHEMKIT_BLOCKCOMPRESSEDFILE_H
+
+#include "io.h"
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+namespace chemkit {
+
+class BlockCompressedFilePrivate;
+
+class CHEMKIT_IO_EXPORT BlockCompressedFile
+{
+public:
+    // constants
+    enum {
+        HeaderSize = 18,
+        FooterSize = 8,
+        MaximumBlockSize = 65536,
+        MaximumDataSize = 65280
+    };
+
+    // construction and destruction
+    BlockCompressedFile();
+    BlockCompressedFile(const std::string &fileName);
+    ~BlockCompressedFile();
+
+    // properties
+    void setFileName(const std::string &fileName);
+    std::string fileName() const;
+    boost::uint64_t size() const;
+
+    // file
+    bool open();
+    bool open(const std::string &fileName);
+    bool isOpen() const;
+    void close();
+
+    // blocks
+    size_t blockSize(boost::uint64_t offset) const;
+    size_t blockDataSize(boost::uint64_t offset) const;
+    bool readBlocks(boost::uint64_t offset, size_t count, std::string &data);
+
+    // input
+    bool read(boost::uint64_t offset, size_t size, std::string &data);
+
+    // error handling
+    std::string errorString() const;
+
+    // static methods
+    static boost::uint64_t virtualOffset(boost::uint64_t blockOffset, size_t dataOffset);
+    static size_t blockSize(const char *block, size_t size);
+    static size_t blockDataSize(const char *block, size_t blockSize);
+    static bool compressBlock(const char *data, size_t size, std::string &block);
+    static bool decompressBlocks(const char *blocks, size_t size, std::string &data);
+    static bool isBlockHeader(const char *data, size_t size);
+    static bool isBlockCompressed(const std::string &fileName);
+
+private:
+    BlockCompressedFilePrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_BLOCKCOMPRESSEDFILE_H
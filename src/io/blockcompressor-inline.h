@@ -0,0 +1,71 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_BLOCKCOMPRESSOR_INLINE_H
+#define CHEMKIT_BLOCKCOMPRESSOR_INLINE_H
+
+#include "blockcompressor.h"
+
+namespace chemkit {
+
+// --- Output -------------------------------------------------------------- //
+/// Compresses \p size bytes of \p data and writes the compressed
+/// blocks to \p sink. Data is buffered until enough has been written
+/// to compress several blocks at once.
+template<typename Sink>
+inline std::streamsize BlockCompressor::write(Sink &sink, const char *data, std::streamsize size)
+{
+    m_buffer.append(data, size);
+
+    if(m_buffer.size() >= BatchSize){
+        compress(m_output, false);
+        boost::iostreams::write(sink, m_output.data(), m_output.size());
+    }
+
+    return size;
+}
+
+/// Compresses the remaining data and writes it to \p sink followed
+/// by the empty end of file block.
+template<typename Sink>
+inline void BlockCompressor::close(Sink &sink)
+{
+    compress(m_output, true);
+    boost::iostreams::write(sink, m_output.data(), m_output.size());
+}
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_BLOCKCOMPRESSOR_INLINE_H
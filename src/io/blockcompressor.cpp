@@ -0,0 +1,140 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "blockcompressor.h"
+
+#include <ios>
+#include <vector>
+#include <algorithm>
+
+#include <chemkit/concurrent.h>
+
+namespace {
+
+// The empty block written at the end of block compressed files. This
+// is the same end of file marker written by samtools.
+const char EndOfFileBlock[] = "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43"
+                              "\x02\x00\x1b\x00\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00";
+const size_t EndOfFileBlockSize = 28;
+
+// Compresses the data for a set of blocks in parallel.
+class BlockWriter
+{
+public:
+    BlockWriter(const std::string &data, std::vector<std::string> &blocks, std::vector<char> &failed)
+        : m_data(data),
+          m_blocks(blocks),
+          m_failed(failed)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        size_t offset = index * chemkit::BlockCompressedFile::MaximumDataSize;
+        size_t size = std::min(m_data.size() - offset, size_t(chemkit::BlockCompressedFile::MaximumDataSize));
+
+        if(!chemkit::BlockCompressedFile::compressBlock(m_data.data() + offset, size, m_blocks[index])){
+            m_failed[index] = true;
+        }
+    }
+
+private:
+    const std::string &m_data;
+    std::vector<std::string> &m_blocks;
+    std::vector<char> &m_failed;
+};
+
+} // end anonymous namespace
+
+namespace chemkit {
+
+// === BlockCompressor ===================================================== //
+/// \class BlockCompressor blockcompressor.h chemkit/blockcompressor.h
+/// \ingroup chemkit-io
+/// \brief The BlockCompressor class writes block compressed data.
+///
+/// The BlockCompressor class is a boost::iostreams output filter
+/// which compresses data into the block compressed format read by
+/// the BlockCompressedFile class. The output is a valid gzip file.
+/// Several blocks are compressed in parallel at a time.
+///
+/// The compressor is used by the file classes when writing files
+/// with the ".bgz" suffix:
+/// \code
+/// boost::iostreams::filtering_ostream stream;
+/// stream.push(BlockCompressor());
+/// stream.push(output);
+/// \endcode
+///
+/// \see BlockCompressedFile
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new block compressor.
+BlockCompressor::BlockCompressor()
+{
+}
+
+// --- Internal Methods ---------------------------------------------------- //
+// Compresses the buffered data into output. Unless flush is true, data
+// that does not fill a whole block is kept in the buffer.
+void BlockCompressor::compress(std::string &output, bool flush)
+{
+    output.clear();
+
+    size_t blockCount = m_buffer.size() / BlockCompressedFile::MaximumDataSize;
+    if(flush && m_buffer.size() % BlockCompressedFile::MaximumDataSize != 0){
+        blockCount++;
+    }
+
+    std::vector<std::string> blocks(blockCount);
+    std::vector<char> failed(blockCount, false);
+    chemkit::concurrent::blockingFor(blockCount, BlockWriter(m_buffer, blocks, failed));
+
+    for(size_t i = 0; i < blockCount; i++){
+        if(failed[i]){
+            throw std::ios_base::failure("Failed to compress block.");
+        }
+
+        output += blocks[i];
+    }
+
+    m_buffer.erase(0, std::min(m_buffer.size(), blockCount * BlockCompressedFile::MaximumDataSize));
+
+    if(flush){
+        output.append(EndOfFileBlock, EndOfFileBlockSize);
+    }
+}
+
+} // end chemkit namespace
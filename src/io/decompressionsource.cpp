@@ -0,0 +1,476 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "decompressionsource.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+#ifndef CHEMKIT_OS_WIN32
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#endif
+
+#include <chemkit/concurrent.h>
+
+#include "blockcompressedfile.h"
+
+namespace chemkit {
+
+// === DecompressionSourcePrivate ========================================== //
+// The decompressed data is passed from the decompression thread to the
+// reader through a ring of buffers. The decompression thread fills the
+// buffer at writeIndex while the reader consumes the buffer at
+// readIndex. filledCount is the number of buffers that have been
+// filled and not yet completely consumed.
+//
+// Block compressed gzip files are decompressed several blocks at a
+// time in parallel. The header of the first block is read to detect
+// them and is then passed on to the decompressor as the start of the
+// input.
+class DecompressionSourcePrivate
+{
+public:
+    // reads the input through readInput()
+    class InputSource : public boost::iostreams::source
+    {
+    public:
+        InputSource(DecompressionSourcePrivate *d)
+            : d(d)
+        {
+        }
+
+        std::streamsize read(char *data, std::streamsize size)
+        {
+            size_t count = d->readInput(data, static_cast<size_t>(size));
+
+            return count > 0 ? static_cast<std::streamsize>(count) : -1;
+        }
+
+    private:
+        DecompressionSourcePrivate *d;
+    };
+
+    DecompressionSourcePrivate(std::istream &input,
+                               const std::string &format,
+                               size_t bufferSize,
+                               size_t bufferCount);
+    ~DecompressionSourcePrivate();
+
+    void run();
+    void decompressStream();
+    void decompressBlocks();
+    bool readBlock(std::string &blocks, size_t &dataSize);
+    std::string* nextBuffer();
+    void fillBuffer();
+    void finish(const std::string &error);
+    size_t readInput(char *data, size_t size);
+
+    std::istream &input;
+    std::string format;
+    std::string header;
+    size_t headerPosition;
+    size_t bufferSize;
+    std::vector<std::string> buffers;
+    size_t readIndex;
+    size_t readPosition;
+    size_t writeIndex;
+    size_t filledCount;
+    bool reading;
+    bool finished;
+    bool stopped;
+    std::string errorString;
+    boost::mutex mutex;
+    boost::condition_variable bufferFilled;
+    boost::condition_variable bufferConsumed;
+    boost::scoped_ptr<boost::thread> thread;
+};
+
+DecompressionSourcePrivate::DecompressionSourcePrivate(std::istream &input,
+                                                       const std::string &format,
+                                                       size_t bufferSize,
+                                                       size_t bufferCount)
+    : input(input),
+      format(format),
+      headerPosition(0),
+      bufferSize(std::max(bufferSize, size_t(1))),
+      buffers(std::max(bufferCount, size_t(2))),
+      readIndex(0),
+      readPosition(0),
+      writeIndex(0),
+      filledCount(0),
+      reading(false),
+      finished(false),
+      stopped(false)
+{
+}
+
+DecompressionSourcePrivate::~DecompressionSourcePrivate()
+{
+    if(thread){
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            stopped = true;
+            bufferConsumed.notify_all();
+        }
+
+        thread->join();
+    }
+}
+
+// Decompresses the input into the buffers until the end of the input
+// is reached, an error occurs or the source is destroyed.
+void DecompressionSourcePrivate::run()
+{
+    try {
+        if(format == "gz" || format == "bgz"){
+            header.resize(BlockCompressedFile::HeaderSize);
+            input.read(&header[0], header.size());
+            header.resize(std::max(input.gcount(), std::streamsize(0)));
+
+            if(BlockCompressedFile::isBlockHeader(header.data(), header.size())){
+                decompressBlocks();
+                return;
+            }
+        }
+
+        decompressStream();
+    }
+    catch(std::exception &e){
+        finish(e.what());
+    }
+}
+
+void DecompressionSourcePrivate::decompressStream()
+{
+    boost::iostreams::filtering_istreambuf stream;
+
+#ifndef CHEMKIT_OS_WIN32
+    if(format == "gz" || format == "bgz"){
+        stream.push(boost::iostreams::gzip_decompressor());
+    }
+    else if(format == "bz2"){
+        stream.push(boost::iostreams::bzip2_decompressor());
+    }
+#endif
+
+    if(stream.empty()){
+        finish("Unsupported compression format '" + format + "'.");
+        return;
+    }
+
+    stream.push(InputSource(this));
+
+    for(;;){
+        std::string *buffer = nextBuffer();
+        if(!buffer){
+            return;
+        }
+
+        // fill the buffer without holding the lock so that the
+        // reader can consume the other buffers in the meantime
+        buffer->resize(bufferSize);
+        std::streamsize size = stream.sgetn(&(*buffer)[0], bufferSize);
+        buffer->resize(std::max(size, std::streamsize(0)));
+
+        if(buffer->empty()){
+            finish(std::string());
+            return;
+        }
+
+        fillBuffer();
+    }
+}
+
+// Reads enough blocks to keep each thread busy and then decompresses
+// them in parallel into the next buffer.
+void DecompressionSourcePrivate::decompressBlocks()
+{
+    size_t batchSize = std::max(bufferSize,
+                                concurrent::idealThreadCount() * 4 * BlockCompressedFile::MaximumDataSize);
+
+    std::string blocks;
+    bool end = false;
+
+    while(!end){
+        std::string *buffer = nextBuffer();
+        if(!buffer){
+            return;
+        }
+
+        // read blocks without holding the lock
+        blocks.clear();
+        size_t dataSize = 0;
+        while(dataSize < batchSize){
+            if(!readBlock(blocks, dataSize)){
+                end = true;
+                break;
+            }
+        }
+
+        buffer->clear();
+        if(!BlockCompressedFile::decompressBlocks(blocks.data(), blocks.size(), *buffer)){
+            finish("Failed to decompress block.");
+            return;
+        }
+
+        if(!buffer->empty()){
+            fillBuffer();
+        }
+    }
+
+    finish(std::string());
+}
+
+// Reads the next block from the input and appends it to blocks. The
+// size of the block's data is added to dataSize. Returns false at the
+// end of the input.
+bool DecompressionSourcePrivate::readBlock(std::string &blocks, size_t &dataSize)
+{
+    size_t start = blocks.size();
+
+    blocks.resize(start + BlockCompressedFile::HeaderSize);
+    size_t size = readInput(&blocks[start], BlockCompressedFile::HeaderSize);
+    if(size == 0){
+        blocks.resize(start);
+        return false;
+    }
+    else if(!BlockCompressedFile::isBlockHeader(&blocks[start], size)){
+        throw std::ios_base::failure("Invalid compressed block.");
+    }
+
+    size_t blockSize = static_cast<unsigned char>(blocks[start + 16]) |
+                       (static_cast<unsigned char>(blocks[start + 17]) << 8);
+    blockSize++;
+
+    blocks.resize(start + blockSize);
+    size_t remaining = blockSize - BlockCompressedFile::HeaderSize;
+    if(blockSize < BlockCompressedFile::HeaderSize + BlockCompressedFile::FooterSize ||
+       readInput(&blocks[start + BlockCompressedFile::HeaderSize], remaining) != remaining){
+        throw std::ios_base::failure("Truncated compressed block.");
+    }
+
+    dataSize += BlockCompressedFile::blockDataSize(&blocks[start], blockSize);
+
+    return true;
+}
+
+// Waits for a free buffer and returns it. Returns 0 if the source
+// has been destroyed.
+std::string* DecompressionSourcePrivate::nextBuffer()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    while(filledCount == buffers.size() && !stopped){
+        bufferConsumed.wait(lock);
+    }
+
+    if(stopped){
+        return 0;
+    }
+
+    return &buffers[writeIndex];
+}
+
+// Passes the buffer returned by nextBuffer() to the reader.
+void DecompressionSourcePrivate::fillBuffer()
+{
+    boost::mutex::scoped_lock lock(mutex);
+    writeIndex = (writeIndex + 1) % buffers.size();
+    filledCount++;
+    bufferFilled.notify_one();
+}
+
+void DecompressionSourcePrivate::finish(const std::string &error)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    errorString = error;
+    finished = true;
+    bufferFilled.notify_one();
+}
+
+// Reads up to size bytes from the input into data, starting with the
+// header read by run(). Returns the number of bytes read.
+size_t DecompressionSourcePrivate::readInput(char *data, size_t size)
+{
+    size_t count = std::min(size, header.size() - headerPosition);
+    std::memcpy(data, header.data() + headerPosition, count);
+    headerPosition += count;
+
+    if(count < size && input.good()){
+        input.read(data + count, size - count);
+        count += std::max(input.gcount(), std::streamsize(0));
+    }
+
+    return count;
+}
+
+// === DecompressionSource ================================================= //
+/// \class DecompressionSource decompressionsource.h chemkit/decompressionsource.h
+/// \ingroup chemkit-io
+/// \brief The DecompressionSource class decompresses an input stream
+///        in a separate thread.
+///
+/// The DecompressionSource class is a boost::iostreams source which
+/// reads compressed data from an input stream and decompresses it in
+/// a background thread. The decompressed data is passed to the reader
+/// through a ring of buffers so that reading the file, decompressing
+/// it and parsing the decompressed data all overlap.
+///
+/// Both gzip ("gz") and bzip2 ("bz2") compression are supported.
+/// Files made of several concatenated compressed members (such as
+/// those written by appending to a gzip file) are decompressed as a
+/// single stream. Block compressed gzip files ("bgz", see
+/// BlockCompressedFile) are detected automatically and their blocks
+/// are decompressed in parallel.
+///
+/// The source is used by the file classes when reading compressed
+/// files:
+/// \code
+/// boost::iostreams::filtering_istream stream;
+/// stream.push(DecompressionSource(input, "gz"));
+/// \endcode
+///
+/// Copies of a source share the same decompression thread. The input
+/// stream must remain valid until the last copy is destroyed.
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new source which decompresses \p input using the
+/// compression \p format. The decompressed data is buffered in
+/// \p bufferCount buffers of \p bufferSize bytes.
+///
+/// The decompression thread is started by the first call to read().
+DecompressionSource::DecompressionSource(std::istream &input,
+                                         const std::string &format,
+                                         size_t bufferSize,
+                                         size_t bufferCount)
+    : d(new DecompressionSourcePrivate(input, format, bufferSize, bufferCount))
+{
+}
+
+/// Destroys the source. The decompression thread is stopped when the
+/// last copy of the source is destroyed.
+DecompressionSource::~DecompressionSource()
+{
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the compression format.
+std::string DecompressionSource::format() const
+{
+    return d->format;
+}
+
+// --- Input --------------------------------------------------------------- //
+/// Reads up to \p size bytes of decompressed data into \p data.
+/// Returns the number of bytes read or \c -1 if the end of the data
+/// has been reached.
+///
+/// Throws std::ios_base::failure if the input cannot be decompressed.
+std::streamsize DecompressionSource::read(char *data, std::streamsize size)
+{
+    if(!d->thread){
+        d->thread.reset(new boost::thread(boost::bind(&DecompressionSourcePrivate::run, d.get())));
+    }
+
+    std::streamsize count = 0;
+
+    while(count < size){
+        // move to the next filled buffer
+        if(!d->reading){
+            boost::mutex::scoped_lock lock(d->mutex);
+
+            // return the data read so far instead of waiting
+            if(d->filledCount == 0 && count > 0){
+                break;
+            }
+
+            while(d->filledCount == 0 && !d->finished){
+                d->bufferFilled.wait(lock);
+            }
+
+            if(d->filledCount == 0){
+                if(count == 0 && !d->errorString.empty()){
+                    throw std::ios_base::failure(d->errorString);
+                }
+
+                break;
+            }
+
+            d->reading = true;
+            d->readPosition = 0;
+        }
+
+        const std::string &buffer = d->buffers[d->readIndex];
+        size_t available = buffer.size() - d->readPosition;
+        size_t length = std::min(available, static_cast<size_t>(size - count));
+
+        std::memcpy(data + count, &buffer[d->readPosition], length);
+        d->readPosition += length;
+        count += length;
+
+        // release the buffer to the decompression thread
+        if(d->readPosition == buffer.size()){
+            boost::mutex::scoped_lock lock(d->mutex);
+            d->readIndex = (d->readIndex + 1) % d->buffers.size();
+            d->filledCount--;
+            d->reading = false;
+            d->bufferConsumed.notify_one();
+        }
+    }
+
+    return count > 0 ? count : -1;
+}
+
+// --- Static Methods ------------------------------------------------------ //
+/// Returns \c true if the compression \p format is supported.
+bool DecompressionSource::isSupported(const std::string &format)
+{
+#ifndef CHEMKIT_OS_WIN32
+    return format == "gz" || format == "bgz" || format == "bz2";
+#else
+    CHEMKIT_UNUSED(format);
+
+    return false;
+#endif
+}
+
+} // end chemkit namespace
@@ -0,0 +1,692 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintdatabase.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <chemkit/fingerprintindex.h>
+
+#include "textwriter.h"
+
+// Fingerprint databases are stored in a binary file which can be
+// searched in place after it has been memory-mapped. The file starts
+// with a header, with all values stored little-endian:
+//
+//   "CKFD" | version (u32) | fingerprint count (u64)
+//          | type offset (u64) | type size (u64)
+//          | index offset (u64) | index size (u64)
+//          | names offset (u64) | names size (u64)
+//
+// followed by the fingerprint type string, the fingerprint index as
+// written by FingerprintIndex::write() and the name table. The name
+// table is an array of count + 1 offsets (u64) followed by the names
+// stored back to back. Each section starts on a 64-byte boundary.
+// The index and name table are stored in the byte order of the
+// machine that wrote the file.
+
+namespace chemkit {
+
+namespace {
+
+const char FileMagic[] = "CKFD";
+const boost::uint32_t FormatVersion = 1;
+
+const size_t HeaderSize = 64;
+
+// --- Binary Encoding ----------------------------------------------------- //
+void appendUInt32(std::string &data, boost::uint32_t value)
+{
+    for(int i = 0; i < 4; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void appendUInt64(std::string &data, boost::uint64_t value)
+{
+    for(int i = 0; i < 8; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+boost::uint32_t readUInt32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint32_t value = 0;
+    for(int i = 3; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+boost::uint64_t readUInt64(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint64_t value = 0;
+    for(int i = 7; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+// Returns size rounded up to a whole number of 64-byte cache lines.
+boost::uint64_t alignedSize(boost::uint64_t size)
+{
+    return (size + 63) & ~boost::uint64_t(63);
+}
+
+// --- FPS Encoding -------------------------------------------------------- //
+const char hexDigits[] = "0123456789abcdef";
+
+// Returns the value of the hex digit or -1 if it is not a hex digit.
+int hexValue(char digit)
+{
+    if(digit >= '0' && digit <= '9'){
+        return digit - '0';
+    }
+    else if(digit >= 'a' && digit <= 'f'){
+        return digit - 'a' + 10;
+    }
+    else if(digit >= 'A' && digit <= 'F'){
+        return digit - 'A' + 10;
+    }
+
+    return -1;
+}
+
+// Decodes the hex encoded fingerprint in the size characters at hex
+// into words. The first byte holds the first eight bits of the
+// fingerprint with the first bit in its least significant bit.
+bool decodeHex(const char *hex, size_t size, std::vector<boost::uint64_t> &words)
+{
+    std::fill(words.begin(), words.end(), 0);
+
+    for(size_t i = 0; i < size / 2; i++){
+        int high = hexValue(hex[2 * i]);
+        int low = hexValue(hex[2 * i + 1]);
+        if(high < 0 || low < 0){
+            return false;
+        }
+
+        words[i / 8] |= boost::uint64_t((high << 4) | low) << (8 * (i % 8));
+    }
+
+    return true;
+}
+
+} // end anonymous namespace
+
+// === FingerprintDatabasePrivate ========================================== //
+class FingerprintDatabasePrivate
+{
+public:
+    void detach();
+
+    std::string fileName;
+    std::string type;
+    std::string errorString;
+    boost::scoped_ptr<FingerprintIndex> index;
+
+    // names of the fingerprints when the database is not mapped
+    std::vector<std::string> names;
+
+    // the mapped file and its name table
+    boost::iostreams::mapped_file_source file;
+    const boost::uint64_t *nameOffsets;
+    const char *nameData;
+};
+
+// Copies the contents of the mapped file to memory and closes it.
+void FingerprintDatabasePrivate::detach()
+{
+    if(!file.is_open()){
+        return;
+    }
+
+    size_t count = index->size();
+
+    names.resize(count);
+    for(size_t i = 0; i < count; i++){
+        names[i].assign(nameData + nameOffsets[i], nameData + nameOffsets[i + 1]);
+    }
+
+    // reserving space copies the index data
+    index->reserve(count);
+
+    file.close();
+    nameOffsets = 0;
+    nameData = 0;
+}
+
+// === FingerprintDatabase ================================================= //
+/// \class FingerprintDatabase fingerprintdatabase.h chemkit/fingerprintdatabase.h
+/// \ingroup chemkit-io
+/// \brief The FingerprintDatabase class contains a collection of
+///        named fingerprints.
+///
+/// Fingerprint databases can be read from and written to files in
+/// the FPS format or in a binary format. Binary files are
+/// memory-mapped when read and are searched in place by index()
+/// without being loaded first.
+///
+/// For example, to find the molecules in a database that are similar
+/// to a query fingerprint:
+/// \code
+/// chemkit::FingerprintDatabase database("molecules.fpdb");
+/// database.read();
+///
+/// std::vector<chemkit::FingerprintIndex::Match> matches =
+///     database.index()->search(query, 0.8);
+///
+/// foreach(const chemkit::FingerprintIndex::Match &match, matches){
+///     std::cout << database.name(match.first) << std::endl;
+/// }
+/// \endcode
+///
+/// \see FingerprintIndex
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new, empty fingerprint database.
+FingerprintDatabase::FingerprintDatabase()
+    : d(new FingerprintDatabasePrivate)
+{
+    d->index.reset(new FingerprintIndex(0));
+    d->nameOffsets = 0;
+    d->nameData = 0;
+}
+
+/// Creates a new, empty fingerprint database with \p fileName.
+FingerprintDatabase::FingerprintDatabase(const std::string &fileName)
+    : d(new FingerprintDatabasePrivate)
+{
+    d->fileName = fileName;
+    d->index.reset(new FingerprintIndex(0));
+    d->nameOffsets = 0;
+    d->nameData = 0;
+}
+
+/// Destroys the fingerprint database.
+FingerprintDatabase::~FingerprintDatabase()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Sets the file name for the database to \p fileName.
+void FingerprintDatabase::setFileName(const std::string &fileName)
+{
+    d->fileName = fileName;
+}
+
+/// Returns the file name for the database.
+std::string FingerprintDatabase::fileName() const
+{
+    return d->fileName;
+}
+
+/// Returns the number of fingerprints in the database.
+size_t FingerprintDatabase::size() const
+{
+    return d->index->size();
+}
+
+/// Returns \c true if the database contains no fingerprints.
+bool FingerprintDatabase::isEmpty() const
+{
+    return size() == 0;
+}
+
+/// Returns the number of bits in each fingerprint in the database.
+size_t FingerprintDatabase::fingerprintSize() const
+{
+    return d->index->fingerprintSize();
+}
+
+/// Sets the type of the fingerprints in the database to \p type
+/// (e.g. "chemkit-FP2/1").
+void FingerprintDatabase::setType(const std::string &type)
+{
+    d->type = type;
+}
+
+/// Returns the type of the fingerprints in the database.
+std::string FingerprintDatabase::type() const
+{
+    return d->type;
+}
+
+// --- Fingerprints -------------------------------------------------------- //
+/// Adds \p fingerprint with \p name to the database and returns its
+/// index. The fingerprint size of an empty database is set to the
+/// size of the first fingerprint added.
+size_t FingerprintDatabase::addFingerprint(const Bitset &fingerprint, const std::string &name)
+{
+    if(isEmpty() && fingerprint.size() != fingerprintSize()){
+        clear();
+        d->index.reset(new FingerprintIndex(fingerprint.size()));
+    }
+
+    d->detach();
+    d->names.push_back(name);
+
+    return d->index->addFingerprint(fingerprint);
+}
+
+/// Returns the fingerprint at \p index.
+Bitset FingerprintDatabase::fingerprint(size_t index) const
+{
+    return d->index->fingerprint(index);
+}
+
+/// Returns the name of the fingerprint at \p index.
+std::string FingerprintDatabase::name(size_t index) const
+{
+    if(d->file.is_open()){
+        return std::string(d->nameData + d->nameOffsets[index],
+                           d->nameData + d->nameOffsets[index + 1]);
+    }
+
+    return d->names[index];
+}
+
+/// Returns the similarity index for the fingerprints in the
+/// database. The index of each fingerprint in the index is the same
+/// as its index in the database.
+const FingerprintIndex* FingerprintDatabase::index() const
+{
+    return d->index.get();
+}
+
+/// Removes all of the fingerprints from the database.
+void FingerprintDatabase::clear()
+{
+    d->index->clear();
+    d->names.clear();
+    d->file.close();
+    d->nameOffsets = 0;
+    d->nameData = 0;
+}
+
+// --- Input and Output ---------------------------------------------------- //
+/// Reads the database from the file set with setFileName().
+bool FingerprintDatabase::read()
+{
+    return read(d->fileName);
+}
+
+/// Reads the database from the file with \p fileName. Files in the
+/// binary format are memory-mapped and searched in place while
+/// other files are read in the FPS format. Returns \c false if an
+/// error occurs.
+bool FingerprintDatabase::read(const std::string &fileName)
+{
+    clear();
+    d->fileName = fileName;
+
+    std::ifstream input(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+    if(!input.is_open()){
+        setErrorString("Failed to open '" + fileName + "' for reading.");
+        return false;
+    }
+
+    char magic[4] = { 0 };
+    input.read(magic, 4);
+    if(!input || std::memcmp(magic, FileMagic, 4) != 0){
+        input.clear();
+        input.seekg(0);
+
+        if(!readFps(input)){
+            clear();
+            return false;
+        }
+
+        return true;
+    }
+    input.close();
+
+    try {
+        d->file.open(fileName);
+    }
+    catch(std::exception &e){
+        setErrorString("Failed to map '" + fileName + "': " + e.what());
+        return false;
+    }
+
+    const char *data = d->file.data();
+    size_t size = d->file.size();
+
+    if(size < HeaderSize || readUInt32(data + 4) != FormatVersion){
+        clear();
+        setErrorString("Invalid fingerprint database header.");
+        return false;
+    }
+
+    boost::uint64_t count = readUInt64(data + 8);
+    boost::uint64_t typeOffset = readUInt64(data + 16);
+    boost::uint64_t typeSize = readUInt64(data + 24);
+    boost::uint64_t indexOffset = readUInt64(data + 32);
+    boost::uint64_t indexSize = readUInt64(data + 40);
+    boost::uint64_t namesOffset = readUInt64(data + 48);
+    boost::uint64_t namesSize = readUInt64(data + 56);
+
+    // each section is compared separately so that a corrupt header
+    // cannot wrap the offset and size sums
+    if(typeSize > size || typeOffset > size - typeSize ||
+       indexSize > size || indexOffset > size - indexSize ||
+       namesOffset % 8 != 0 ||
+       namesSize > size || namesOffset > size - namesSize ||
+       count >= namesSize / 8){
+        clear();
+        setErrorString("Invalid fingerprint database file size.");
+        return false;
+    }
+
+    if(!d->index->map(data + indexOffset, indexSize) || d->index->size() != count){
+        clear();
+        setErrorString("Invalid fingerprint database index.");
+        return false;
+    }
+
+    d->nameOffsets = reinterpret_cast<const boost::uint64_t *>(data + namesOffset);
+    d->nameData = data + namesOffset + (count + 1) * 8;
+
+    bool validNames = d->nameOffsets[0] == 0 &&
+                      d->nameOffsets[count] <= namesSize - (count + 1) * 8;
+    for(size_t i = 0; validNames && i < count; i++){
+        validNames = d->nameOffsets[i] <= d->nameOffsets[i + 1];
+    }
+
+    if(!validNames){
+        clear();
+        setErrorString("Invalid fingerprint database name table.");
+        return false;
+    }
+
+    d->type.assign(data + typeOffset, typeSize);
+
+    return true;
+}
+
+/// Reads fingerprints in the FPS format from \p input and adds them
+/// to the database. Returns \c false if an error occurs.
+///
+/// Reference:
+///   http://code.google.com/p/chem-fingerprints/wiki/FPS
+bool FingerprintDatabase::readFps(std::istream &input)
+{
+    size_t fingerprintSize = 0;
+    std::vector<boost::uint64_t> words;
+    Bitset fingerprint;
+
+    std::string line;
+    size_t lineNumber = 0;
+    bool header = true;
+
+    while(std::getline(input, line)){
+        lineNumber++;
+
+        if(!line.empty() && line[line.size() - 1] == '\r'){
+            line.erase(line.size() - 1);
+        }
+
+        if(line.empty()){
+            continue;
+        }
+
+        // header lines
+        if(line[0] == '#'){
+            if(!header){
+                continue;
+            }
+            else if(boost::starts_with(line, "#num_bits=")){
+                try {
+                    int value = boost::lexical_cast<int>(line.substr(10));
+                    if(value <= 0){
+                        throw boost::bad_lexical_cast();
+                    }
+
+                    fingerprintSize = value;
+                }
+                catch(boost::bad_lexical_cast &){
+                    setErrorString((boost::format("Invalid fingerprint size on line %d.") % lineNumber).str());
+                    return false;
+                }
+            }
+            else if(boost::starts_with(line, "#type=")){
+                d->type = line.substr(6);
+            }
+
+            continue;
+        }
+
+        // fingerprint lines
+        size_t tab = line.find('\t');
+        size_t hexSize = tab == std::string::npos ? line.size() : tab;
+
+        if(header){
+            header = false;
+
+            if(fingerprintSize == 0){
+                fingerprintSize = hexSize * 4;
+            }
+
+            if(!isEmpty() && fingerprintSize != this->fingerprintSize()){
+                setErrorString("Fingerprint size does not match the database.");
+                return false;
+            }
+
+            words.resize(std::max<size_t>(1, (fingerprintSize + 63) / 64));
+        }
+
+        if(hexSize != (fingerprintSize + 7) / 8 * 2 ||
+           !decodeHex(line.data(), hexSize, words)){
+            setErrorString((boost::format("Invalid fingerprint on line %d.") % lineNumber).str());
+            return false;
+        }
+
+        std::string name;
+        if(tab != std::string::npos){
+            size_t end = line.find('\t', tab + 1);
+            name = line.substr(tab + 1, end == std::string::npos ? std::string::npos : end - tab - 1);
+        }
+
+        if(isEmpty() && this->fingerprintSize() != fingerprintSize){
+            d->index.reset(new FingerprintIndex(fingerprintSize));
+        }
+
+        d->detach();
+        d->names.push_back(name);
+        d->index->addFingerprint(&words[0]);
+    }
+
+    return true;
+}
+
+/// Writes the database to the file set with setFileName().
+bool FingerprintDatabase::write()
+{
+    return write(d->fileName);
+}
+
+/// Writes the database to the file with \p fileName. Files with the
+/// ".fps" extension are written in the FPS format and all other
+/// files are written in the binary format. Returns \c false if an
+/// error occurs.
+///
+/// If the database was read from a binary file its contents are
+/// loaded into memory first so that the file can be overwritten.
+bool FingerprintDatabase::write(const std::string &fileName)
+{
+    d->detach();
+    d->fileName = fileName;
+
+    std::ofstream output(fileName.c_str(), std::ios_base::out | std::ios_base::binary);
+    if(!output.is_open()){
+        setErrorString("Failed to open '" + fileName + "' for writing.");
+        return false;
+    }
+
+    if(boost::iequals(boost::filesystem::extension(fileName), ".fps")){
+        return writeFps(output);
+    }
+
+    // name table
+    std::vector<boost::uint64_t> nameOffsets(1, 0);
+    for(size_t i = 0; i < d->names.size(); i++){
+        nameOffsets.push_back(nameOffsets.back() + d->names[i].size());
+    }
+
+    boost::uint64_t typeOffset = HeaderSize;
+    boost::uint64_t indexOffset = typeOffset + alignedSize(d->type.size());
+
+    // write index after the header and type
+    output.seekp(indexOffset);
+    if(!d->index->write(output)){
+        setErrorString("Failed to write fingerprint index.");
+        return false;
+    }
+
+    boost::uint64_t indexSize = static_cast<boost::uint64_t>(output.tellp()) - indexOffset;
+    boost::uint64_t namesOffset = indexOffset + alignedSize(indexSize);
+    boost::uint64_t namesSize = nameOffsets.size() * 8 + nameOffsets.back();
+
+    output.seekp(namesOffset);
+    output.write(reinterpret_cast<const char *>(&nameOffsets[0]), nameOffsets.size() * 8);
+    for(size_t i = 0; i < d->names.size(); i++){
+        output.write(d->names[i].data(), d->names[i].size());
+    }
+
+    // header and type
+    std::string header(FileMagic, 4);
+    appendUInt32(header, FormatVersion);
+    appendUInt64(header, size());
+    appendUInt64(header, typeOffset);
+    appendUInt64(header, d->type.size());
+    appendUInt64(header, indexOffset);
+    appendUInt64(header, indexSize);
+    appendUInt64(header, namesOffset);
+    appendUInt64(header, namesSize);
+    header += d->type;
+
+    output.seekp(0);
+    output.write(header.data(), header.size());
+
+    if(!output){
+        setErrorString("Failed to write to '" + fileName + "'.");
+        return false;
+    }
+
+    return true;
+}
+
+/// Writes the database to \p output in the FPS format. Returns
+/// \c false if an error occurs.
+bool FingerprintDatabase::writeFps(std::ostream &output) const
+{
+    TextWriter writer(output);
+
+    writer.write("#FPS1\n#num_bits=");
+    writer.writeInteger(fingerprintSize());
+    writer.write('\n');
+    if(!d->type.empty()){
+        writer.write("#type=");
+        writer.write(d->type);
+        writer.write('\n');
+    }
+    writer.write("#software=chemkit/" CHEMKIT_VERSION_STRING "\n");
+
+    size_t byteCount = (fingerprintSize() + 7) / 8;
+    std::vector<char> hex(byteCount * 2);
+
+    for(size_t i = 0; i < size(); i++){
+        const boost::uint64_t *words = d->index->fingerprintWords(i);
+
+        for(size_t j = 0; j < byteCount; j++){
+            int value = static_cast<int>((words[j / 8] >> (8 * (j % 8))) & 0xff);
+
+            hex[2 * j] = hexDigits[value >> 4];
+            hex[2 * j + 1] = hexDigits[value & 0xf];
+        }
+
+        writer.write(&hex[0], hex.size());
+        writer.write('\t');
+        writer.write(name(i));
+        writer.write('\n');
+    }
+
+    writer.flush();
+
+    if(!output){
+        d->errorString = "Failed to write FPS output.";
+        return false;
+    }
+
+    return true;
+}
+
+/// Returns \c true if the database is searching a memory-mapped
+/// binary file.
+bool FingerprintDatabase::isMapped() const
+{
+    return d->file.is_open();
+}
+
+// --- Error Handling ------------------------------------------------------ //
+void FingerprintDatabase::setErrorString(const std::string &errorString)
+{
+    d->errorString = errorString;
+}
+
+/// Returns a string describing the last error that occurred.
+std::string FingerprintDatabase::errorString() const
+{
+    return d->errorString;
+}
+
+} // end chemkit namespace
@@ -0,0 +1,99 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FINGERPRINTDATABASE_H
+#define CHEMKIT_FINGERPRINTDATABASE_H
+
+#include "io.h"
+
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include <chemkit/bitset.h>
+
+namespace chemkit {
+
+class FingerprintIndex;
+class FingerprintDatabasePrivate;
+
+class CHEMKIT_IO_EXPORT FingerprintDatabase
+{
+public:
+    // construction and destruction
+    FingerprintDatabase();
+    FingerprintDatabase(const std::string &fileName);
+    ~FingerprintDatabase();
+
+    // properties
+    void setFileName(const std::string &fileName);
+    std::string fileName() const;
+    size_t size() const;
+    bool isEmpty() const;
+    size_t fingerprintSize() const;
+    void setType(const std::string &type);
+    std::string type() const;
+
+    // fingerprints
+    size_t addFingerprint(const Bitset &fingerprint, const std::string &name);
+    Bitset fingerprint(size_t index) const;
+    std::string name(size_t index) const;
+    const FingerprintIndex* index() const;
+    void clear();
+
+    // input and output
+    bool read();
+    bool read(const std::string &fileName);
+    bool readFps(std::istream &input);
+    bool write();
+    bool write(const std::string &fileName);
+    bool writeFps(std::ostream &output) const;
+    bool isMapped() const;
+
+    // error handling
+    std::string errorString() const;
+
+private:
+    CHEMKIT_DISABLE_COPY(FingerprintDatabase)
+
+    void setErrorString(const std::string &errorString);
+
+private:
+    FingerprintDatabasePrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_FINGERPRINTDATABASE_H
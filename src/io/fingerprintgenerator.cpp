@@ -0,0 +1,401 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintgenerator.h"
+
+#include <algorithm>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <chemkit/foreach.h>
+#include <chemkit/molecule.h>
+#include <chemkit/concurrent.h>
+#include <chemkit/fingerprint.h>
+
+#include "moleculefile.h"
+
+namespace chemkit {
+
+namespace {
+
+typedef std::vector<boost::shared_ptr<Fingerprint> > FingerprintSet;
+
+} // end anonymous namespace
+
+// === FingerprintGeneratorPrivate ========================================= //
+class FingerprintGeneratorPrivate
+{
+public:
+    FingerprintSet takeFingerprints();
+    void releaseFingerprints(const FingerprintSet &fingerprints);
+
+    std::vector<std::string> names;
+    size_t threadCount;
+    size_t batchSize;
+    std::string errorString;
+
+    // fingerprint objects not in use by a worker thread. each worker
+    // takes a set for the block of molecules it is working on and
+    // returns it afterwards so the objects are reused between blocks
+    // and between calls to generate().
+    std::vector<FingerprintSet> fingerprintSets;
+    boost::mutex mutex;
+};
+
+FingerprintSet FingerprintGeneratorPrivate::takeFingerprints()
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+
+    if(!fingerprintSets.empty()){
+        FingerprintSet fingerprints = fingerprintSets.back();
+        fingerprintSets.pop_back();
+        return fingerprints;
+    }
+
+    FingerprintSet fingerprints;
+    foreach(const std::string &name, names){
+        fingerprints.push_back(boost::shared_ptr<Fingerprint>(Fingerprint::create(name)));
+    }
+
+    return fingerprints;
+}
+
+void FingerprintGeneratorPrivate::releaseFingerprints(const FingerprintSet &fingerprints)
+{
+    boost::lock_guard<boost::mutex> lock(mutex);
+
+    fingerprintSets.push_back(fingerprints);
+}
+
+namespace {
+
+// Calculates the fingerprints for one block of molecules.
+class GenerateBlock
+{
+public:
+    GenerateBlock(FingerprintGeneratorPrivate *d,
+                  const boost::shared_ptr<Molecule> *molecules,
+                  size_t count,
+                  size_t blockSize)
+        : d(d),
+          m_molecules(molecules),
+          m_count(count),
+          m_blockSize(blockSize)
+    {
+    }
+
+    void operator()(size_t block) const
+    {
+        FingerprintSet fingerprints = d->takeFingerprints();
+
+        size_t begin = block * m_blockSize;
+        size_t end = std::min(m_count, begin + m_blockSize);
+
+        for(size_t i = begin; i < end; i++){
+            const Molecule *molecule = m_molecules[i].get();
+            if(!molecule){
+                continue;
+            }
+
+            foreach(const boost::shared_ptr<Fingerprint> &fingerprint, fingerprints){
+                fingerprint->cachedValue(molecule);
+            }
+        }
+
+        d->releaseFingerprints(fingerprints);
+    }
+
+private:
+    FingerprintGeneratorPrivate *d;
+    const boost::shared_ptr<Molecule> *m_molecules;
+    size_t m_count;
+    size_t m_blockSize;
+};
+
+} // end anonymous namespace
+
+// === FingerprintGenerator ================================================ //
+/// \class FingerprintGenerator fingerprintgenerator.h chemkit/fingerprintgenerator.h
+/// \ingroup chemkit-io
+/// \brief The FingerprintGenerator class calculates fingerprints
+///        for many molecules in parallel.
+///
+/// The generator calculates one or more fingerprint types for each
+/// molecule using several worker threads. Each thread reuses its own
+/// set of Fingerprint objects instead of creating a new one for each
+/// molecule. The results are cached in the molecules and are returned
+/// by Molecule::fingerprint() without being recalculated.
+///
+/// For example, to calculate the FP2 and ECFP fingerprints for every
+/// molecule in a file as it is read:
+/// \code
+/// std::vector<std::string> names;
+/// names.push_back("fp2");
+/// names.push_back("ecfp");
+///
+/// chemkit::FingerprintGenerator generator(names);
+/// chemkit::MoleculeFile file("molecules.sdf");
+///
+/// generator.generate(&file, callback);
+/// \endcode
+///
+/// where \c callback is called with each molecule in the order they
+/// appear in the file:
+/// \code
+/// void callback(const boost::shared_ptr<chemkit::Molecule> &molecule)
+/// {
+///     chemkit::Bitset fp2 = molecule->fingerprint("fp2");
+///     chemkit::Bitset ecfp = molecule->fingerprint("ecfp");
+/// }
+/// \endcode
+///
+/// \see Fingerprint, Fingerprint::cachedValue()
+
+/// \typedef FingerprintGenerator::Callback
+///
+/// Typedef for a function called with each molecule after its
+/// fingerprints have been generated.
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new fingerprint generator with no fingerprints.
+FingerprintGenerator::FingerprintGenerator()
+    : d(new FingerprintGeneratorPrivate)
+{
+    d->threadCount = concurrent::idealThreadCount();
+    d->batchSize = 1024;
+}
+
+/// Creates a new fingerprint generator for the fingerprint with
+/// \p name.
+FingerprintGenerator::FingerprintGenerator(const std::string &name)
+    : d(new FingerprintGeneratorPrivate)
+{
+    d->names.push_back(name);
+    d->threadCount = concurrent::idealThreadCount();
+    d->batchSize = 1024;
+}
+
+/// Creates a new fingerprint generator for each of the fingerprints
+/// in \p names.
+FingerprintGenerator::FingerprintGenerator(const std::vector<std::string> &names)
+    : d(new FingerprintGeneratorPrivate)
+{
+    d->names = names;
+    d->threadCount = concurrent::idealThreadCount();
+    d->batchSize = 1024;
+}
+
+/// Destroys the fingerprint generator.
+FingerprintGenerator::~FingerprintGenerator()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Adds the fingerprint with \p name to the generator.
+void FingerprintGenerator::addFingerprint(const std::string &name)
+{
+    d->names.push_back(name);
+    d->fingerprintSets.clear();
+}
+
+/// Returns the names of the fingerprints calculated by the
+/// generator.
+std::vector<std::string> FingerprintGenerator::fingerprints() const
+{
+    return d->names;
+}
+
+/// Sets the maximum number of threads used to \p count. The default
+/// is the number of hardware threads available.
+void FingerprintGenerator::setThreadCount(size_t count)
+{
+    d->threadCount = std::max(size_t(1), count);
+}
+
+/// Returns the maximum number of threads used.
+size_t FingerprintGenerator::threadCount() const
+{
+    return d->threadCount;
+}
+
+/// Sets the number of molecules read from a file before their
+/// fingerprints are generated when streaming to \p size. The default
+/// is \c 1024.
+void FingerprintGenerator::setBatchSize(size_t size)
+{
+    d->batchSize = std::max(size_t(1), size);
+}
+
+/// Returns the number of molecules read from a file before their
+/// fingerprints are generated when streaming.
+size_t FingerprintGenerator::batchSize() const
+{
+    return d->batchSize;
+}
+
+// --- Generation ---------------------------------------------------------- //
+/// Generates the fingerprints for each molecule in \p molecules.
+/// Returns \c false if any of the fingerprints are not supported.
+bool FingerprintGenerator::generate(const std::vector<boost::shared_ptr<Molecule> > &molecules)
+{
+    if(molecules.empty()){
+        return generate(0, 0);
+    }
+
+    return generate(&molecules[0], molecules.size());
+}
+
+/// Generates the fingerprints for each molecule in \p file.
+bool FingerprintGenerator::generate(const MoleculeFile *file)
+{
+    MoleculeFile::MoleculeRange range = file->molecules();
+    std::vector<boost::shared_ptr<Molecule> > molecules(range.begin(), range.end());
+
+    return generate(molecules);
+}
+
+/// Reads molecules from \p file in batches, generates their
+/// fingerprints and then calls \p callback with each molecule in
+/// the order they were read. The molecules are not added to the
+/// file.
+///
+/// If \p file is not already open for reading it is opened and is
+/// closed again once all of the molecules have been read. Returns
+/// \c false if a molecule cannot be read from \p file.
+///
+/// \see MoleculeFile::readMolecule()
+bool FingerprintGenerator::generate(MoleculeFile *file, const Callback &callback)
+{
+    bool opened = false;
+    if(!file->isOpen()){
+        if(!file->open()){
+            setErrorString(file->errorString());
+            return false;
+        }
+
+        opened = true;
+    }
+
+    std::vector<boost::shared_ptr<Molecule> > batch;
+    batch.reserve(d->batchSize);
+
+    bool ok = true;
+    for(;;){
+        batch.clear();
+
+        while(batch.size() < d->batchSize){
+            boost::shared_ptr<Molecule> molecule = file->readMolecule();
+            if(!molecule){
+                break;
+            }
+
+            batch.push_back(molecule);
+        }
+
+        if(batch.empty()){
+            break;
+        }
+
+        if(!generate(batch)){
+            ok = false;
+            break;
+        }
+
+        if(callback){
+            foreach(const boost::shared_ptr<Molecule> &molecule, batch){
+                callback(molecule);
+            }
+        }
+    }
+
+    // a null molecule with an error means the file could not be read
+    // past a malformed record rather than that its end was reached
+    if(ok && !file->errorString().empty()){
+        setErrorString(file->errorString());
+        ok = false;
+    }
+
+    if(opened){
+        file->close();
+    }
+
+    return ok;
+}
+
+bool FingerprintGenerator::generate(const boost::shared_ptr<Molecule> *molecules, size_t count)
+{
+    // check that each fingerprint is supported before starting the
+    // worker threads. this also loads the plugins from the calling
+    // thread.
+    FingerprintSet fingerprints = d->takeFingerprints();
+    for(size_t i = 0; i < fingerprints.size(); i++){
+        if(!fingerprints[i]){
+            setErrorString("Fingerprint '" + d->names[i] + "' is not supported.");
+            return false;
+        }
+    }
+    d->releaseFingerprints(fingerprints);
+
+    if(count == 0){
+        return true;
+    }
+
+    // split the molecules into blocks so that a set of fingerprint
+    // objects is only taken once for each block
+    size_t blockSize = std::max(size_t(1), count / (d->threadCount * 8));
+    size_t blockCount = (count + blockSize - 1) / blockSize;
+
+    concurrent::blockingFor(blockCount,
+                            GenerateBlock(d, molecules, count, blockSize),
+                            d->threadCount);
+
+    return true;
+}
+
+// --- Error Handling ------------------------------------------------------ //
+void FingerprintGenerator::setErrorString(const std::string &errorString)
+{
+    d->errorString = errorString;
+}
+
+/// Returns a string describing the last error that occurred.
+std::string FingerprintGenerator::errorString() const
+{
+    return d->errorString;
+}
+
+} // end chemkit namespace
@@ -0,0 +1,93 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_FINGERPRINTGENERATOR_H
+#define CHEMKIT_FINGERPRINTGENERATOR_H
+
+#include "io.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace chemkit {
+
+class Molecule;
+class MoleculeFile;
+class FingerprintGeneratorPrivate;
+
+class CHEMKIT_IO_EXPORT FingerprintGenerator
+{
+public:
+    // typedefs
+    typedef boost::function<void (const boost::shared_ptr<Molecule> &)> Callback;
+
+    // construction and destruction
+    FingerprintGenerator();
+    FingerprintGenerator(const std::string &name);
+    FingerprintGenerator(const std::vector<std::string> &names);
+    ~FingerprintGenerator();
+
+    // properties
+    void addFingerprint(const std::string &name);
+    std::vector<std::string> fingerprints() const;
+    void setThreadCount(size_t count);
+    size_t threadCount() const;
+    void setBatchSize(size_t size);
+    size_t batchSize() const;
+
+    // generation
+    bool generate(const std::vector<boost::shared_ptr<Molecule> > &molecules);
+    bool generate(const MoleculeFile *file);
+    bool generate(MoleculeFile *file, const Callback &callback);
+
+    // error handling
+    std::string errorString() const;
+
+private:
+    CHEMKIT_DISABLE_COPY(FingerprintGenerator)
+
+    bool generate(const boost::shared_ptr<Molecule> *molecules, size_t count);
+    void setErrorString(const std::string &errorString);
+
+private:
+    FingerprintGeneratorPrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_FINGERPRINTGENERATOR_H
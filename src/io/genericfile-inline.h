@@ -309,18 +309,13 @@ inline bool GenericFile<File, Format>::read(std::istream &input)
     // create input stream
     boost::iostreams::filtering_istream inputStream;
 
-    // insert stream decompressor
-#ifndef CHEMKIT_OS_WIN32
-    if(m_compressionFormat == "gz"){
-        inputStream.push(boost::iostreams::gzip_decompressor());
+    // insert input stream, decompressing it in a separate thread
+    if(DecompressionSource::isSupported(m_compressionFormat)){
+        inputStream.push(DecompressionSource(input, m_compressionFormat));
     }
-    else if(m_compressionFormat == "bz2"){
-        inputStream.push(boost::iostreams::bzip2_decompressor());
+    else{
+        inputStream.push(input);
     }
-#endif
-
-    // insert input stream
-    inputStream.push(input);
 
     // read the file
     bool ok = m_format->read(inputStream, static_cast<File *>(this));
@@ -451,6 +446,9 @@ inline bool GenericFile<File, Format>::write(std::ostream &output, Format *forma
     else if(m_compressionFormat == "bz2"){
         outputStream.push(boost::iostreams::bzip2_compressor());
     }
+    else if(m_compressionFormat == "bgz"){
+        outputStream.push(BlockCompressor());
+    }
 #endif
 
     // insert output stream
@@ -510,6 +508,7 @@ inline std::vector<std::string> GenericFile<File, Format>::compressionFormats()
 
 #ifndef CHEMKIT_OS_WIN32
     formats.push_back("gz");
+    formats.push_back("bgz");
     formats.push_back("bz2");
 #endif
 
@@ -517,7 +516,8 @@ inline std::vector<std::string> GenericFile<File, Format>::compressionFormats()
 }
 
 // --- Internal Methods ---------------------------------------------------- //
-/// Returns the file suffix for the file name.
+/// Returns the file suffix for the file name. The compression suffix
+/// of compressed files (e.g. "file.sdf.gz") is skipped.
 template<typename File, typename Format>
 inline std::string GenericFile<File, Format>::suffix(const std::string &fileName)
 {
@@ -531,6 +531,11 @@ inline std::string GenericFile<File, Format>::suffix(const std::string &fileName
     // remove the leading '.' character
     suffix.erase(0, 1);
 
+    const std::vector<std::string> &compressionFormats = this->compressionFormats();
+    if(std::find(compressionFormats.begin(), compressionFormats.end(), suffix) != compressionFormats.end()){
+        return this->suffix(boost::filesystem::path(fileName).stem().string());
+    }
+
     return suffix;
 }
 
@@ -49,6 +49,9 @@
 #include <chemkit/variant.h>
 #include <chemkit/variantmap.h>
 
+#include "blockcompressor.h"
+#include "decompressionsource.h"
+
 namespace chemkit {
 
 template<typename File, typename Format>
@@ -0,0 +1,198 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#ifndef CHEMKIT_LINETOKENIZER_INLINE_H
+#define CHEMKIT_LINETOKENIZER_INLINE_H
+
+#include "linetokenizer.h"
+
+namespace chemkit {
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new tokenizer with an empty line.
+inline LineTokenizer::LineTokenizer()
+    : m_position(0)
+{
+}
+
+/// Creates a new tokenizer for \p line.
+inline LineTokenizer::LineTokenizer(const boost::string_ref &line)
+    : m_line(line),
+      m_position(0)
+{
+}
+
+/// Creates a new tokenizer for \p line. The string must outlive
+/// the tokenizer.
+inline LineTokenizer::LineTokenizer(const std::string &line)
+    : m_line(line),
+      m_position(0)
+{
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Sets the line to tokenize to \p line and moves to its start.
+inline void LineTokenizer::setLine(const boost::string_ref &line)
+{
+    m_line = line;
+    m_position = 0;
+}
+
+/// Returns the line being tokenized.
+inline boost::string_ref LineTokenizer::line() const
+{
+    return m_line;
+}
+
+/// Sets the position of the next token search to \p position.
+inline void LineTokenizer::setPosition(size_t position)
+{
+    m_position = std::min(position, m_line.size());
+}
+
+/// Returns the position of the next token search.
+inline size_t LineTokenizer::position() const
+{
+    return m_position;
+}
+
+/// Returns \c true if there are no more tokens in the line.
+inline bool LineTokenizer::atEnd() const
+{
+    for(size_t i = m_position; i < m_line.size(); i++){
+        if(!isSpace(m_line[i])){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// --- Tokens -------------------------------------------------------------- //
+/// Returns the next whitespace-delimited token in the line or an
+/// empty string if there are no more tokens.
+inline boost::string_ref LineTokenizer::nextToken()
+{
+    size_t size = m_line.size();
+
+    while(m_position < size && isSpace(m_line[m_position])){
+        m_position++;
+    }
+
+    size_t begin = m_position;
+
+    while(m_position < size && !isSpace(m_line[m_position])){
+        m_position++;
+    }
+
+    return m_line.substr(begin, m_position - begin);
+}
+
+/// Reads the next token as an integer into \p value. Returns
+/// \c false if there are no more tokens or the token is not an
+/// integer.
+inline bool LineTokenizer::nextInteger(int *value)
+{
+    return parseInteger(nextToken(), value);
+}
+
+/// Reads the next token as a real number into \p value. Returns
+/// \c false if there are no more tokens or the token is not a
+/// number.
+inline bool LineTokenizer::nextReal(Real *value)
+{
+    return parseReal(nextToken(), value);
+}
+
+/// Returns the field of \p width characters starting at
+/// \p position with surrounding whitespace removed. The field is
+/// clipped to the end of the line.
+inline boost::string_ref LineTokenizer::column(size_t position, size_t width) const
+{
+    if(position >= m_line.size()){
+        return boost::string_ref();
+    }
+
+    return trimmed(m_line.substr(position, width));
+}
+
+/// Reads the integer in the field of \p width characters starting
+/// at \p position into \p value.
+inline bool LineTokenizer::columnInteger(size_t position, size_t width, int *value) const
+{
+    return parseInteger(column(position, width), value);
+}
+
+/// Reads the real number in the field of \p width characters
+/// starting at \p position into \p value.
+inline bool LineTokenizer::columnReal(size_t position, size_t width, Real *value) const
+{
+    return parseReal(column(position, width), value);
+}
+
+// --- Static Methods ------------------------------------------------------ //
+/// Returns \p string with leading and trailing whitespace removed.
+inline boost::string_ref LineTokenizer::trimmed(const boost::string_ref &string)
+{
+    size_t begin = 0;
+    size_t end = string.size();
+
+    while(begin < end && isSpace(string[begin])){
+        begin++;
+    }
+    while(end > begin && isSpace(string[end - 1])){
+        end--;
+    }
+
+    return string.substr(begin, end - begin);
+}
+
+/// Returns \c true if \p character is a space, tab, or line break.
+/// Unlike isspace() this does not depend on the current locale.
+inline bool LineTokenizer::isSpace(char character)
+{
+    return character == ' ' || (character >= '\t' && character <= '\r');
+}
+
+/// Returns \c true if \p character is a decimal digit.
+inline bool LineTokenizer::isDigit(char character)
+{
+    return static_cast<unsigned char>(character - '0') < 10;
+}
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_LINETOKENIZER_INLINE_H
@@ -0,0 +1,274 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#include "linetokenizer.h"
+
+#include <limits>
+#include <sstream>
+
+namespace chemkit {
+
+namespace {
+
+// powers of ten that are exactly representable as doubles
+const double exactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// largest integer below which all integers are exactly representable
+const unsigned long long maximumExactMantissa = 1ULL << 53;
+
+} // end anonymous namespace
+
+// === LineTokenizer ======================================================= //
+/// \class LineTokenizer linetokenizer.h chemkit/linetokenizer.h
+/// \ingroup chemkit-io
+/// \brief The LineTokenizer class splits lines into tokens and
+///        parses numbers.
+///
+/// The LineTokenizer class is used by file formats to read fields
+/// from a line of text without creating temporary strings. Tokens
+/// are returned as boost::string_ref views into the line, so the
+/// line buffer must remain valid while they are used.
+///
+/// Whitespace-delimited tokens are read with nextToken() and
+/// fixed-width fields with column(). Numbers are parsed with
+/// parseInteger() and parseReal() which, unlike sscanf() and
+/// boost::lexical_cast(), do not depend on the current locale and
+/// do not allocate memory.
+///
+/// For example, to read the coordinates from a PDB atom line:
+/// \code
+/// chemkit::LineTokenizer tokenizer(line);
+///
+/// chemkit::Real x, y, z;
+/// tokenizer.columnReal(30, 8, &x);
+/// tokenizer.columnReal(38, 8, &y);
+/// tokenizer.columnReal(46, 8, &z);
+/// \endcode
+
+// --- Tokens -------------------------------------------------------------- //
+/// Replaces the contents of \p tokens with the remaining
+/// whitespace-delimited tokens in the line and returns the number
+/// of tokens. Reusing the same vector for each line avoids
+/// reallocating it.
+size_t LineTokenizer::tokenize(std::vector<boost::string_ref> &tokens)
+{
+    tokens.clear();
+
+    for(;;){
+        boost::string_ref token = nextToken();
+        if(token.empty()){
+            break;
+        }
+
+        tokens.push_back(token);
+    }
+
+    return tokens.size();
+}
+
+// --- Static Methods ------------------------------------------------------ //
+/// Parses \p string as a decimal integer and stores it in
+/// \p value. Leading and trailing whitespace is ignored. Returns
+/// \c false (and leaves \p value unchanged) if \p string is not an
+/// integer or is out of range.
+bool LineTokenizer::parseInteger(const boost::string_ref &string, int *value)
+{
+    boost::string_ref token = trimmed(string);
+    const char *position = token.begin();
+    const char *end = token.end();
+
+    bool negative = false;
+    if(position != end && (*position == '-' || *position == '+')){
+        negative = *position == '-';
+        position++;
+    }
+
+    if(position == end){
+        return false;
+    }
+
+    long long number = 0;
+    for(; position != end; position++){
+        if(!isDigit(*position)){
+            return false;
+        }
+
+        number = number * 10 + (*position - '0');
+        if(number > static_cast<long long>(std::numeric_limits<int>::max()) + 1){
+            return false;
+        }
+    }
+
+    if(negative){
+        number = -number;
+    }
+    else if(number > std::numeric_limits<int>::max()){
+        return false;
+    }
+
+    *value = static_cast<int>(number);
+
+    return true;
+}
+
+/// Parses \p string as a real number in decimal or scientific
+/// notation (e.g. "-1.25" or "3.0e-4") and stores it in \p value.
+/// Leading and trailing whitespace is ignored. Returns \c false
+/// (and leaves \p value unchanged) if \p string is not a number.
+///
+/// The result is the correctly rounded value of the number and is
+/// identical to that of strtod() in the "C" locale.
+bool LineTokenizer::parseReal(const boost::string_ref &string, Real *value)
+{
+    boost::string_ref token = trimmed(string);
+    const char *position = token.begin();
+    const char *end = token.end();
+
+    bool negative = false;
+    if(position != end && (*position == '-' || *position == '+')){
+        negative = *position == '-';
+        position++;
+    }
+
+    // the significant digits are accumulated into an integer
+    // mantissa with the decimal point folded into the exponent
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    bool exact = true;
+
+    for(; position != end && isDigit(*position); position++){
+        digits = true;
+
+        if(mantissa < maximumExactMantissa){
+            mantissa = mantissa * 10 + (*position - '0');
+        }
+        else{
+            exact = false;
+            exponent++;
+        }
+    }
+
+    if(position != end && *position == '.'){
+        position++;
+
+        for(; position != end && isDigit(*position); position++){
+            digits = true;
+
+            if(mantissa < maximumExactMantissa){
+                mantissa = mantissa * 10 + (*position - '0');
+                exponent--;
+            }
+            else{
+                exact = false;
+            }
+        }
+    }
+
+    if(!digits){
+        return false;
+    }
+
+    if(position != end && (*position == 'e' || *position == 'E')){
+        position++;
+
+        bool negativeExponent = false;
+        if(position != end && (*position == '-' || *position == '+')){
+            negativeExponent = *position == '-';
+            position++;
+        }
+
+        if(position == end){
+            return false;
+        }
+
+        int number = 0;
+        for(; position != end && isDigit(*position); position++){
+            if(number < 10000){
+                number = number * 10 + (*position - '0');
+            }
+        }
+
+        exponent += negativeExponent ? -number : number;
+    }
+
+    if(position != end){
+        return false;
+    }
+
+    // when both the mantissa and the power of ten are exactly
+    // representable a single multiplication or division gives the
+    // correctly rounded result
+    double number;
+    if(exact &&
+       mantissa <= maximumExactMantissa &&
+       exponent >= -22 &&
+       exponent <= 22){
+        number = static_cast<double>(mantissa);
+
+        if(exponent < 0){
+            number /= exactPowersOfTen[-exponent];
+        }
+        else{
+            number *= exactPowersOfTen[exponent];
+        }
+
+        if(negative){
+            number = -number;
+        }
+    }
+    else{
+        // fall back to the standard library for numbers with more
+        // significant digits or larger exponents than can be handled
+        // exactly above
+        std::istringstream stream(std::string(token.begin(), token.end()));
+        stream.imbue(std::locale::classic());
+        stream >> number;
+        if(stream.fail()){
+            return false;
+        }
+    }
+
+    *value = static_cast<Real>(number);
+
+    return true;
+}
+
+} // end chemkit namespace
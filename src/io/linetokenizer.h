@@ -0,0 +1,90 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#ifndef CHEMKIT_LINETOKENIZER_H
+#define CHEMKIT_LINETOKENIZER_H
+
+#include "io.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+namespace chemkit {
+
+class CHEMKIT_IO_EXPORT LineTokenizer
+{
+public:
+    // construction and destruction
+    LineTokenizer();
+    LineTokenizer(const boost::string_ref &line);
+    LineTokenizer(const std::string &line);
+
+    // properties
+    void setLine(const boost::string_ref &line);
+    boost::string_ref line() const;
+    void setPosition(size_t position);
+    size_t position() const;
+    bool atEnd() const;
+
+    // tokens
+    boost::string_ref nextToken();
+    bool nextInteger(int *value);
+    bool nextReal(Real *value);
+    size_t tokenize(std::vector<boost::string_ref> &tokens);
+    boost::string_ref column(size_t position, size_t width) const;
+    bool columnInteger(size_t position, size_t width, int *value) const;
+    bool columnReal(size_t position, size_t width, Real *value) const;
+
+    // static methods
+    static boost::string_ref trimmed(const boost::string_ref &string);
+    static bool parseInteger(const boost::string_ref &string, int *value);
+    static bool parseReal(const boost::string_ref &string, Real *value);
+    static bool isSpace(char character);
+    static bool isDigit(char character);
+
+private:
+    boost::string_ref m_line;
+    size_t m_position;
+};
+
+} // end chemkit namespace
+
+#include "linetokenizer-inline.h"
+
+#endif // CHEMKIT_LINETOKENIZER_H
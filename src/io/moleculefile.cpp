@@ -35,12 +35,122 @@
 
 #include "moleculefile.h"
 
+#include <fstream>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/lambda/lambda.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#ifndef CHEMKIT_OS_WIN32
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#endif
 
 #include <chemkit/foreach.h>
 #include <chemkit/molecule.h>
 #include <chemkit/variantmap.h>
 
+#include "moleculefileindex.h"
+#include "blockcompressedfile.h"
+
+namespace {
+
+// The number of blocks decompressed at a time when indexing block
+// compressed files.
+const size_t IndexBlockCount = 64;
+
+// Indexes the molecule records in a block compressed file. The file is
+// decompressed a piece at a time and each piece is indexed by the
+// format. Records are stored with virtual offsets so that they can be
+// read by decompressing only the blocks that contain them.
+bool indexBlockCompressedFile(chemkit::BlockCompressedFile &file,
+                              chemkit::MoleculeFileFormat *format,
+                              chemkit::MoleculeFileIndex *index,
+                              std::string &errorString)
+{
+    // uncompressed data not yet indexed, starting at dataStart
+    std::string data;
+    boost::uint64_t dataStart = 0;
+
+    // uncompressed start and file offset of each block in data
+    std::vector<std::pair<boost::uint64_t, boost::uint64_t> > blocks;
+
+    boost::uint64_t blockOffset = 0;
+    boost::uint64_t dataEnd = 0;
+
+    while(blockOffset < file.size()){
+        // find the next blocks
+        boost::uint64_t offset = blockOffset;
+        size_t count = 0;
+        while(count < IndexBlockCount && offset < file.size()){
+            size_t blockSize = file.blockSize(offset);
+            if(blockSize == 0){
+                errorString = "Invalid compressed block.";
+                return false;
+            }
+
+            blocks.push_back(std::make_pair(dataEnd, offset));
+            dataEnd += file.blockDataSize(offset);
+            offset += blockSize;
+            count++;
+        }
+
+        if(!file.readBlocks(blockOffset, count, data)){
+            errorString = file.errorString();
+            return false;
+        }
+
+        blockOffset = offset;
+        bool last = blockOffset >= file.size();
+
+        chemkit::MoleculeFileIndex pieceIndex;
+        if(!format->indexData(data.data(), data.size(), &pieceIndex)){
+            errorString = format->errorString();
+            return false;
+        }
+
+        // the last record may continue in the next blocks
+        size_t recordCount = pieceIndex.size();
+        if(!last && recordCount > 0){
+            recordCount--;
+        }
+
+        std::vector<std::pair<boost::uint64_t, boost::uint64_t> >::const_iterator block = blocks.begin();
+        for(size_t i = 0; i < recordCount; i++){
+            boost::uint64_t position = dataStart + pieceIndex.offset(i);
+
+            while(block + 1 != blocks.end() && (block + 1)->first <= position){
+                ++block;
+            }
+
+            index->addRecord(chemkit::BlockCompressedFile::virtualOffset(block->second, position - block->first),
+                             pieceIndex.length(i),
+                             pieceIndex.name(i));
+        }
+
+        if(last){
+            break;
+        }
+
+        // keep the data from the start of the unfinished record
+        size_t keep = pieceIndex.isEmpty() ? 0 : static_cast<size_t>(pieceIndex.offset(recordCount));
+
+        data.erase(0, keep);
+        dataStart += keep;
+
+        while(blocks.size() > 1 && blocks[1].first <= dataStart){
+            blocks.erase(blocks.begin());
+        }
+    }
+
+    return true;
+}
+
+} // end anonymous namespace
+
 namespace chemkit {
 
 // === MoleculeFilePrivate ================================================= //
@@ -49,6 +159,16 @@ class MoleculeFilePrivate
 public:
     std::vector<boost::shared_ptr<Molecule> > molecules;
     VariantMap fileData;
+    boost::scoped_ptr<std::ifstream> inputFile;
+    boost::scoped_ptr<boost::iostreams::filtering_istream> inputStream;
+    boost::scoped_ptr<std::ofstream> outputFile;
+    boost::scoped_ptr<boost::iostreams::filtering_ostream> outputStream;
+    boost::scoped_ptr<MoleculeFileIndex> index;
+    boost::scoped_ptr<MoleculeFileFormat> indexFormat;
+    boost::iostreams::mapped_file_source indexFile;
+    boost::scoped_ptr<BlockCompressedFile> blockFile;
+    std::string indexedFileName;
+    std::string record;
 };
 
 // === MoleculeFile ======================================================== //
@@ -79,7 +199,45 @@ public:
 /// boost::shared_ptr<Molecule> molecule = file.molecule();
 /// \endcode
 ///
-/// \see PolymerFile
+/// Large files can be processed one molecule at a time without
+/// reading the whole file into memory. After calling open(), each
+/// call to readMolecule() returns the next molecule in the file.
+/// Molecules can be written one at a time in the same way with
+/// create(), writeMolecule() and close():
+/// \code
+/// MoleculeFile input("input.sdf");
+/// input.open();
+///
+/// MoleculeFile output("output.mol2");
+/// output.create();
+///
+/// while(boost::shared_ptr<Molecule> molecule = input.readMolecule()){
+///     output.writeMolecule(molecule);
+/// }
+///
+/// output.close();
+/// \endcode
+///
+/// Single molecules can be read from large files without parsing the
+/// whole file using an index. The index contains the location and
+/// name of each molecule record and is built once by openIndex() and
+/// stored next to the file (see indexFileName()). Later calls reuse
+/// the stored index as long as the file has not been modified:
+/// \code
+/// MoleculeFile file("library.sdf");
+///
+/// // read the 1000th molecule
+/// boost::shared_ptr<Molecule> molecule = file.fetchMolecule(999);
+///
+/// // read the molecule named "aspirin"
+/// boost::shared_ptr<Molecule> aspirin = file.fetchMolecule("aspirin");
+/// \endcode
+///
+/// Files written with the ".bgz" suffix are block compressed. They
+/// can be indexed in the same way while remaining compressed, and a
+/// full read decompresses their blocks in parallel.
+///
+/// \see PolymerFile, MoleculeFileIndex
 
 // --- Construction and Destruction ---------------------------------------- //
 /// Creates a new, empty file object.
@@ -99,6 +257,8 @@ MoleculeFile::MoleculeFile(const std::string &fileName)
 /// any molecules that it contains.
 MoleculeFile::~MoleculeFile()
 {
+    close();
+
     delete d;
 }
 
@@ -186,7 +346,473 @@ void MoleculeFile::clear()
     d->fileData.clear();
 }
 
+// --- Streaming Input ----------------------------------------------------- //
+/// Opens the file for reading molecules one at a time using the
+/// current file name. Returns \c false if no file name or format is
+/// set or if the file cannot be opened.
+///
+/// \see readMolecule(), close()
+bool MoleculeFile::open()
+{
+    if(fileName().empty()){
+        setErrorString("No file name set for reading.");
+        return false;
+    }
+
+    close();
+
+    d->inputFile.reset(new std::ifstream(fileName().c_str(), std::ios_base::in | std::ios_base::binary));
+    if(!d->inputFile->is_open()){
+        d->inputFile.reset();
+        setErrorString("Failed to open file for reading.");
+        return false;
+    }
+
+    return open(*d->inputFile);
+}
+
+/// Opens the file with \p fileName for reading molecules one at a
+/// time. Returns \c false if the file cannot be opened.
+bool MoleculeFile::open(const std::string &fileName)
+{
+    setFileName(fileName);
+
+    return open();
+}
+
+/// Opens \p input for reading molecules one at a time using the
+/// current format. The stream must remain valid until close() is
+/// called. Returns \c false if no format is set or if reading the
+/// header fails.
+bool MoleculeFile::open(std::istream &input)
+{
+    if(!format()){
+        setErrorString("No file format set for reading.");
+        return false;
+    }
+
+    d->inputStream.reset(new boost::iostreams::filtering_istream);
+
+    // insert input stream, decompressing it in a separate thread
+    if(DecompressionSource::isSupported(compressionFormat())){
+        d->inputStream->push(DecompressionSource(input, compressionFormat()));
+    }
+    else{
+        d->inputStream->push(input);
+    }
+
+    bool ok = format()->readHeader(*d->inputStream, this);
+    if(!ok){
+        setErrorString(format()->errorString());
+        close();
+    }
+
+    return ok;
+}
+
+/// Returns \c true if the file is open for reading molecules.
+bool MoleculeFile::isOpen() const
+{
+    return d->inputStream != 0;
+}
+
+/// Reads and returns the next molecule from the file. The molecule
+/// is not added to the file. Returns a null pointer if the file is
+/// not open, if there are no more molecules or if an error occurs.
+/// When a null pointer is returned errorString() is empty if the end
+/// of the file was reached and describes the error otherwise.
+boost::shared_ptr<Molecule> MoleculeFile::readMolecule()
+{
+    if(!isOpen()){
+        setErrorString("File is not open for reading.");
+        return boost::shared_ptr<Molecule>();
+    }
+
+    boost::shared_ptr<Molecule> molecule = format()->readMolecule(*d->inputStream, this);
+    if(!molecule){
+        setErrorString(format()->errorString());
+    }
+
+    return molecule;
+}
+
+// --- Streaming Output ---------------------------------------------------- //
+/// Creates the file for writing molecules one at a time using the
+/// current file name. Returns \c false if no file name or format is
+/// set or if the file cannot be created.
+///
+/// \see writeMolecule(), close()
+bool MoleculeFile::create()
+{
+    if(fileName().empty()){
+        setErrorString("No file name set for writing.");
+        return false;
+    }
+
+    close();
+
+    d->outputFile.reset(new std::ofstream(fileName().c_str(), std::ios_base::out | std::ios_base::binary));
+    if(!d->outputFile->is_open()){
+        d->outputFile.reset();
+        setErrorString("Failed to open file for writing.");
+        return false;
+    }
+
+    return create(*d->outputFile);
+}
+
+/// Creates the file with \p fileName for writing molecules one at a
+/// time. Returns \c false if the file cannot be created.
+bool MoleculeFile::create(const std::string &fileName)
+{
+    setFileName(fileName);
+
+    return create();
+}
+
+/// Prepares \p output for writing molecules one at a time using the
+/// current format. The stream must remain valid until close() is
+/// called. Returns \c false if no format is set or if writing the
+/// header fails.
+bool MoleculeFile::create(std::ostream &output)
+{
+    if(!format()){
+        setErrorString("No file format set for writing.");
+        return false;
+    }
+
+    d->outputStream.reset(new boost::iostreams::filtering_ostream);
+
+    // insert stream compressor
+#ifndef CHEMKIT_OS_WIN32
+    if(compressionFormat() == "gz"){
+        d->outputStream->push(boost::iostreams::gzip_compressor());
+    }
+    else if(compressionFormat() == "bz2"){
+        d->outputStream->push(boost::iostreams::bzip2_compressor());
+    }
+    else if(compressionFormat() == "bgz"){
+        d->outputStream->push(BlockCompressor());
+    }
+#endif
+
+    d->outputStream->push(output);
+
+    bool ok = format()->writeHeader(this, *d->outputStream);
+    if(!ok){
+        setErrorString(format()->errorString());
+        d->outputStream.reset();
+        d->outputFile.reset();
+    }
+
+    return ok;
+}
+
+/// Returns \c true if the file is open for writing molecules.
+bool MoleculeFile::isCreated() const
+{
+    return d->outputStream != 0;
+}
+
+/// Writes \p molecule to the file. The molecule is not added to the
+/// file. Returns \c false if the file is not open for writing or if
+/// an error occurs.
+bool MoleculeFile::writeMolecule(const boost::shared_ptr<Molecule> &molecule)
+{
+    if(!isCreated()){
+        setErrorString("File is not open for writing.");
+        return false;
+    }
+
+    bool ok = format()->writeMolecule(this, molecule, *d->outputStream);
+    if(!ok){
+        setErrorString(format()->errorString());
+    }
+
+    return ok;
+}
+
+/// Closes the file after reading or writing molecules. When writing,
+/// any data following the last molecule is written before the file
+/// is closed. Returns \c false if writing that data fails.
+bool MoleculeFile::close()
+{
+    d->inputStream.reset();
+    d->inputFile.reset();
+
+    bool ok = true;
+
+    if(d->outputStream){
+        ok = format()->writeFooter(this, *d->outputStream);
+        if(!ok){
+            setErrorString(format()->errorString());
+        }
+
+        // closing the stream flushes the compressor
+        d->outputStream->reset();
+        d->outputStream.reset();
+
+        if(d->outputFile){
+            d->outputFile->close();
+            ok &= !d->outputFile->fail();
+            d->outputFile.reset();
+        }
+    }
+
+    return ok;
+}
+
+// --- Indexed Input ------------------------------------------------------- //
+/// Scans the file for the location and name of each molecule record
+/// and writes the index to indexFileName(). Returns \c false if the
+/// file cannot be indexed. If the file is indexed but the index
+/// cannot be written the index is still available from index() and
+/// \c false is returned.
+///
+/// Only files in formats that support indexing (such as sdf and mol2)
+/// can be indexed. Compressed files can be indexed if they are block
+/// compressed (see BlockCompressedFile). The records in the index for
+/// a compressed file are located by their virtual offset and only the
+/// blocks containing a record are decompressed to fetch it.
+///
+/// \see openIndex(), fetchMolecule()
+bool MoleculeFile::createIndex()
+{
+    d->index.reset();
+    d->indexFormat.reset();
+    d->indexFile.close();
+    d->blockFile.reset();
+
+    if(fileName().empty()){
+        setErrorString("No file name set for indexing.");
+        return false;
+    }
+    else if(!format()){
+        setErrorString("No file format set for indexing.");
+        return false;
+    }
+
+    boost::uint64_t fileSize = 0;
+    boost::uint64_t fileTime = 0;
+
+    try {
+        fileSize = boost::filesystem::file_size(fileName());
+        fileTime = boost::filesystem::last_write_time(fileName());
+    }
+    catch(std::exception &){
+        setErrorString("Failed to open file for indexing.");
+        return false;
+    }
+
+    boost::scoped_ptr<MoleculeFileIndex> index(new MoleculeFileIndex);
+    index->setFileSize(fileSize);
+    index->setFileTime(fileTime);
+
+    if(compressionFormat().empty()){
+        try {
+            // empty files cannot be mapped
+            if(fileSize > 0){
+                d->indexFile.open(fileName());
+            }
+        }
+        catch(std::exception &){
+            setErrorString("Failed to open file for indexing.");
+            return false;
+        }
+
+        if(d->indexFile.is_open() &&
+           !format()->indexData(d->indexFile.data(), d->indexFile.size(), index.get())){
+            setErrorString(format()->errorString());
+            d->indexFile.close();
+            return false;
+        }
+    }
+    else{
+        if(!BlockCompressedFile::isBlockCompressed(fileName())){
+            setErrorString("Only block compressed files can be indexed.");
+            return false;
+        }
+
+        d->blockFile.reset(new BlockCompressedFile(fileName()));
+
+        std::string errorString;
+        if(!d->blockFile->open()){
+            setErrorString(d->blockFile->errorString());
+            d->blockFile.reset();
+            return false;
+        }
+        else if(!indexBlockCompressedFile(*d->blockFile, format(), index.get(), errorString)){
+            setErrorString(errorString);
+            d->blockFile.reset();
+            return false;
+        }
+    }
+
+    d->index.swap(index);
+    d->indexedFileName = fileName();
+
+    if(!d->index->write(indexFileName(fileName()))){
+        setErrorString(d->index->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+/// Opens the index for the file. If a valid index for the file was
+/// previously stored it is read from indexFileName(). Otherwise the
+/// index is created with createIndex(). Returns \c false if no index
+/// is available.
+///
+/// \see fetchMolecule()
+bool MoleculeFile::openIndex()
+{
+    if(d->index && d->indexedFileName == fileName()){
+        return true;
+    }
+
+    d->index.reset();
+    d->indexFormat.reset();
+    d->indexFile.close();
+    d->blockFile.reset();
+
+    if(fileName().empty() || !format()){
+        return createIndex();
+    }
+
+    // use the stored index if it was created for the current file
+    boost::scoped_ptr<MoleculeFileIndex> index(new MoleculeFileIndex);
+
+    try {
+        if(index->read(indexFileName(fileName())) &&
+           index->fileSize() == boost::filesystem::file_size(fileName()) &&
+           index->fileTime() == static_cast<boost::uint64_t>(boost::filesystem::last_write_time(fileName()))){
+            if(!compressionFormat().empty()){
+                d->blockFile.reset(new BlockCompressedFile(fileName()));
+                if(!d->blockFile->open()){
+                    d->blockFile.reset();
+                    return createIndex() || d->index;
+                }
+            }
+            else if(index->fileSize() > 0){
+                d->indexFile.open(fileName());
+            }
+
+            d->index.swap(index);
+            d->indexedFileName = fileName();
+            return true;
+        }
+    }
+    catch(std::exception &){
+        d->indexFile.close();
+    }
+
+    return createIndex() || d->index;
+}
+
+/// Returns the index for the file. Returns \c 0 if the index has not
+/// been opened.
+///
+/// \see openIndex()
+const MoleculeFileIndex* MoleculeFile::index() const
+{
+    return d->index.get();
+}
+
+/// Reads and returns the molecule at \p index in the file. Only the
+/// record for the molecule is parsed. The molecule is not added to
+/// the file. Returns a null pointer if the index cannot be opened, if
+/// \p index is out of range or if an error occurs.
+///
+/// \see openIndex()
+boost::shared_ptr<Molecule> MoleculeFile::fetchMolecule(size_t index)
+{
+    if(!openIndex()){
+        return boost::shared_ptr<Molecule>();
+    }
+
+    if(index >= d->index->size()){
+        setErrorString("Molecule index out of range.");
+        return boost::shared_ptr<Molecule>();
+    }
+
+    boost::uint64_t offset = d->index->offset(index);
+    boost::uint64_t length = d->index->length(index);
+
+    // find the record data, decompressing it from a compressed file
+    const char *data = 0;
+    if(d->blockFile){
+        if(!d->blockFile->read(offset, static_cast<size_t>(length), d->record)){
+            setErrorString(d->blockFile->errorString());
+            return boost::shared_ptr<Molecule>();
+        }
+
+        data = d->record.data();
+    }
+    else{
+        if(length > d->indexFile.size() || offset > d->indexFile.size() - length){
+            setErrorString("Index does not match file.");
+            return boost::shared_ptr<Molecule>();
+        }
+
+        data = d->indexFile.data() + offset;
+    }
+
+    // use a separate format object so that fetching molecules does not
+    // interfere with streaming input from the file
+    if(!d->indexFormat){
+        d->indexFormat.reset(MoleculeFileFormat::create(format()->name()));
+
+        if(!d->indexFormat){
+            setErrorString("Failed to create format for reading.");
+            return boost::shared_ptr<Molecule>();
+        }
+    }
+
+    boost::iostreams::stream<boost::iostreams::array_source> stream(data, static_cast<size_t>(length));
+
+    if(!d->indexFormat->readHeader(stream, this)){
+        setErrorString(d->indexFormat->errorString());
+        return boost::shared_ptr<Molecule>();
+    }
+
+    boost::shared_ptr<Molecule> molecule = d->indexFormat->readMolecule(stream, this);
+    if(!molecule){
+        setErrorString(d->indexFormat->errorString());
+    }
+
+    return molecule;
+}
+
+/// Reads and returns the first molecule in the file with \p name.
+/// Only the record for the molecule is parsed. Returns a null pointer
+/// if no molecule with \p name is found.
+///
+/// \see openIndex()
+boost::shared_ptr<Molecule> MoleculeFile::fetchMolecule(const std::string &name)
+{
+    if(!openIndex()){
+        return boost::shared_ptr<Molecule>();
+    }
+
+    size_t index = d->index->find(name);
+    if(index == d->index->size()){
+        setErrorString("Molecule not found.");
+        return boost::shared_ptr<Molecule>();
+    }
+
+    return fetchMolecule(index);
+}
+
 // --- Static Methods ------------------------------------------------------ //
+/// Returns the name of the index file for \p fileName.
+///
+/// \see createIndex()
+std::string MoleculeFile::indexFileName(const std::string &fileName)
+{
+    return fileName + ".index";
+}
+
 /// Reads and returns a molecule from the file. Returns a null pointer if
 /// there was an error reading the file or the file is empty.
 ///
@@ -50,6 +50,7 @@
 namespace chemkit {
 
 class Molecule;
+class MoleculeFileIndex;
 class MoleculeFilePrivate;
 
 class CHEMKIT_IO_EXPORT MoleculeFile : public GenericFile<MoleculeFile, MoleculeFileFormat>
@@ -77,7 +78,31 @@ public:
     bool contains(const boost::shared_ptr<Molecule> &molecule) const;
     void clear();
 
+    // streaming input
+    bool open();
+    bool open(const std::string &fileName);
+    bool open(std::istream &input);
+    bool isOpen() const;
+    boost::shared_ptr<Molecule> readMolecule();
+
+    // streaming output
+    bool create();
+    bool create(const std::string &fileName);
+    bool create(std::ostream &output);
+    bool isCreated() const;
+    bool writeMolecule(const boost::shared_ptr<Molecule> &molecule);
+
+    bool close();
+
+    // indexed input
+    bool createIndex();
+    bool openIndex();
+    const MoleculeFileIndex* index() const;
+    boost::shared_ptr<Molecule> fetchMolecule(size_t index);
+    boost::shared_ptr<Molecule> fetchMolecule(const std::string &name);
+
     // static methods
+    static std::string indexFileName(const std::string &fileName);
     static boost::shared_ptr<Molecule> quickRead(const std::string &fileName);
     static void quickWrite(const Molecule *molecule, const std::string &fileName);
 
@@ -38,11 +38,14 @@
 #include <map>
 
 #include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <chemkit/variantmap.h>
 #include <chemkit/pluginmanager.h>
 
+#include "moleculefile.h"
+
 namespace chemkit {
 
 // === MoleculeFileFormatPrivate =========================================== //
@@ -52,6 +55,9 @@ public:
     std::string name;
     std::string errorString;
     VariantMap options;
+    std::vector<boost::shared_ptr<Molecule> > streamMolecules;
+    size_t streamMoleculeIndex;
+    boost::scoped_ptr<MoleculeFile> outputFile;
 };
 
 // === MoleculeFileFormat ================================================== //
@@ -68,6 +74,12 @@ public:
 /// A list of supported molecule file formats is available at:
 /// http://wiki.chemkit.org/Features#Molecule_File_Formats
 ///
+/// Formats that can read or write one molecule at a time should
+/// reimplement the streaming methods (readHeader() and readMolecule()
+/// for input, writeHeader(), writeMolecule() and writeFooter() for
+/// output). The default implementations buffer the whole file using
+/// read() and write().
+///
 /// \see MoleculeFile, PolymerFileFormat
 
 // --- Construction and Destruction ---------------------------------------- //
@@ -76,6 +88,7 @@ MoleculeFileFormat::MoleculeFileFormat(const std::string &name)
     : d(new MoleculeFileFormatPrivate)
 {
     d->name = boost::algorithm::to_lower_copy(name);
+    d->streamMoleculeIndex = 0;
 }
 
 /// Destroys a molecule file format.
@@ -151,6 +164,128 @@ bool MoleculeFileFormat::write(const MoleculeFile *file, std::ostream &output)
     return false;
 }
 
+// --- Streaming Input ----------------------------------------------------- //
+/// Prepares to read molecules one at a time from \p input into
+/// \p file. This reads any header data that comes before the first
+/// molecule. Returns \c false if an error occurs.
+///
+/// The default implementation reads all of the molecules with read()
+/// and returns them one at a time from readMolecule().
+bool MoleculeFileFormat::readHeader(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    MoleculeFile buffer;
+    bool ok = read(input, &buffer);
+
+    d->streamMolecules.assign(buffer.molecules().begin(), buffer.molecules().end());
+    d->streamMoleculeIndex = 0;
+
+    return ok;
+}
+
+/// Reads and returns the next molecule from \p input. Returns a null
+/// pointer if there are no more molecules or if an error occurs.
+///
+/// This method is only valid after a call to readHeader().
+boost::shared_ptr<Molecule> MoleculeFileFormat::readMolecule(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    if(d->streamMoleculeIndex >= d->streamMolecules.size()){
+        d->streamMolecules.clear();
+        d->streamMoleculeIndex = 0;
+        return boost::shared_ptr<Molecule>();
+    }
+
+    // release the molecule from the buffer once it is returned
+    boost::shared_ptr<Molecule> molecule;
+    molecule.swap(d->streamMolecules[d->streamMoleculeIndex++]);
+
+    return molecule;
+}
+
+// --- Streaming Output ---------------------------------------------------- //
+/// Prepares to write molecules one at a time from \p file to
+/// \p output. This writes any header data that comes before the
+/// first molecule. Returns \c false if an error occurs.
+///
+/// The default implementation collects the molecules passed to
+/// writeMolecule() and writes them all with write() in writeFooter().
+bool MoleculeFileFormat::writeHeader(MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    d->outputFile.reset(new MoleculeFile);
+
+    return true;
+}
+
+/// Writes \p molecule to \p output. Returns \c false if an error
+/// occurs.
+///
+/// This method is only valid after a call to writeHeader().
+bool MoleculeFileFormat::writeMolecule(MoleculeFile *file,
+                                       const boost::shared_ptr<Molecule> &molecule,
+                                       std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    if(!d->outputFile){
+        setErrorString("Header not written.");
+        return false;
+    }
+
+    d->outputFile->addMolecule(molecule);
+
+    return true;
+}
+
+/// Writes any data that comes after the last molecule to \p output.
+/// Returns \c false if an error occurs.
+bool MoleculeFileFormat::writeFooter(MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    if(!d->outputFile){
+        setErrorString("Header not written.");
+        return false;
+    }
+
+    bool ok = write(d->outputFile.get(), output);
+    d->outputFile.reset();
+
+    return ok;
+}
+
+// --- Indexing ------------------------------------------------------------ //
+/// Scans the \p size bytes of file data at \p data for the location
+/// and name of each molecule record and adds them to \p index.
+/// Returns \c false if the format does not support indexing or an
+/// error occurs.
+///
+/// Each record added to the index must be readable on its own with
+/// readHeader() followed by readMolecule(). Formats should find the
+/// record boundaries without parsing the molecules.
+///
+/// When indexing compressed files the data is passed in pieces which
+/// may end part way through a record. The last record found in each
+/// piece is ignored and scanned again at the start of the next piece.
+///
+/// \see MoleculeFile::createIndex()
+bool MoleculeFileFormat::indexData(const char *data, size_t size, MoleculeFileIndex *index)
+{
+    CHEMKIT_UNUSED(data);
+    CHEMKIT_UNUSED(size);
+    CHEMKIT_UNUSED(index);
+
+    setErrorString((boost::format("'%s' indexing not supported.") % name()).str());
+    return false;
+}
+
 // --- Error Handling ------------------------------------------------------ //
 /// Sets a string describing the last error that occurred.
 void MoleculeFileFormat::setErrorString(const std::string &error)
@@ -43,6 +43,7 @@
 #include <istream>
 #include <ostream>
 
+#include <boost/shared_ptr.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 
 #include <chemkit/plugin.h>
@@ -50,7 +51,9 @@
 
 namespace chemkit {
 
+class Molecule;
 class MoleculeFile;
+class MoleculeFileIndex;
 class MoleculeFileFormatPrivate;
 
 class CHEMKIT_IO_EXPORT MoleculeFileFormat
@@ -71,6 +74,18 @@ public:
     virtual bool readMappedFile(const boost::iostreams::mapped_file_source &input, MoleculeFile *file);
     virtual bool write(const MoleculeFile *file, std::ostream &output);
 
+    // streaming input
+    virtual bool readHeader(std::istream &input, MoleculeFile *file);
+    virtual boost::shared_ptr<Molecule> readMolecule(std::istream &input, MoleculeFile *file);
+
+    // streaming output
+    virtual bool writeHeader(MoleculeFile *file, std::ostream &output);
+    virtual bool writeMolecule(MoleculeFile *file, const boost::shared_ptr<Molecule> &molecule, std::ostream &output);
+    virtual bool writeFooter(MoleculeFile *file, std::ostream &output);
+
+    // indexing
+    virtual bool indexData(const char *data, size_t size, MoleculeFileIndex *index);
+
     // error handling
     std::string errorString() const;
 
@@ -71,6 +71,69 @@ inline MoleculeFileFormatAdaptor<LineFormat>::~MoleculeFileFormatAdaptor()
 
 inline bool MoleculeFileFormatAdaptor<LineFormat>::read(std::istream &input, MoleculeFile *file)
 {
+    // lines are read in batches which are parsed in parallel
+    const size_t batchSize = 16384;
+
+    std::vector<std::string> formulas;
+    std::vector<std::string> names;
+    std::string line;
+
+    while(input){
+        formulas.clear();
+        names.clear();
+
+        while(formulas.size() < batchSize && std::getline(input, line)){
+            if(line.empty()){
+                continue;
+            }
+
+            formulas.push_back(std::string());
+            names.push_back(std::string());
+            splitLine(line, formulas.back(), names.back());
+        }
+
+        std::vector<Molecule *> molecules = m_format->readBatch(formulas);
+
+        for(size_t i = 0; i < molecules.size(); i++){
+            if(!molecules[i]){
+                continue;
+            }
+
+            boost::shared_ptr<Molecule> molecule(molecules[i]);
+            if(!names[i].empty()){
+                molecule->setName(names[i]);
+            }
+
+            file->addMolecule(molecule);
+        }
+    }
+
+    return true;
+}
+
+inline bool MoleculeFileFormatAdaptor<LineFormat>::write(const MoleculeFile *file, std::ostream &output)
+{
+    TextWriter writer(output);
+
+    BOOST_FOREACH(const boost::shared_ptr<Molecule> &molecule, file->molecules()){
+        writeLine(molecule.get(), writer);
+    }
+
+    return true;
+}
+
+inline bool MoleculeFileFormatAdaptor<LineFormat>::readHeader(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    return true;
+}
+
+inline boost::shared_ptr<Molecule> MoleculeFileFormatAdaptor<LineFormat>::readMolecule(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
     while(!input.eof()){
         std::string line;
         std::getline(input, line);
@@ -78,44 +141,91 @@ inline bool MoleculeFileFormatAdaptor<LineFormat>::read(std::istream &input, Mol
             continue;
         }
 
-        std::vector<std::string> lineItems;
-        boost::split(lineItems, line, boost::is_any_of("\t "));
-        if(lineItems.empty()){
-            continue;
-        }
+        std::string formula;
+        std::string name;
+        splitLine(line, formula, name);
 
-        std::string formula = lineItems[0];
         boost::shared_ptr<Molecule> molecule(m_format->read(formula));
         if(!molecule){
             continue;
         }
 
-        if(lineItems.size() >= 2){
-            molecule->setName(lineItems[1]);
+        if(!name.empty()){
+            molecule->setName(name);
         }
 
-        file->addMolecule(molecule);
+        return molecule;
     }
 
-    return true;
+    return boost::shared_ptr<Molecule>();
 }
 
-inline bool MoleculeFileFormatAdaptor<LineFormat>::write(const MoleculeFile *file, std::ostream &output)
+inline bool MoleculeFileFormatAdaptor<LineFormat>::writeHeader(MoleculeFile *file, std::ostream &output)
 {
-    BOOST_FOREACH(const boost::shared_ptr<Molecule> &molecule, file->molecules()){
-        std::string formula = m_format->write(molecule.get());
-        output << formula;
+    CHEMKIT_UNUSED(file);
 
-        if(!molecule->name().empty()){
-            output << " " << molecule->name();
-        }
+    // one writer buffers all of the molecules until writeFooter()
+    m_streamWriter.reset(new TextWriter(output));
 
-        output << "\n";
+    return true;
+}
+
+inline bool MoleculeFileFormatAdaptor<LineFormat>::writeMolecule(MoleculeFile *file,
+                                                                 const boost::shared_ptr<Molecule> &molecule,
+                                                                 std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    if(!m_streamWriter || &m_streamWriter->output() != &output){
+        m_streamWriter.reset(new TextWriter(output));
     }
 
+    writeLine(molecule.get(), *m_streamWriter);
+
+    return true;
+}
+
+inline bool MoleculeFileFormatAdaptor<LineFormat>::writeFooter(MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    // destroying the writer flushes it
+    m_streamWriter.reset();
+
     return true;
 }
 
+inline void MoleculeFileFormatAdaptor<LineFormat>::writeLine(const Molecule *molecule, TextWriter &writer)
+{
+    writer.write(m_format->write(molecule));
+
+    if(!molecule->name().empty()){
+        writer.write(' ');
+        writer.write(molecule->name());
+    }
+
+    writer.write('\n');
+}
+
+// Splits a line into the formula and the name that follows it. The
+// fields are separated by a single space or tab character.
+inline void MoleculeFileFormatAdaptor<LineFormat>::splitLine(const std::string &line,
+                                                             std::string &formula,
+                                                             std::string &name)
+{
+    size_t formulaEnd = line.find_first_of("\t ");
+    formula.assign(line, 0, formulaEnd);
+
+    if(formulaEnd == std::string::npos){
+        name.clear();
+    }
+    else{
+        size_t nameEnd = line.find_first_of("\t ", formulaEnd + 1);
+        name.assign(line, formulaEnd + 1, nameEnd == std::string::npos ? nameEnd : nameEnd - formulaEnd - 1);
+    }
+}
+
 // === MoleculeFileFormatAdaptor<PolymerFileFormat> ======================= //
 inline MoleculeFileFormatAdaptor<PolymerFileFormat>::MoleculeFileFormatAdaptor(PolymerFileFormat *format)
     : MoleculeFileFormat(format->name())
@@ -148,6 +258,53 @@ inline bool MoleculeFileFormatAdaptor<PolymerFileFormat>::read(std::istream &inp
     return true;
 }
 
+inline bool MoleculeFileFormatAdaptor<PolymerFileFormat>::readHeader(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    m_molecules.clear();
+
+    return true;
+}
+
+// Polymer files are read one entry at a time. The polymers and
+// ligands from each entry are returned before the next entry is read.
+inline boost::shared_ptr<Molecule> MoleculeFileFormatAdaptor<PolymerFileFormat>::readMolecule(std::istream &input, MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    // peek() rather than good() because formats which read the input
+    // through a streambuf iterator never set the end of file flag
+    while(m_molecules.empty() && input.peek() != std::char_traits<char>::eof()){
+        // read directly from the input so that no data past the end
+        // of the entry is buffered and lost
+        PolymerFile polymerFile;
+        bool ok = m_format->read(input, &polymerFile);
+        if(!ok){
+            setErrorString(m_format->errorString());
+            return boost::shared_ptr<Molecule>();
+        }
+
+        BOOST_FOREACH(const boost::shared_ptr<Polymer> &polymer, polymerFile.polymers()){
+            m_molecules.push_back(polymer);
+        }
+
+        BOOST_FOREACH(const boost::shared_ptr<Molecule> &ligand, polymerFile.ligands()){
+            m_molecules.push_back(ligand);
+        }
+    }
+
+    if(m_molecules.empty()){
+        return boost::shared_ptr<Molecule>();
+    }
+
+    boost::shared_ptr<Molecule> molecule = m_molecules.front();
+    m_molecules.pop_front();
+
+    return molecule;
+}
+
 } // end chemkit namespace
 
 #endif // CHEMKIT_MOLECULEFILEFORMATADAPTOR_INLINE_H
@@ -36,8 +36,13 @@
 #ifndef CHEMKIT_MOLECULEFILEFORMATADAPTOR_H
 #define CHEMKIT_MOLECULEFILEFORMATADAPTOR_H
 
+#include "textwriter.h"
 #include "moleculefileformat.h"
 
+#include <deque>
+
+#include <boost/scoped_ptr.hpp>
+
 namespace chemkit {
 
 class LineFormat;
@@ -58,9 +63,19 @@ public:
 
     virtual bool read(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
     virtual bool write(const MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    virtual bool readHeader(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
+    virtual boost::shared_ptr<Molecule> readMolecule(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
+    virtual bool writeHeader(MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    virtual bool writeMolecule(MoleculeFile *file, const boost::shared_ptr<Molecule> &molecule, std::ostream &output) CHEMKIT_OVERRIDE;
+    virtual bool writeFooter(MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+
+private:
+    void writeLine(const Molecule *molecule, TextWriter &writer);
+    static void splitLine(const std::string &line, std::string &formula, std::string &name);
 
 private:
     LineFormat *m_format;
+    boost::scoped_ptr<TextWriter> m_streamWriter;
 };
 
 template<>
@@ -71,9 +86,12 @@ public:
     virtual ~MoleculeFileFormatAdaptor();
 
     virtual bool read(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
+    virtual bool readHeader(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
+    virtual boost::shared_ptr<Molecule> readMolecule(std::istream &input, MoleculeFile *file) CHEMKIT_OVERRIDE;
 
 private:
     PolymerFileFormat *m_format;
+    std::deque<boost::shared_ptr<Molecule> > m_molecules;
 };
 
 } // end chemkit namespace
@@ -0,0 +1,489 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "moleculefileindex.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+// The molecule file index is stored in a sidecar file next to the
+// molecule file it describes. All values are stored little-endian.
+// The index starts with a header:
+//
+//   "CMFI" | version (u32) | file size (u64) | file time (u64)
+//          | record count (u64) | bucket count (u64) | names size (u64)
+//
+// followed by one entry for each record:
+//
+//   offset (u64) | length (u64) | name offset (u64) | name length (u32)
+//
+// then the name hash table, an array of bucket count record indices
+// (u32) using linear probing with empty buckets set to 0xffffffff,
+// and finally the record names stored back to back.
+
+namespace {
+
+const char FileMagic[] = "CMFI";
+const boost::uint32_t FormatVersion = 1;
+
+const size_t HeaderSize = 48;
+const size_t RecordSize = 28;
+
+const boost::uint32_t EmptyBucket = 0xffffffff;
+
+// --- Binary Encoding ----------------------------------------------------- //
+void appendUInt32(std::string &data, boost::uint32_t value)
+{
+    for(int i = 0; i < 4; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void appendUInt64(std::string &data, boost::uint64_t value)
+{
+    for(int i = 0; i < 8; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+boost::uint32_t readUInt32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint32_t value = 0;
+    for(int i = 3; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+boost::uint64_t readUInt64(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint64_t value = 0;
+    for(int i = 7; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+// 32-bit FNV-1a hash. The hash is part of the file format so it must
+// not depend on the platform or standard library.
+boost::uint32_t hashName(const char *name, size_t length)
+{
+    boost::uint32_t hash = 2166136261u;
+
+    for(size_t i = 0; i < length; i++){
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+} // end anonymous namespace
+
+namespace chemkit {
+
+// === MoleculeFileIndexPrivate ============================================ //
+class MoleculeFileIndexPrivate
+{
+public:
+    struct Record
+    {
+        boost::uint64_t offset;
+        boost::uint64_t length;
+        boost::uint64_t nameOffset;
+        boost::uint32_t nameLength;
+    };
+
+    bool nameEquals(const Record &record, const char *name, size_t length) const;
+    void insertBucket(boost::uint32_t index);
+    void rehash(size_t bucketCount);
+
+    boost::uint64_t fileSize;
+    boost::uint64_t fileTime;
+    std::vector<Record> records;
+    std::vector<boost::uint32_t> buckets;
+    std::string names;
+    std::string errorString;
+};
+
+bool MoleculeFileIndexPrivate::nameEquals(const Record &record, const char *name, size_t length) const
+{
+    return record.nameLength == length &&
+           std::memcmp(names.data() + record.nameOffset, name, length) == 0;
+}
+
+// Inserts the record at index into the hash table. Records with the
+// same name as an earlier record are not inserted so that lookups
+// return the first matching record in the file.
+void MoleculeFileIndexPrivate::insertBucket(boost::uint32_t index)
+{
+    const Record &record = records[index];
+    const char *name = names.data() + record.nameOffset;
+
+    size_t mask = buckets.size() - 1;
+    size_t bucket = hashName(name, record.nameLength) & mask;
+
+    while(buckets[bucket] != EmptyBucket){
+        if(nameEquals(records[buckets[bucket]], name, record.nameLength)){
+            return;
+        }
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    buckets[bucket] = index;
+}
+
+void MoleculeFileIndexPrivate::rehash(size_t bucketCount)
+{
+    buckets.assign(bucketCount, EmptyBucket);
+
+    for(size_t i = 0; i < records.size(); i++){
+        insertBucket(static_cast<boost::uint32_t>(i));
+    }
+}
+
+// === MoleculeFileIndex =================================================== //
+/// \class MoleculeFileIndex moleculefileindex.h chemkit/moleculefileindex.h
+/// \ingroup chemkit-io
+/// \brief The MoleculeFileIndex class contains the location and name
+///        of each record in a molecule file.
+///
+/// A molecule file index stores the byte offset and length of each
+/// molecule record in a file along with a hash table of the record
+/// names. This allows a single molecule to be read from a large file
+/// by its position or name without parsing the rest of the file.
+///
+/// Indexes are normally created and used through the MoleculeFile
+/// class which stores them in a sidecar file next to the molecule
+/// file (see MoleculeFile::createIndex()).
+///
+/// \see MoleculeFile
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new, empty molecule file index.
+MoleculeFileIndex::MoleculeFileIndex()
+    : d(new MoleculeFileIndexPrivate)
+{
+    d->fileSize = 0;
+    d->fileTime = 0;
+}
+
+/// Creates a new molecule file index as a copy of \p index.
+MoleculeFileIndex::MoleculeFileIndex(const MoleculeFileIndex &index)
+    : d(new MoleculeFileIndexPrivate(*index.d))
+{
+}
+
+/// Destroys the molecule file index.
+MoleculeFileIndex::~MoleculeFileIndex()
+{
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the number of records in the index.
+size_t MoleculeFileIndex::size() const
+{
+    return d->records.size();
+}
+
+/// Returns \c true if the index contains no records.
+bool MoleculeFileIndex::isEmpty() const
+{
+    return d->records.empty();
+}
+
+/// Sets the size of the indexed file to \p size.
+void MoleculeFileIndex::setFileSize(boost::uint64_t size)
+{
+    d->fileSize = size;
+}
+
+/// Returns the size of the indexed file. This is used to check
+/// whether the index is still valid for the file.
+boost::uint64_t MoleculeFileIndex::fileSize() const
+{
+    return d->fileSize;
+}
+
+/// Sets the modification time of the indexed file to \p time.
+void MoleculeFileIndex::setFileTime(boost::uint64_t time)
+{
+    d->fileTime = time;
+}
+
+/// Returns the modification time of the indexed file. This is used
+/// to check whether the index is still valid for the file.
+boost::uint64_t MoleculeFileIndex::fileTime() const
+{
+    return d->fileTime;
+}
+
+// --- Records ------------------------------------------------------------- //
+/// Adds a record to the index starting at \p offset with \p length
+/// bytes and \p name.
+void MoleculeFileIndex::addRecord(boost::uint64_t offset, boost::uint64_t length, const std::string &name)
+{
+    MoleculeFileIndexPrivate::Record record;
+    record.offset = offset;
+    record.length = length;
+    record.nameOffset = d->names.size();
+    record.nameLength = static_cast<boost::uint32_t>(name.size());
+
+    d->names.append(name);
+    d->records.push_back(record);
+
+    // keep the hash table at most half full
+    if(d->records.size() * 2 > d->buckets.size()){
+        d->rehash(std::max<size_t>(16, d->buckets.size() * 2));
+    }
+    else{
+        d->insertBucket(static_cast<boost::uint32_t>(d->records.size() - 1));
+    }
+}
+
+/// Returns the byte offset of the record at \p index.
+boost::uint64_t MoleculeFileIndex::offset(size_t index) const
+{
+    return d->records[index].offset;
+}
+
+/// Returns the length in bytes of the record at \p index.
+boost::uint64_t MoleculeFileIndex::length(size_t index) const
+{
+    return d->records[index].length;
+}
+
+/// Returns the name of the record at \p index.
+std::string MoleculeFileIndex::name(size_t index) const
+{
+    const MoleculeFileIndexPrivate::Record &record = d->records[index];
+
+    return d->names.substr(record.nameOffset, record.nameLength);
+}
+
+/// Returns the index of the first record with \p name. Returns
+/// size() if no record with \p name is found.
+size_t MoleculeFileIndex::find(const std::string &name) const
+{
+    if(d->buckets.empty()){
+        return size();
+    }
+
+    size_t mask = d->buckets.size() - 1;
+    size_t bucket = hashName(name.data(), name.size()) & mask;
+
+    while(d->buckets[bucket] != EmptyBucket){
+        boost::uint32_t index = d->buckets[bucket];
+
+        if(d->nameEquals(d->records[index], name.data(), name.size())){
+            return index;
+        }
+
+        bucket = (bucket + 1) & mask;
+    }
+
+    return size();
+}
+
+/// Removes all of the records from the index.
+void MoleculeFileIndex::clear()
+{
+    d->fileSize = 0;
+    d->fileTime = 0;
+    d->records.clear();
+    d->buckets.clear();
+    d->names.clear();
+}
+
+// --- Input and Output ---------------------------------------------------- //
+/// Reads the index from the file with \p fileName. Returns \c false
+/// if the file cannot be read or is not a valid index.
+bool MoleculeFileIndex::read(const std::string &fileName)
+{
+    clear();
+
+    std::ifstream file(fileName.c_str(), std::ios_base::in | std::ios_base::binary);
+    if(!file.is_open()){
+        d->errorString = "Failed to open index file for reading.";
+        return false;
+    }
+
+    std::string data((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+    if(data.size() < HeaderSize ||
+       std::memcmp(data.data(), FileMagic, 4) != 0 ||
+       readUInt32(data.data() + 4) != FormatVersion){
+        d->errorString = "Invalid index file header.";
+        return false;
+    }
+
+    const char *header = data.data();
+    boost::uint64_t fileSize = readUInt64(header + 8);
+    boost::uint64_t fileTime = readUInt64(header + 16);
+    boost::uint64_t recordCount = readUInt64(header + 24);
+    boost::uint64_t bucketCount = readUInt64(header + 32);
+    boost::uint64_t namesSize = readUInt64(header + 40);
+
+    // bucket count must be a power of two at least twice the record
+    // count, as kept by addRecord(). the sizes are compared against the
+    // data one at a time so that they cannot overflow.
+    boost::uint64_t dataSize = data.size() - HeaderSize;
+    if(recordCount >= EmptyBucket ||
+       bucketCount < recordCount * 2 ||
+       (bucketCount & (bucketCount - 1)) != 0 ||
+       recordCount > dataSize / RecordSize ||
+       bucketCount > (dataSize - recordCount * RecordSize) / 4 ||
+       namesSize != dataSize - recordCount * RecordSize - bucketCount * 4){
+        d->errorString = "Invalid index file size.";
+        return false;
+    }
+
+    d->records.resize(recordCount);
+    const char *record = header + HeaderSize;
+    for(size_t i = 0; i < recordCount; i++, record += RecordSize){
+        MoleculeFileIndexPrivate::Record &entry = d->records[i];
+        entry.offset = readUInt64(record);
+        entry.length = readUInt64(record + 8);
+        entry.nameOffset = readUInt64(record + 16);
+        entry.nameLength = readUInt32(record + 24);
+
+        if(entry.nameLength > namesSize || entry.nameOffset > namesSize - entry.nameLength){
+            clear();
+            d->errorString = "Invalid index record.";
+            return false;
+        }
+    }
+
+    // find() stops at the first empty bucket so the table must not
+    // have more used buckets than records
+    d->buckets.resize(bucketCount);
+    const char *bucket = record;
+    size_t usedBucketCount = 0;
+    for(size_t i = 0; i < bucketCount; i++, bucket += 4){
+        d->buckets[i] = readUInt32(bucket);
+
+        if(d->buckets[i] != EmptyBucket &&
+           (d->buckets[i] >= recordCount || ++usedBucketCount > recordCount)){
+            clear();
+            d->errorString = "Invalid index hash table.";
+            return false;
+        }
+    }
+
+    d->names.assign(bucket, namesSize);
+    d->fileSize = fileSize;
+    d->fileTime = fileTime;
+
+    return true;
+}
+
+/// Writes the index to the file with \p fileName. Returns \c false
+/// if the file cannot be written.
+bool MoleculeFileIndex::write(const std::string &fileName) const
+{
+    std::string data(FileMagic, 4);
+    appendUInt32(data, FormatVersion);
+    appendUInt64(data, d->fileSize);
+    appendUInt64(data, d->fileTime);
+    appendUInt64(data, d->records.size());
+    appendUInt64(data, d->buckets.size());
+    appendUInt64(data, d->names.size());
+
+    data.reserve(data.size() +
+                 d->records.size() * RecordSize +
+                 d->buckets.size() * 4 +
+                 d->names.size());
+
+    for(size_t i = 0; i < d->records.size(); i++){
+        const MoleculeFileIndexPrivate::Record &record = d->records[i];
+        appendUInt64(data, record.offset);
+        appendUInt64(data, record.length);
+        appendUInt64(data, record.nameOffset);
+        appendUInt32(data, record.nameLength);
+    }
+
+    for(size_t i = 0; i < d->buckets.size(); i++){
+        appendUInt32(data, d->buckets[i]);
+    }
+
+    data.append(d->names);
+
+    std::ofstream file(fileName.c_str(), std::ios_base::out | std::ios_base::binary);
+    if(!file.is_open()){
+        d->errorString = "Failed to open index file for writing.";
+        return false;
+    }
+
+    file.write(data.data(), data.size());
+    file.close();
+
+    if(file.fail()){
+        d->errorString = "Failed to write index file.";
+        return false;
+    }
+
+    return true;
+}
+
+// --- Error Handling ------------------------------------------------------ //
+/// Returns a string describing the last error that occurred.
+std::string MoleculeFileIndex::errorString() const
+{
+    return d->errorString;
+}
+
+// --- Operators ----------------------------------------------------------- //
+MoleculeFileIndex& MoleculeFileIndex::operator=(const MoleculeFileIndex &index)
+{
+    if(&index != this){
+        *d = *index.d;
+    }
+
+    return *this;
+}
+
+} // end chemkit namespace
@@ -0,0 +1,89 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2011 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_MOLECULEFILEINDEX_H
+#define CHEMKIT_MOLECULEFILEINDEX_H
+
+#include "io.h"
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+
+namespace chemkit {
+
+class MoleculeFileIndexPrivate;
+
+class CHEMKIT_IO_EXPORT MoleculeFileIndex
+{
+public:
+    // construction and destruction
+    MoleculeFileIndex();
+    MoleculeFileIndex(const MoleculeFileIndex &index);
+    ~MoleculeFileIndex();
+
+    // properties
+    size_t size() const;
+    bool isEmpty() const;
+    void setFileSize(boost::uint64_t size);
+    boost::uint64_t fileSize() const;
+    void setFileTime(boost::uint64_t time);
+    boost::uint64_t fileTime() const;
+
+    // records
+    void addRecord(boost::uint64_t offset, boost::uint64_t length, const std::string &name);
+    boost::uint64_t offset(size_t index) const;
+    boost::uint64_t length(size_t index) const;
+    std::string name(size_t index) const;
+    size_t find(const std::string &name) const;
+    void clear();
+
+    // input and output
+    bool read(const std::string &fileName);
+    bool write(const std::string &fileName) const;
+
+    // error handling
+    std::string errorString() const;
+
+    // operators
+    MoleculeFileIndex& operator=(const MoleculeFileIndex &index);
+
+private:
+    MoleculeFileIndexPrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_MOLECULEFILEINDEX_H
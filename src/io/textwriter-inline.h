@@ -0,0 +1,109 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_TEXTWRITER_INLINE_H
+#define CHEMKIT_TEXTWRITER_INLINE_H
+
+#include "textwriter.h"
+
+#include <cstring>
+
+namespace chemkit {
+
+// --- Properties ---------------------------------------------------------- //
+/// Returns the stream that the writer flushes to.
+inline std::ostream& TextWriter::output() const
+{
+    return m_output;
+}
+
+/// Returns the size of the writer's buffer in bytes.
+inline size_t TextWriter::bufferSize() const
+{
+    return m_buffer.size();
+}
+
+/// Returns the number of bytes waiting in the buffer to be flushed.
+inline size_t TextWriter::size() const
+{
+    return m_size;
+}
+
+// --- Output -------------------------------------------------------------- //
+/// Writes \p character.
+inline void TextWriter::write(char character)
+{
+    if(m_size == m_buffer.size()){
+        flush();
+    }
+
+    m_buffer[m_size++] = character;
+}
+
+/// Writes the null-terminated \p string.
+inline void TextWriter::write(const char *string)
+{
+    write(string, std::strlen(string));
+}
+
+/// Writes \p size bytes from \p data.
+inline void TextWriter::write(const char *data, size_t size)
+{
+    if(size <= m_buffer.size() - m_size){
+        std::memcpy(&m_buffer[m_size], data, size);
+        m_size += size;
+    }
+    else{
+        writeSlow(data, size);
+    }
+}
+
+/// Writes \p string.
+inline void TextWriter::write(const std::string &string)
+{
+    write(string.data(), string.size());
+}
+
+/// Writes \p string right-aligned in a field of \p width characters.
+/// This is equivalent to the \c "%*s" printf() conversion.
+inline void TextWriter::writePadded(const std::string &string, size_t width)
+{
+    writePadding(string.size(), width);
+    write(string);
+}
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_TEXTWRITER_INLINE_H
@@ -0,0 +1,368 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "textwriter.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/special_functions/sign.hpp>
+
+namespace chemkit {
+
+namespace {
+
+// powers of ten that are exactly representable as doubles
+const double exactPowersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+const unsigned long long integerPowersOfTen[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL
+};
+
+// the largest precision handled by the fast formatting path
+const int maximumFastPrecision = 9;
+
+// scaled values must be below this bound so that the rounding
+// error of the scaling multiplication (at most 2^-22) is well
+// within the tolerance used to detect halfway cases
+const double maximumFastScaledValue = 2147483648.0;
+
+// values whose fractional digit lies this close to one half are
+// passed to snprintf() which rounds the exact binary value
+const double halfwayTolerance = 1e-6;
+
+// writes the digits of value backwards ending at end and returns
+// a pointer to the first digit
+inline char* formatDigits(unsigned long long value, char *end)
+{
+    do {
+        *--end = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value);
+
+    return end;
+}
+
+// returns magnitude * 10^shift with a single rounding
+inline double scaledValue(double magnitude, int shift)
+{
+    return shift >= 0 ? magnitude * exactPowersOfTen[shift]
+                      : magnitude / exactPowersOfTen[-shift];
+}
+
+// rounds magnitude * 10^shift to the nearest integer and stores it
+// in rounded. returns false if the result could be off by one.
+bool roundScaled(double magnitude, int shift, unsigned long long *rounded)
+{
+    double scaled = scaledValue(magnitude, shift);
+    if(!(scaled < maximumFastScaledValue)){
+        return false;
+    }
+
+    double integer = std::floor(scaled);
+    double fraction = scaled - integer;
+    if(std::fabs(fraction - 0.5) < halfwayTolerance){
+        return false;
+    }
+
+    *rounded = static_cast<unsigned long long>(integer) + (fraction > 0.5 ? 1 : 0);
+    return true;
+}
+
+// formats value as "%.*f" into buffer and returns its length or
+// zero if the value must be formatted by snprintf()
+size_t formatFixed(double value, int precision, char *buffer)
+{
+    if(precision < 0 || precision > maximumFastPrecision || !(boost::math::isfinite)(value)){
+        return 0;
+    }
+
+    unsigned long long rounded;
+    if(!roundScaled(std::fabs(value), precision, &rounded)){
+        return 0;
+    }
+
+    char digits[24];
+    char *end = digits + sizeof(digits);
+
+    // fractional digits padded with leading zeros
+    char *position = end;
+    if(precision > 0){
+        unsigned long long fraction = rounded % integerPowersOfTen[precision];
+        for(int i = 0; i < precision; i++){
+            *--position = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+
+        *--position = '.';
+    }
+
+    // integer digits
+    position = formatDigits(rounded / integerPowersOfTen[precision], position);
+
+    // negative values, including those that round to zero, keep
+    // their sign as they do with printf()
+    if((boost::math::signbit)(value)){
+        *--position = '-';
+    }
+
+    size_t size = end - position;
+    std::memcpy(buffer, position, size);
+    return size;
+}
+
+// formats value as "%.*g" into buffer and returns its length or
+// zero if the value must be formatted by snprintf()
+size_t formatGeneral(double value, int precision, char *buffer)
+{
+    if(precision == 0){
+        precision = 1;
+    }
+
+    if(precision < 0 || precision > maximumFastPrecision || !(boost::math::isfinite)(value)){
+        return 0;
+    }
+
+    double magnitude = std::fabs(value);
+    if(magnitude == 0){
+        size_t size = 0;
+        if((boost::math::signbit)(value)){
+            buffer[size++] = '-';
+        }
+        buffer[size++] = '0';
+        return size;
+    }
+
+    // find the decimal exponent of the value rounded to precision
+    // significant digits. the exponent from log10() may be off by one
+    // near powers of ten so it is checked against the scaled value.
+    int exponent = static_cast<int>(std::floor(std::log10(magnitude)));
+    if(exponent < -5 || exponent > precision){
+        return 0;
+    }
+
+    double scaled = scaledValue(magnitude, precision - 1 - exponent);
+    if(scaled < exactPowersOfTen[precision - 1]){
+        exponent--;
+    }
+    else if(scaled >= exactPowersOfTen[precision]){
+        exponent++;
+    }
+
+    unsigned long long rounded;
+    if(!roundScaled(magnitude, precision - 1 - exponent, &rounded)){
+        return 0;
+    }
+
+    if(rounded >= integerPowersOfTen[precision]){
+        exponent++;
+    }
+
+    // values outside of this range use exponential notation
+    if(exponent < -4 || exponent >= precision){
+        return 0;
+    }
+
+    size_t size = formatFixed(value, precision - 1 - exponent, buffer);
+
+    // remove trailing zeros and the decimal point
+    if(std::memchr(buffer, '.', size)){
+        while(buffer[size - 1] == '0'){
+            size--;
+        }
+
+        if(buffer[size - 1] == '.'){
+            size--;
+        }
+    }
+
+    return size;
+}
+
+} // end anonymous namespace
+
+// === TextWriter ========================================================== //
+/// \class TextWriter textwriter.h chemkit/textwriter.h
+/// \ingroup chemkit-io
+/// \brief The TextWriter class writes formatted text to a stream
+///        through a buffer.
+///
+/// The TextWriter class is used by file formats to write records
+/// without the overhead of a std::ostream insertion or a sprintf()
+/// call for each field. Text is appended to an internal buffer which
+/// is written to the output stream in large blocks when it fills, when
+/// flush() is called and when the writer is destroyed.
+///
+/// Numbers are formatted with writeInteger(), writeFixed() and
+/// writeGeneral() which produce the same text as the \c "%*d",
+/// \c "%*.*f" and \c "%*.*g" printf() conversions in the "C" locale.
+/// Common values are formatted directly and the rest (very large
+/// values, exact rounding ties and exponential notation) are passed to
+/// snprintf() so the output is always identical.
+///
+/// For example, to write the coordinates of an atom as in a MDL
+/// atom block:
+/// \code
+/// chemkit::TextWriter writer(output);
+///
+/// writer.writeFixed(atom->x(), 4, 10);
+/// writer.writeFixed(atom->y(), 4, 10);
+/// writer.writeFixed(atom->z(), 4, 10);
+/// writer.write('\n');
+/// \endcode
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new text writer for \p output with a buffer of
+/// \p bufferSize bytes.
+TextWriter::TextWriter(std::ostream &output, size_t bufferSize)
+    : m_output(output),
+      m_buffer(bufferSize > 0 ? bufferSize : 1),
+      m_size(0)
+{
+}
+
+/// Destroys the text writer. Any buffered text is flushed.
+TextWriter::~TextWriter()
+{
+    flush();
+}
+
+// --- Output -------------------------------------------------------------- //
+/// Writes \p value as a decimal integer right-aligned in a field of
+/// \p width characters. This is equivalent to the \c "%*lld" printf()
+/// conversion.
+void TextWriter::writeInteger(long long value, size_t width)
+{
+    char digits[24];
+    char *end = digits + sizeof(digits);
+
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    char *position = formatDigits(magnitude, end);
+    if(value < 0){
+        *--position = '-';
+    }
+
+    size_t size = end - position;
+    writePadding(size, width);
+    write(position, size);
+}
+
+/// Writes \p value with \p precision digits after the decimal point
+/// right-aligned in a field of \p width characters. This is
+/// equivalent to the \c "%*.*f" printf() conversion.
+void TextWriter::writeFixed(double value, int precision, size_t width)
+{
+    char buffer[32];
+    size_t size = formatFixed(value, precision, buffer);
+    if(size == 0){
+        writeFormatted("%*.*f", precision, width, value);
+        return;
+    }
+
+    writePadding(size, width);
+    write(buffer, size);
+}
+
+/// Writes \p value with \p precision significant digits right-aligned
+/// in a field of \p width characters. This is equivalent to the
+/// \c "%*.*g" printf() conversion.
+void TextWriter::writeGeneral(double value, int precision, size_t width)
+{
+    char buffer[32];
+    size_t size = formatGeneral(value, precision, buffer);
+    if(size == 0){
+        writeFormatted("%*.*g", precision, width, value);
+        return;
+    }
+
+    writePadding(size, width);
+    write(buffer, size);
+}
+
+/// Writes the buffered text to the output stream.
+void TextWriter::flush()
+{
+    if(m_size > 0){
+        m_output.write(&m_buffer[0], m_size);
+        m_size = 0;
+    }
+}
+
+// --- Internal Methods ---------------------------------------------------- //
+void TextWriter::writeSlow(const char *data, size_t size)
+{
+    flush();
+
+    if(size >= m_buffer.size()){
+        m_output.write(data, size);
+    }
+    else{
+        std::memcpy(&m_buffer[0], data, size);
+        m_size = size;
+    }
+}
+
+void TextWriter::writePadding(size_t size, size_t width)
+{
+    for(; size < width; size++){
+        write(' ');
+    }
+}
+
+void TextWriter::writeFormatted(const char *format, int precision, size_t width, double value)
+{
+    char buffer[64];
+    int size = snprintf(buffer, sizeof(buffer), format, static_cast<int>(width), precision, value);
+    if(size < 0){
+        return;
+    }
+    else if(static_cast<size_t>(size) < sizeof(buffer)){
+        write(buffer, size);
+        return;
+    }
+
+    std::vector<char> largeBuffer(size + 1);
+    snprintf(&largeBuffer[0], largeBuffer.size(), format, static_cast<int>(width), precision, value);
+    write(&largeBuffer[0], size);
+}
+
+} // end chemkit namespace
@@ -0,0 +1,90 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CHEMKIT_TEXTWRITER_H
+#define CHEMKIT_TEXTWRITER_H
+
+#include "io.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace chemkit {
+
+class CHEMKIT_IO_EXPORT TextWriter
+{
+public:
+    // enumerations
+    enum {
+        DefaultBufferSize = 65536
+    };
+
+    // construction and destruction
+    TextWriter(std::ostream &output, size_t bufferSize = DefaultBufferSize);
+    ~TextWriter();
+
+    // properties
+    std::ostream& output() const;
+    size_t bufferSize() const;
+    size_t size() const;
+
+    // output
+    void write(char character);
+    void write(const char *string);
+    void write(const char *data, size_t size);
+    void write(const std::string &string);
+    void writePadded(const std::string &string, size_t width);
+    void writeInteger(long long value, size_t width = 0);
+    void writeFixed(double value, int precision, size_t width = 0);
+    void writeGeneral(double value, int precision, size_t width = 0);
+    void flush();
+
+private:
+    void writeSlow(const char *data, size_t size);
+    void writePadding(size_t size, size_t width);
+    void writeFormatted(const char *format, int precision, size_t width, double value);
+
+private:
+    std::ostream &m_output;
+    std::vector<char> m_buffer;
+    size_t m_size;
+};
+
+} // end chemkit namespace
+
+#include "textwriter-inline.h"
+
+#endif // CHEMKIT_TEXTWRITER_H
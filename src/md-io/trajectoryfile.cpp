@@ -35,6 +35,16 @@
 
 #include "trajectoryfile.h"
 
+#include <fstream>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#ifndef CHEMKIT_OS_WIN32
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#endif
+
 #include <chemkit/trajectory.h>
 
 namespace chemkit {
@@ -45,6 +55,10 @@ class TrajectoryFilePrivate
 public:
     boost::shared_ptr<Trajectory> trajectory;
     boost::shared_ptr<Topology> topology;
+    boost::scoped_ptr<std::ifstream> inputFile;
+    boost::scoped_ptr<boost::iostreams::filtering_istream> inputStream;
+    boost::scoped_ptr<std::ofstream> outputFile;
+    boost::scoped_ptr<boost::iostreams::filtering_ostream> outputStream;
 };
 
 // === TrajectoryFile ====================================================== //
@@ -55,6 +69,36 @@ public:
 /// A list of supported trajectory file formats is available at:
 /// http://wiki.chemkit.org/Features#Trajectory_File_Formats
 ///
+/// Along with reading the whole trajectory into memory with read(),
+/// frames can be streamed from the file one at a time. After calling
+/// open(), each call to readFrame() decodes the next frame into a
+/// caller-owned TrajectoryFrame:
+/// \code
+/// TrajectoryFile file("trajectory.xtc");
+/// file.open();
+///
+/// Trajectory trajectory;
+/// TrajectoryFrame *frame = trajectory.addFrame();
+///
+/// while(file.readFrame(frame)){
+///     // process frame
+/// }
+/// \endcode
+///
+/// Frames can be written one at a time in the same way. After
+/// calling create(), each call to writeFrame() writes the next frame
+/// to the file and close() finishes writing the file:
+/// \code
+/// TrajectoryFile output("output.mdcrd");
+/// output.create();
+///
+/// while(input.readFrame(frame)){
+///     output.writeFrame(frame);
+/// }
+///
+/// output.close();
+/// \endcode
+///
 /// \see Trajectory, TrajectoryFileFormat
 
 // --- Construction and Destruction ---------------------------------------- //
@@ -74,6 +118,8 @@ TrajectoryFile::TrajectoryFile(const std::string &fileName)
 /// Destroys the trajectory file object.
 TrajectoryFile::~TrajectoryFile()
 {
+    close();
+
     delete d;
 }
 
@@ -110,4 +156,218 @@ boost::shared_ptr<Trajectory> TrajectoryFile::trajectory() const
     return d->trajectory;
 }
 
+// --- Streaming Input ----------------------------------------------------- //
+/// Opens the file for reading frames one at a time using the current
+/// file name. Returns \c false if no file name or format is set or
+/// if the file cannot be opened.
+///
+/// \see readFrame(), close()
+bool TrajectoryFile::open()
+{
+    if(fileName().empty()){
+        setErrorString("No file name set for reading.");
+        return false;
+    }
+
+    close();
+
+    d->inputFile.reset(new std::ifstream(fileName().c_str(), std::ios_base::in | std::ios_base::binary));
+    if(!d->inputFile->is_open()){
+        d->inputFile.reset();
+        setErrorString("Failed to open file for reading.");
+        return false;
+    }
+
+    return open(*d->inputFile);
+}
+
+/// Opens the file with \p fileName for reading frames one at a time.
+/// Returns \c false if the file cannot be opened.
+bool TrajectoryFile::open(const std::string &fileName)
+{
+    setFileName(fileName);
+
+    return open();
+}
+
+/// Opens \p input for reading frames one at a time using the current
+/// format. The stream must remain valid until close() is called.
+/// Returns \c false if no format is set or if reading the header
+/// fails.
+bool TrajectoryFile::open(std::istream &input)
+{
+    if(!format()){
+        setErrorString("No file format set for reading.");
+        return false;
+    }
+
+    d->inputStream.reset(new boost::iostreams::filtering_istream);
+
+    // insert input stream, decompressing it in a separate thread
+    if(DecompressionSource::isSupported(compressionFormat())){
+        d->inputStream->push(DecompressionSource(input, compressionFormat()));
+    }
+    else{
+        d->inputStream->push(input);
+    }
+
+    bool ok = format()->readHeader(*d->inputStream, this);
+    if(!ok){
+        setErrorString(format()->errorString());
+        close();
+    }
+
+    return ok;
+}
+
+/// Returns \c true if the file is open for reading frames.
+bool TrajectoryFile::isOpen() const
+{
+    return d->inputStream != 0;
+}
+
+/// Reads the next frame from the file into \p frame. The trajectory
+/// containing \p frame is resized if its size differs from the size
+/// of the frames in the file. Returns \c false if the file is not
+/// open, if there are no more frames or if an error occurs.
+bool TrajectoryFile::readFrame(TrajectoryFrame *frame)
+{
+    if(!isOpen()){
+        setErrorString("File is not open for reading.");
+        return false;
+    }
+
+    bool ok = format()->readFrame(*d->inputStream, this, frame);
+    if(!ok && !format()->errorString().empty()){
+        setErrorString(format()->errorString());
+    }
+
+    return ok;
+}
+
+// --- Streaming Output ---------------------------------------------------- //
+/// Creates the file for writing frames one at a time using the
+/// current file name. Returns \c false if no file name or format is
+/// set or if the file cannot be created.
+///
+/// \see writeFrame(), close()
+bool TrajectoryFile::create()
+{
+    if(fileName().empty()){
+        setErrorString("No file name set for writing.");
+        return false;
+    }
+
+    close();
+
+    d->outputFile.reset(new std::ofstream(fileName().c_str(), std::ios_base::out | std::ios_base::binary));
+    if(!d->outputFile->is_open()){
+        d->outputFile.reset();
+        setErrorString("Failed to open file for writing.");
+        return false;
+    }
+
+    return create(*d->outputFile);
+}
+
+/// Creates the file with \p fileName for writing frames one at a
+/// time. Returns \c false if the file cannot be created.
+bool TrajectoryFile::create(const std::string &fileName)
+{
+    setFileName(fileName);
+
+    return create();
+}
+
+/// Prepares \p output for writing frames one at a time using the
+/// current format. The stream must remain valid until close() is
+/// called. Returns \c false if no format is set or if writing the
+/// header fails.
+bool TrajectoryFile::create(std::ostream &output)
+{
+    if(!format()){
+        setErrorString("No file format set for writing.");
+        return false;
+    }
+
+    d->outputStream.reset(new boost::iostreams::filtering_ostream);
+
+    // insert stream compressor
+#ifndef CHEMKIT_OS_WIN32
+    if(compressionFormat() == "gz"){
+        d->outputStream->push(boost::iostreams::gzip_compressor());
+    }
+    else if(compressionFormat() == "bz2"){
+        d->outputStream->push(boost::iostreams::bzip2_compressor());
+    }
+    else if(compressionFormat() == "bgz"){
+        d->outputStream->push(BlockCompressor());
+    }
+#endif
+
+    d->outputStream->push(output);
+
+    bool ok = format()->writeHeader(this, *d->outputStream);
+    if(!ok){
+        setErrorString(format()->errorString());
+        d->outputStream.reset();
+        d->outputFile.reset();
+    }
+
+    return ok;
+}
+
+/// Returns \c true if the file is open for writing frames.
+bool TrajectoryFile::isCreated() const
+{
+    return d->outputStream != 0;
+}
+
+/// Writes \p frame to the file. Returns \c false if the file is not
+/// open for writing or if an error occurs.
+bool TrajectoryFile::writeFrame(const TrajectoryFrame *frame)
+{
+    if(!isCreated()){
+        setErrorString("File is not open for writing.");
+        return false;
+    }
+
+    bool ok = format()->writeFrame(this, frame, *d->outputStream);
+    if(!ok){
+        setErrorString(format()->errorString());
+    }
+
+    return ok;
+}
+
+/// Closes the file after reading or writing frames. When writing,
+/// any data following the last frame is written before the file is
+/// closed. Returns \c false if writing that data fails.
+bool TrajectoryFile::close()
+{
+    d->inputStream.reset();
+    d->inputFile.reset();
+
+    bool ok = true;
+
+    if(d->outputStream){
+        ok = format()->writeFooter(this, *d->outputStream);
+        if(!ok){
+            setErrorString(format()->errorString());
+        }
+
+        // closing the stream flushes the compressor
+        d->outputStream->reset();
+        d->outputStream.reset();
+
+        if(d->outputFile){
+            d->outputFile->close();
+            ok &= !d->outputFile->fail();
+            d->outputFile.reset();
+        }
+    }
+
+    return ok;
+}
+
 } // end chemkit namespace
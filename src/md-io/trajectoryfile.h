@@ -50,6 +50,7 @@ namespace chemkit {
 
 class Topology;
 class Trajectory;
+class TrajectoryFrame;
 class TrajectoryFilePrivate;
 
 class CHEMKIT_MD_IO_EXPORT TrajectoryFile : public GenericFile<TrajectoryFile, TrajectoryFileFormat>
@@ -71,6 +72,22 @@ public:
     void setTrajectory(const boost::shared_ptr<Trajectory> &trajectory);
     boost::shared_ptr<Trajectory> trajectory() const;
 
+    // streaming input
+    bool open();
+    bool open(const std::string &fileName);
+    bool open(std::istream &input);
+    bool isOpen() const;
+    bool readFrame(TrajectoryFrame *frame);
+
+    // streaming output
+    bool create();
+    bool create(const std::string &fileName);
+    bool create(std::ostream &output);
+    bool isCreated() const;
+    bool writeFrame(const TrajectoryFrame *frame);
+
+    bool close();
+
 private:
     TrajectoryFilePrivate* const d;
 };
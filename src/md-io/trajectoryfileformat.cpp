@@ -36,8 +36,14 @@
 #include "trajectoryfileformat.h"
 
 #include <boost/format.hpp>
+#include <boost/make_shared.hpp>
 
+#include <chemkit/unitcell.h>
+#include <chemkit/trajectory.h>
 #include <chemkit/pluginmanager.h>
+#include <chemkit/trajectoryframe.h>
+
+#include "trajectoryfile.h"
 
 namespace chemkit {
 
@@ -47,6 +53,9 @@ class TrajectoryFileFormatPrivate
 public:
     std::string name;
     std::string errorString;
+    boost::shared_ptr<Trajectory> streamTrajectory;
+    size_t streamFrameIndex;
+    boost::shared_ptr<Trajectory> outputTrajectory;
 };
 
 // === TrajectoryFormatFile ================================================ //
@@ -63,6 +72,7 @@ TrajectoryFileFormat::TrajectoryFileFormat(const std::string &name)
     : d(new TrajectoryFileFormatPrivate)
 {
     d->name = name;
+    d->streamFrameIndex = 0;
 }
 
 /// Destroys the trajectory file format object.
@@ -85,7 +95,7 @@ bool TrajectoryFileFormat::read(std::istream &input, TrajectoryFile *file)
     CHEMKIT_UNUSED(input);
     CHEMKIT_UNUSED(file);
 
-    setErrorString((boost::format("'%1' reading not supported.") % name()).str());
+    setErrorString((boost::format("'%s' reading not supported.") % name()).str());
     return false;
 }
 
@@ -108,10 +118,135 @@ bool TrajectoryFileFormat::write(const TrajectoryFile *file, std::ostream &outpu
     CHEMKIT_UNUSED(file);
     CHEMKIT_UNUSED(output);
 
-    setErrorString((boost::format("'%1' writing not supported.") % name()).str());
+    setErrorString((boost::format("'%s' writing not supported.") % name()).str());
     return false;
 }
 
+// --- Streaming Input ----------------------------------------------------- //
+/// Prepares to read frames one at a time from \p input into
+/// \p file. This reads any header data that comes before the first
+/// frame. Returns \c false if an error occurs.
+///
+/// The default implementation reads the entire trajectory using
+/// read() and keeps it until the last frame has been returned from
+/// readFrame().
+bool TrajectoryFileFormat::readHeader(std::istream &input, TrajectoryFile *file)
+{
+    boost::shared_ptr<Trajectory> trajectory = file->trajectory();
+
+    bool ok = read(input, file);
+
+    d->streamTrajectory = file->trajectory();
+    d->streamFrameIndex = 0;
+
+    // restore the file's previous trajectory
+    file->setTrajectory(trajectory);
+
+    return ok;
+}
+
+/// Reads the next frame from \p input into \p frame. The size of
+/// the trajectory that \p frame belongs to is set to the number of
+/// coordinates in the frame. Returns \c false if there are no more
+/// frames or if an error occurs.
+///
+/// This method is only valid after a call to readHeader().
+bool TrajectoryFileFormat::readFrame(std::istream &input, TrajectoryFile *file, TrajectoryFrame *frame)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    if(!d->streamTrajectory || d->streamFrameIndex >= d->streamTrajectory->frameCount()){
+        d->streamTrajectory.reset();
+        return false;
+    }
+
+    copyFrame(d->streamTrajectory->frame(d->streamFrameIndex++), frame);
+
+    return true;
+}
+
+// --- Streaming Output ---------------------------------------------------- //
+/// Prepares to write frames one at a time from \p file to \p output.
+/// This writes any header data that comes before the first frame.
+/// Returns \c false if an error occurs.
+///
+/// The default implementation collects the frames passed to
+/// writeFrame() and writes them all with write() in writeFooter().
+bool TrajectoryFileFormat::writeHeader(TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    d->outputTrajectory = boost::make_shared<Trajectory>();
+
+    return true;
+}
+
+/// Writes \p frame to \p output. Returns \c false if an error
+/// occurs.
+///
+/// This method is only valid after a call to writeHeader().
+bool TrajectoryFileFormat::writeFrame(TrajectoryFile *file, const TrajectoryFrame *frame, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    if(!d->outputTrajectory){
+        setErrorString("Header not written.");
+        return false;
+    }
+
+    copyFrame(frame, d->outputTrajectory->addFrame());
+
+    return true;
+}
+
+/// Writes any data that comes after the last frame to \p output.
+/// Returns \c false if an error occurs.
+bool TrajectoryFileFormat::writeFooter(TrajectoryFile *file, std::ostream &output)
+{
+    if(!d->outputTrajectory){
+        setErrorString("Header not written.");
+        return false;
+    }
+
+    boost::shared_ptr<Trajectory> trajectory = file->trajectory();
+    file->setTrajectory(d->outputTrajectory);
+
+    bool ok = write(file, output);
+
+    // restore the file's previous trajectory
+    file->setTrajectory(trajectory);
+    d->outputTrajectory.reset();
+
+    return ok;
+}
+
+/// Copies the time, coordinates and unit cell of \p source into
+/// \p target. The trajectory containing \p target is resized to the
+/// size of \p source if they differ.
+void TrajectoryFileFormat::copyFrame(const TrajectoryFrame *source, TrajectoryFrame *target)
+{
+    if(target->size() != source->size()){
+        target->trajectory()->resize(source->size());
+    }
+
+    for(size_t i = 0; i < source->size(); i++){
+        target->setPosition(i, source->position(i));
+    }
+
+    target->setTime(source->time());
+
+    const UnitCell *cell = source->unitCell();
+    if(cell){
+        target->setUnitCell(new UnitCell(cell->x(), cell->y(), cell->z()));
+    }
+    else{
+        target->setUnitCell(0);
+    }
+}
+
 // --- Error Handling ------------------------------------------------------ //
 /// Sets a string describing the last error that occurred.
 void TrajectoryFileFormat::setErrorString(const std::string &errorString)
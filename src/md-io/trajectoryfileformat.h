@@ -50,6 +50,7 @@
 namespace chemkit {
 
 class TrajectoryFile;
+class TrajectoryFrame;
 class TrajectoryFileFormatPrivate;
 
 class CHEMKIT_MD_IO_EXPORT TrajectoryFileFormat
@@ -66,6 +67,15 @@ public:
     virtual bool readMappedFile(const boost::iostreams::mapped_file_source &input, TrajectoryFile *file);
     virtual bool write(const TrajectoryFile *file, std::ostream &output);
 
+    // streaming input
+    virtual bool readHeader(std::istream &input, TrajectoryFile *file);
+    virtual bool readFrame(std::istream &input, TrajectoryFile *file, TrajectoryFrame *frame);
+
+    // streaming output
+    virtual bool writeHeader(TrajectoryFile *file, std::ostream &output);
+    virtual bool writeFrame(TrajectoryFile *file, const TrajectoryFrame *frame, std::ostream &output);
+    virtual bool writeFooter(TrajectoryFile *file, std::ostream &output);
+
     // error handling
     std::string errorString() const;
 
@@ -76,6 +86,7 @@ public:
 protected:
     TrajectoryFileFormat(const std::string &name);
     void setErrorString(const std::string &errorString);
+    static void copyFrame(const TrajectoryFrame *source, TrajectoryFrame *target);
 
 private:
     TrajectoryFileFormatPrivate* const d;
@@ -50,6 +50,7 @@ public:
     std::vector<Real> masses;
     std::vector<Real> charges;
     std::vector<Real> radii;
+    std::vector<std::string> residueNames;
     std::vector<Topology::BondedInteraction> bondedInteractions;
     std::vector<Topology::AngleInteraction> angleInteractions;
     std::vector<Topology::TorsionInteraction> torsionInteractions;
@@ -98,6 +99,7 @@ void Topology::resize(size_t size)
     d->masses.resize(size);
     d->charges.resize(size);
     d->radii.resize(size);
+    d->residueNames.resize(size);
 }
 
 /// Returns the size of the topology.
@@ -161,6 +163,23 @@ Real Topology::charge(size_t index)
     return d->charges[index];
 }
 
+/// Sets the name of the residue containing the atom at \p index to
+/// \p name.
+void Topology::setResidueName(size_t index, const std::string &name)
+{
+    assert(index < d->residueNames.size());
+
+    d->residueNames[index] = name;
+}
+
+/// Returns the name of the residue containing the atom at \p index.
+std::string Topology::residueName(size_t index) const
+{
+    assert(index < d->residueNames.size());
+
+    return d->residueNames[index];
+}
+
 // --- Interactions -------------------------------------------------------- //
 void Topology::addBondedInteraction(size_t i, size_t j)
 {
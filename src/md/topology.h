@@ -80,6 +80,8 @@ public:
     Real mass(size_t index);
     void setCharge(size_t index, Real charge);
     Real charge(size_t index);
+    void setResidueName(size_t index, const std::string &name);
+    std::string residueName(size_t index) const;
 
     // interations
     void addBondedInteraction(size_t i, size_t j);
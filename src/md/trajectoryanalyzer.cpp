@@ -0,0 +1,667 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#include "trajectoryanalyzer.h"
+
+#include <cmath>
+#include <iomanip>
+#include <algorithm>
+
+#include <Eigen/Core>
+#include <Eigen/SVD>
+#include <Eigen/LU>
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+
+#include <chemkit/foreach.h>
+#include <chemkit/concurrent.h>
+#include <chemkit/cartesiancoordinates.h>
+
+#include "trajectory.h"
+#include "trajectoryframe.h"
+
+namespace chemkit {
+
+namespace {
+
+typedef Eigen::Matrix<Real, 3, Eigen::Dynamic> PositionMatrix;
+
+// Sums of the fitted positions of each selected atom over a block of
+// frames. These are combined in frame order after each analysis pass
+// so that the fluctuations do not depend on the thread count.
+struct FluctuationSums
+{
+    PositionMatrix positions;
+    std::vector<Real> squaredNorms;
+    size_t frameCount;
+};
+
+} // end anonymous namespace
+
+// === TrajectoryAnalyzerPrivate =========================================== //
+class TrajectoryAnalyzerPrivate
+{
+public:
+    std::vector<size_t> selection;
+    std::vector<Real> masses;
+    CartesianCoordinates *reference;
+    bool referenceFromFrame;
+    size_t threadCount;
+    std::vector<std::vector<size_t> > measurements;
+
+    // results
+    std::vector<Real> times;
+    std::vector<Real> rmsd;
+    std::vector<Real> radiusOfGyration;
+    std::vector<std::vector<Real> > measurementValues;
+    FluctuationSums fluctuations;
+};
+
+// === TrajectoryAnalysisBlocks ============================================ //
+// Analyzes one block of frames. Each block writes to its own range of
+// the per-frame result arrays and to its own fluctuation sums so blocks
+// can be processed concurrently without locking.
+class TrajectoryAnalysisBlocks
+{
+public:
+    TrajectoryAnalysisBlocks(TrajectoryAnalyzerPrivate *d,
+                             const std::vector<TrajectoryFrame *> &frames,
+                             const std::vector<size_t> &atoms,
+                             const PositionMatrix &reference,
+                             size_t offset,
+                             size_t blockSize)
+        : d(d),
+          m_frames(frames),
+          m_atoms(atoms),
+          m_reference(reference),
+          m_offset(offset),
+          m_blockSize(blockSize),
+          m_sums((frames.size() + blockSize - 1) / blockSize)
+    {
+    }
+
+    size_t blockCount() const
+    {
+        return m_sums.size();
+    }
+
+    const FluctuationSums& sums(size_t block) const
+    {
+        return m_sums[block];
+    }
+
+    void analyzeBlock(size_t block)
+    {
+        size_t atomCount = m_atoms.size();
+
+        FluctuationSums &sums = m_sums[block];
+        sums.positions = PositionMatrix::Zero(3, atomCount);
+        sums.squaredNorms.assign(atomCount, 0);
+        sums.frameCount = 0;
+
+        PositionMatrix positions(3, atomCount);
+
+        size_t begin = block * m_blockSize;
+        size_t end = std::min(m_frames.size(), begin + m_blockSize);
+
+        for(size_t i = begin; i < end; i++){
+            const TrajectoryFrame *frame = m_frames[i];
+            const CartesianCoordinates *coordinates = frame->coordinates();
+            size_t index = m_offset + i;
+
+            d->times[index] = frame->time();
+
+            // measurements use the unfitted coordinates
+            for(size_t j = 0; j < d->measurements.size(); j++){
+                d->measurementValues[j][index] = measure(coordinates, d->measurements[j]);
+            }
+
+            if(atomCount == 0){
+                continue;
+            }
+
+            for(size_t j = 0; j < atomCount; j++){
+                positions.col(j) = (*coordinates)[m_atoms[j]];
+            }
+
+            // superimpose the selection onto the reference (kabsch)
+            Vector3 center = positions.rowwise().sum() / Real(atomCount);
+            positions.colwise() -= center;
+
+            Eigen::Matrix<Real, 3, 3> covariance = positions * m_reference.transpose();
+            Eigen::JacobiSVD<Eigen::Matrix<Real, 3, 3> > svd(covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+
+            Eigen::Matrix<Real, 3, 3> reflection = Eigen::Matrix<Real, 3, 3>::Identity();
+            if((svd.matrixV() * svd.matrixU().transpose()).determinant() < 0){
+                reflection(2, 2) = -1;
+            }
+
+            Eigen::Matrix<Real, 3, 3> rotation = svd.matrixV() * reflection * svd.matrixU().transpose();
+            positions = rotation * positions;
+
+            d->rmsd[index] = std::sqrt((positions - m_reference).squaredNorm() / Real(atomCount));
+            d->radiusOfGyration[index] = radiusOfGyration(positions);
+
+            sums.positions += positions;
+            for(size_t j = 0; j < atomCount; j++){
+                sums.squaredNorms[j] += positions.col(j).squaredNorm();
+            }
+            sums.frameCount++;
+        }
+    }
+
+private:
+    Real measure(const CartesianCoordinates *coordinates, const std::vector<size_t> &atoms) const
+    {
+        if(atoms.size() == 2){
+            return coordinates->distance(atoms[0], atoms[1]);
+        }
+        else if(atoms.size() == 3){
+            return coordinates->angle(atoms[0], atoms[1], atoms[2]);
+        }
+        else{
+            return coordinates->torsionAngle(atoms[0], atoms[1], atoms[2], atoms[3]);
+        }
+    }
+
+    Real radiusOfGyration(const PositionMatrix &positions) const
+    {
+        if(d->masses.empty()){
+            // positions are already centered on their geometric center
+            return std::sqrt(positions.squaredNorm() / Real(positions.cols()));
+        }
+
+        Real totalMass = 0;
+        Vector3 center = Vector3::Zero();
+        for(size_t j = 0; j < m_atoms.size(); j++){
+            Real mass = d->masses[m_atoms[j]];
+            center += mass * positions.col(j);
+            totalMass += mass;
+        }
+
+        if(totalMass <= 0){
+            return 0;
+        }
+
+        center /= totalMass;
+
+        Real sum = 0;
+        for(size_t j = 0; j < m_atoms.size(); j++){
+            sum += d->masses[m_atoms[j]] * (positions.col(j) - center).squaredNorm();
+        }
+
+        return std::sqrt(sum / totalMass);
+    }
+
+private:
+    TrajectoryAnalyzerPrivate *d;
+    const std::vector<TrajectoryFrame *> &m_frames;
+    const std::vector<size_t> &m_atoms;
+    const PositionMatrix &m_reference;
+    size_t m_offset;
+    size_t m_blockSize;
+    std::vector<FluctuationSums> m_sums;
+};
+
+// === TrajectoryAnalyzer ================================================== //
+/// \class TrajectoryAnalyzer trajectoryanalyzer.h chemkit/trajectoryanalyzer.h
+/// \ingroup chemkit-md
+/// \brief The TrajectoryAnalyzer class calculates structural
+///        properties over the frames of a trajectory.
+///
+/// For each frame the selected atoms are superimposed onto the
+/// reference coordinates and the root mean square deviation (RMSD)
+/// and radius of gyration are calculated. The root mean square
+/// fluctuation (RMSF) of each selected atom about its average fitted
+/// position is accumulated over all of the analyzed frames. Distance,
+/// angle and torsion angle time series can be added with the
+/// addDistance(), addAngle() and addTorsionAngle() methods.
+///
+/// Frames are distributed over threadCount() threads. Results are
+/// appended on each call to analyze() so long trajectories can be
+/// streamed through the analyzer a block of frames at a time without
+/// ever being loaded into memory at once.
+///
+/// The following example calculates the RMSD of each frame in a
+/// trajectory and writes the results to standard output:
+/// \code
+/// TrajectoryAnalyzer analyzer;
+/// analyzer.analyze(trajectory);
+/// analyzer.write(std::cout);
+/// \endcode
+///
+/// And this example streams a trajectory file through the analyzer
+/// one thousand frames at a time:
+/// \code
+/// TrajectoryFile file("trajectory.xtc");
+/// file.open();
+///
+/// Trajectory block;
+/// for(int i = 0; i < 1000; i++){
+///     block.addFrame();
+/// }
+///
+/// for(;;){
+///     std::vector<TrajectoryFrame *> frames;
+///     foreach(TrajectoryFrame *frame, block.frames()){
+///         if(!file.readFrame(frame)){
+///             break;
+///         }
+///
+///         frames.push_back(frame);
+///     }
+///
+///     if(frames.empty()){
+///         break;
+///     }
+///
+///     analyzer.analyze(frames);
+/// }
+/// \endcode
+///
+/// \see Trajectory, TrajectoryFrame
+
+// --- Construction and Destruction ---------------------------------------- //
+/// Creates a new trajectory analyzer.
+TrajectoryAnalyzer::TrajectoryAnalyzer()
+    : d(new TrajectoryAnalyzerPrivate)
+{
+    d->reference = 0;
+    d->referenceFromFrame = false;
+    d->threadCount = concurrent::idealThreadCount();
+    d->fluctuations.frameCount = 0;
+}
+
+/// Destroys the trajectory analyzer object.
+TrajectoryAnalyzer::~TrajectoryAnalyzer()
+{
+    delete d->reference;
+    delete d;
+}
+
+// --- Properties ---------------------------------------------------------- //
+/// Sets the indices of the atoms used for superposition, RMSD, RMSF
+/// and radius of gyration calculations to \p selection. If the
+/// selection is empty (the default) every atom is used.
+///
+/// The selection should be set before any frames are analyzed.
+void TrajectoryAnalyzer::setSelection(const std::vector<size_t> &selection)
+{
+    d->selection = selection;
+}
+
+/// Returns the indices of the selected atoms.
+std::vector<size_t> TrajectoryAnalyzer::selection() const
+{
+    return d->selection;
+}
+
+/// Sets the mass of each atom to \p masses. The masses are used to
+/// weight the radius of gyration. If no masses are set (the default)
+/// each atom is weighted equally.
+void TrajectoryAnalyzer::setMasses(const std::vector<Real> &masses)
+{
+    d->masses = masses;
+}
+
+/// Returns the mass of each atom.
+std::vector<Real> TrajectoryAnalyzer::masses() const
+{
+    return d->masses;
+}
+
+/// Sets the reference coordinates that each frame is superimposed
+/// onto to \p coordinates. The coordinates are copied. If no
+/// reference coordinates are set the coordinates from the first
+/// analyzed frame are used.
+void TrajectoryAnalyzer::setReferenceCoordinates(const CartesianCoordinates *coordinates)
+{
+    delete d->reference;
+    d->referenceFromFrame = false;
+
+    if(coordinates){
+        d->reference = new CartesianCoordinates(*coordinates);
+    }
+    else{
+        d->reference = 0;
+    }
+}
+
+/// Returns the reference coordinates.
+const CartesianCoordinates* TrajectoryAnalyzer::referenceCoordinates() const
+{
+    return d->reference;
+}
+
+/// Sets the number of threads used to analyze frames to
+/// \p threadCount. The default is the number of hardware threads
+/// available.
+void TrajectoryAnalyzer::setThreadCount(size_t threadCount)
+{
+    d->threadCount = std::max(size_t(1), threadCount);
+}
+
+/// Returns the number of threads used to analyze frames.
+size_t TrajectoryAnalyzer::threadCount() const
+{
+    return d->threadCount;
+}
+
+// --- Measurements -------------------------------------------------------- //
+/// Adds a measurement of the distance between atoms \p i and \p j.
+void TrajectoryAnalyzer::addDistance(size_t i, size_t j)
+{
+    std::vector<size_t> atoms(2);
+    atoms[0] = i;
+    atoms[1] = j;
+
+    d->measurements.push_back(atoms);
+    d->measurementValues.push_back(std::vector<Real>(frameCount()));
+}
+
+/// Adds a measurement of the angle between atoms \p i, \p j and
+/// \p k. The angle is in degrees.
+void TrajectoryAnalyzer::addAngle(size_t i, size_t j, size_t k)
+{
+    std::vector<size_t> atoms(3);
+    atoms[0] = i;
+    atoms[1] = j;
+    atoms[2] = k;
+
+    d->measurements.push_back(atoms);
+    d->measurementValues.push_back(std::vector<Real>(frameCount()));
+}
+
+/// Adds a measurement of the torsion angle between atoms \p i, \p j,
+/// \p k and \p l. The angle is in degrees.
+void TrajectoryAnalyzer::addTorsionAngle(size_t i, size_t j, size_t k, size_t l)
+{
+    std::vector<size_t> atoms(4);
+    atoms[0] = i;
+    atoms[1] = j;
+    atoms[2] = k;
+    atoms[3] = l;
+
+    d->measurements.push_back(atoms);
+    d->measurementValues.push_back(std::vector<Real>(frameCount()));
+}
+
+/// Returns the number of measurements.
+size_t TrajectoryAnalyzer::measurementCount() const
+{
+    return d->measurements.size();
+}
+
+/// Returns the name of the measurement at \p index (e.g.
+/// "distance(1,2)").
+std::string TrajectoryAnalyzer::measurementName(size_t index) const
+{
+    const std::vector<size_t> &atoms = d->measurements[index];
+
+    std::string name;
+    if(atoms.size() == 2){
+        name = "distance";
+    }
+    else if(atoms.size() == 3){
+        name = "angle";
+    }
+    else{
+        name = "torsion";
+    }
+
+    name += "(";
+    for(size_t i = 0; i < atoms.size(); i++){
+        if(i > 0){
+            name += ",";
+        }
+
+        name += (boost::format("%d") % atoms[i]).str();
+    }
+    name += ")";
+
+    return name;
+}
+
+// --- Analysis ------------------------------------------------------------ //
+/// Analyzes each frame in \p trajectory.
+void TrajectoryAnalyzer::analyze(const Trajectory *trajectory)
+{
+    analyze(trajectory->frames());
+}
+
+/// Analyzes each frame in \p frames. The results are appended to the
+/// results from any previously analyzed frames.
+void TrajectoryAnalyzer::analyze(const std::vector<TrajectoryFrame *> &frames)
+{
+    if(frames.empty()){
+        return;
+    }
+
+    // use the first frame as the reference if none has been set
+    if(!d->reference){
+        d->reference = new CartesianCoordinates(*frames.front()->coordinates());
+        d->referenceFromFrame = true;
+    }
+
+    // atoms used for superposition
+    std::vector<size_t> atoms = d->selection;
+    if(atoms.empty()){
+        size_t size = std::min(d->reference->size(), frames.front()->size());
+
+        atoms.resize(size);
+        for(size_t i = 0; i < size; i++){
+            atoms[i] = i;
+        }
+    }
+
+    PositionMatrix reference(3, atoms.size());
+    for(size_t i = 0; i < atoms.size(); i++){
+        reference.col(i) = (*d->reference)[atoms[i]];
+    }
+    if(!atoms.empty()){
+        reference.colwise() -= reference.rowwise().sum() / Real(atoms.size());
+    }
+
+    // make room for the results
+    size_t offset = frameCount();
+    size_t count = offset + frames.size();
+    d->times.resize(count);
+    d->rmsd.resize(count);
+    d->radiusOfGyration.resize(count);
+    for(size_t i = 0; i < d->measurementValues.size(); i++){
+        d->measurementValues[i].resize(count);
+    }
+
+    // split the frames into blocks and analyze them concurrently. the
+    // block size does not depend on the thread count so the summation
+    // order, and thus the results, are the same for any thread count
+    const size_t blockSize = 16;
+    TrajectoryAnalysisBlocks blocks(d, frames, atoms, reference, offset, blockSize);
+
+    concurrent::blockingFor(blocks.blockCount(),
+                            boost::bind(&TrajectoryAnalysisBlocks::analyzeBlock, &blocks, _1),
+                            d->threadCount);
+
+    // combine fluctuation sums in frame order
+    FluctuationSums &fluctuations = d->fluctuations;
+    if(fluctuations.frameCount == 0){
+        fluctuations.positions = PositionMatrix::Zero(3, atoms.size());
+        fluctuations.squaredNorms.assign(atoms.size(), 0);
+    }
+
+    for(size_t i = 0; i < blocks.blockCount(); i++){
+        const FluctuationSums &sums = blocks.sums(i);
+        if(sums.frameCount == 0 || sums.positions.cols() != fluctuations.positions.cols()){
+            continue;
+        }
+
+        fluctuations.positions += sums.positions;
+        for(size_t j = 0; j < sums.squaredNorms.size(); j++){
+            fluctuations.squaredNorms[j] += sums.squaredNorms[j];
+        }
+        fluctuations.frameCount += sums.frameCount;
+    }
+}
+
+/// Removes all of the results and the reference coordinates taken
+/// from the first analyzed frame.
+void TrajectoryAnalyzer::clear()
+{
+    d->times.clear();
+    d->rmsd.clear();
+    d->radiusOfGyration.clear();
+    for(size_t i = 0; i < d->measurementValues.size(); i++){
+        d->measurementValues[i].clear();
+    }
+
+    d->fluctuations.positions.resize(3, 0);
+    d->fluctuations.squaredNorms.clear();
+    d->fluctuations.frameCount = 0;
+
+    if(d->referenceFromFrame){
+        delete d->reference;
+        d->reference = 0;
+        d->referenceFromFrame = false;
+    }
+}
+
+// --- Results ------------------------------------------------------------- //
+/// Returns the number of frames that have been analyzed.
+size_t TrajectoryAnalyzer::frameCount() const
+{
+    return d->times.size();
+}
+
+/// Returns the time of each analyzed frame.
+std::vector<Real> TrajectoryAnalyzer::times() const
+{
+    return d->times;
+}
+
+/// Returns the root mean square deviation of the selected atoms from
+/// the reference coordinates for each analyzed frame after optimal
+/// superposition.
+std::vector<Real> TrajectoryAnalyzer::rmsd() const
+{
+    return d->rmsd;
+}
+
+/// Returns the root mean square fluctuation of each selected atom
+/// about its average superimposed position over all of the analyzed
+/// frames.
+std::vector<Real> TrajectoryAnalyzer::rmsf() const
+{
+    const FluctuationSums &fluctuations = d->fluctuations;
+    if(fluctuations.frameCount == 0){
+        return std::vector<Real>();
+    }
+
+    Real frameCount = Real(fluctuations.frameCount);
+
+    std::vector<Real> rmsf(fluctuations.squaredNorms.size());
+    for(size_t i = 0; i < rmsf.size(); i++){
+        Vector3 mean = fluctuations.positions.col(i) / frameCount;
+        Real variance = fluctuations.squaredNorms[i] / frameCount - mean.squaredNorm();
+        rmsf[i] = std::sqrt(std::max(Real(0), variance));
+    }
+
+    return rmsf;
+}
+
+/// Returns the radius of gyration of the selected atoms for each
+/// analyzed frame.
+std::vector<Real> TrajectoryAnalyzer::radiusOfGyration() const
+{
+    return d->radiusOfGyration;
+}
+
+/// Returns the value of the measurement at \p index for each
+/// analyzed frame.
+std::vector<Real> TrajectoryAnalyzer::measurement(size_t index) const
+{
+    return d->measurementValues[index];
+}
+
+// --- Output -------------------------------------------------------------- //
+/// Writes the per-frame results to \p output as tab-separated
+/// columns containing the frame number, time, RMSD, radius of
+/// gyration and then each measurement.
+bool TrajectoryAnalyzer::write(std::ostream &output) const
+{
+    output << "#frame\ttime\trmsd\trgyr";
+    for(size_t i = 0; i < measurementCount(); i++){
+        output << "\t" << measurementName(i);
+    }
+    output << "\n";
+
+    output << std::fixed << std::setprecision(4);
+
+    for(size_t frame = 0; frame < frameCount(); frame++){
+        output << frame
+               << "\t" << d->times[frame]
+               << "\t" << d->rmsd[frame]
+               << "\t" << d->radiusOfGyration[frame];
+
+        for(size_t i = 0; i < measurementCount(); i++){
+            output << "\t" << d->measurementValues[i][frame];
+        }
+
+        output << "\n";
+    }
+
+    return !output.fail();
+}
+
+/// Writes the RMSF of each selected atom to \p output as
+/// tab-separated columns containing the atom index and its RMSF.
+bool TrajectoryAnalyzer::writeRmsf(std::ostream &output) const
+{
+    std::vector<Real> rmsf = this->rmsf();
+
+    output << "#atom\trmsf\n";
+    output << std::fixed << std::setprecision(4);
+
+    for(size_t i = 0; i < rmsf.size(); i++){
+        size_t atom = d->selection.empty() ? i : d->selection[i];
+
+        output << atom << "\t" << rmsf[i] << "\n";
+    }
+
+    return !output.fail();
+}
+
+} // end chemkit namespace
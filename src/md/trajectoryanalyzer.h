@@ -0,0 +1,103 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#ifndef CHEMKIT_TRAJECTORYANALYZER_H
+#define CHEMKIT_TRAJECTORYANALYZER_H
+
+#include "md.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace chemkit {
+
+class Trajectory;
+class TrajectoryFrame;
+class CartesianCoordinates;
+class TrajectoryAnalyzerPrivate;
+
+class CHEMKIT_MD_EXPORT TrajectoryAnalyzer
+{
+public:
+    // construction and destruction
+    TrajectoryAnalyzer();
+    ~TrajectoryAnalyzer();
+
+    // properties
+    void setSelection(const std::vector<size_t> &selection);
+    std::vector<size_t> selection() const;
+    void setMasses(const std::vector<Real> &masses);
+    std::vector<Real> masses() const;
+    void setReferenceCoordinates(const CartesianCoordinates *coordinates);
+    const CartesianCoordinates* referenceCoordinates() const;
+    void setThreadCount(size_t threadCount);
+    size_t threadCount() const;
+
+    // measurements
+    void addDistance(size_t i, size_t j);
+    void addAngle(size_t i, size_t j, size_t k);
+    void addTorsionAngle(size_t i, size_t j, size_t k, size_t l);
+    size_t measurementCount() const;
+    std::string measurementName(size_t index) const;
+
+    // analysis
+    void analyze(const Trajectory *trajectory);
+    void analyze(const std::vector<TrajectoryFrame *> &frames);
+    void clear();
+
+    // results
+    size_t frameCount() const;
+    std::vector<Real> times() const;
+    std::vector<Real> rmsd() const;
+    std::vector<Real> rmsf() const;
+    std::vector<Real> radiusOfGyration() const;
+    std::vector<Real> measurement(size_t index) const;
+
+    // output
+    bool write(std::ostream &output) const;
+    bool writeRmsf(std::ostream &output) const;
+
+private:
+    CHEMKIT_DISABLE_COPY(TrajectoryAnalyzer)
+
+private:
+    TrajectoryAnalyzerPrivate* const d;
+};
+
+} // end chemkit namespace
+
+#endif // CHEMKIT_TRAJECTORYANALYZER_H
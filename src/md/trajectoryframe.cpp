@@ -150,9 +150,14 @@ const CartesianCoordinates* TrajectoryFrame::coordinates() const
 }
 
 // --- Unit Cell ----------------------------------------------------------- //
-/// Sets the unit cell for the frame to \p cell.
+/// Sets the unit cell for the frame to \p cell. The frame takes
+/// ownership of the cell and deletes any previously set cell.
 void TrajectoryFrame::setUnitCell(UnitCell *cell)
 {
+    if(cell != d->unitCell){
+        delete d->unitCell;
+    }
+
     d->unitCell = cell;
 }
 
@@ -33,22 +33,386 @@
 **
 ******************************************************************************/
 
+
 #include "mdcrdfileformat.h"
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
 #include <boost/make_shared.hpp>
+#include <boost/math/special_functions/sign.hpp>
 
+#include <chemkit/foreach.h>
+#include <chemkit/vector3.h>
+#include <chemkit/unitcell.h>
 #include <chemkit/topology.h>
 #include <chemkit/trajectory.h>
 #include <chemkit/trajectoryfile.h>
 #include <chemkit/trajectoryframe.h>
 #include <chemkit/cartesiancoordinates.h>
 
+// The mdcrd format stores the coordinates of each frame as "%8.3f"
+// fields with ten fields per line. Each frame starts on a new line
+// and may be followed by a line containing the three box lengths.
+// Because the fields are fixed width they are not always separated
+// by whitespace, so they are parsed by column rather than by token.
+
+namespace {
+
+const int FieldWidth = 8;
+const int FieldsPerLine = 10;
+
+enum FrameStatus {
+    EndOfFile,
+    InvalidFrame,
+    Frame,
+    FrameWithBox
+};
+
+// Reads lines from an input stream. The most recent line can be
+// pushed back to be returned again by the next call to readLine().
+class StreamLineReader
+{
+public:
+    StreamLineReader(std::istream &input, std::string &line, bool &pending)
+        : m_input(input),
+          m_line(line),
+          m_pending(pending)
+    {
+    }
+
+    bool readLine(const char **begin, const char **end)
+    {
+        if(!m_pending && !std::getline(m_input, m_line)){
+            return false;
+        }
+
+        m_pending = false;
+        *begin = m_line.data();
+        *end = m_line.data() + m_line.size();
+        return true;
+    }
+
+    void unreadLine()
+    {
+        m_pending = true;
+    }
+
+private:
+    std::istream &m_input;
+    std::string &m_line;
+    bool &m_pending;
+};
+
+// Reads lines directly from a memory buffer.
+class BufferLineReader
+{
+public:
+    BufferLineReader(const char *begin, const char *end)
+        : m_position(begin),
+          m_lineBegin(begin),
+          m_end(end)
+    {
+    }
+
+    bool readLine(const char **begin, const char **end)
+    {
+        if(m_position >= m_end){
+            return false;
+        }
+
+        m_lineBegin = m_position;
+
+        const char *newline = static_cast<const char *>(memchr(m_position, '\n', m_end - m_position));
+        if(newline){
+            *end = newline;
+            m_position = newline + 1;
+        }
+        else{
+            *end = m_end;
+            m_position = m_end;
+        }
+
+        *begin = m_lineBegin;
+        return true;
+    }
+
+    void unreadLine()
+    {
+        m_position = m_lineBegin;
+    }
+
+    const char* position() const
+    {
+        return m_position;
+    }
+
+private:
+    const char *m_position;
+    const char *m_lineBegin;
+    const char *m_end;
+};
+
+// Parses the number in the field [begin, end). Returns false if the
+// field does not contain a number.
+bool parseField(const char *begin, const char *end, chemkit::Real *value)
+{
+    while(begin < end && *begin == ' '){
+        begin++;
+    }
+
+    const char *p = begin;
+
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+
+    // accumulate every digit into an integer and scale it once at the
+    // end so the result is rounded the same as with strtod()
+    long long mantissa = 0;
+    int digitCount = 0;
+    int fractionDigitCount = 0;
+    bool fraction = false;
+
+    for(; p < end; p++){
+        char c = *p;
+
+        if(c >= '0' && c <= '9'){
+            mantissa = mantissa * 10 + (c - '0');
+            digitCount++;
+
+            if(fraction){
+                fractionDigitCount++;
+            }
+        }
+        else if(c == '.' && !fraction){
+            fraction = true;
+        }
+        else{
+            break;
+        }
+    }
+
+    if(p == end && digitCount > 0 && digitCount <= 18){
+        static const chemkit::Real powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+            1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+        };
+
+        *value = chemkit::Real(mantissa) / powers[fractionDigitCount];
+        if(negative){
+            *value = -*value;
+        }
+
+        return true;
+    }
+
+    // fall back to strtod() for anything unusual (e.g. exponents)
+    char buffer[64];
+    size_t length = std::min(size_t(end - begin), sizeof(buffer) - 1);
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    char *parseEnd = 0;
+    *value = strtod(buffer, &parseEnd);
+
+    while(*parseEnd == ' '){
+        parseEnd++;
+    }
+
+    return parseEnd != buffer && *parseEnd == '\0';
+}
+
+// Appends each field in the line [begin, end) to values. Returns the
+// number of fields in the line or -1 if a field is not a number.
+int parseLine(const char *begin, const char *end, std::vector<chemkit::Real> &values)
+{
+    while(end > begin && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')){
+        end--;
+    }
+
+    int count = 0;
+
+    for(const char *field = begin; field < end; field += FieldWidth){
+        const char *fieldEnd = std::min(field + FieldWidth, end);
+
+        chemkit::Real value;
+        if(!parseField(field, fieldEnd, &value)){
+            return -1;
+        }
+
+        values.push_back(value);
+        count++;
+    }
+
+    return count;
+}
+
+// Reads the coordinates for a frame of size atoms into values and
+// the box lengths, if present, into box.
+template<typename LineReader>
+FrameStatus readFrameValues(LineReader &reader,
+                            size_t size,
+                            std::vector<chemkit::Real> &values,
+                            chemkit::Vector3 &box)
+{
+    values.clear();
+
+    if(size == 0){
+        return EndOfFile;
+    }
+
+    const char *begin;
+    const char *end;
+
+    while(values.size() < 3 * size){
+        if(!reader.readLine(&begin, &end)){
+            return values.empty() ? EndOfFile : InvalidFrame;
+        }
+
+        if(parseLine(begin, end, values) < 0){
+            return InvalidFrame;
+        }
+    }
+
+    if(values.size() != 3 * size){
+        return InvalidFrame;
+    }
+
+    // a following line with three fields contains the box lengths (a
+    // one atom frame is indistinguishable from a box line so those
+    // are always treated as frames)
+    if(size > 1 && reader.readLine(&begin, &end)){
+        if(parseLine(begin, end, values) == 3){
+            box = chemkit::Vector3(values[3 * size + 0],
+                                   values[3 * size + 1],
+                                   values[3 * size + 2]);
+            values.resize(3 * size);
+            return FrameWithBox;
+        }
+
+        values.resize(3 * size);
+        reader.unreadLine();
+    }
+
+    return Frame;
+}
+
+void setFrame(chemkit::TrajectoryFrame *frame,
+              size_t size,
+              const std::vector<chemkit::Real> &values,
+              FrameStatus status,
+              const chemkit::Vector3 &box)
+{
+    if(frame->size() != size){
+        frame->trajectory()->resize(size);
+    }
+
+    for(size_t i = 0; i < size; i++){
+        frame->setPosition(i, chemkit::Point3(values[i*3+0], values[i*3+1], values[i*3+2]));
+    }
+
+    if(status == FrameWithBox){
+        frame->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(box.x(), 0, 0),
+                                                 chemkit::Vector3(0, box.y(), 0),
+                                                 chemkit::Vector3(0, 0, box.z())));
+    }
+    else{
+        frame->setUnitCell(0);
+    }
+}
+
+// Writes value into buffer formatted as "%8.3f". Like the fortran
+// writers used by amber, values which do not fit in the field are
+// written as asterisks.
+char* formatField(chemkit::Real value, char *buffer)
+{
+    bool negative = (boost::math::signbit)(value) != 0;
+
+    if(!(std::fabs(value) < (negative ? 999.9995 : 9999.9995))){
+        memset(buffer, '*', FieldWidth);
+        return buffer + FieldWidth;
+    }
+
+    // round the exact product of the value and 1000 to the nearest
+    // integer (ties to even) the same as printf() does. fma() gives
+    // the rounding error of the floating point product.
+    chemkit::Real magnitude = std::fabs(value);
+    chemkit::Real product = magnitude * 1000;
+    chemkit::Real error = fma(magnitude, 1000, -product);
+    chemkit::Real integer = std::floor(product);
+    chemkit::Real excess = ((product - integer) - 0.5) + error;
+
+    long long scaled = static_cast<long long>(integer);
+    if(excess > 0 || (excess == 0 && scaled % 2 == 1)){
+        scaled++;
+    }
+
+    // fill the field from right to left
+    char *p = buffer + FieldWidth;
+    for(int i = 0; i < 3; i++){
+        *--p = char('0' + scaled % 10);
+        scaled /= 10;
+    }
+    *--p = '.';
+    do {
+        *--p = char('0' + scaled % 10);
+        scaled /= 10;
+    } while(scaled > 0);
+
+    if(negative){
+        *--p = '-';
+    }
+
+    while(p > buffer){
+        *--p = ' ';
+    }
+
+    return buffer + FieldWidth;
+}
+
+} // end anonymous namespace
+
 MdcrdFileFormat::MdcrdFileFormat()
-    : chemkit::TrajectoryFileFormat("mdcrd")
+    : chemkit::TrajectoryFileFormat("mdcrd"),
+      m_size(0),
+      m_linePending(false)
 {
 }
 
 bool MdcrdFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    if(!readHeader(input, file)){
+        return false;
+    }
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory =
+        boost::make_shared<chemkit::Trajectory>(m_size);
+
+    for(;;){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+
+        if(!readFrame(input, file, frame)){
+            trajectory->removeFrame(frame);
+            break;
+        }
+    }
+
+    if(!errorString().empty()){
+        return false;
+    }
+
+    file->setTrajectory(trajectory);
+
+    return true;
+}
+
+bool MdcrdFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input,
+                                     chemkit::TrajectoryFile *file)
 {
     boost::shared_ptr<chemkit::Topology> topology = file->topology();
     if(!topology){
@@ -56,26 +420,159 @@ bool MdcrdFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
         return false;
     }
 
+    size_t size = topology->size();
+
     boost::shared_ptr<chemkit::Trajectory> trajectory =
-        boost::make_shared<chemkit::Trajectory>();
+        boost::make_shared<chemkit::Trajectory>(size);
 
-    trajectory->resize(topology->size());
+    BufferLineReader reader(input.data(), input.data() + input.size());
 
     // comments line
-    std::string comments;
-    std::getline(input, comments);
+    const char *begin;
+    const char *end;
+    reader.readLine(&begin, &end);
 
-    while(!input.eof()){
-        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+    std::vector<chemkit::Real> values;
+    values.reserve(3 * size + 3);
 
-        for(size_t i = 0; i < trajectory->size(); i++){
-            chemkit::Real x, y, z;
-            input >> x >> y >> z;
-            frame->setPosition(i, chemkit::Point3(x, y, z));
+    for(;;){
+        chemkit::Vector3 box;
+        FrameStatus status = readFrameValues(reader, size, values, box);
+
+        if(status == EndOfFile){
+            break;
+        }
+        else if(status == InvalidFrame){
+            setErrorString("Invalid or incomplete frame.");
+            return false;
         }
+
+        setFrame(trajectory->addFrame(), size, values, status, box);
     }
 
     file->setTrajectory(trajectory);
 
     return true;
 }
+
+bool MdcrdFileFormat::write(const chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = file->trajectory();
+    if(!trajectory){
+        setErrorString("No trajectory to write.");
+        return false;
+    }
+
+    // comments line
+    output << "trajectory written by chemkit\n";
+
+    foreach(const chemkit::TrajectoryFrame *frame, trajectory->frames()){
+        writeFrameData(frame, output);
+    }
+
+    return !output.fail();
+}
+
+bool MdcrdFileFormat::writeHeader(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    // comments line
+    output << "trajectory written by chemkit\n";
+
+    return !output.fail();
+}
+
+bool MdcrdFileFormat::writeFrame(chemkit::TrajectoryFile *file,
+                                 const chemkit::TrajectoryFrame *frame,
+                                 std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    writeFrameData(frame, output);
+
+    return !output.fail();
+}
+
+bool MdcrdFileFormat::writeFooter(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    return !output.fail();
+}
+
+bool MdcrdFileFormat::readHeader(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    setErrorString(std::string());
+
+    boost::shared_ptr<chemkit::Topology> topology = file->topology();
+    if(!topology){
+        setErrorString("Topology required to read 'mdcrd' trajectories.");
+        return false;
+    }
+
+    m_size = topology->size();
+    m_linePending = false;
+    m_values.reserve(3 * m_size + 3);
+
+    // comments line
+    std::getline(input, m_line);
+
+    return true;
+}
+
+bool MdcrdFileFormat::readFrame(std::istream &input, chemkit::TrajectoryFile *file, chemkit::TrajectoryFrame *frame)
+{
+    CHEMKIT_UNUSED(file);
+
+    StreamLineReader reader(input, m_line, m_linePending);
+
+    chemkit::Vector3 box;
+    FrameStatus status = readFrameValues(reader, m_size, m_values, box);
+
+    if(status == EndOfFile){
+        return false;
+    }
+    else if(status == InvalidFrame){
+        setErrorString("Invalid or incomplete frame.");
+        return false;
+    }
+
+    setFrame(frame, m_size, m_values, status, box);
+
+    return true;
+}
+
+void MdcrdFileFormat::writeFrameData(const chemkit::TrajectoryFrame *frame, std::ostream &output)
+{
+    // the frame is formatted into the buffer and written in one block
+    size_t valueCount = 3 * frame->size();
+    m_buffer.resize(valueCount * FieldWidth + valueCount / FieldsPerLine + 1);
+
+    char *p = &m_buffer[0];
+    const chemkit::CartesianCoordinates *coordinates = frame->coordinates();
+
+    for(size_t i = 0; i < valueCount; i++){
+        const chemkit::Point3 &position = (*coordinates)[i / 3];
+        p = formatField(position[i % 3], p);
+
+        if(i % FieldsPerLine == FieldsPerLine - 1 || i == valueCount - 1){
+            *p++ = '\n';
+        }
+    }
+
+    output.write(&m_buffer[0], p - &m_buffer[0]);
+
+    // box line
+    const chemkit::UnitCell *cell = frame->unitCell();
+    if(cell){
+        char line[3 * FieldWidth + 1];
+        p = line;
+        p = formatField(cell->x().norm(), p);
+        p = formatField(cell->y().norm(), p);
+        p = formatField(cell->z().norm(), p);
+        *p++ = '\n';
+
+        output.write(line, p - line);
+    }
+}
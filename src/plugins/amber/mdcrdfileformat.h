@@ -43,7 +43,24 @@ class MdcrdFileFormat : public chemkit::TrajectoryFileFormat
 public:
     MdcrdFileFormat();
 
-    virtual bool read(std::istream &input, chemkit::TrajectoryFile *file);
+    bool read(std::istream &input, chemkit::TrajectoryFile *file) CHEMKIT_OVERRIDE;
+    bool readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::TrajectoryFile *file) CHEMKIT_OVERRIDE;
+    bool write(const chemkit::TrajectoryFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool readHeader(std::istream &input, chemkit::TrajectoryFile *file) CHEMKIT_OVERRIDE;
+    bool readFrame(std::istream &input, chemkit::TrajectoryFile *file, chemkit::TrajectoryFrame *frame) CHEMKIT_OVERRIDE;
+    bool writeHeader(chemkit::TrajectoryFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFrame(chemkit::TrajectoryFile *file, const chemkit::TrajectoryFrame *frame, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFooter(chemkit::TrajectoryFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+
+private:
+    void writeFrameData(const chemkit::TrajectoryFrame *frame, std::ostream &output);
+
+private:
+    size_t m_size;
+    std::string m_line;
+    bool m_linePending;
+    std::vector<chemkit::Real> m_values;
+    std::vector<char> m_buffer;
 };
 
 #endif // MDCRDFILEFORMAT_H
@@ -90,185 +90,188 @@ bool CmlFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &i
 bool CmlFileFormat::readXML(const rapidxml::xml_document<> &doc, chemkit::MoleculeFile *file)
 {
     // parse molecules
-    boost::shared_ptr<chemkit::Molecule> molecule;
     rapidxml::xml_node<> *moleculeNode = doc.first_node("molecule");
     while(moleculeNode){
-        molecule = boost::make_shared<chemkit::Molecule>();
+        // add molecule to file
+        file->addMolecule(readMoleculeNode(moleculeNode));
 
-        chemkit::DiagramCoordinates *diagramCoordinates = 0;
-        chemkit::CartesianCoordinates *cartesianCoordinates = 0;
+        // move to next molecule
+        moleculeNode = moleculeNode->next_sibling("molecule");
+    }
 
-        // parse name
-        rapidxml::xml_node<> *nameNode = moleculeNode->first_node("name");
-        if(nameNode && nameNode->value()){
-            molecule->setName(nameNode->value());
-        }
+    return true;
+}
 
-        // parse atoms
-        rapidxml::xml_node<> *atomArrayNode = moleculeNode->first_node("atomArray");
-        if(atomArrayNode){
-            rapidxml::xml_node<> *atomNode = atomArrayNode->first_node("atom");
+boost::shared_ptr<chemkit::Molecule> CmlFileFormat::readMoleculeNode(rapidxml::xml_node<> *moleculeNode)
+{
+    boost::shared_ptr<chemkit::Molecule> molecule = boost::make_shared<chemkit::Molecule>();
 
-            while(atomNode){
-                chemkit::Point2f point2(0, 0);
-                chemkit::Point3 point3(0, 0, 0);
+    chemkit::DiagramCoordinates *diagramCoordinates = 0;
+    chemkit::CartesianCoordinates *cartesianCoordinates = 0;
 
-                rapidxml::xml_attribute<> *attr = atomNode->first_attribute();
-                while(attr){
-                    if(strcmp(attr->name(), "elementType") == 0){
-                        molecule->addAtom(attr->value());
-                    }
-                    else if(strcmp(attr->name(), "x2") == 0){
-                        point2[0] = static_cast<float>(strtod(attr->value(), 0));
-                    }
-                    else if(strcmp(attr->name(), "y2") == 0){
-                        point2[1] = static_cast<float>(strtod(attr->value(), 0));
-                    }
-                    else if(strcmp(attr->name(), "x3") == 0){
-                        point3[0] = strtod(attr->value(), 0);
-                    }
-                    else if(strcmp(attr->name(), "y3") == 0){
-                        point3[1] = strtod(attr->value(), 0);
-                    }
-                    else if(strcmp(attr->name(), "z3") == 0){
-                        point3[2] = strtod(attr->value(), 0);
-                    }
+    // parse name
+    rapidxml::xml_node<> *nameNode = moleculeNode->first_node("name");
+    if(nameNode && nameNode->value()){
+        molecule->setName(nameNode->value());
+    }
 
-                    attr = attr->next_attribute();
-                }
+    // parse atoms
+    rapidxml::xml_node<> *atomArrayNode = moleculeNode->first_node("atomArray");
+    if(atomArrayNode){
+        rapidxml::xml_node<> *atomNode = atomArrayNode->first_node("atom");
 
-                if(cartesianCoordinates){
-                    cartesianCoordinates->append(point3);
+        while(atomNode){
+            chemkit::Point2f point2(0, 0);
+            chemkit::Point3 point3(0, 0, 0);
+
+            rapidxml::xml_attribute<> *attr = atomNode->first_attribute();
+            while(attr){
+                if(strcmp(attr->name(), "elementType") == 0){
+                    molecule->addAtom(attr->value());
                 }
-                else if(!point3.isZero()){
-                    cartesianCoordinates = new chemkit::CartesianCoordinates(molecule->size() - 1);
-                    cartesianCoordinates->append(point3);
+                else if(strcmp(attr->name(), "x2") == 0){
+                    point2[0] = static_cast<float>(strtod(attr->value(), 0));
                 }
-
-                if(diagramCoordinates){
-                    diagramCoordinates->append(point2);
+                else if(strcmp(attr->name(), "y2") == 0){
+                    point2[1] = static_cast<float>(strtod(attr->value(), 0));
                 }
-                else if(!point2.isZero()){
-                    diagramCoordinates = new chemkit::DiagramCoordinates(molecule->size() - 1);
-                    diagramCoordinates->append(point2);
+                else if(strcmp(attr->name(), "x3") == 0){
+                    point3[0] = strtod(attr->value(), 0);
                 }
+                else if(strcmp(attr->name(), "y3") == 0){
+                    point3[1] = strtod(attr->value(), 0);
+                }
+                else if(strcmp(attr->name(), "z3") == 0){
+                    point3[2] = strtod(attr->value(), 0);
+                }
+
+                attr = attr->next_attribute();
+            }
+
+            if(cartesianCoordinates){
+                cartesianCoordinates->append(point3);
+            }
+            else if(!point3.isZero()){
+                cartesianCoordinates = new chemkit::CartesianCoordinates(molecule->size() - 1);
+                cartesianCoordinates->append(point3);
+            }
 
-                atomNode = atomNode->next_sibling("atom");
+            if(diagramCoordinates){
+                diagramCoordinates->append(point2);
             }
+            else if(!point2.isZero()){
+                diagramCoordinates = new chemkit::DiagramCoordinates(molecule->size() - 1);
+                diagramCoordinates->append(point2);
+            }
+
+            atomNode = atomNode->next_sibling("atom");
         }
+    }
 
-        // parse bonds
-        rapidxml::xml_node<> *bondArrayNode = moleculeNode->first_node("bondArray");
-        if(bondArrayNode){
-            rapidxml::xml_node<> *bondNode = bondArrayNode->first_node("bond");
-            while(bondNode){
-                rapidxml::xml_attribute<> *atomRefs2Attr = bondNode->first_attribute("atomRefs2");
-                if(atomRefs2Attr && atomRefs2Attr->value()){
-                    unsigned int atom1;
-                    unsigned int atom2;
-                    int count = sscanf(atomRefs2Attr->value(), " %*c%u %*c%u", &atom1, &atom2);
-                    if(count == 2){
-                        rapidxml::xml_attribute<> *orderAttr = bondNode->first_attribute("order");
-                        chemkit::Bond::BondOrderType bondOrder = chemkit::Bond::Single;
-
-                        if(orderAttr && orderAttr->value()){
-                            bondOrder = strtol(orderAttr->value(), 0, 10);
-                        }
-
-                        molecule->addBond(molecule->atom(atom1 - 1),
-                                          molecule->atom(atom2 - 1),
-                                          bondOrder);
+    // parse bonds
+    rapidxml::xml_node<> *bondArrayNode = moleculeNode->first_node("bondArray");
+    if(bondArrayNode){
+        rapidxml::xml_node<> *bondNode = bondArrayNode->first_node("bond");
+        while(bondNode){
+            rapidxml::xml_attribute<> *atomRefs2Attr = bondNode->first_attribute("atomRefs2");
+            if(atomRefs2Attr && atomRefs2Attr->value()){
+                unsigned int atom1;
+                unsigned int atom2;
+                int count = sscanf(atomRefs2Attr->value(), " %*c%u %*c%u", &atom1, &atom2);
+                if(count == 2){
+                    rapidxml::xml_attribute<> *orderAttr = bondNode->first_attribute("order");
+                    chemkit::Bond::BondOrderType bondOrder = chemkit::Bond::Single;
+
+                    if(orderAttr && orderAttr->value()){
+                        bondOrder = strtol(orderAttr->value(), 0, 10);
                     }
-                }
 
-                bondNode = bondNode->next_sibling("bond");
+                    molecule->addBond(molecule->atom(atom1 - 1),
+                                      molecule->atom(atom2 - 1),
+                                      bondOrder);
+                }
             }
-        }
 
-        // add coordinate sets
-        if(cartesianCoordinates){
-            molecule->addCoordinateSet(cartesianCoordinates);
-            cartesianCoordinates = 0;
+            bondNode = bondNode->next_sibling("bond");
         }
+    }
+
+    // add coordinate sets
+    if(cartesianCoordinates){
+        molecule->addCoordinateSet(cartesianCoordinates);
+        cartesianCoordinates = 0;
+    }
+
+    if(diagramCoordinates){
+        molecule->addCoordinateSet(diagramCoordinates);
+        diagramCoordinates = 0;
+    }
 
-        if(diagramCoordinates){
-            molecule->addCoordinateSet(diagramCoordinates);
-            diagramCoordinates = 0;
+    // add molecule property data
+    rapidxml::xml_node<> *propertyListNode = moleculeNode->first_node("propertyList");
+    if(!propertyListNode){
+        // in some files the propertyList node is stored within a list node
+        rapidxml::xml_node<> *listNode = moleculeNode->first_node("list");
+        if(listNode){
+            propertyListNode = listNode->first_node("propertyList");
         }
+    }
 
-        // add molecule property data
-        rapidxml::xml_node<> *propertyListNode = moleculeNode->first_node("propertyList");
-        if(!propertyListNode){
-            // in some files the propertyList node is stored within a list node
-            rapidxml::xml_node<> *listNode = moleculeNode->first_node("list");
-            if(listNode){
-                propertyListNode = listNode->first_node("propertyList");
+    if(propertyListNode){
+        rapidxml::xml_node<> *propertyNode = propertyListNode->first_node("property");
+        while(propertyNode){
+            // get the name for the property from the title attribute
+            rapidxml::xml_attribute<> *titleAttr = propertyNode->first_attribute("title");
+            if(!titleAttr){
+                propertyNode = propertyNode->next_sibling("property");
+                continue;
             }
-        }
 
-        if(propertyListNode){
-            rapidxml::xml_node<> *propertyNode = propertyListNode->first_node("property");
-            while(propertyNode){
-                // get the name for the property from the title attribute
-                rapidxml::xml_attribute<> *titleAttr = propertyNode->first_attribute("title");
-                if(!titleAttr){
-                    propertyNode = propertyNode->next_sibling("property");
-                    continue;
-                }
+            std::string title = titleAttr->value();
 
-                std::string title = titleAttr->value();
+            // get the value for the property
+            rapidxml::xml_node<> *scalarNode = propertyNode->first_node("scalar");
+            if(scalarNode && scalarNode->value_size()){
+                // determine the scalar data type
+                std::string dataType;
+                rapidxml::xml_attribute<> *dataTypeAttr = scalarNode->first_attribute("dataType");
+                if(dataTypeAttr && dataTypeAttr->value_size()){
+                    dataType = dataTypeAttr->value();
+                }
 
-                // get the value for the property
-                rapidxml::xml_node<> *scalarNode = propertyNode->first_node("scalar");
-                if(scalarNode && scalarNode->value_size()){
-                    // determine the scalar data type
-                    std::string dataType;
-                    rapidxml::xml_attribute<> *dataTypeAttr = scalarNode->first_attribute("dataType");
-                    if(dataTypeAttr && dataTypeAttr->value_size()){
-                        dataType = dataTypeAttr->value();
+                // parse the data value
+                chemkit::Variant value;
+                std::string valueString = scalarNode->value();
+                try {
+                    if(dataType == "xsd:decimal" || dataType == "xsd:double"){
+                        value = boost::lexical_cast<double>(valueString);
                     }
-
-                    // parse the data value
-                    chemkit::Variant value;
-                    std::string valueString = scalarNode->value();
-                    try {
-                        if(dataType == "xsd:decimal" || dataType == "xsd:double"){
-                            value = boost::lexical_cast<double>(valueString);
-                        }
-                        else if(dataType == "xsd:float"){
-                            value = boost::lexical_cast<float>(valueString);
-                        }
-                        else if(dataType == "xsd:integer"){
-                            value = boost::lexical_cast<int>(valueString);
-                        }
-                        else{
-                            // unknown data type, so store the value as a string
-                            value = valueString;
-                        }
+                    else if(dataType == "xsd:float"){
+                        value = boost::lexical_cast<float>(valueString);
                     }
-                    catch(boost::bad_lexical_cast &){
-                        // failed to parse the value, so store the value as a string
+                    else if(dataType == "xsd:integer"){
+                        value = boost::lexical_cast<int>(valueString);
+                    }
+                    else{
+                        // unknown data type, so store the value as a string
                         value = valueString;
                     }
-
-                    // set the data value
-                    molecule->setData(title, value);
+                }
+                catch(boost::bad_lexical_cast &){
+                    // failed to parse the value, so store the value as a string
+                    value = valueString;
                 }
 
-                // move to the next property node
-                propertyNode = propertyNode->next_sibling("property");
+                // set the data value
+                molecule->setData(title, value);
             }
-        }
-
-        // add molecule to file
-        file->addMolecule(molecule);
-        molecule.reset();
 
-        // move to next molecule
-        moleculeNode = moleculeNode->next_sibling("molecule");
+            // move to the next property node
+            propertyNode = propertyNode->next_sibling("property");
+        }
     }
 
-    return true;
+    return molecule;
 }
 
 bool CmlFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
@@ -277,46 +280,159 @@ bool CmlFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &outpu
 
     // write each molecule
     foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file->molecules()){
-        output << "<molecule>\n";
+        writeMoleculeElement(molecule.get(), output);
+    }
 
-        // write molecule name
-        if(!molecule->name().empty()){
-            output << "  <name>" << molecule->name() << "</name>\n";
-        }
+    return true;
+}
+
+bool CmlFileFormat::readHeader(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
 
-        // write atom array
-        if(molecule->atomCount() != 0){
-            output << "  <atomArray>\n";
-
-            foreach(const chemkit::Atom *atom, molecule->atoms()){
-                output << "    <atom id=\"a" << atom->index() + 1 << "\""
-                       << " elementType=\"" << atom->symbol() << "\""
-                       << " x3=\"" << atom->x() << "\""
-                       << " y3=\"" << atom->y() << "\""
-                       << " z3=\"" << atom->z() << "\""
-                       << "/>\n";
+    return true;
+}
+
+// Reads the next molecule element from input. Only the text of a
+// single molecule element is kept in memory, which allows for files
+// that are too large to parse as a whole document.
+boost::shared_ptr<chemkit::Molecule> CmlFileFormat::readMolecule(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    std::string element;
+    int depth = 0;
+
+    // read the input one tag at a time until a complete molecule
+    // element has been read
+    std::string text;
+    while(std::getline(input, text, '>')){
+        size_t tagStart = text.rfind('<');
+        if(tagStart == std::string::npos){
+            if(depth > 0){
+                element += text;
+                element += '>';
             }
 
-            output << "  </atomArray>\n";
+            continue;
         }
 
-        // write bond array
-        if(molecule->bondCount() != 0){
-            output << "  <bondArray>\n";
+        const char *tag = &text[tagStart];
+        bool selfClosing = !text.empty() && text[text.size() - 1] == '/';
+
+        if(strncmp(tag, "<molecule", 9) == 0 && (tag[9] == '\0' || tag[9] == '/' || isspace(tag[9]))){
+            if(depth == 0){
+                element = tag;
+            }
+            else{
+                element += text;
+            }
+
+            element += '>';
+
+            if(!selfClosing){
+                depth++;
+            }
+        }
+        else if(depth > 0){
+            element += text;
+            element += '>';
 
-            foreach(const chemkit::Bond *bond, molecule->bonds()){
-                output << "    <bond atomRefs2=\""
-                       << "a" << bond->atom1()->index() + 1 << " "
-                       << "a" << bond->atom2()->index() + 1 << "\""
-                       << " order=\"" << static_cast<int>(bond->order())
-                       << "\"/>\n";
+            if(strncmp(tag, "</molecule", 10) == 0){
+                depth--;
             }
+        }
 
-            output << "  </bondArray>\n";
+        if(depth == 0 && !element.empty()){
+            break;
         }
+    }
+
+    if(element.empty() || depth != 0){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
 
-        output << "</molecule>\n";
+    // parse the molecule element
+    rapidxml::xml_document<> doc;
+    try {
+        doc.parse<0>(const_cast<char *>(element.c_str()));
+    }
+    catch(rapidxml::parse_error &e){
+        setErrorString(std::string("XML parse error: ") + e.what());
+        return boost::shared_ptr<chemkit::Molecule>();
     }
 
+    return readMoleculeNode(doc.first_node("molecule"));
+}
+
+bool CmlFileFormat::writeHeader(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    output << "<?xml version=\"1.0\"?>\n";
+
+    return true;
+}
+
+bool CmlFileFormat::writeMolecule(chemkit::MoleculeFile *file,
+                                  const boost::shared_ptr<chemkit::Molecule> &molecule,
+                                  std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    writeMoleculeElement(molecule.get(), output);
+
     return true;
 }
+
+bool CmlFileFormat::writeFooter(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    return true;
+}
+
+void CmlFileFormat::writeMoleculeElement(const chemkit::Molecule *molecule, std::ostream &output)
+{
+    output << "<molecule>\n";
+
+    // write molecule name
+    if(!molecule->name().empty()){
+        output << "  <name>" << molecule->name() << "</name>\n";
+    }
+
+    // write atom array
+    if(molecule->atomCount() != 0){
+        output << "  <atomArray>\n";
+
+        foreach(const chemkit::Atom *atom, molecule->atoms()){
+            output << "    <atom id=\"a" << atom->index() + 1 << "\""
+                   << " elementType=\"" << atom->symbol() << "\""
+                   << " x3=\"" << atom->x() << "\""
+                   << " y3=\"" << atom->y() << "\""
+                   << " z3=\"" << atom->z() << "\""
+                   << "/>\n";
+        }
+
+        output << "  </atomArray>\n";
+    }
+
+    // write bond array
+    if(molecule->bondCount() != 0){
+        output << "  <bondArray>\n";
+
+        foreach(const chemkit::Bond *bond, molecule->bonds()){
+            output << "    <bond atomRefs2=\""
+                   << "a" << bond->atom1()->index() + 1 << " "
+                   << "a" << bond->atom2()->index() + 1 << "\""
+                   << " order=\"" << static_cast<int>(bond->order())
+                   << "\"/>\n";
+        }
+
+        output << "  </bondArray>\n";
+    }
+
+    output << "</molecule>\n";
+}
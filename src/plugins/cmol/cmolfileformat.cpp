@@ -0,0 +1,786 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "cmolfileformat.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <chemkit/atom.h>
+#include <chemkit/bond.h>
+#include <chemkit/foreach.h>
+#include <chemkit/molecule.h>
+#include <chemkit/concurrent.h>
+#include <chemkit/moleculefile.h>
+#include <chemkit/coordinateset.h>
+#include <chemkit/diagramcoordinates.h>
+#include <chemkit/internalcoordinates.h>
+#include <chemkit/cartesiancoordinates.h>
+
+// The cmol format is chemkit's native binary molecule format. It
+// stores molecules exactly as they are represented in memory so that
+// they can be reloaded without parsing or perceiving anything. All
+// values are stored little-endian. The file starts with a header:
+//
+//   "CMOL" | version (u32)
+//
+// followed by one record for each molecule:
+//
+//   record size (u64) | name (str) | atom count (u32) | bond count (u32)
+//                     | coordinate set count (u32) | data count (u32)
+//
+// followed by the atom and bond properties, each stored as a flat
+// array with one value per atom or bond:
+//
+//   atomic numbers (u8) | mass numbers (u16) | chiralities (u8)
+//   | partial charges (f64) | types (str)
+//   | bond atoms (u32 x 2) | bond orders (u8) | bond stereochemistry (u8)
+//
+// then the coordinate sets and data fields:
+//
+//   { type (u8) | positions (f64 x 3 or f32 x 2 for diagrams) } ...
+//   { name (str) | type (u8) | value (i64, f64 or str) } ...
+//
+// Data types are stored so that each value is read back with the
+// same variant type it was written with.
+//
+// Strings (str) are stored as their length (u32) followed by their
+// characters. Internal coordinate sets are stored as cartesian
+// coordinates. The record size allows the records of a mapped file
+// to be located without decoding them, and they are then decoded in
+// parallel.
+
+namespace {
+
+const char FileMagic[] = "CMOL";
+const boost::uint32_t FormatVersion = 1;
+
+const size_t HeaderSize = 8;
+const size_t RecordSizeSize = 8;
+
+enum CoordinatesType {
+    CartesianCoordinatesType = 0,
+    DiagramCoordinatesType = 1
+};
+
+enum DataType {
+    BoolDataType = 0,
+    IntDataType = 1,
+    LongDataType = 2,
+    FloatDataType = 3,
+    DoubleDataType = 4,
+    StringDataType = 5
+};
+
+// --- Binary Encoding ----------------------------------------------------- //
+inline void appendUInt8(std::string &data, boost::uint8_t value)
+{
+    data.push_back(static_cast<char>(value));
+}
+
+inline void appendUInt16(std::string &data, boost::uint16_t value)
+{
+    data.push_back(static_cast<char>(value & 0xff));
+    data.push_back(static_cast<char>((value >> 8) & 0xff));
+}
+
+inline void appendUInt32(std::string &data, boost::uint32_t value)
+{
+    for(int i = 0; i < 4; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+inline void appendUInt64(std::string &data, boost::uint64_t value)
+{
+    for(int i = 0; i < 8; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+inline void appendFloat(std::string &data, float value)
+{
+    boost::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendUInt32(data, bits);
+}
+
+inline void appendDouble(std::string &data, double value)
+{
+    boost::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendUInt64(data, bits);
+}
+
+inline void appendString(std::string &data, const std::string &value)
+{
+    appendUInt32(data, static_cast<boost::uint32_t>(value.size()));
+    data.append(value);
+}
+
+inline boost::uint32_t readUInt32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint32_t value = 0;
+    for(int i = 3; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+inline boost::uint64_t readUInt64(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint64_t value = 0;
+    for(int i = 7; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+// Reads values from a record. Reading past the end of the record
+// returns zero values and marks the decoder as failed.
+class Decoder
+{
+public:
+    Decoder(const char *data, size_t size)
+        : m_data(data),
+          m_size(size),
+          m_position(0),
+          m_ok(true)
+    {
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+    bool atEnd() const
+    {
+        return m_position == m_size;
+    }
+
+    // returns a pointer to the next size bytes or null if the record
+    // is too short
+    const char* take(size_t size)
+    {
+        if(!m_ok || size > m_size - m_position){
+            m_ok = false;
+            return 0;
+        }
+
+        const char *data = m_data + m_position;
+        m_position += size;
+        return data;
+    }
+
+    boost::uint8_t readUInt8()
+    {
+        const char *data = take(1);
+        return data ? static_cast<boost::uint8_t>(*data) : 0;
+    }
+
+    boost::uint32_t readUInt32()
+    {
+        const char *data = take(4);
+        return data ? ::readUInt32(data) : 0;
+    }
+
+    boost::uint64_t readUInt64()
+    {
+        const char *data = take(8);
+        return data ? ::readUInt64(data) : 0;
+    }
+
+    double readDouble()
+    {
+        boost::uint64_t bits = readUInt64();
+
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::string readString()
+    {
+        size_t length = readUInt32();
+        const char *data = take(length);
+        return data ? std::string(data, length) : std::string();
+    }
+
+private:
+    const char *m_data;
+    size_t m_size;
+    size_t m_position;
+    bool m_ok;
+};
+
+inline double decodeDouble(const char *data)
+{
+    boost::uint64_t bits = readUInt64(data);
+
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline float decodeFloat(const char *data)
+{
+    boost::uint32_t bits = readUInt32(data);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// --- Records ------------------------------------------------------------- //
+void appendCartesianCoordinates(std::string &data, const chemkit::CartesianCoordinates *coordinates, size_t atomCount)
+{
+    appendUInt8(data, CartesianCoordinatesType);
+
+    for(size_t i = 0; i < atomCount; i++){
+        const chemkit::Point3 &position = i < coordinates->size() ? (*coordinates)[i] : chemkit::Point3(0, 0, 0);
+
+        appendDouble(data, position.x());
+        appendDouble(data, position.y());
+        appendDouble(data, position.z());
+    }
+}
+
+// Encodes molecule and appends the record to data.
+void appendRecord(std::string &data, const chemkit::Molecule *molecule)
+{
+    size_t recordStart = data.size();
+    appendUInt64(data, 0);
+
+    size_t atomCount = molecule->atomCount();
+    size_t bondCount = molecule->bondCount();
+
+    // only cartesian and diagram coordinates are stored
+    std::vector<boost::shared_ptr<chemkit::CoordinateSet> > coordinateSets;
+    foreach(const boost::shared_ptr<chemkit::CoordinateSet> &coordinateSet, molecule->coordinateSets()){
+        if(coordinateSet->type() != chemkit::CoordinateSet::None){
+            coordinateSets.push_back(coordinateSet);
+        }
+    }
+
+    // only boolean, numeric and string data is stored
+    std::vector<std::string> dataNames;
+    foreach(const std::string &name, molecule->dataNames()){
+        chemkit::Variant::Type type = molecule->data(name).type();
+
+        if(type != chemkit::Variant::Null && type != chemkit::Variant::Pointer){
+            dataNames.push_back(name);
+        }
+    }
+
+    appendString(data, molecule->name());
+    appendUInt32(data, static_cast<boost::uint32_t>(atomCount));
+    appendUInt32(data, static_cast<boost::uint32_t>(bondCount));
+    appendUInt32(data, static_cast<boost::uint32_t>(coordinateSets.size()));
+    appendUInt32(data, static_cast<boost::uint32_t>(dataNames.size()));
+
+    // atoms
+    data.reserve(data.size() + atomCount * 40 + bondCount * 10 + coordinateSets.size() * atomCount * 24);
+
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        appendUInt8(data, atom->atomicNumber());
+    }
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        appendUInt16(data, atom->massNumber());
+    }
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        appendUInt8(data, static_cast<boost::uint8_t>(atom->chirality()));
+    }
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        appendDouble(data, atom->partialCharge());
+    }
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        appendString(data, atom->type());
+    }
+
+    // bonds
+    foreach(const chemkit::Bond *bond, molecule->bonds()){
+        appendUInt32(data, static_cast<boost::uint32_t>(bond->atom1()->index()));
+        appendUInt32(data, static_cast<boost::uint32_t>(bond->atom2()->index()));
+    }
+    foreach(const chemkit::Bond *bond, molecule->bonds()){
+        appendUInt8(data, bond->order());
+    }
+    foreach(const chemkit::Bond *bond, molecule->bonds()){
+        appendUInt8(data, static_cast<boost::uint8_t>(bond->stereochemistry()));
+    }
+
+    // coordinates
+    foreach(const boost::shared_ptr<chemkit::CoordinateSet> &coordinateSet, coordinateSets){
+        if(coordinateSet->type() == chemkit::CoordinateSet::Diagram){
+            const chemkit::DiagramCoordinates *coordinates = coordinateSet->diagramCoordinates();
+
+            appendUInt8(data, DiagramCoordinatesType);
+
+            for(size_t i = 0; i < atomCount; i++){
+                chemkit::Point2f position = i < coordinates->size() ? coordinates->position(i) : chemkit::Point2f(0, 0);
+
+                appendFloat(data, position.x());
+                appendFloat(data, position.y());
+            }
+        }
+        else if(coordinateSet->type() == chemkit::CoordinateSet::Internal){
+            boost::scoped_ptr<chemkit::CartesianCoordinates> coordinates(coordinateSet->internalCoordinates()->toCartesianCoordinates());
+
+            appendCartesianCoordinates(data, coordinates.get(), atomCount);
+        }
+        else{
+            appendCartesianCoordinates(data, coordinateSet->cartesianCoordinates(), atomCount);
+        }
+    }
+
+    // data
+    foreach(const std::string &name, dataNames){
+        chemkit::Variant value = molecule->data(name);
+
+        appendString(data, name);
+
+        switch(value.type()){
+            case chemkit::Variant::Bool:
+                appendUInt8(data, BoolDataType);
+                appendUInt64(data, value.toBool());
+                break;
+            case chemkit::Variant::Int:
+                appendUInt8(data, IntDataType);
+                appendUInt64(data, static_cast<boost::uint64_t>(static_cast<boost::int64_t>(value.toInt())));
+                break;
+            case chemkit::Variant::Long:
+                appendUInt8(data, LongDataType);
+                appendUInt64(data, static_cast<boost::uint64_t>(static_cast<boost::int64_t>(value.toLong())));
+                break;
+            case chemkit::Variant::Float:
+                appendUInt8(data, FloatDataType);
+                appendDouble(data, value.toFloat());
+                break;
+            case chemkit::Variant::Double:
+                appendUInt8(data, DoubleDataType);
+                appendDouble(data, value.toDouble());
+                break;
+            default:
+                appendUInt8(data, StringDataType);
+                appendString(data, value.toString());
+                break;
+        }
+    }
+
+    // fill in the record size
+    boost::uint64_t recordSize = data.size() - recordStart - RecordSizeSize;
+    for(int i = 0; i < 8; i++){
+        data[recordStart + i] = static_cast<char>((recordSize >> (8 * i)) & 0xff);
+    }
+}
+
+// Decodes a molecule from the record data (not including the record
+// size). Returns a null pointer if the record is invalid.
+boost::shared_ptr<chemkit::Molecule> decodeRecord(const char *data, size_t size)
+{
+    Decoder decoder(data, size);
+
+    std::string name = decoder.readString();
+    size_t atomCount = decoder.readUInt32();
+    size_t bondCount = decoder.readUInt32();
+    size_t coordinateSetCount = decoder.readUInt32();
+    size_t dataCount = decoder.readUInt32();
+
+    // check that the fixed size arrays fit in the record before
+    // allocating anything
+    const char *atomicNumbers = decoder.take(atomCount);
+    const char *massNumbers = decoder.take(atomCount * 2);
+    const char *chiralities = decoder.take(atomCount);
+    const char *partialCharges = decoder.take(atomCount * 8);
+    if(!decoder.ok()){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    boost::shared_ptr<chemkit::Molecule> molecule = boost::make_shared<chemkit::Molecule>();
+    if(!name.empty()){
+        molecule->setName(name);
+    }
+
+    // atoms
+    molecule->setAtomCapacity(atomCount);
+    for(size_t i = 0; i < atomCount; i++){
+        chemkit::Atom *atom = molecule->addAtom(static_cast<unsigned char>(atomicNumbers[i]));
+
+        boost::uint16_t massNumber = static_cast<unsigned char>(massNumbers[2 * i]) |
+                                     (static_cast<unsigned char>(massNumbers[2 * i + 1]) << 8);
+        if(massNumber != atom->massNumber()){
+            atom->setMassNumber(massNumber);
+        }
+
+        chemkit::Real partialCharge = decodeDouble(partialCharges + 8 * i);
+        if(partialCharge != 0){
+            atom->setPartialCharge(partialCharge);
+        }
+
+        chemkit::Stereochemistry::Type chirality = static_cast<chemkit::Stereochemistry::Type>(chiralities[i]);
+        if(chirality != chemkit::Stereochemistry::None){
+            atom->setChirality(chirality);
+        }
+    }
+
+    for(size_t i = 0; i < atomCount; i++){
+        std::string type = decoder.readString();
+        if(!type.empty()){
+            molecule->atom(i)->setType(type);
+        }
+    }
+
+    // bonds
+    const char *bondAtoms = decoder.take(bondCount * 8);
+    const char *bondOrders = decoder.take(bondCount);
+    const char *bondStereochemistry = decoder.take(bondCount);
+    if(!decoder.ok()){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    molecule->setBondCapacity(bondCount);
+    for(size_t i = 0; i < bondCount; i++){
+        size_t a = readUInt32(bondAtoms + 8 * i);
+        size_t b = readUInt32(bondAtoms + 8 * i + 4);
+        if(a >= atomCount || b >= atomCount){
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
+
+        chemkit::Bond *bond = molecule->addBond(a, b, static_cast<unsigned char>(bondOrders[i]));
+        if(!bond){
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
+
+        chemkit::Stereochemistry::Type stereochemistry = static_cast<chemkit::Stereochemistry::Type>(bondStereochemistry[i]);
+        if(stereochemistry != chemkit::Stereochemistry::None){
+            bond->setStereochemistry(stereochemistry);
+        }
+    }
+
+    // coordinates
+    for(size_t i = 0; i < coordinateSetCount; i++){
+        int type = decoder.readUInt8();
+
+        if(type == CartesianCoordinatesType){
+            const char *values = decoder.take(atomCount * 24);
+            if(!values){
+                return boost::shared_ptr<chemkit::Molecule>();
+            }
+
+            chemkit::CartesianCoordinates *coordinates = new chemkit::CartesianCoordinates(atomCount);
+            for(size_t j = 0; j < atomCount; j++){
+                (*coordinates)[j] = chemkit::Point3(decodeDouble(values + 24 * j),
+                                                    decodeDouble(values + 24 * j + 8),
+                                                    decodeDouble(values + 24 * j + 16));
+            }
+
+            molecule->addCoordinateSet(coordinates);
+        }
+        else if(type == DiagramCoordinatesType){
+            const char *values = decoder.take(atomCount * 8);
+            if(!values){
+                return boost::shared_ptr<chemkit::Molecule>();
+            }
+
+            chemkit::DiagramCoordinates *coordinates = new chemkit::DiagramCoordinates(atomCount);
+            for(size_t j = 0; j < atomCount; j++){
+                coordinates->setPosition(j, decodeFloat(values + 8 * j), decodeFloat(values + 8 * j + 4));
+            }
+
+            molecule->addCoordinateSet(coordinates);
+        }
+        else{
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
+    }
+
+    // data
+    for(size_t i = 0; i < dataCount; i++){
+        std::string name = decoder.readString();
+        int type = decoder.readUInt8();
+
+        if(type == BoolDataType){
+            molecule->setData(name, decoder.readUInt64() != 0);
+        }
+        else if(type == IntDataType){
+            molecule->setData(name, static_cast<int>(static_cast<boost::int64_t>(decoder.readUInt64())));
+        }
+        else if(type == LongDataType){
+            molecule->setData(name, static_cast<long>(static_cast<boost::int64_t>(decoder.readUInt64())));
+        }
+        else if(type == FloatDataType){
+            molecule->setData(name, static_cast<float>(decoder.readDouble()));
+        }
+        else if(type == DoubleDataType){
+            molecule->setData(name, decoder.readDouble());
+        }
+        else if(type == StringDataType){
+            molecule->setData(name, decoder.readString());
+        }
+        else{
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
+    }
+
+    if(!decoder.ok() || !decoder.atEnd()){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    return molecule;
+}
+
+} // end anonymous namespace
+
+// === CmolFileFormat::RecordReader ======================================== //
+// Decodes the records of a mapped file in parallel. Each molecule is
+// stored at the record's index so that the file order is preserved.
+class CmolFileFormat::RecordReader
+{
+public:
+    RecordReader(const char *data,
+                 const std::vector<std::pair<size_t, size_t> > &records,
+                 std::vector<boost::shared_ptr<chemkit::Molecule> > &molecules)
+        : m_data(data),
+          m_records(records),
+          m_molecules(molecules)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        const std::pair<size_t, size_t> &record = m_records[index];
+
+        m_molecules[index] = decodeRecord(m_data + record.first, record.second);
+    }
+
+private:
+    const char *m_data;
+    const std::vector<std::pair<size_t, size_t> > &m_records;
+    std::vector<boost::shared_ptr<chemkit::Molecule> > &m_molecules;
+};
+
+// === CmolFileFormat ====================================================== //
+CmolFileFormat::CmolFileFormat()
+    : chemkit::MoleculeFileFormat("cmol")
+{
+}
+
+bool CmolFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
+{
+    if(!readHeader(input, file)){
+        return false;
+    }
+
+    while(boost::shared_ptr<chemkit::Molecule> molecule = readMolecule(input, file)){
+        file->addMolecule(molecule);
+    }
+
+    return errorString().empty();
+}
+
+bool CmolFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file)
+{
+    const char *data = input.data();
+    size_t size = input.size();
+
+    if(size < HeaderSize ||
+       std::memcmp(data, FileMagic, 4) != 0 ||
+       readUInt32(data + 4) != FormatVersion){
+        setErrorString("Invalid cmol file header.");
+        return false;
+    }
+
+    // locate the records from their sizes
+    std::vector<std::pair<size_t, size_t> > records;
+
+    size_t position = HeaderSize;
+    while(position < size){
+        if(size - position < RecordSizeSize){
+            setErrorString("Truncated cmol record.");
+            return false;
+        }
+
+        boost::uint64_t recordSize = readUInt64(data + position);
+        position += RecordSizeSize;
+
+        if(recordSize > size - position){
+            setErrorString("Truncated cmol record.");
+            return false;
+        }
+
+        records.push_back(std::make_pair(position, static_cast<size_t>(recordSize)));
+        position += recordSize;
+    }
+
+    // decode records
+    std::vector<boost::shared_ptr<chemkit::Molecule> > molecules(records.size());
+    chemkit::concurrent::blockingFor(records.size(), RecordReader(data, records, molecules));
+
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, molecules){
+        if(!molecule){
+            setErrorString("Invalid cmol record.");
+            return false;
+        }
+
+        file->addMolecule(molecule);
+    }
+
+    return true;
+}
+
+bool CmolFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
+{
+    if(!writeHeader(0, output)){
+        return false;
+    }
+
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file->molecules()){
+        if(!writeMolecule(0, molecule, output)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool CmolFileFormat::readHeader(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    setErrorString(std::string());
+
+    char header[HeaderSize];
+    input.read(header, HeaderSize);
+
+    if(input.gcount() != static_cast<std::streamsize>(HeaderSize) ||
+       std::memcmp(header, FileMagic, 4) != 0 ||
+       readUInt32(header + 4) != FormatVersion){
+        setErrorString("Invalid cmol file header.");
+        return false;
+    }
+
+    return true;
+}
+
+boost::shared_ptr<chemkit::Molecule> CmolFileFormat::readMolecule(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    char sizeData[RecordSizeSize];
+    input.read(sizeData, RecordSizeSize);
+
+    // end of file
+    if(input.gcount() == 0){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+    else if(input.gcount() != static_cast<std::streamsize>(RecordSizeSize)){
+        setErrorString("Truncated cmol record.");
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    boost::uint64_t recordSize = readUInt64(sizeData);
+
+    // read the record in pieces so that a corrupt size cannot cause a
+    // huge allocation
+    m_buffer.clear();
+    while(m_buffer.size() < recordSize){
+        char block[4096];
+        size_t blockSize = std::min<boost::uint64_t>(sizeof(block), recordSize - m_buffer.size());
+
+        input.read(block, blockSize);
+        if(input.gcount() != static_cast<std::streamsize>(blockSize)){
+            setErrorString("Truncated cmol record.");
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
+
+        m_buffer.append(block, blockSize);
+    }
+
+    boost::shared_ptr<chemkit::Molecule> molecule = decodeRecord(m_buffer.data(), m_buffer.size());
+    if(!molecule){
+        setErrorString("Invalid cmol record.");
+    }
+
+    return molecule;
+}
+
+bool CmolFileFormat::writeHeader(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    std::string header(FileMagic, 4);
+    appendUInt32(header, FormatVersion);
+    output.write(header.data(), header.size());
+
+    return !output.fail();
+}
+
+bool CmolFileFormat::writeMolecule(chemkit::MoleculeFile *file,
+                                   const boost::shared_ptr<chemkit::Molecule> &molecule,
+                                   std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    m_buffer.clear();
+    appendRecord(m_buffer, molecule.get());
+    output.write(m_buffer.data(), m_buffer.size());
+
+    if(output.fail()){
+        setErrorString("Failed to write cmol record.");
+        return false;
+    }
+
+    return true;
+}
+
+bool CmolFileFormat::writeFooter(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    return true;
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef CMOLFILEFORMAT_H
+#define CMOLFILEFORMAT_H
+
+#include <string>
+
+#include <chemkit/moleculefileformat.h>
+
+class CmolFileFormat : public chemkit::MoleculeFileFormat
+{
+public:
+    CmolFileFormat();
+
+    bool read(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool write(const chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool readHeader(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    boost::shared_ptr<chemkit::Molecule> readMolecule(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool writeHeader(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeMolecule(chemkit::MoleculeFile *file, const boost::shared_ptr<chemkit::Molecule> &molecule, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFooter(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+
+private:
+    class RecordReader;
+
+    std::string m_buffer;
+};
+
+#endif // CMOLFILEFORMAT_H
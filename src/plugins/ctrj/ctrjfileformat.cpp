@@ -0,0 +1,964 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "ctrjfileformat.h"
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+#include <chemkit/vector3.h>
+#include <chemkit/unitcell.h>
+#include <chemkit/concurrent.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+#include <chemkit/cartesiancoordinates.h>
+
+// The ctrj format is chemkit's native compressed trajectory format.
+// All values are stored little-endian. The file starts with a header:
+//
+//   "CTRJ" | version (u32) | atom count (u64) | chunk size (u32)
+//          | encoding (u32) | precision (f64)
+//
+// followed by the frames, grouped into chunks of up to chunk size
+// frames. Each chunk is independently gzip-compressed:
+//
+//   "CHNK" | frame count (u32) | compressed size (u64) | data
+//
+// The uncompressed data of a chunk contains the time and optional
+// unit cell of each frame followed by the coordinates. The first
+// frame of a chunk is stored absolutely and the following frames as
+// differences from the previous frame, either as the xor of the
+// double bit patterns (exact encoding) or as the difference of the
+// values rounded to a multiple of the precision (quantized encoding).
+// The coordinate words are byte-plane shuffled so that the mostly
+// zero high bytes of the differences compress well.
+//
+// The chunks are followed by a seek table giving the location of
+// each chunk and a trailer pointing to the table:
+//
+//   "CIDX" | chunk count (u64) | { offset (u64) | first frame (u64)
+//          | frame count (u32) } ... | table offset (u64) | "CTRJ"
+//
+// The seek table allows chunks to be located and decoded in parallel.
+// Files without a valid seek table (e.g. from an interrupted write)
+// are read by scanning the chunks sequentially.
+
+namespace {
+
+const char FileMagic[] = "CTRJ";
+const char ChunkMagic[] = "CHNK";
+const char IndexMagic[] = "CIDX";
+const boost::uint32_t FormatVersion = 1;
+
+const size_t HeaderSize = 32;
+const size_t ChunkHeaderSize = 16;
+const size_t IndexHeaderSize = 12;
+const size_t IndexEntrySize = 20;
+const size_t TrailerSize = 12;
+
+// number of frames stored in each chunk
+const size_t DefaultChunkSize = 100;
+
+// largest piece of chunk data read from the stream at once
+const size_t ChunkReadBlockSize = 1 << 20;
+
+// deflate expands its input by at most this factor when decompressing
+const boost::uint64_t MaximumCompressionRatio = 1032;
+
+enum Encoding {
+    ExactEncoding = 0,
+    QuantizedEncoding = 1
+};
+
+// location of a chunk within the file
+struct ChunkEntry
+{
+    size_t offset;
+    size_t firstFrame;
+    size_t frameCount;
+};
+
+// --- Binary Encoding ----------------------------------------------------- //
+void appendUInt32(std::string &data, boost::uint32_t value)
+{
+    for(int i = 0; i < 4; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void appendUInt64(std::string &data, boost::uint64_t value)
+{
+    for(int i = 0; i < 8; i++){
+        data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+inline boost::uint64_t doubleToBits(double value)
+{
+    boost::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double bitsToDouble(boost::uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void appendDouble(std::string &data, double value)
+{
+    appendUInt64(data, doubleToBits(value));
+}
+
+boost::uint32_t readUInt32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint32_t value = 0;
+    for(int i = 3; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+boost::uint64_t readUInt64(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    boost::uint64_t value = 0;
+    for(int i = 7; i >= 0; i--){
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+inline double readDouble(const char *data)
+{
+    return bitsToDouble(readUInt64(data));
+}
+
+inline boost::uint64_t zigzagEncode(boost::int64_t value)
+{
+    return (static_cast<boost::uint64_t>(value) << 1) ^ static_cast<boost::uint64_t>(value >> 63);
+}
+
+inline boost::int64_t zigzagDecode(boost::uint64_t value)
+{
+    return static_cast<boost::int64_t>(value >> 1) ^ -static_cast<boost::int64_t>(value & 1);
+}
+
+// --- Header and Seek Table ----------------------------------------------- //
+std::string headerData(const CtrjHeader &header)
+{
+    std::string data(FileMagic, 4);
+    appendUInt32(data, FormatVersion);
+    appendUInt64(data, header.atomCount);
+    appendUInt32(data, static_cast<boost::uint32_t>(header.chunkSize));
+    appendUInt32(data, static_cast<boost::uint32_t>(header.encoding));
+    appendDouble(data, header.precision);
+
+    return data;
+}
+
+bool readHeaderData(const char *data, size_t size, CtrjHeader &header)
+{
+    if(size < HeaderSize ||
+       std::memcmp(data, FileMagic, 4) != 0 ||
+       readUInt32(data + 4) != FormatVersion){
+        return false;
+    }
+
+    header.atomCount = readUInt64(data + 8);
+    header.chunkSize = readUInt32(data + 16);
+    header.encoding = readUInt32(data + 20);
+    header.precision = readDouble(data + 24);
+
+    if(header.encoding == QuantizedEncoding){
+        return header.precision > 0;
+    }
+
+    return header.encoding == ExactEncoding;
+}
+
+// returns true if a chunk with compressedSize bytes of compressed data
+// could hold frameCount frames. each frame needs at least its time,
+// cell flag and coordinates once decompressed.
+bool checkChunkSize(const CtrjHeader &header, boost::uint64_t frameCount, boost::uint64_t compressedSize)
+{
+    if(frameCount == 0){
+        return true;
+    }
+
+    boost::uint64_t decodedSize = std::numeric_limits<boost::uint64_t>::max();
+    if(compressedSize < decodedSize / MaximumCompressionRatio){
+        decodedSize = compressedSize * MaximumCompressionRatio;
+    }
+
+    if(header.atomCount > decodedSize / frameCount / 24){
+        return false;
+    }
+
+    return frameCount <= decodedSize / (9 + 24 * header.atomCount);
+}
+
+// reads the chunk locations from the seek table at the end of the file
+bool readIndex(const char *data, size_t size, std::vector<ChunkEntry> &entries)
+{
+    if(size < HeaderSize + IndexHeaderSize + TrailerSize){
+        return false;
+    }
+
+    const char *trailer = data + size - TrailerSize;
+    if(std::memcmp(trailer + 8, FileMagic, 4) != 0){
+        return false;
+    }
+
+    boost::uint64_t indexOffset = readUInt64(trailer);
+    if(indexOffset < HeaderSize || indexOffset > size - TrailerSize - IndexHeaderSize){
+        return false;
+    }
+
+    const char *index = data + indexOffset;
+    if(std::memcmp(index, IndexMagic, 4) != 0){
+        return false;
+    }
+
+    boost::uint64_t chunkCount = readUInt64(index + 4);
+    if(chunkCount != (size - TrailerSize - IndexHeaderSize - indexOffset) / IndexEntrySize){
+        return false;
+    }
+
+    entries.resize(chunkCount);
+    for(size_t i = 0; i < chunkCount; i++){
+        const char *entry = index + IndexHeaderSize + i * IndexEntrySize;
+        entries[i].offset = readUInt64(entry);
+        entries[i].firstFrame = readUInt64(entry + 8);
+        entries[i].frameCount = readUInt32(entry + 16);
+    }
+
+    return true;
+}
+
+// locates the chunks by walking them from the start of the file, this
+// is used when the seek table is missing. a truncated final chunk is
+// ignored. returns false if a chunk claims more frames than it can hold.
+bool scanChunks(const CtrjHeader &header, const char *data, size_t size, std::vector<ChunkEntry> &entries)
+{
+    entries.clear();
+
+    size_t offset = HeaderSize;
+    size_t firstFrame = 0;
+
+    while(offset + ChunkHeaderSize <= size &&
+          std::memcmp(data + offset, ChunkMagic, 4) == 0){
+        boost::uint64_t compressedSize = readUInt64(data + offset + 8);
+        boost::uint32_t frameCount = readUInt32(data + offset + 4);
+        if(compressedSize > size - offset - ChunkHeaderSize){
+            break;
+        }
+        else if(!checkChunkSize(header, frameCount, compressedSize)){
+            return false;
+        }
+
+        ChunkEntry entry;
+        entry.offset = offset;
+        entry.firstFrame = firstFrame;
+        entry.frameCount = frameCount;
+        entries.push_back(entry);
+
+        offset += ChunkHeaderSize + compressedSize;
+        firstFrame += entry.frameCount;
+    }
+
+    return true;
+}
+
+// returns true if the entries describe consecutive chunks within the
+// file which are large enough to hold their frames
+bool checkEntries(const CtrjHeader &header, const char *data, size_t size, const std::vector<ChunkEntry> &entries)
+{
+    size_t firstFrame = 0;
+
+    for(size_t i = 0; i < entries.size(); i++){
+        const ChunkEntry &entry = entries[i];
+
+        if(entry.offset < HeaderSize ||
+           entry.offset > size - ChunkHeaderSize ||
+           std::memcmp(data + entry.offset, ChunkMagic, 4) != 0 ||
+           readUInt32(data + entry.offset + 4) != entry.frameCount ||
+           readUInt64(data + entry.offset + 8) > size - entry.offset - ChunkHeaderSize ||
+           !checkChunkSize(header, entry.frameCount, readUInt64(data + entry.offset + 8)) ||
+           entry.firstFrame != firstFrame){
+            return false;
+        }
+
+        firstFrame += entry.frameCount;
+    }
+
+    return true;
+}
+
+// --- Chunk Encoding ------------------------------------------------------ //
+void compress(const std::string &input, std::string &output)
+{
+    output.clear();
+
+    boost::iostreams::filtering_ostream stream;
+    stream.push(boost::iostreams::gzip_compressor());
+    stream.push(boost::iostreams::back_inserter(output));
+    stream.write(input.data(), input.size());
+    stream.reset();
+}
+
+bool decompress(const char *data, size_t size, std::string &output)
+{
+    output.clear();
+
+    try {
+        boost::iostreams::filtering_streambuf<boost::iostreams::input> stream;
+        stream.push(boost::iostreams::gzip_decompressor());
+        stream.push(boost::iostreams::array_source(data, size));
+
+        boost::iostreams::copy(stream, boost::iostreams::back_inserter(output));
+    }
+    catch(std::exception &){
+        return false;
+    }
+
+    return true;
+}
+
+// reads size bytes of compressed chunk data from input. the size comes
+// from the file so the buffer is grown in blocks as data actually arrives
+// and a corrupt size fails at the end of the stream instead of allocating.
+bool readChunkData(std::istream &input, boost::uint64_t size, std::string &data)
+{
+    data.clear();
+
+    while(data.size() < size){
+        size_t count = static_cast<size_t>(std::min<boost::uint64_t>(size - data.size(), ChunkReadBlockSize));
+        size_t offset = data.size();
+
+        data.resize(offset + count);
+        input.read(&data[offset], count);
+        if(static_cast<size_t>(input.gcount()) != count){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// encodes the frames in the range [begin, end) into an uncompressed chunk
+void encodeChunk(const CtrjHeader &header,
+                 const std::vector<chemkit::TrajectoryFrame *> &frames,
+                 size_t begin,
+                 size_t end,
+                 std::string &data)
+{
+    size_t frameCount = end - begin;
+    size_t valueCount = 3 * header.atomCount;
+
+    data.clear();
+
+    // frame times and unit cells
+    for(size_t i = begin; i < end; i++){
+        const chemkit::TrajectoryFrame *frame = frames[i];
+        appendDouble(data, frame->time());
+
+        const chemkit::UnitCell *cell = frame->unitCell();
+        if(cell){
+            data.push_back(1);
+
+            const chemkit::Vector3 *vectors[] = { &cell->x(), &cell->y(), &cell->z() };
+            for(int j = 0; j < 3; j++){
+                for(int k = 0; k < 3; k++){
+                    appendDouble(data, (*vectors[j])[k]);
+                }
+            }
+        }
+        else{
+            data.push_back(0);
+        }
+    }
+
+    // coordinates as differences from the previous frame
+    std::vector<boost::uint64_t> words(frameCount * valueCount);
+    std::vector<boost::uint64_t> previous(valueCount, 0);
+
+    for(size_t i = 0; i < frameCount; i++){
+        const chemkit::CartesianCoordinates *coordinates = frames[begin + i]->coordinates();
+        boost::uint64_t *frameWords = &words[i * valueCount];
+
+        for(size_t j = 0; j < valueCount; j++){
+            double value = (*coordinates)[j / 3][j % 3];
+
+            if(header.encoding == ExactEncoding){
+                boost::uint64_t bits = doubleToBits(value);
+                frameWords[j] = bits ^ previous[j];
+                previous[j] = bits;
+            }
+            else{
+                boost::int64_t quantized = static_cast<boost::int64_t>(std::floor(value / header.precision + 0.5));
+                frameWords[j] = zigzagEncode(quantized - static_cast<boost::int64_t>(previous[j]));
+                previous[j] = static_cast<boost::uint64_t>(quantized);
+            }
+        }
+    }
+
+    // byte-plane shuffle
+    size_t offset = data.size();
+    data.resize(offset + 8 * words.size());
+
+    for(size_t plane = 0; plane < 8; plane++){
+        char *bytes = &data[offset + plane * words.size()];
+
+        for(size_t i = 0; i < words.size(); i++){
+            bytes[i] = static_cast<char>((words[i] >> (8 * plane)) & 0xff);
+        }
+    }
+}
+
+// decodes an uncompressed chunk containing frameCount frames
+bool decodeChunk(const CtrjHeader &header,
+                 const std::string &data,
+                 size_t frameCount,
+                 CtrjChunk &chunk)
+{
+    if(frameCount == 0){
+        chunk.frameCount = 0;
+        return data.empty();
+    }
+
+    // each frame needs at least its time, cell flag and coordinates
+    if(header.atomCount > data.size() / frameCount / 24){
+        return false;
+    }
+
+    size_t valueCount = 3 * header.atomCount;
+    if(data.size() / (9 + 8 * valueCount) < frameCount){
+        return false;
+    }
+
+    chunk.frameCount = frameCount;
+    chunk.times.resize(frameCount);
+    chunk.hasUnitCell.resize(frameCount);
+    chunk.unitCells.resize(9 * frameCount);
+    chunk.positions.resize(frameCount * valueCount);
+
+    // frame times and unit cells
+    size_t offset = 0;
+    for(size_t i = 0; i < frameCount; i++){
+        if(offset + 9 > data.size()){
+            return false;
+        }
+
+        chunk.times[i] = readDouble(&data[offset]);
+        chunk.hasUnitCell[i] = data[offset + 8];
+        offset += 9;
+
+        if(chunk.hasUnitCell[i]){
+            if(offset + 72 > data.size()){
+                return false;
+            }
+
+            for(size_t j = 0; j < 9; j++){
+                chunk.unitCells[9 * i + j] = readDouble(&data[offset]);
+                offset += 8;
+            }
+        }
+    }
+
+    // coordinates
+    size_t wordCount = frameCount * valueCount;
+    if(data.size() - offset != 8 * wordCount){
+        return false;
+    }
+
+    std::vector<boost::uint64_t> words(wordCount, 0);
+    for(size_t plane = 0; plane < 8; plane++){
+        const unsigned char *bytes =
+            reinterpret_cast<const unsigned char *>(data.data() + offset + plane * wordCount);
+
+        for(size_t i = 0; i < wordCount; i++){
+            words[i] |= static_cast<boost::uint64_t>(bytes[i]) << (8 * plane);
+        }
+    }
+
+    std::vector<boost::uint64_t> previous(valueCount, 0);
+    for(size_t i = 0; i < frameCount; i++){
+        const boost::uint64_t *frameWords = &words[i * valueCount];
+        chemkit::Real *positions = &chunk.positions[i * valueCount];
+
+        for(size_t j = 0; j < valueCount; j++){
+            if(header.encoding == ExactEncoding){
+                boost::uint64_t bits = frameWords[j] ^ previous[j];
+                positions[j] = bitsToDouble(bits);
+                previous[j] = bits;
+            }
+            else{
+                boost::int64_t quantized =
+                    static_cast<boost::int64_t>(previous[j]) + zigzagDecode(frameWords[j]);
+                positions[j] = quantized * header.precision;
+                previous[j] = static_cast<boost::uint64_t>(quantized);
+            }
+        }
+    }
+
+    return true;
+}
+
+// sets frame to the index'th frame in chunk
+void setFrame(const CtrjChunk &chunk, size_t index, size_t atomCount, chemkit::TrajectoryFrame *frame)
+{
+    if(frame->size() != atomCount){
+        frame->trajectory()->resize(atomCount);
+    }
+
+    const chemkit::Real *positions = &chunk.positions[0] + index * 3 * atomCount;
+    for(size_t i = 0; i < atomCount; i++){
+        frame->setPosition(i, chemkit::Point3(positions[3 * i + 0],
+                                              positions[3 * i + 1],
+                                              positions[3 * i + 2]));
+    }
+
+    frame->setTime(chunk.times[index]);
+
+    if(chunk.hasUnitCell[index]){
+        const chemkit::Real *cell = &chunk.unitCells[9 * index];
+
+        frame->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(cell[0], cell[1], cell[2]),
+                                                 chemkit::Vector3(cell[3], cell[4], cell[5]),
+                                                 chemkit::Vector3(cell[6], cell[7], cell[8])));
+    }
+    else{
+        frame->setUnitCell(0);
+    }
+}
+
+// encodes and compresses consecutive chunks starting at firstFrame
+class ChunkEncoder
+{
+public:
+    ChunkEncoder(const CtrjHeader &header,
+                 const std::vector<chemkit::TrajectoryFrame *> &frames,
+                 size_t firstFrame,
+                 size_t frameCount,
+                 std::vector<std::string> &chunks)
+        : m_header(header),
+          m_frames(frames),
+          m_firstFrame(firstFrame),
+          m_frameCount(frameCount),
+          m_chunks(chunks)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        size_t begin = m_firstFrame + index * m_header.chunkSize;
+        size_t end = std::min(begin + m_header.chunkSize, m_frameCount);
+
+        std::string data;
+        encodeChunk(m_header, m_frames, begin, end, data);
+        compress(data, m_chunks[index]);
+    }
+
+private:
+    const CtrjHeader &m_header;
+    const std::vector<chemkit::TrajectoryFrame *> &m_frames;
+    size_t m_firstFrame;
+    size_t m_frameCount;
+    std::vector<std::string> &m_chunks;
+};
+
+// decompresses and decodes chunks into their frames
+class ChunkDecoder
+{
+public:
+    ChunkDecoder(const CtrjHeader &header,
+                 const char *data,
+                 const std::vector<ChunkEntry> &entries,
+                 const std::vector<chemkit::TrajectoryFrame *> &frames,
+                 std::vector<char> &decoded)
+        : m_header(header),
+          m_data(data),
+          m_entries(entries),
+          m_frames(frames),
+          m_decoded(decoded)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        const ChunkEntry &entry = m_entries[index];
+        const char *chunkData = m_data + entry.offset;
+
+        std::string data;
+        CtrjChunk chunk;
+        if(!decompress(chunkData + ChunkHeaderSize, readUInt64(chunkData + 8), data) ||
+           !decodeChunk(m_header, data, entry.frameCount, chunk)){
+            return;
+        }
+
+        for(size_t i = 0; i < entry.frameCount; i++){
+            setFrame(chunk, i, m_header.atomCount, m_frames[entry.firstFrame + i]);
+        }
+
+        m_decoded[index] = true;
+    }
+
+private:
+    const CtrjHeader &m_header;
+    const char *m_data;
+    const std::vector<ChunkEntry> &m_entries;
+    const std::vector<chemkit::TrajectoryFrame *> &m_frames;
+    std::vector<char> &m_decoded;
+};
+
+} // end anonymous namespace
+
+CtrjFileFormat::CtrjFileFormat()
+    : chemkit::TrajectoryFileFormat("ctrj"),
+      m_chunkFrame(0),
+      m_outputOffset(0),
+      m_outputFrameCount(0),
+      m_outputChunkCount(0),
+      m_outputBufferCount(0)
+{
+    m_chunk.frameCount = 0;
+}
+
+bool CtrjFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    std::string data((std::istreambuf_iterator<char>(input)),
+                     std::istreambuf_iterator<char>());
+
+    return readBuffer(data.data(), data.size(), file);
+}
+
+bool CtrjFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input,
+                                    chemkit::TrajectoryFile *file)
+{
+    return readBuffer(input.data(), input.size(), file);
+}
+
+bool CtrjFileFormat::write(const chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = file->trajectory();
+    if(!trajectory){
+        setErrorString("No trajectory to write.");
+        return false;
+    }
+
+    beginOutput(file, trajectory->size(), output);
+
+    std::vector<chemkit::TrajectoryFrame *> frames = trajectory->frames();
+    writeChunks(frames, frames.size(), output);
+
+    endOutput(output);
+
+    return !output.fail();
+}
+
+bool CtrjFileFormat::readHeader(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    setErrorString(std::string());
+
+    m_chunk.frameCount = 0;
+    m_chunkFrame = 0;
+
+    char data[HeaderSize];
+    input.read(data, HeaderSize);
+    if(static_cast<size_t>(input.gcount()) != HeaderSize ||
+       !readHeaderData(data, HeaderSize, m_header)){
+        setErrorString("Invalid ctrj header.");
+        return false;
+    }
+
+    return true;
+}
+
+bool CtrjFileFormat::readFrame(std::istream &input,
+                               chemkit::TrajectoryFile *file,
+                               chemkit::TrajectoryFrame *frame)
+{
+    CHEMKIT_UNUSED(file);
+
+    // decode the next chunk once all frames in the current one are read
+    while(m_chunkFrame >= m_chunk.frameCount){
+        char header[ChunkHeaderSize];
+        input.read(header, 4);
+
+        // the seek table follows the last chunk
+        if(input.gcount() != 4 || std::memcmp(header, IndexMagic, 4) == 0){
+            return false;
+        }
+        else if(std::memcmp(header, ChunkMagic, 4) != 0){
+            setErrorString("Invalid chunk header.");
+            return false;
+        }
+
+        input.read(header + 4, ChunkHeaderSize - 4);
+        if(static_cast<size_t>(input.gcount()) != ChunkHeaderSize - 4){
+            setErrorString("Truncated chunk.");
+            return false;
+        }
+
+        size_t frameCount = readUInt32(header + 4);
+        boost::uint64_t compressedSize = readUInt64(header + 8);
+        if(!checkChunkSize(m_header, frameCount, compressedSize)){
+            setErrorString("Invalid chunk header.");
+            return false;
+        }
+
+        if(!readChunkData(input, compressedSize, m_compressedChunk)){
+            setErrorString("Truncated chunk.");
+            return false;
+        }
+
+        std::string data;
+        if(!decompress(m_compressedChunk.data(), m_compressedChunk.size(), data) ||
+           !decodeChunk(m_header, data, frameCount, m_chunk)){
+            setErrorString("Failed to decode chunk.");
+            return false;
+        }
+
+        m_chunkFrame = 0;
+    }
+
+    setFrame(m_chunk, m_chunkFrame++, m_header.atomCount, frame);
+
+    return true;
+}
+
+bool CtrjFileFormat::writeHeader(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    // the header is written along with the first frame once the
+    // number of atoms is known
+    m_outputBuffer.reset();
+    m_outputBufferCount = 0;
+
+    return !output.fail();
+}
+
+bool CtrjFileFormat::writeFrame(chemkit::TrajectoryFile *file,
+                                const chemkit::TrajectoryFrame *frame,
+                                std::ostream &output)
+{
+    if(!m_outputBuffer){
+        beginOutput(file, frame->size(), output);
+
+        m_outputBuffer = boost::make_shared<chemkit::Trajectory>(frame->size());
+    }
+    else if(frame->size() != m_outputHeader.atomCount){
+        setErrorString("All frames must have the same number of atoms.");
+        return false;
+    }
+
+    // frames are buffered until there is one chunk for each thread
+    // to compress
+    if(m_outputBufferCount == m_outputBuffer->frameCount()){
+        m_outputBuffer->addFrame();
+    }
+
+    copyFrame(frame, m_outputBuffer->frame(m_outputBufferCount++));
+
+    size_t bufferSize = m_outputHeader.chunkSize * chemkit::concurrent::idealThreadCount();
+    if(m_outputBufferCount == bufferSize){
+        writeChunks(m_outputBuffer->frames(), m_outputBufferCount, output);
+        m_outputBufferCount = 0;
+    }
+
+    return !output.fail();
+}
+
+bool CtrjFileFormat::writeFooter(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    if(!m_outputBuffer){
+        beginOutput(file, 0, output);
+    }
+    else if(m_outputBufferCount > 0){
+        writeChunks(m_outputBuffer->frames(), m_outputBufferCount, output);
+    }
+
+    endOutput(output);
+
+    m_outputBuffer.reset();
+    m_outputBufferCount = 0;
+
+    return !output.fail();
+}
+
+bool CtrjFileFormat::readBuffer(const char *data, size_t size, chemkit::TrajectoryFile *file)
+{
+    if(!readHeaderData(data, size, m_header)){
+        setErrorString("Invalid ctrj header.");
+        return false;
+    }
+
+    std::vector<ChunkEntry> entries;
+    if((!readIndex(data, size, entries) || !checkEntries(m_header, data, size, entries)) &&
+       !scanChunks(m_header, data, size, entries)){
+        setErrorString("Invalid chunk header.");
+        return false;
+    }
+
+    // frames are created up front so that the chunks can be decoded
+    // directly into them in parallel
+    boost::shared_ptr<chemkit::Trajectory> trajectory =
+        boost::make_shared<chemkit::Trajectory>(m_header.atomCount);
+
+    size_t frameCount = entries.empty() ? 0 : entries.back().firstFrame + entries.back().frameCount;
+    for(size_t i = 0; i < frameCount; i++){
+        trajectory->addFrame();
+    }
+
+    std::vector<chemkit::TrajectoryFrame *> frames = trajectory->frames();
+    std::vector<char> decoded(entries.size(), false);
+
+    chemkit::concurrent::blockingFor(entries.size(),
+                                     ChunkDecoder(m_header, data, entries, frames, decoded));
+
+    if(std::find(decoded.begin(), decoded.end(), false) != decoded.end()){
+        setErrorString("Failed to decode chunk.");
+        return false;
+    }
+
+    file->setTrajectory(trajectory);
+
+    return true;
+}
+
+// writes the file header and resets the seek table
+void CtrjFileFormat::beginOutput(const chemkit::TrajectoryFile *file, size_t atomCount, std::ostream &output)
+{
+    // coordinates are stored exactly unless a precision is set
+    m_outputHeader.atomCount = atomCount;
+    m_outputHeader.chunkSize = DefaultChunkSize;
+    m_outputHeader.encoding = ExactEncoding;
+    m_outputHeader.precision = 0;
+
+    chemkit::Variant precision = file->data("precision");
+    if(!precision.isNull() && precision.toDouble() > 0){
+        m_outputHeader.encoding = QuantizedEncoding;
+        m_outputHeader.precision = precision.toDouble();
+    }
+
+    std::string data = headerData(m_outputHeader);
+    output.write(data.data(), data.size());
+
+    m_outputOffset = data.size();
+    m_outputFrameCount = 0;
+    m_outputChunkCount = 0;
+    m_outputIndex.clear();
+}
+
+// compresses the first frameCount frames into chunks and writes them
+void CtrjFileFormat::writeChunks(const std::vector<chemkit::TrajectoryFrame *> &frames,
+                                 size_t frameCount,
+                                 std::ostream &output)
+{
+    // chunks are compressed in parallel in batches of one chunk per
+    // thread and then written in order
+    size_t chunkSize = m_outputHeader.chunkSize;
+    size_t chunkCount = (frameCount + chunkSize - 1) / chunkSize;
+    size_t batchSize = chemkit::concurrent::idealThreadCount();
+
+    std::vector<std::string> chunks;
+    std::string data;
+
+    for(size_t firstChunk = 0; firstChunk < chunkCount; firstChunk += batchSize){
+        size_t count = std::min(batchSize, chunkCount - firstChunk);
+        chunks.resize(count);
+
+        chemkit::concurrent::blockingFor(count, ChunkEncoder(m_outputHeader,
+                                                             frames,
+                                                             firstChunk * chunkSize,
+                                                             frameCount,
+                                                             chunks));
+
+        for(size_t i = 0; i < count; i++){
+            size_t chunkFrameCount = std::min(chunkSize, frameCount - (firstChunk + i) * chunkSize);
+
+            data.assign(ChunkMagic, 4);
+            appendUInt32(data, static_cast<boost::uint32_t>(chunkFrameCount));
+            appendUInt64(data, chunks[i].size());
+            output.write(data.data(), data.size());
+            output.write(chunks[i].data(), chunks[i].size());
+
+            // seek table entry
+            appendUInt64(m_outputIndex, m_outputOffset);
+            appendUInt64(m_outputIndex, m_outputFrameCount);
+            appendUInt32(m_outputIndex, static_cast<boost::uint32_t>(chunkFrameCount));
+
+            m_outputOffset += data.size() + chunks[i].size();
+            m_outputFrameCount += chunkFrameCount;
+            m_outputChunkCount++;
+        }
+    }
+}
+
+// writes the seek table and trailer
+void CtrjFileFormat::endOutput(std::ostream &output)
+{
+    std::string data(IndexMagic, 4);
+    appendUInt64(data, m_outputChunkCount);
+    data.append(m_outputIndex);
+    appendUInt64(data, m_outputOffset);
+    data.append(FileMagic, 4);
+
+    output.write(data.data(), data.size());
+}
@@ -0,0 +1,279 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "ecfpfingerprint.h"
+
+#include <algorithm>
+
+#include <chemkit/atom.h>
+#include <chemkit/bond.h>
+#include <chemkit/ring.h>
+#include <chemkit/foreach.h>
+
+namespace {
+
+// bond type used for aromatic bonds in atom environments
+const boost::uint32_t AromaticBondType = 4;
+
+// Combines value into the hash in seed. The hash only uses 32-bit
+// arithmetic so that identifiers are the same on every platform.
+inline boost::uint32_t hashCombine(boost::uint32_t seed, boost::uint32_t value)
+{
+    return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+// Mixes the bits in hash so that identifiers are spread evenly over
+// the bits of a folded fingerprint.
+inline boost::uint32_t finalizeHash(boost::uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+} // end anonymous namespace
+
+EcfpFingerprint::EcfpFingerprint()
+    : chemkit::Fingerprint("ecfp")
+{
+}
+
+EcfpFingerprint::~EcfpFingerprint()
+{
+}
+
+// Returns the number of bits in the folded fingerprint. A size
+// option that is not positive gives an empty fingerprint.
+size_t EcfpFingerprint::size() const
+{
+    long size = option("size").toLong();
+
+    return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+// Returns the folded fingerprint value for the molecule.
+chemkit::Bitset EcfpFingerprint::value(const chemkit::Molecule *molecule) const
+{
+    size_t size = this->size();
+    chemkit::Bitset fingerprint(size);
+    if(size == 0){
+        return fingerprint;
+    }
+
+    std::vector<boost::uint32_t> identifiers;
+    calculateIdentifiers(molecule, identifiers);
+
+    foreach(boost::uint32_t identifier, identifiers){
+        fingerprint.set(identifier % size);
+    }
+
+    return fingerprint;
+}
+
+// Returns the number of times each bit of the folded fingerprint is
+// set for the molecule.
+std::vector<size_t> EcfpFingerprint::counts(const chemkit::Molecule *molecule) const
+{
+    size_t size = this->size();
+    std::vector<size_t> counts(size, 0);
+    if(size == 0){
+        return counts;
+    }
+
+    std::vector<boost::uint32_t> identifiers;
+    calculateIdentifiers(molecule, identifiers);
+
+    foreach(boost::uint32_t identifier, identifiers){
+        counts[identifier % size]++;
+    }
+
+    return counts;
+}
+
+// Returns each unfolded atom environment identifier in the molecule
+// along with the number of times it occurs.
+chemkit::Fingerprint::FeatureCounts EcfpFingerprint::features(const chemkit::Molecule *molecule) const
+{
+    std::vector<boost::uint32_t> identifiers;
+    calculateIdentifiers(molecule, identifiers);
+    std::sort(identifiers.begin(), identifiers.end());
+
+    FeatureCounts features;
+    for(size_t i = 0; i < identifiers.size(); i++){
+        if(features.empty() || features.back().first != identifiers[i]){
+            features.push_back(std::make_pair(identifiers[i], size_t(0)));
+        }
+
+        features.back().second++;
+    }
+
+    return features;
+}
+
+// Returns the default value for the option specified by name.
+chemkit::Variant EcfpFingerprint::defaultOption(const std::string &name) const
+{
+    if(name == "radius"){
+        return 2;
+    }
+    else if(name == "size"){
+        return 2048;
+    }
+
+    return chemkit::Variant();
+}
+
+// Calculates the identifier of the environment around each heavy atom
+// out to each radius up to and including the radius option. An
+// atom's identifier starts as a hash of its invariants (atomic
+// number, heavy atom degree, hydrogen count, formal charge and ring
+// membership). Each iteration then hashes the atom's identifier with
+// the sorted bond types and identifiers of its neighbors from the
+// previous iteration. This is the extended connectivity scheme used
+// by ECFP and Morgan fingerprints.
+//
+// Reference:
+//   Rogers, D. and Hahn, M. Extended-Connectivity Fingerprints.
+//   J. Chem. Inf. Model. 50 (2010) 742-754.
+void EcfpFingerprint::calculateIdentifiers(const chemkit::Molecule *molecule,
+                                           std::vector<boost::uint32_t> &identifiers) const
+{
+    int radius = option("radius").toInt();
+    size_t atomCount = molecule->atomCount();
+
+    // a negative radius has no environments
+    identifiers.clear();
+    if(radius < 0){
+        return;
+    }
+
+    // number the heavy atoms, terminal hydrogens only contribute to
+    // the hydrogen count of their neighbor
+    std::vector<size_t> heavyIndices(atomCount, size_t(-1));
+    std::vector<const chemkit::Atom *> heavyAtoms;
+    heavyAtoms.reserve(atomCount);
+
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        if(!atom->isTerminalHydrogen()){
+            heavyIndices[atom->index()] = heavyAtoms.size();
+            heavyAtoms.push_back(atom);
+        }
+    }
+
+    size_t heavyAtomCount = heavyAtoms.size();
+    identifiers.reserve(heavyAtomCount * (radius + 1));
+
+    // find ring atoms and aromatic bonds with a single pass over the
+    // rings in the molecule
+    std::vector<char> ringAtoms(atomCount, false);
+    std::vector<char> aromaticBonds(molecule->bondCount(), false);
+
+    foreach(const chemkit::Ring *ring, molecule->rings()){
+        foreach(const chemkit::Atom *atom, ring->atoms()){
+            ringAtoms[atom->index()] = true;
+        }
+
+        if(ring->isAromatic()){
+            foreach(const chemkit::Bond *bond, ring->bonds()){
+                aromaticBonds[bond->index()] = true;
+            }
+        }
+    }
+
+    // build the heavy atom neighbor lists and initial identifiers
+    std::vector<size_t> neighborOffsets(heavyAtomCount + 1, 0);
+    std::vector<std::pair<boost::uint32_t, size_t> > neighbors;
+    neighbors.reserve(2 * molecule->bondCount());
+
+    std::vector<boost::uint32_t> current(heavyAtomCount);
+    std::vector<boost::uint32_t> next(heavyAtomCount);
+
+    for(size_t i = 0; i < heavyAtomCount; i++){
+        const chemkit::Atom *atom = heavyAtoms[i];
+        neighborOffsets[i] = neighbors.size();
+
+        boost::uint32_t hydrogenCount = 0;
+        foreach(const chemkit::Bond *bond, atom->bonds()){
+            size_t neighbor = heavyIndices[bond->otherAtom(atom)->index()];
+            if(neighbor == size_t(-1)){
+                hydrogenCount++;
+                continue;
+            }
+
+            boost::uint32_t bondType = aromaticBonds[bond->index()] ? AromaticBondType : bond->order();
+            neighbors.push_back(std::make_pair(bondType, neighbor));
+        }
+
+        boost::uint32_t hash = atom->atomicNumber();
+        hash = hashCombine(hash, static_cast<boost::uint32_t>(neighbors.size() - neighborOffsets[i]));
+        hash = hashCombine(hash, hydrogenCount);
+        hash = hashCombine(hash, static_cast<boost::uint32_t>(atom->formalCharge()));
+        hash = hashCombine(hash, ringAtoms[atom->index()] ? 1 : 0);
+
+        current[i] = finalizeHash(hash);
+        identifiers.push_back(current[i]);
+    }
+
+    neighborOffsets[heavyAtomCount] = neighbors.size();
+
+    // grow each atom's environment by one bond per iteration
+    std::vector<std::pair<boost::uint32_t, boost::uint32_t> > environment;
+
+    for(int iteration = 1; iteration <= radius; iteration++){
+        for(size_t i = 0; i < heavyAtomCount; i++){
+            environment.clear();
+            for(size_t j = neighborOffsets[i]; j < neighborOffsets[i + 1]; j++){
+                environment.push_back(std::make_pair(neighbors[j].first, current[neighbors[j].second]));
+            }
+
+            std::sort(environment.begin(), environment.end());
+
+            boost::uint32_t hash = hashCombine(static_cast<boost::uint32_t>(iteration), current[i]);
+            for(size_t j = 0; j < environment.size(); j++){
+                hash = hashCombine(hash, environment[j].first);
+                hash = hashCombine(hash, environment[j].second);
+            }
+
+            next[i] = finalizeHash(hash);
+            identifiers.push_back(next[i]);
+        }
+
+        current.swap(next);
+    }
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#ifndef ECFPFINGERPRINT_H
+#define ECFPFINGERPRINT_H
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <chemkit/molecule.h>
+#include <chemkit/fingerprint.h>
+
+class EcfpFingerprint : public chemkit::Fingerprint
+{
+public:
+    EcfpFingerprint();
+    ~EcfpFingerprint();
+
+    size_t size() const CHEMKIT_OVERRIDE;
+    chemkit::Bitset value(const chemkit::Molecule *molecule) const CHEMKIT_OVERRIDE;
+    std::vector<size_t> counts(const chemkit::Molecule *molecule) const CHEMKIT_OVERRIDE;
+    FeatureCounts features(const chemkit::Molecule *molecule) const CHEMKIT_OVERRIDE;
+
+protected:
+    chemkit::Variant defaultOption(const std::string &name) const CHEMKIT_OVERRIDE;
+
+private:
+    void calculateIdentifiers(const chemkit::Molecule *molecule,
+                              std::vector<boost::uint32_t> &identifiers) const;
+};
+
+#endif // ECFPFINGERPRINT_H
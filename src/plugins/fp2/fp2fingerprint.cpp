@@ -36,165 +36,313 @@
 
 #include "fp2fingerprint.h"
 
+#include <vector>
+
 #include <chemkit/atom.h>
 #include <chemkit/bond.h>
-#include <chemkit/ring.h>
 #include <chemkit/foreach.h>
 
 // The FP2 fingerprint implementation is adapted from code provided
 // by Chris Morley.
 
-Fp2Fingerprint::Fp2Fingerprint()
-    : chemkit::Fingerprint("fp2")
-{
-}
+namespace {
 
-Fp2Fingerprint::~Fp2Fingerprint()
-{
-}
+// maximum number of atoms in a fragment
+const size_t MaxFragmentSize = 7;
 
-// Returns the FP2 fingerprint value for the molecule.
-chemkit::Bitset Fp2Fingerprint::value(const chemkit::Molecule *molecule) const
+// Returns the canonical hash value for the size values in fragment.
+// Fragment can be any type with an operator[] returning the values.
+template<typename Fragment>
+size_t canonicalHash(const Fragment &fragment, size_t size)
 {
-    // create bitset
-    chemkit::Bitset fingerprint(1021);
+    const size_t MODINT = 108; // 2^32 % 1021
 
-    foreach(const chemkit::Atom *atom, molecule->atoms()){
-        // skip fragments starting at terminal hydrogens
-        if(atom->isTerminalHydrogen()){
+    // check if we need to reverse the fragment
+    bool reverse = false;
+
+    for(size_t i = 1; i < size; i++){
+        if(fragment[i] == fragment[size - i]){
             continue;
         }
 
-        // add each atom fragment to the fingerprint
-        addFragments(atom, fingerprint);
+        reverse = fragment[i] < fragment[size - i];
+        break;
     }
 
-    return fingerprint;
+    // calculate hash value
+    size_t hash = 0;
+
+    if(reverse){
+        for(size_t i = size - 1; i != 0; i--){
+            hash = (hash * MODINT + (fragment[i] % 1021)) % 1021;
+        }
+    }
+    else{
+        for(size_t i = 0; i < size; i++){
+            hash = (hash * MODINT + (fragment[i] % 1021)) % 1021;
+        }
+    }
+
+    return hash;
 }
 
-// Add all fragments starting at atom to the fingerprint.
-void Fp2Fingerprint::addFragments(const chemkit::Atom *atom,
-                                  chemkit::Bitset &fingerprint) const
+// A rotated, and optionally reversed, view of a ring fragment. Ring
+// fragments are stored as bond order and atomic number pairs with
+// the ring closure bond first. Rotating by two values moves the
+// first atom to the end of the ring and reversing keeps the first
+// bond in place while reversing the rest. The open form of a ring
+// replaces the ring closure bond with a zero so that it is hashed
+// as a linear fragment.
+class RingView
 {
-    Fragment fragment;
-    chemkit::Bitset visited(atom->molecule()->atomCount());
-    extendFragment(fragment, 1, visited, atom, 0, atom, fingerprint);
-}
+public:
+    RingView(const unsigned char *fragment, size_t size, size_t rotation, bool reversed, bool open = false)
+        : m_fragment(fragment),
+          m_size(size),
+          m_rotation(rotation),
+          m_reversed(reversed),
+          m_open(open)
+    {
+    }
+
+    unsigned char operator[](size_t index) const
+    {
+        if(index == 0 && m_open){
+            return 0;
+        }
+
+        if(m_reversed && index != 0){
+            index = m_size - index;
+        }
+
+        index += m_rotation;
+        if(index >= m_size){
+            index -= m_size;
+        }
+
+        return m_fragment[index];
+    }
+
+    bool operator>(const RingView &other) const
+    {
+        for(size_t i = 0; i < m_size; i++){
+            unsigned char value = (*this)[i];
+            unsigned char otherValue = other[i];
 
-// Extend the fragment to atom.
-void Fp2Fingerprint::extendFragment(Fragment fragment,
-                                    size_t depth,
-                                    chemkit::Bitset visited,
-                                    const chemkit::Atom *atom,
-                                    const chemkit::Bond *bond,
-                                    const chemkit::Atom *firstAtom,
-                                    chemkit::Bitset &fingerprint) const
+            if(value != otherValue){
+                return value > otherValue;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    const unsigned char *m_fragment;
+    size_t m_size;
+    size_t m_rotation;
+    bool m_reversed;
+    bool m_open;
+};
+
+// Enumerates the linear and ring fragments in a molecule. Fragments
+// are grown one atom at a time with an explicit stack, and the
+// fragment values and visited atoms are kept in buffers that are
+// reused for every fragment in the molecule.
+class FragmentEnumerator
 {
-    const size_t MaxFragmentSize = 7;
+public:
+    FragmentEnumerator(const chemkit::Molecule *molecule);
+
+    void addFragments(size_t firstAtom, chemkit::Bitset &fingerprint);
+
+private:
+    void pushAtom(size_t depth, size_t atom, size_t bond, unsigned char bondOrder);
+    void addRing(size_t size, chemkit::Bitset &fingerprint) const;
 
-    chemkit::Bond::BondOrderType bondOrder = 0;
-    if(bond){
-        bondOrder = bond->isAromatic() ? 5 : bond->order();
+private:
+    struct Neighbor
+    {
+        size_t atom;
+        size_t bond;
+        unsigned char bondOrder;
+    };
+
+    struct Frame
+    {
+        size_t atom;
+        size_t bond;
+        size_t nextNeighbor;
+        unsigned char bondOrder;
+        unsigned char firstValue;
+    };
+
+    std::vector<unsigned char> m_atomicNumbers;
+    std::vector<size_t> m_neighborOffsets;
+    std::vector<Neighbor> m_neighbors;
+    std::vector<char> m_visited;
+    unsigned char m_fragment[2 * MaxFragmentSize];
+    Frame m_frames[MaxFragmentSize];
+};
+
+// Builds the neighbor lists for the molecule. Bond orders are looked
+// up once per bond and terminal hydrogens are left out because they
+// are never part of a fragment.
+FragmentEnumerator::FragmentEnumerator(const chemkit::Molecule *molecule)
+    : m_atomicNumbers(molecule->atomCount()),
+      m_neighborOffsets(molecule->atomCount() + 1, 0),
+      m_visited(molecule->atomCount(), false)
+{
+    std::vector<unsigned char> bondOrders(molecule->bondCount());
+    foreach(const chemkit::Bond *bond, molecule->bonds()){
+        bondOrders[bond->index()] = bond->isAromatic() ? 5 : bond->order();
     }
 
-    fragment.push_back(bondOrder);
-    fragment.push_back(atom->atomicNumber());
-    visited.set(atom->index());
+    m_neighbors.reserve(2 * molecule->bondCount());
 
-    foreach(const chemkit::Bond *neighborBond, atom->bonds()){
-        if(neighborBond == bond){
-            continue; // don't retrace steps
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        m_atomicNumbers[atom->index()] = atom->atomicNumber();
+        m_neighborOffsets[atom->index()] = m_neighbors.size();
+
+        foreach(const chemkit::Bond *bond, atom->bonds()){
+            const chemkit::Atom *neighbor = bond->otherAtom(atom);
+            if(neighbor->isTerminalHydrogen()){
+                continue;
+            }
+
+            Neighbor entry;
+            entry.atom = neighbor->index();
+            entry.bond = bond->index();
+            entry.bondOrder = bondOrders[bond->index()];
+            m_neighbors.push_back(entry);
         }
+    }
+
+    m_neighborOffsets[molecule->atomCount()] = m_neighbors.size();
+}
+
+// Add all fragments starting at the first atom to the fingerprint.
+//
+// Each frame on the stack is one atom in the current fragment. When a
+// ring closure back to the first atom is found the first value of
+// the fragment is set to the bond order leading to the current atom.
+// That value stays in place for the rest of the current atom's
+// neighbors and the fragments grown from them, and it is restored
+// when the stack unwinds back to an atom.
+void FragmentEnumerator::addFragments(size_t firstAtom, chemkit::Bitset &fingerprint)
+{
+    pushAtom(0, firstAtom, size_t(-1), 0);
+    size_t depth = 1;
+
+    while(depth > 0){
+        Frame &frame = m_frames[depth - 1];
+        m_fragment[0] = frame.firstValue;
 
-        const chemkit::Atom *neighbor = neighborBond->otherAtom(atom);
-        if(neighbor->isTerminalHydrogen()){
-            continue; // don't include terminal hydrogens
+        // all neighbors visited
+        if(frame.nextNeighbor == m_neighborOffsets[frame.atom + 1]){
+            // do not save C, N, O single atom fragments
+            if(m_fragment[0] == 0 && (depth > 1 || m_fragment[1] > 8 || m_fragment[1] < 6)){
+                fingerprint.set(canonicalHash(m_fragment, 2 * depth));
+            }
+
+            m_visited[frame.atom] = false;
+            depth--;
+            continue;
+        }
+
+        const Neighbor &neighbor = m_neighbors[frame.nextNeighbor++];
+        if(neighbor.bond == frame.bond){
+            continue; // don't retrace steps
         }
 
         // if the neighbor is an atom that we've already visited
         // then this fragment forms a ring
-        if(visited.test(neighbor->index())){
-            if(neighbor == firstAtom){
+        if(m_visited[neighbor.atom]){
+            if(neighbor.atom == firstAtom){
                 // add bond at front for the ring
-                fragment[0] = bondOrder;
-
-                // insert ring
-                Fragment ring = fragment;
-                Fragment canonicalRing = fragment;
-                for(size_t i = 0; i < ring.size() / 2; i++){
-                    // rotate atoms in ring
-                    std::rotate(ring.begin(), ring.begin() + 2, ring.end());
-                    if(ring > canonicalRing){
-                        canonicalRing = ring;
-                    }
-
-                    // reverse the ring
-                    Fragment reversedRing = ring;
-                    std::reverse(reversedRing.begin() + 1, reversedRing.end());
-                    if(reversedRing > canonicalRing){
-                        canonicalRing = reversedRing;
-                    }
-
-                    // add the non-ring form of all ring rotations
-                    Fragment ringCopy = ring;
-                    ringCopy[0] = 0;
-                    fingerprint.set(canonicalHash(ringCopy));
-                }
-
-                fingerprint.set(canonicalHash(canonicalRing));
+                frame.firstValue = frame.bondOrder;
+                m_fragment[0] = frame.firstValue;
+
+                addRing(2 * depth, fingerprint);
             }
         }
         // no ring
-        else{
-            if(depth < MaxFragmentSize){
-                // extend fragment to the next atom
-                extendFragment(fragment,
-                               depth+1,
-                               visited,
-                               neighbor,
-                               neighborBond,
-                               firstAtom,
-                               fingerprint);
-            }
+        else if(depth < MaxFragmentSize){
+            // extend fragment to the next atom
+            pushAtom(depth, neighbor.atom, neighbor.bond, neighbor.bondOrder);
+            depth++;
         }
     }
+}
 
-    // do not save C, N, O single atom fragments
-    if(fragment[0] == 0 && (depth > 1 || fragment[1] > 8 || fragment[1] < 6)){
-        fingerprint.set(canonicalHash(fragment));
-    }
+// Extend the fragment at depth to atom.
+void FragmentEnumerator::pushAtom(size_t depth, size_t atom, size_t bond, unsigned char bondOrder)
+{
+    m_fragment[2 * depth] = bondOrder;
+    m_fragment[2 * depth + 1] = m_atomicNumbers[atom];
+    m_visited[atom] = true;
+
+    Frame &frame = m_frames[depth];
+    frame.atom = atom;
+    frame.bond = bond;
+    frame.nextNeighbor = m_neighborOffsets[atom];
+    frame.bondOrder = bondOrder;
+    frame.firstValue = m_fragment[0];
 }
 
-// Returns the canonical hash value for the fragment.
-size_t Fp2Fingerprint::canonicalHash(const Fragment &fragment)
+// Adds the canonical form of the ring in the first size fragment
+// values to the fingerprint along with the open form of each of its
+// rotations.
+void FragmentEnumerator::addRing(size_t size, chemkit::Bitset &fingerprint) const
 {
-    const size_t MODINT = 108; // 2^32 % 1021
+    RingView canonicalRing(m_fragment, size, 0, false);
 
-    // check if we need to reverse the fragment
-    bool reverse = false;
+    for(size_t rotation = 2; rotation <= size; rotation += 2){
+        RingView ring(m_fragment, size, rotation % size, false);
+        if(ring > canonicalRing){
+            canonicalRing = ring;
+        }
 
-    for(size_t i = 1; i < fragment.size(); i++){
-        if(*(fragment.begin() + i) == *(fragment.end() - i)){
-            continue;
+        RingView reversedRing(m_fragment, size, rotation % size, true);
+        if(reversedRing > canonicalRing){
+            canonicalRing = reversedRing;
         }
 
-        reverse = *(fragment.begin() + i) < *(fragment.end() - i);
-        break;
+        // add the non-ring form of all ring rotations
+        fingerprint.set(canonicalHash(RingView(m_fragment, size, rotation % size, false, true), size));
     }
 
-    // calculate hash value
-    size_t hash = 0;
+    fingerprint.set(canonicalHash(canonicalRing, size));
+}
 
-    if(reverse){
-        for(size_t i = fragment.size() - 1; i != 0; i--){
-            hash = (hash * MODINT + (fragment[i] % 1021)) % 1021;
-        }
-    }
-    else{
-        for(size_t i = 0; i < fragment.size(); i++){
-            hash = (hash * MODINT + (fragment[i] % 1021)) % 1021;
+} // end anonymous namespace
+
+Fp2Fingerprint::Fp2Fingerprint()
+    : chemkit::Fingerprint("fp2")
+{
+}
+
+Fp2Fingerprint::~Fp2Fingerprint()
+{
+}
+
+// Returns the FP2 fingerprint value for the molecule.
+chemkit::Bitset Fp2Fingerprint::value(const chemkit::Molecule *molecule) const
+{
+    // create bitset
+    chemkit::Bitset fingerprint(1021);
+
+    FragmentEnumerator enumerator(molecule);
+
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        // skip fragments starting at terminal hydrogens
+        if(atom->isTerminalHydrogen()){
+            continue;
         }
+
+        // add each atom fragment to the fingerprint
+        enumerator.addFragments(atom->index(), fingerprint);
     }
 
-    return hash;
+    return fingerprint;
 }
@@ -36,11 +36,10 @@
 #include "grofileformat.h"
 
 #include <boost/make_shared.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
 
 #include <chemkit/topology.h>
 #include <chemkit/topologyfile.h>
+#include <chemkit/linetokenizer.h>
 
 GroFileFormat::GroFileFormat()
     : chemkit::TopologyFileFormat("gro")
@@ -58,15 +57,12 @@ bool GroFileFormat::read(std::istream &input, chemkit::TopologyFile *file)
     std::getline(input, comments);
 
     // read topology size from the second line
-    size_t size = 0;
-    std::string sizeString;
-    std::getline(input, sizeString);
-    boost::algorithm::trim(sizeString);
+    std::string line;
+    std::getline(input, line);
+    chemkit::LineTokenizer tokenizer(line);
 
-    try{
-        size = boost::lexical_cast<size_t>(sizeString);
-    }
-    catch(boost::bad_lexical_cast&){
+    int size = 0;
+    if(!tokenizer.nextInteger(&size) || size < 0 || !tokenizer.atEnd()){
         setErrorString("Second line does not contain size.");
         return false;
     }
@@ -74,25 +70,28 @@ bool GroFileFormat::read(std::istream &input, chemkit::TopologyFile *file)
     boost::shared_ptr<chemkit::Topology> topology =
         boost::make_shared<chemkit::Topology>(size);
 
-    for(size_t i = 0; i < size; i++){
-        std::string line;
+    for(int i = 0; i < size; i++){
         std::getline(input, line);
         if(line.empty()){
             break;
         }
 
-        boost::algorithm::trim_left(line);
-        std::vector<std::string> tokens;
-        boost::split(tokens,
-                     line,
-                     boost::is_any_of("\t "),
-                     boost::algorithm::token_compress_on);
+        tokenizer.setLine(line);
+        boost::string_ref residue = tokenizer.nextToken();
+        boost::string_ref type = tokenizer.nextToken();
 
-        if(tokens.size() < 2){
+        if(type.empty()){
             break;
         }
 
-        topology->setType(i, tokens[1]);
+        topology->setType(i, std::string(type.begin(), type.end()));
+
+        // the first token is the residue number followed by the residue name
+        size_t nameBegin = 0;
+        while(nameBegin < residue.size() && chemkit::LineTokenizer::isDigit(residue[nameBegin])){
+            nameBegin++;
+        }
+        topology->setResidueName(i, std::string(residue.begin() + nameBegin, residue.end()));
     }
 
     file->setTopology(topology);
@@ -36,6 +36,7 @@
 #include <chemkit/plugin.h>
 
 #include "grofileformat.h"
+#include "grotrajectoryfileformat.h"
 #include "topfileformat.h"
 
 class GromacsPlugin : public chemkit::Plugin
@@ -46,6 +47,7 @@ public:
     {
         CHEMKIT_REGISTER_TOPOLOGY_FILE_FORMAT("gro", GroFileFormat);
         CHEMKIT_REGISTER_TOPOLOGY_FILE_FORMAT("top", TopFileFormat);
+        CHEMKIT_REGISTER_TRAJECTORY_FILE_FORMAT("gro", GroTrajectoryFileFormat);
     }
 };
 
@@ -0,0 +1,234 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "grotrajectoryfileformat.h"
+
+#include <algorithm>
+
+#include <boost/make_shared.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include <chemkit/vector3.h>
+#include <chemkit/unitcell.h>
+#include <chemkit/topology.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+#include <chemkit/linetokenizer.h>
+
+// A gro trajectory is a sequence of gro frames. Each frame consists
+// of a title line (which may contain the time as "t= <time>"), the
+// atom count, one fixed-column line per atom and a box line. The
+// coordinates start at column 20 and their field width is given by
+// the distance between the decimal points. Lengths are in nanometers
+// and are converted to angstroms.
+
+namespace {
+
+// returns the time from a title line or zero if it does not contain one
+chemkit::Real parseTime(const std::string &line)
+{
+    size_t position = line.find("t=");
+    while(position != std::string::npos){
+        if(position == 0 || line[position - 1] == ' '){
+            chemkit::LineTokenizer tokenizer(line);
+            tokenizer.setPosition(position + 2);
+
+            chemkit::Real time = 0;
+            tokenizer.nextReal(&time);
+            return time;
+        }
+
+        position = line.find("t=", position + 2);
+    }
+
+    return 0;
+}
+
+} // end anonymous namespace
+
+GroTrajectoryFileFormat::GroTrajectoryFileFormat()
+    : chemkit::TrajectoryFileFormat("gro"),
+      m_setTypes(false)
+{
+}
+
+bool GroTrajectoryFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    if(!readHeader(input, file)){
+        return false;
+    }
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory =
+        boost::make_shared<chemkit::Trajectory>();
+
+    for(;;){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+
+        if(!readFrame(input, file, frame)){
+            trajectory->removeFrame(frame);
+            break;
+        }
+    }
+
+    if(!errorString().empty()){
+        return false;
+    }
+
+    file->setTrajectory(trajectory);
+
+    return true;
+}
+
+bool GroTrajectoryFileFormat::readHeader(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    CHEMKIT_UNUSED(input);
+
+    setErrorString(std::string());
+
+    // the atom names from the first frame are used as the
+    // topology if the file does not already have one
+    m_setTypes = !file->topology();
+
+    return true;
+}
+
+bool GroTrajectoryFileFormat::readFrame(std::istream &input,
+                                        chemkit::TrajectoryFile *file,
+                                        chemkit::TrajectoryFrame *frame)
+{
+    // title line, blank lines at the end of the file are ignored
+    if(!std::getline(input, m_line)){
+        return false;
+    }
+    else if(boost::algorithm::trim_copy(m_line).empty() && input.peek() == EOF){
+        return false;
+    }
+
+    chemkit::Real time = parseTime(m_line);
+
+    // atom count line
+    std::getline(input, m_line);
+    chemkit::LineTokenizer tokenizer(m_line);
+    int count = 0;
+    if(!tokenizer.nextInteger(&count) || count < 0){
+        setErrorString("Invalid atom count line.");
+        return false;
+    }
+
+    size_t size = count;
+
+    if(frame->size() != size){
+        frame->trajectory()->resize(size);
+    }
+
+    boost::shared_ptr<chemkit::Topology> topology;
+    if(m_setTypes){
+        topology = boost::make_shared<chemkit::Topology>(size);
+    }
+
+    // atom lines
+    size_t width = 8;
+    for(size_t i = 0; i < size; i++){
+        if(!std::getline(input, m_line)){
+            setErrorString("Unexpected end of frame.");
+            return false;
+        }
+
+        // the coordinate width is the same for all atoms in the frame
+        if(i == 0){
+            size_t first = m_line.find('.', 20);
+            size_t second = m_line.find('.', first + 1);
+            if(first != std::string::npos && second != std::string::npos){
+                width = second - first;
+            }
+        }
+
+        tokenizer.setLine(m_line);
+
+        chemkit::Real x, y, z;
+        if(!tokenizer.columnReal(20, width, &x) ||
+           !tokenizer.columnReal(20 + width, width, &y) ||
+           !tokenizer.columnReal(20 + 2 * width, width, &z)){
+            setErrorString("Invalid atom line.");
+            return false;
+        }
+
+        frame->setPosition(i, chemkit::Point3(x, y, z) * 10);
+
+        if(topology){
+            boost::string_ref residueName = tokenizer.column(5, 5);
+            boost::string_ref type = tokenizer.column(10, 5);
+            topology->setResidueName(i, std::string(residueName.begin(), residueName.end()));
+            topology->setType(i, std::string(type.begin(), type.end()));
+        }
+    }
+
+    // box line, either the three box lengths or all nine box
+    // vector components for triclinic boxes
+    std::getline(input, m_line);
+
+    tokenizer.setLine(m_line);
+
+    chemkit::Real box[9] = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    size_t boxCount = 0;
+    while(boxCount < 9 && tokenizer.nextReal(&box[boxCount])){
+        boxCount++;
+    }
+
+    if(boxCount < 3){
+        setErrorString("Invalid box line.");
+        return false;
+    }
+
+    if(std::count(box, box + 9, chemkit::Real(0)) == 9){
+        frame->setUnitCell(0);
+    }
+    else{
+        // the order is v1(x) v2(y) v3(z) v1(y) v1(z) v2(x) v2(z) v3(x) v3(y)
+        frame->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(box[0], box[3], box[4]) * 10,
+                                                 chemkit::Vector3(box[5], box[1], box[6]) * 10,
+                                                 chemkit::Vector3(box[7], box[8], box[2]) * 10));
+    }
+
+    frame->setTime(time);
+
+    if(topology){
+        file->setTopology(topology);
+        m_setTypes = false;
+    }
+
+    return true;
+}
@@ -37,40 +37,136 @@
 // mdl, sd, and sdf chemical files.
 //
 // Specification: http://www.symyx.com/downloads/public/ctfile/ctfile.jsp
+//
+// A record whose header is truncated, whose bond block is malformed
+// or which has no "M  END" line is invalid. read(), readMappedFile()
+// and readMolecule() all stop at the first invalid record and report
+// it, keeping the molecules read before it.
 
 #include "mdlfileformat.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 #include <chemkit/atom.h>
 #include <chemkit/bond.h>
 #include <chemkit/foreach.h>
 #include <chemkit/molecule.h>
+#include <chemkit/concurrent.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/textwriter.h>
+#include <chemkit/linetokenizer.h>
+#include <chemkit/moleculefileindex.h>
 
 namespace {
 
-int readNumber(const char *s, int length)
+// Returns the offset of the line following the next "$$$$" record
+// delimiter at or after position, or size if there are no more
+// delimiters in the data. As in readDataBlock() the delimiter may be
+// preceded by white space on its line.
+size_t nextRecordEnd(const char *data, size_t size, size_t position)
 {
-    // skip any leading white space
-    while(isspace(*s) && --length){
-        s++;
+    while(position < size){
+        const char *match = static_cast<const char *>(memchr(data + position, '$', size - position));
+        if(!match){
+            break;
+        }
+
+        size_t offset = match - data;
+
+        size_t lineStart = offset;
+        while(lineStart > 0 && data[lineStart - 1] != '\n' && isspace(data[lineStart - 1])){
+            lineStart--;
+        }
+
+        if((lineStart == 0 || data[lineStart - 1] == '\n') &&
+           size - offset >= 4 &&
+           strncmp(match, "$$$$", 4) == 0){
+            const char *end = static_cast<const char *>(memchr(match, '\n', size - offset));
+
+            return end ? end - data + 1 : size;
+        }
+
+        position = offset + 1;
     }
 
-    int number = 0;
+    return size;
+}
+
+// Returns true if the data contains only white space.
+bool isBlank(const char *data, size_t size)
+{
+    for(size_t i = 0; i < size; i++){
+        if(!isspace(data[i])){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the first line of the record without the line ending.
+std::string firstLine(const char *data, size_t size)
+{
+    const char *end = static_cast<const char *>(memchr(data, '\n', size));
+    size_t length = end ? end - data : size;
 
-    while(length-- && isdigit(*s)){
-        number = number * 10 + (*s++ - '0');
+    if(length > 0 && data[length - 1] == '\r'){
+        length--;
     }
 
-    return number;
+    return std::string(data, length);
 }
 
 } // end anonymous namespace
 
+// === MdlFileFormat::RecordReader ========================================= //
+// Reads the records of a mapped sdf file in parallel. Each record is
+// parsed from its own stream over the mapped data and the molecule is
+// stored at the record's index so that the file order is preserved.
+// Invalid records are stored as a null molecule along with the
+// reason they were rejected.
+class MdlFileFormat::RecordReader
+{
+public:
+    RecordReader(const char *data,
+                 const std::vector<std::pair<size_t, size_t> > &records,
+                 std::vector<boost::shared_ptr<chemkit::Molecule> > &molecules,
+                 std::vector<std::string> &errors)
+        : m_data(data),
+          m_records(records),
+          m_molecules(molecules),
+          m_errors(errors)
+    {
+    }
+
+    void operator()(size_t index) const
+    {
+        const std::pair<size_t, size_t> &record = m_records[index];
+
+        boost::iostreams::stream<boost::iostreams::array_source> input(m_data + record.first,
+                                                                        record.second - record.first);
+
+        boost::shared_ptr<chemkit::Molecule> molecule = readMolBlock(input, m_errors[index]);
+        if(molecule){
+            readDataBlock(input, molecule.get());
+        }
+
+        m_molecules[index] = molecule;
+    }
+
+private:
+    const char *m_data;
+    const std::vector<std::pair<size_t, size_t> > &m_records;
+    std::vector<boost::shared_ptr<chemkit::Molecule> > &m_molecules;
+    std::vector<std::string> &m_errors;
+};
+
 // --- Construction and Destruction ---------------------------------------- //
 MdlFileFormat::MdlFileFormat(const std::string &name)
-    : chemkit::MoleculeFileFormat(name)
+    : chemkit::MoleculeFileFormat(name),
+      m_streamCount(0)
 {
 }
 
@@ -92,17 +188,70 @@ bool MdlFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
     }
 }
 
+// The records in sdf files are located by scanning the mapped data
+// for "$$$$" delimiters and are then parsed in parallel.
+bool MdlFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file)
+{
+    const char *data = input.data();
+    size_t size = input.size();
+
+    if(!isSdf()){
+        boost::iostreams::stream<boost::iostreams::array_source> stream(data, size);
+
+        return readMolFile(stream, file);
+    }
+
+    // find record boundaries
+    std::vector<std::pair<size_t, size_t> > records;
+
+    size_t position = 0;
+    while(position < size){
+        size_t end = nextRecordEnd(data, size, position);
+
+        if(!isBlank(data + position, end - position)){
+            records.push_back(std::make_pair(position, end));
+        }
+
+        position = end;
+    }
+
+    // read records
+    std::vector<boost::shared_ptr<chemkit::Molecule> > molecules(records.size());
+    std::vector<std::string> errors(records.size());
+    chemkit::concurrent::blockingFor(records.size(), RecordReader(data, records, molecules, errors));
+
+    // add the molecules up to the first invalid record as read() does
+    for(size_t i = 0; i < molecules.size(); i++){
+        if(!molecules[i]){
+            setErrorString(errors[i].empty() ? std::string("Truncated molecule header.") : errors[i]);
+            return false;
+        }
+
+        file->addMolecule(molecules[i]);
+    }
+
+    // return false if we failed to read any molecules
+    if(file->moleculeCount() == 0){
+        setErrorString("File is empty");
+        return false;
+    }
+
+    return true;
+}
+
 bool MdlFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
 {
     if(file->isEmpty()){
         return false;
     }
 
+    chemkit::TextWriter writer(output);
+
     if(name() == "mol" || name() == "mdl"){
-        writeMolFile(file->molecule().get(), output);
+        writeMolFile(file->molecule().get(), writer);
     }
     else if(name() == "sdf" || name() == "sd"){
-        writeSdfFile(file, output);
+        writeSdfFile(file, writer);
     }
     else{
         return false;
@@ -111,8 +260,139 @@ bool MdlFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &outpu
     return true;
 }
 
+// --- Indexing ------------------------------------------------------------ //
+// The records are located with the same "$$$$" delimiter scan used by
+// readMappedFile() and are named by their title line.
+bool MdlFileFormat::indexData(const char *data, size_t size, chemkit::MoleculeFileIndex *index)
+{
+    if(!isSdf()){
+        index->addRecord(0, size, firstLine(data, size));
+        return true;
+    }
+
+    size_t position = 0;
+    while(position < size){
+        size_t end = nextRecordEnd(data, size, position);
+
+        if(!isBlank(data + position, end - position)){
+            index->addRecord(position, end - position, firstLine(data + position, end - position));
+        }
+
+        position = end;
+    }
+
+    return true;
+}
+
+// --- Streaming Input and Output ------------------------------------------ //
+bool MdlFileFormat::readHeader(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    setErrorString(std::string());
+    m_streamCount = 0;
+
+    return true;
+}
+
+boost::shared_ptr<chemkit::Molecule> MdlFileFormat::readMolecule(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    // mol files contain a single molecule
+    if(!isSdf() && m_streamCount > 0){
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    std::string errorString;
+    boost::shared_ptr<chemkit::Molecule> molecule = readMolBlock(input, errorString);
+    if(!molecule){
+        if(!errorString.empty()){
+            setErrorString(errorString);
+        }
+        else if(m_streamCount == 0){
+            setErrorString("File is empty");
+        }
+
+        return molecule;
+    }
+
+    if(isSdf()){
+        readDataBlock(input, molecule.get());
+    }
+
+    m_streamCount++;
+
+    return molecule;
+}
+
+bool MdlFileFormat::writeHeader(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    m_streamCount = 0;
+
+    // one writer buffers all of the molecules until writeFooter()
+    m_streamWriter.reset(new chemkit::TextWriter(output));
+
+    return true;
+}
+
+bool MdlFileFormat::writeMolecule(chemkit::MoleculeFile *file,
+                                  const boost::shared_ptr<chemkit::Molecule> &molecule,
+                                  std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    if(!m_streamWriter || &m_streamWriter->output() != &output){
+        m_streamWriter.reset(new chemkit::TextWriter(output));
+    }
+
+    chemkit::TextWriter &writer = *m_streamWriter;
+
+    if(isSdf()){
+        writeMolFile(molecule.get(), writer);
+        writer.write("$$$$\n");
+    }
+    else if(m_streamCount == 0){
+        // only the first molecule is written to mol files
+        writeMolFile(molecule.get(), writer);
+    }
+
+    m_streamCount++;
+
+    return true;
+}
+
+bool MdlFileFormat::writeFooter(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    // destroying the writer flushes it
+    m_streamWriter.reset();
+
+    if(m_streamCount == 0){
+        setErrorString("No molecules written.");
+        return false;
+    }
+
+    return true;
+}
+
 // --- Internal Methods ---------------------------------------------------- //
-bool MdlFileFormat::readMolFile(std::istream &input, chemkit::MoleculeFile *file)
+bool MdlFileFormat::isSdf() const
+{
+    return name() == "sdf" || name() == "sd";
+}
+
+// Reads a single molecule from input. Returns a null pointer if the
+// end of the input has been reached. Records that are truncated, have
+// a malformed bond block or are missing their "M  END" line are also
+// rejected with a null pointer and the reason is stored in
+// errorString.
+boost::shared_ptr<chemkit::Molecule> MdlFileFormat::readMolBlock(std::istream &input, std::string &errorString)
 {
     // title line
     std::string title;
@@ -127,16 +407,25 @@ bool MdlFileFormat::readMolFile(std::istream &input, chemkit::MoleculeFile *file
     std::getline(input, comment);
 
     if(input.eof()){
-        setErrorString("File is empty");
-        return false;
+        if(!(isBlank(title.c_str(), title.size()) &&
+             isBlank(creator.c_str(), creator.size()) &&
+             isBlank(comment.c_str(), comment.size()))){
+            errorString = "Truncated molecule header.";
+        }
+
+        return boost::shared_ptr<chemkit::Molecule>();
     }
 
     // read counts line
     std::string countsLine;
     std::getline(input, countsLine);
 
-    int atomCount = readNumber(&countsLine[0], 3);
-    int bondCount = readNumber(&countsLine[3], 3);
+    chemkit::LineTokenizer tokenizer(countsLine);
+
+    int atomCount = 0;
+    int bondCount = 0;
+    tokenizer.columnInteger(0, 3, &atomCount);
+    tokenizer.columnInteger(3, 3, &bondCount);
 
     // create molecule
     boost::shared_ptr<chemkit::Molecule> molecule(new chemkit::Molecule);
@@ -148,10 +437,28 @@ bool MdlFileFormat::readMolFile(std::istream &input, chemkit::MoleculeFile *file
     readAtomBlock(input, molecule.get(), atomCount);
 
     // read bonds
-    readBondBlock(input, molecule.get(), bondCount);
+    if(!readBondBlock(input, molecule.get(), bondCount)){
+        errorString = "Invalid bond block.";
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
 
     // read properties
-    readPropertyBlock(input, molecule.get());
+    if(!readPropertyBlock(input, molecule.get())){
+        errorString = "Missing \"M  END\" line.";
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    return molecule;
+}
+
+bool MdlFileFormat::readMolFile(std::istream &input, chemkit::MoleculeFile *file)
+{
+    std::string errorString;
+    boost::shared_ptr<chemkit::Molecule> molecule = readMolBlock(input, errorString);
+    if(!molecule){
+        setErrorString(errorString.empty() ? std::string("File is empty") : errorString);
+        return false;
+    }
 
     file->addMolecule(molecule);
 
@@ -160,17 +467,28 @@ bool MdlFileFormat::readMolFile(std::istream &input, chemkit::MoleculeFile *file
 
 bool MdlFileFormat::readSdfFile(std::istream &input, chemkit::MoleculeFile *file)
 {
-    while(!input.eof()){
+    for(;;){
         // read molecule
-        readMolFile(input, file);
+        std::string errorString;
+        boost::shared_ptr<chemkit::Molecule> molecule = readMolBlock(input, errorString);
+        if(!molecule){
+            if(!errorString.empty()){
+                setErrorString(errorString);
+                return false;
+            }
+
+            break;
+        }
 
         // read data block
-        chemkit::Molecule *molecule = file->molecules().back().get();
-        readDataBlock(input, molecule);
+        readDataBlock(input, molecule.get());
+
+        file->addMolecule(molecule);
     }
 
     // return false if we failed to read any molecules
     if(file->moleculeCount() == 0){
+        setErrorString("File is empty");
         return false;
     }
 
@@ -179,8 +497,10 @@ bool MdlFileFormat::readSdfFile(std::istream &input, chemkit::MoleculeFile *file
 
 bool MdlFileFormat::readAtomBlock(std::istream &input, chemkit::Molecule *molecule, int atomCount)
 {
+    std::string line;
+    chemkit::LineTokenizer tokenizer;
+
     for(int i = 0; i < atomCount; i++){
-        std::string line;
         std::getline(input, line);
 
         if(line.size() < 33){
@@ -188,16 +508,21 @@ bool MdlFileFormat::readAtomBlock(std::istream &input, chemkit::Molecule *molecu
             continue;
         }
 
-        double x, y, z;
-        char symbol[3];
-        sscanf(&line[0], "%10lf%10lf%10lf%3s", &x, &y, &z, symbol);
+        tokenizer.setLine(line);
+
+        chemkit::Real x = 0, y = 0, z = 0;
+        tokenizer.columnReal(0, 10, &x);
+        tokenizer.columnReal(10, 10, &y);
+        tokenizer.columnReal(20, 10, &z);
 
-        chemkit::Atom *atom = molecule->addAtom(symbol);
+        boost::string_ref symbol = tokenizer.column(31, 3);
+
+        chemkit::Atom *atom = molecule->addAtom(chemkit::Element::fromSymbol(symbol.data(), symbol.size()));
         if(!atom->element().isValid()){
-            if(strcmp(symbol, "D") == 0){
+            if(symbol == "D"){
                 atom->setIsotope(chemkit::Isotope(chemkit::Atom::Hydrogen, 2));
             }
-            else if(strcmp(symbol, "T") == 0){
+            else if(symbol == "T"){
                 atom->setIsotope(chemkit::Isotope(chemkit::Atom::Hydrogen, 3));
             }
         }
@@ -210,16 +535,22 @@ bool MdlFileFormat::readAtomBlock(std::istream &input, chemkit::Molecule *molecu
 
 bool MdlFileFormat::readBondBlock(std::istream &input, chemkit::Molecule *molecule, int bondCount)
 {
+    std::string line;
+    chemkit::LineTokenizer tokenizer;
+
     for(int i = 0; i < bondCount; i++){
-        std::string line;
         std::getline(input, line);
         if(line.size() < 9){
             // line too short
             return false;
         }
 
-        int firstAtomIndex = readNumber(&line[0], 3);
-        int secondAtomIndex = readNumber(&line[3], 3);
+        tokenizer.setLine(line);
+
+        int firstAtomIndex = 0;
+        int secondAtomIndex = 0;
+        tokenizer.columnInteger(0, 3, &firstAtomIndex);
+        tokenizer.columnInteger(3, 3, &secondAtomIndex);
 
         chemkit::Atom *firstAtom = molecule->atom(firstAtomIndex - 1);
         chemkit::Atom *secondAtom = molecule->atom(secondAtomIndex - 1);
@@ -245,6 +576,10 @@ bool MdlFileFormat::readPropertyBlock(std::istream &input, chemkit::Molecule *mo
         if(boost::starts_with(line, "M  END")){
             return true;
         }
+        else if(boost::starts_with(boost::algorithm::trim_left_copy(line), "$$$$")){
+            // end of the record without an "M  END" line
+            return false;
+        }
     }
 
     return false;
@@ -287,56 +622,53 @@ bool MdlFileFormat::readDataBlock(std::istream &input, chemkit::Molecule *molecu
     return false;
 }
 
-void MdlFileFormat::writeMolFile(const chemkit::Molecule *molecule, std::ostream &output)
+void MdlFileFormat::writeMolFile(const chemkit::Molecule *molecule, chemkit::TextWriter &writer)
 {
     // name, creator, and comment lines
-    output << molecule->name() << "\n";
-    output << "\n";
-    output << "\n";
+    writer.write(molecule->name());
+    writer.write("\n\n\n");
 
     // counts line
-    char countsLine[41];
-    sprintf(countsLine, "%3d%3d  0  0  0  0  0  0  0  0999 V2000\n", static_cast<int>(molecule->atomCount()),
-                                                                     static_cast<int>(molecule->bondCount()));
-    output.write(countsLine, sizeof(countsLine) - 1);
+    writer.writeInteger(molecule->atomCount(), 3);
+    writer.writeInteger(molecule->bondCount(), 3);
+    writer.write("  0  0  0  0  0  0  0  0999 V2000\n");
 
     // atoms
-    writeAtomBlock(molecule, output);
+    writeAtomBlock(molecule, writer);
 
     // bonds
-    writeBondBlock(molecule, output);
+    writeBondBlock(molecule, writer);
 
     // properties
-    output << "M  END\n";
+    writer.write("M  END\n");
 }
 
-void MdlFileFormat::writeSdfFile(const chemkit::MoleculeFile *file, std::ostream &output)
+void MdlFileFormat::writeSdfFile(const chemkit::MoleculeFile *file, chemkit::TextWriter &writer)
 {
     foreach(const boost::shared_ptr<chemkit::Molecule> molecule, file->molecules()){
-        writeMolFile(molecule.get(), output);
-        output << "$$$$\n";
+        writeMolFile(molecule.get(), writer);
+        writer.write("$$$$\n");
     }
 }
 
-void MdlFileFormat::writeAtomBlock(const chemkit::Molecule *molecule, std::ostream &output)
+void MdlFileFormat::writeAtomBlock(const chemkit::Molecule *molecule, chemkit::TextWriter &writer)
 {
     foreach(const chemkit::Atom *atom, molecule->atoms()){
-        char line[50];
-        sprintf(line, "%10.4f%10.4f%10.4f %3s 0  0  0  0  0\n", atom->x(),
-                                                                atom->y(),
-                                                                atom->z(),
-                                                                atom->symbol().c_str());
-        output.write(line, sizeof(line) - 1);
+        writer.writeFixed(atom->x(), 4, 10);
+        writer.writeFixed(atom->y(), 4, 10);
+        writer.writeFixed(atom->z(), 4, 10);
+        writer.write(' ');
+        writer.writePadded(atom->symbol(), 3);
+        writer.write(" 0  0  0  0  0\n");
     }
 }
 
-void MdlFileFormat::writeBondBlock(const chemkit::Molecule *molecule, std::ostream &output)
+void MdlFileFormat::writeBondBlock(const chemkit::Molecule *molecule, chemkit::TextWriter &writer)
 {
     foreach(const chemkit::Bond *bond, molecule->bonds()){
-        char line[23];
-        sprintf(line, "%3d%3d%3d  0  0  0  0\n", static_cast<int>(bond->atom1()->index()) + 1,
-                                                 static_cast<int>(bond->atom2()->index()) + 1,
-                                                 static_cast<int>(bond->order()));
-        output.write(line, sizeof(line) - 1);
+        writer.writeInteger(bond->atom1()->index() + 1, 3);
+        writer.writeInteger(bond->atom2()->index() + 1, 3);
+        writer.writeInteger(bond->order(), 3);
+        writer.write("  0  0  0  0\n");
     }
 }
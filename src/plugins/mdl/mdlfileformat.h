@@ -36,7 +36,10 @@
 #ifndef MDLFILEFORMAT_H
 #define MDLFILEFORMAT_H
 
+#include <boost/scoped_ptr.hpp>
+
 #include <chemkit/molecule.h>
+#include <chemkit/textwriter.h>
 #include <chemkit/moleculefileformat.h>
 
 class MdlFileFormat : public chemkit::MoleculeFileFormat
@@ -48,19 +51,38 @@ public:
 
     // input and output
     bool read(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
     bool write(const chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
 
+    // streaming input and output
+    bool readHeader(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    boost::shared_ptr<chemkit::Molecule> readMolecule(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool writeHeader(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeMolecule(chemkit::MoleculeFile *file, const boost::shared_ptr<chemkit::Molecule> &molecule, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFooter(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+
+    // indexing
+    bool indexData(const char *data, size_t size, chemkit::MoleculeFileIndex *index) CHEMKIT_OVERRIDE;
+
 private:
+    class RecordReader;
+
+    bool isSdf() const;
     bool readMolFile(std::istream &input, chemkit::MoleculeFile *file);
     bool readSdfFile(std::istream &input, chemkit::MoleculeFile *file);
-    bool readAtomBlock(std::istream &input, chemkit::Molecule *molecule, int atomCount);
-    bool readBondBlock(std::istream &input, chemkit::Molecule *molecule, int bondCount);
-    bool readPropertyBlock(std::istream &input, chemkit::Molecule *molecule);
-    bool readDataBlock(std::istream &input, chemkit::Molecule *molecule);
-    void writeMolFile(const chemkit::Molecule *molecule, std::ostream &output);
-    void writeSdfFile(const chemkit::MoleculeFile *file, std::ostream &output);
-    void writeAtomBlock(const chemkit::Molecule *molecule, std::ostream &output);
-    void writeBondBlock(const chemkit::Molecule *molecule, std::ostream &output);
+    static boost::shared_ptr<chemkit::Molecule> readMolBlock(std::istream &input, std::string &errorString);
+    static bool readAtomBlock(std::istream &input, chemkit::Molecule *molecule, int atomCount);
+    static bool readBondBlock(std::istream &input, chemkit::Molecule *molecule, int bondCount);
+    static bool readPropertyBlock(std::istream &input, chemkit::Molecule *molecule);
+    static bool readDataBlock(std::istream &input, chemkit::Molecule *molecule);
+    void writeMolFile(const chemkit::Molecule *molecule, chemkit::TextWriter &writer);
+    void writeSdfFile(const chemkit::MoleculeFile *file, chemkit::TextWriter &writer);
+    void writeAtomBlock(const chemkit::Molecule *molecule, chemkit::TextWriter &writer);
+    void writeBondBlock(const chemkit::Molecule *molecule, chemkit::TextWriter &writer);
+
+private:
+    size_t m_streamCount;
+    boost::scoped_ptr<chemkit::TextWriter> m_streamWriter;
 };
 
 #endif // MDLFILEFORMAT_H
@@ -35,7 +35,10 @@
 
 #include "pdbfileformat.h"
 
+#include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 #include <chemkit/atom.h>
 #include <chemkit/foreach.h>
@@ -47,15 +50,48 @@
 #include <chemkit/polymerfile.h>
 #include <chemkit/polymerchain.h>
 #include <chemkit/coordinateset.h>
+#include <chemkit/linetokenizer.h>
 #include <chemkit/cartesiancoordinates.h>
 
 namespace {
 
+// Returns the range of each MODEL record in data, from the line
+// following the MODEL line to the line following its ENDMDL line.
+std::vector<std::pair<size_t, size_t> > findModels(const char *data, size_t size)
+{
+    std::vector<std::pair<size_t, size_t> > models;
+
+    size_t modelBegin = 0;
+    bool inModel = false;
+
+    size_t position = 0;
+    while(position < size){
+        const char *line = data + position;
+        size_t length = size - position;
+
+        const char *newline = static_cast<const char *>(memchr(line, '\n', length));
+        size_t next = newline ? static_cast<size_t>(newline - data) + 1 : size;
+
+        if(length >= 5 && memcmp(line, "MODEL", 5) == 0){
+            modelBegin = next;
+            inModel = true;
+        }
+        else if(inModel && length >= 6 && memcmp(line, "ENDMDL", 6) == 0){
+            models.push_back(std::make_pair(modelBegin, next));
+            inModel = false;
+        }
+
+        position = next;
+    }
+
+    return models;
+}
+
 // === PdbAtom ============================================================= //
 class PdbAtom
 {
 public:
-    PdbAtom(const char *data);
+    PdbAtom(const chemkit::LineTokenizer &tokenizer);
 
     int id;
     std::string name;
@@ -63,37 +99,57 @@ public:
     chemkit::Element element;
 };
 
-PdbAtom::PdbAtom(const char *data)
+// reads the coordinates from an ATOM or HETATM record
+chemkit::Point3 readPosition(const chemkit::LineTokenizer &tokenizer)
+{
+    chemkit::Real x = 0, y = 0, z = 0;
+
+    if(!tokenizer.columnReal(30, 8, &x) ||
+       !tokenizer.columnReal(38, 8, &y) ||
+       !tokenizer.columnReal(46, 8, &z)){
+        // fall back to whitespace-delimited coordinates for
+        // files that do not follow the fixed column layout
+        chemkit::LineTokenizer coordinates(tokenizer.line());
+        coordinates.setPosition(30);
+        coordinates.nextReal(&x);
+        coordinates.nextReal(&y);
+        coordinates.nextReal(&z);
+    }
+
+    return chemkit::Point3(x, y, z);
+}
+
+PdbAtom::PdbAtom(const chemkit::LineTokenizer &tokenizer)
 {
+    const boost::string_ref line = tokenizer.line();
+
     // atom id
-    sscanf(&data[7], "%d", &id);
+    id = 0;
+    tokenizer.columnInteger(6, 5, &id);
 
     // atom name
-    name.clear();
-    for(int i = 13; i < 16; i++){
-        name += data[i];
-    }
-    boost::trim(name);
+    boost::string_ref nameField = tokenizer.column(13, 3);
+    name.assign(nameField.begin(), nameField.end());
 
     // coordinates
-    double x, y, z;
-    sscanf(&data[31], "%lf%lf%lf", &x, &y, &z);
-    position = chemkit::Point3(x, y, z);
+    position = readPosition(tokenizer);
 
     // atomic number
-    std::string symbol;
-    for(int i = 77; i < 79 && isalpha(data[i]); i++){
-        symbol += tolower(data[i]);
+    char symbol[2];
+    size_t symbolLength = 0;
+    for(size_t i = 77; i < 79 && i < line.size() && isalpha(line[i]); i++){
+        symbol[symbolLength++] = tolower(line[i]);
     }
-    boost::trim(symbol);
-    symbol[0] = toupper(symbol[0]);
-    element = chemkit::Element::fromSymbol(symbol);
+    if(symbolLength){
+        symbol[0] = toupper(symbol[0]);
+    }
+    element = chemkit::Element::fromSymbol(symbol, symbolLength);
 
-    if(!element.isValid()){
+    if(!element.isValid() && !name.empty()){
         // try atomic number from name
-        symbol = boost::to_lower_copy(name);
-        symbol[0] = toupper(symbol[0]);
-        element = chemkit::Element::fromSymbol(symbol);
+        std::string nameSymbol = boost::to_lower_copy(name);
+        nameSymbol[0] = toupper(nameSymbol[0]);
+        element = chemkit::Element::fromSymbol(nameSymbol);
     }
 }
 
@@ -268,6 +324,7 @@ public:
     PdbConformer(std::istream &input);
 
     chemkit::Point3 position(int atom) const;
+    size_t size() const;
 
 private:
     std::vector<chemkit::Point3> m_positions;
@@ -275,8 +332,9 @@ private:
 
 PdbConformer::PdbConformer(std::istream &input)
 {
+    std::string line;
+
     for(;;){
-        std::string line;
         std::getline(input, line);
 
         if(line.empty() || input.eof()){
@@ -284,11 +342,7 @@ PdbConformer::PdbConformer(std::istream &input)
         }
 
         if(boost::starts_with(line, "ATOM")){
-            chemkit::Real x = boost::lexical_cast<chemkit::Real>(boost::trim_left_copy(line.substr(30, 8)));
-            chemkit::Real y = boost::lexical_cast<chemkit::Real>(boost::trim_left_copy(line.substr(38, 8)));
-            chemkit::Real z = boost::lexical_cast<chemkit::Real>(boost::trim_left_copy(line.substr(46, 8)));
-
-            m_positions.push_back(chemkit::Point3(x, y, z));
+            m_positions.push_back(readPosition(chemkit::LineTokenizer(line)));
         }
         else if(boost::starts_with(line, "ENDMDL")){
             break;
@@ -301,6 +355,52 @@ chemkit::Point3 PdbConformer::position(int atom) const
     return m_positions[atom];
 }
 
+size_t PdbConformer::size() const
+{
+    return m_positions.size();
+}
+
+// === PdbModelLoader ====================================================== //
+// Decodes the coordinates of a model from its records. The loader owns
+// a copy of the model's records, shared between copies of the loader,
+// so the model can still be decoded after the mapped file it was read
+// from has been closed.
+class PdbModelLoader
+{
+public:
+    PdbModelLoader(const boost::shared_ptr<std::string> &data, size_t size);
+
+    chemkit::CartesianCoordinates* operator()() const;
+
+private:
+    boost::shared_ptr<std::string> m_data;
+    size_t m_size;
+};
+
+PdbModelLoader::PdbModelLoader(const boost::shared_ptr<std::string> &data, size_t size)
+    : m_data(data),
+      m_size(size)
+{
+}
+
+// Returns the coordinates of the model, or 0 if the model does not
+// have a position for each atom in the polymer.
+chemkit::CartesianCoordinates* PdbModelLoader::operator()() const
+{
+    boost::iostreams::stream<boost::iostreams::array_source> input(m_data->data(), m_data->size());
+    PdbConformer conformer(input);
+    if(conformer.size() < m_size){
+        return 0;
+    }
+
+    chemkit::CartesianCoordinates *coordinates = new chemkit::CartesianCoordinates(m_size);
+    for(size_t i = 0; i < m_size; i++){
+        coordinates->setPosition(i, conformer.position(i));
+    }
+
+    return coordinates;
+}
+
 // === PdbLigand =========================================================== //
 class PdbLigand
 {
@@ -364,11 +464,13 @@ public:
     void addChain(PdbChain *chain);
     void addLigand(PdbLigand *ligand);
     void addConnections(const std::vector<int> &connections);
+    void addModel(const char *data, size_t size);
     void writePolymerFile(chemkit::PolymerFile *file);
 
 private:
     std::vector<PdbChain *> m_chains;
     std::vector<PdbConformer *> m_conformers;
+    std::vector<boost::shared_ptr<std::string> > m_models;
     std::vector<PdbConformation *> m_conformations;
     std::vector<PdbLigand *> m_ligands;
     std::vector<std::vector<int> > m_connections;
@@ -397,52 +499,47 @@ bool PdbFile::read(std::istream &input)
     PdbLigand *currentLigand = 0;
     PdbResidue *currentResidue = 0;
 
+    std::string lineString;
+    chemkit::LineTokenizer tokenizer;
+
     for(;;){
-        std::string lineString;
         std::getline(input, lineString);
         if(lineString.empty() || input.eof()){
             break;
         }
 
         const char *line = lineString.c_str();
+        tokenizer.setLine(lineString);
 
         if(strncmp("ATOM", line, 4) == 0){
-            PdbAtom *atom = new PdbAtom(line);
+            PdbAtom *atom = new PdbAtom(tokenizer);
 
-            char chainId = line[21];
+            char chainId = lineString.size() > 21 ? line[21] : ' ';
             if(!currentChain || currentChain->id() != chainId){
                 currentChain = new PdbChain(chainId);
                 addChain(currentChain);
             }
 
-            int residueIndex = strtol(&line[22], 0, 10);
+            int residueIndex = 0;
+            tokenizer.columnInteger(22, 4, &residueIndex);
             if(!currentResidue || currentResidue->index() != residueIndex){
-                std::string name;
-                for(int i = 17; i < 21; i++){
-                    name += line[i];
-                }
+                boost::string_ref name = tokenizer.column(17, 4);
 
-                boost::trim(name);
-
-                currentResidue = new PdbResidue(name, residueIndex);
+                currentResidue = new PdbResidue(std::string(name.begin(), name.end()), residueIndex);
                 currentChain->addResidue(currentResidue);
             }
 
             currentResidue->addAtom(atom);
         }
         else if(strncmp("HETATM", line, 6) == 0){
-            PdbAtom *atom = new PdbAtom(line);
+            PdbAtom *atom = new PdbAtom(tokenizer);
 
-            int ligandIndex = strtol(&line[22], 0, 10);
+            int ligandIndex = 0;
+            tokenizer.columnInteger(22, 4, &ligandIndex);
             if(!currentLigand || currentLigand->index() != ligandIndex){
-                std::string ligandName;
-                for(int i = 17; i < 21; i++){
-                    ligandName += line[i];
-                }
-
-                boost::trim(ligandName);
+                boost::string_ref ligandName = tokenizer.column(17, 4);
 
-                currentLigand = new PdbLigand(ligandName, ligandIndex);
+                currentLigand = new PdbLigand(std::string(ligandName.begin(), ligandName.end()), ligandIndex);
                 addLigand(currentLigand);
             }
 
@@ -457,19 +554,13 @@ bool PdbFile::read(std::istream &input)
             m_conformers.push_back(conformer);
         }
         else if(strncmp("CONECT", line, 6) == 0){
-            std::string string = &line[7];
-            boost::trim(string);
-
-            std::vector<std::string> tokens;
-            boost::split(tokens, string, boost::is_any_of(" "), boost::token_compress_on);
-
             std::vector<int> ids;
 
-            foreach(const std::string &idString, tokens){
-                try {
-                    ids.push_back(boost::lexical_cast<int>(idString));
-                }
-                catch(boost::bad_lexical_cast&){
+            tokenizer.setPosition(6);
+            while(!tokenizer.atEnd()){
+                int id;
+                if(tokenizer.nextInteger(&id)){
+                    ids.push_back(id);
                 }
             }
 
@@ -496,6 +587,10 @@ bool PdbFile::read(std::istream &input)
             boost::trim_right(title);
             m_title += title;
         }
+        else if(strncmp("END", line, 3) == 0 && (line[3] == '\0' || isspace(line[3]))){
+            // end of entry, any following records belong to the next entry
+            break;
+        }
     }
 
     return true;
@@ -516,6 +611,14 @@ void PdbFile::addConnections(const std::vector<int> &connections)
     m_connections.push_back(connections);
 }
 
+// Adds the model with the size bytes of records at data. The records
+// are copied but their coordinates are not decoded until they are
+// first accessed.
+void PdbFile::addModel(const char *data, size_t size)
+{
+    m_models.push_back(boost::make_shared<std::string>(data, size));
+}
+
 void PdbFile::writePolymerFile(chemkit::PolymerFile *file)
 {
     boost::shared_ptr<chemkit::Polymer> polymer(new chemkit::Polymer);
@@ -614,6 +717,10 @@ void PdbFile::writePolymerFile(chemkit::PolymerFile *file)
             foreach(const PdbConformation *pdbConformation, m_conformations){
                 if(pdbConformation->chain() == pdbChain->id()){
                     for(int residue = pdbConformation->firstResidue(); residue < pdbConformation->lastResidue(); residue++){
+                        if(residue < 0 || static_cast<size_t>(residue) >= chain->residueCount()){
+                            continue;
+                        }
+
                         chemkit::AminoAcid *aminoAcid = static_cast<chemkit::AminoAcid *>(chain->residue(residue));
 
                         if(aminoAcid){
@@ -636,6 +743,13 @@ void PdbFile::writePolymerFile(chemkit::PolymerFile *file)
         polymer->addCoordinateSet(coordinates);
     }
 
+    // add models which are decoded when first accessed
+    for(size_t i = 0; i < m_models.size(); i++){
+        PdbModelLoader loader(m_models[i], polymer->size());
+
+        polymer->addCoordinateSet(boost::make_shared<chemkit::CoordinateSet>(loader));
+    }
+
     if(!polymer->isEmpty()){
         file->addPolymer(polymer);
     }
@@ -711,3 +825,46 @@ bool PdbFileFormat::read(std::istream &input, chemkit::PolymerFile *file)
     pdb.writePolymerFile(file);
     return true;
 }
+
+// For files with multiple models (e.g. NMR ensembles) only the
+// records up to the end of the first model and those following the
+// last model are parsed. The records of the other models are copied
+// and added as coordinate sets which are decoded when first accessed,
+// so the polymer does not depend on the mapping after reading.
+bool PdbFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::PolymerFile *file)
+{
+    const char *data = input.data();
+    size_t size = input.size();
+
+    std::vector<std::pair<size_t, size_t> > models = findModels(data, size);
+
+    PdbFile pdb;
+
+    if(models.size() < 2){
+        boost::iostreams::stream<boost::iostreams::array_source> stream(data, size);
+        if(!pdb.read(stream)){
+            return false;
+        }
+    }
+    else{
+        // records up to the end of the first model
+        boost::iostreams::stream<boost::iostreams::array_source> head(data, models.front().second);
+        if(!pdb.read(head)){
+            return false;
+        }
+
+        for(size_t i = 1; i < models.size(); i++){
+            pdb.addModel(data + models[i].first, models[i].second - models[i].first);
+        }
+
+        // records following the last model
+        size_t tailBegin = models.back().second;
+        boost::iostreams::stream<boost::iostreams::array_source> tail(data + tailBegin, size - tailBegin);
+        if(!pdb.read(tail)){
+            return false;
+        }
+    }
+
+    pdb.writePolymerFile(file);
+    return true;
+}
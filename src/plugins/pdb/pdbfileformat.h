@@ -44,6 +44,7 @@ public:
     PdbFileFormat();
 
     bool read(std::istream &input, chemkit::PolymerFile *file);
+    bool readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::PolymerFile *file);
 };
 
 #endif // PDBFILEFORMAT_H
@@ -41,6 +41,7 @@
 #include <chemkit/element.h>
 #include <chemkit/foreach.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/linetokenizer.h>
 
 PqrFileFormat::PqrFileFormat()
     : chemkit::MoleculeFileFormat("pqr")
@@ -55,8 +56,11 @@ bool PqrFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
 {
     boost::shared_ptr<chemkit::Molecule> molecule(new chemkit::Molecule);
 
+    std::string line;
+    chemkit::LineTokenizer tokenizer;
+    std::vector<boost::string_ref> lineTokens;
+
     for(;;){
-        std::string line;
         std::getline(input, line);
 
         if(line.empty()){
@@ -65,16 +69,20 @@ bool PqrFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
 
         if(boost::starts_with(line, "ATOM")){
             // split string by whitespace
-            std::vector<std::string> lineTokens;
-            boost::split(lineTokens,
-                         line,
-                         boost::is_any_of("\t "),
-                         boost::algorithm::token_compress_on);
-
-            if(lineTokens.size() < 10){
+            tokenizer.setLine(line);
+            if(tokenizer.tokenize(lineTokens) < 10){
                 break;
             }
 
+            chemkit::Real x, y, z, charge;
+            if(!chemkit::LineTokenizer::parseReal(lineTokens[5], &x) ||
+               !chemkit::LineTokenizer::parseReal(lineTokens[6], &y) ||
+               !chemkit::LineTokenizer::parseReal(lineTokens[7], &z) ||
+               !chemkit::LineTokenizer::parseReal(lineTokens[8], &charge)){
+                setErrorString("Invalid atom line.");
+                return false;
+            }
+
             // read symbol as first character of atom name
             char symbol = lineTokens[2][0];
 
@@ -82,12 +90,10 @@ bool PqrFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
             chemkit::Atom *atom = molecule->addAtom(chemkit::Element::fromSymbol(symbol));
 
             // set coordinates
-            atom->setPosition(boost::lexical_cast<chemkit::Real>(lineTokens[5]),
-                              boost::lexical_cast<chemkit::Real>(lineTokens[6]),
-                              boost::lexical_cast<chemkit::Real>(lineTokens[7]));
+            atom->setPosition(x, y, z);
 
             // set charge
-            atom->setPartialCharge(boost::lexical_cast<chemkit::Real>(lineTokens[8]));
+            atom->setPartialCharge(charge);
         }
     }
 
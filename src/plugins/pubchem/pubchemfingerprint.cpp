@@ -35,6 +35,9 @@
 
 #include "pubchemfingerprint.h"
 
+#include <vector>
+#include <algorithm>
+
 #include <chemkit/atom.h>
 #include <chemkit/bond.h>
 #include <chemkit/foreach.h>
@@ -42,364 +45,284 @@
 
 // PubChem Fingerprint Specification:
 // ftp://ftp.ncbi.nlm.nih.gov/pubchem/specifications/pubchem_fingerprints.txt
+//
+// Each implemented section is described by a table of bits. The
+// molecule is scanned once to count its elements and to find the
+// pairs of bonded elements and the bits are then set from those.
 
-PubChemFingerprint::PubChemFingerprint()
-    : chemkit::Fingerprint("pubchem")
-{
-}
+namespace {
 
-PubChemFingerprint::~PubChemFingerprint()
+const size_t FingerprintSize = 881;
+
+// Returns the number of entries in a table.
+template<typename T, size_t N>
+inline size_t tableSize(const T (&)[N])
 {
+    return N;
 }
 
-chemkit::Bitset PubChemFingerprint::value(const chemkit::Molecule *molecule) const
+// --- Section 1: Hierarchic Element Counts -------------------------------- //
+struct ElementCountBit
 {
-    chemkit::Bitset bitset(881);
+    chemkit::Atom::AtomicNumberType element;
+    unsigned char minimumCount;
+};
 
-    // section 1 - hierarchic element counts
-    size_t hydrogenCount = molecule->atomCount(chemkit::Atom::Hydrogen);
-    bitset[0] = hydrogenCount >= 4;
-    bitset[1] = hydrogenCount >= 8;
-    bitset[2] = hydrogenCount >= 16;
-    bitset[3] = hydrogenCount >= 32;
-
-    size_t lithiumCount = molecule->atomCount(chemkit::Atom::Lithium);
-    bitset[4] = lithiumCount >= 1;
-    bitset[5] = lithiumCount >= 2;
-
-    size_t boronCount = molecule->atomCount(chemkit::Atom::Boron);
-    bitset[6] = boronCount >= 1;
-    bitset[7] = boronCount >= 2;
-    bitset[8] = boronCount >= 4;
-
-    size_t carbonCount = molecule->atomCount(chemkit::Atom::Carbon);
-    bitset[9] = carbonCount >= 2;
-    bitset[10] = carbonCount >= 4;
-    bitset[11] = carbonCount >= 8;
-    bitset[12] = carbonCount >= 16;
-    bitset[13] = carbonCount >= 32;
+// The hierarchic element count bits (0-114) in order. Each bit is
+// set if the molecule contains at least the given number of atoms
+// of the element.
+const ElementCountBit elementCountBits[] = {
+    { chemkit::Atom::Hydrogen, 4 },
+    { chemkit::Atom::Hydrogen, 8 },
+    { chemkit::Atom::Hydrogen, 16 },
+    { chemkit::Atom::Hydrogen, 32 },
+    { chemkit::Atom::Lithium, 1 },
+    { chemkit::Atom::Lithium, 2 },
+    { chemkit::Atom::Boron, 1 },
+    { chemkit::Atom::Boron, 2 },
+    { chemkit::Atom::Boron, 4 },
+    { chemkit::Atom::Carbon, 2 },
+    { chemkit::Atom::Carbon, 4 },
+    { chemkit::Atom::Carbon, 8 },
+    { chemkit::Atom::Carbon, 16 },
+    { chemkit::Atom::Carbon, 32 },
+    { chemkit::Atom::Nitrogen, 1 },
+    { chemkit::Atom::Nitrogen, 2 },
+    { chemkit::Atom::Nitrogen, 4 },
+    { chemkit::Atom::Nitrogen, 8 },
+    { chemkit::Atom::Oxygen, 1 },
+    { chemkit::Atom::Oxygen, 2 },
+    { chemkit::Atom::Oxygen, 4 },
+    { chemkit::Atom::Oxygen, 8 },
+    { chemkit::Atom::Oxygen, 16 },
+    { chemkit::Atom::Fluorine, 1 },
+    { chemkit::Atom::Fluorine, 2 },
+    { chemkit::Atom::Fluorine, 4 },
+    { chemkit::Atom::Sodium, 1 },
+    { chemkit::Atom::Sodium, 2 },
+    { chemkit::Atom::Silicon, 1 },
+    { chemkit::Atom::Silicon, 2 },
+    { chemkit::Atom::Phosphorus, 1 },
+    { chemkit::Atom::Phosphorus, 2 },
+    { chemkit::Atom::Phosphorus, 4 },
+    { chemkit::Atom::Sulfur, 1 },
+    { chemkit::Atom::Sulfur, 2 },
+    { chemkit::Atom::Sulfur, 4 },
+    { chemkit::Atom::Sulfur, 8 },
+    { chemkit::Atom::Chlorine, 1 },
+    { chemkit::Atom::Chlorine, 2 },
+    { chemkit::Atom::Chlorine, 4 },
+    { chemkit::Atom::Chlorine, 8 },
+    { chemkit::Atom::Potassium, 1 },
+    { chemkit::Atom::Potassium, 2 },
+    { chemkit::Atom::Bromine, 1 },
+    { chemkit::Atom::Bromine, 2 },
+    { chemkit::Atom::Bromine, 4 },
+    { chemkit::Atom::Iodine, 1 },
+    { chemkit::Atom::Iodine, 2 },
+    { chemkit::Atom::Iodine, 4 },
+    { chemkit::Atom::Beryllium, 1 },
+    { chemkit::Atom::Magnesium, 1 },
+    { chemkit::Atom::Aluminum, 1 },
+    { chemkit::Atom::Calcium, 1 },
+    { chemkit::Atom::Scandium, 1 },
+    { chemkit::Atom::Titanium, 1 },
+    { chemkit::Atom::Vanadium, 1 },
+    { chemkit::Atom::Chromium, 1 },
+    { chemkit::Atom::Manganese, 1 },
+    { chemkit::Atom::Iron, 1 },
+    { chemkit::Atom::Cobalt, 1 },
+    { chemkit::Atom::Nickel, 1 },
+    { chemkit::Atom::Copper, 1 },
+    { chemkit::Atom::Zinc, 1 },
+    { chemkit::Atom::Gallium, 1 },
+    { chemkit::Atom::Germanium, 1 },
+    { chemkit::Atom::Arsenic, 1 },
+    { chemkit::Atom::Selenium, 1 },
+    { chemkit::Atom::Krypton, 1 },
+    { chemkit::Atom::Rubidium, 1 },
+    { chemkit::Atom::Strontium, 1 },
+    { chemkit::Atom::Yttrium, 1 },
+    { chemkit::Atom::Zirconium, 1 },
+    { chemkit::Atom::Niobium, 1 },
+    { chemkit::Atom::Molybdenum, 1 },
+    { chemkit::Atom::Ruthenium, 1 },
+    { chemkit::Atom::Rhodium, 1 },
+    { chemkit::Atom::Palladium, 1 },
+    { chemkit::Atom::Silver, 1 },
+    { chemkit::Atom::Cadmium, 1 },
+    { chemkit::Atom::Indium, 1 },
+    { chemkit::Atom::Tin, 1 },
+    { chemkit::Atom::Antimony, 1 },
+    { chemkit::Atom::Tellurium, 1 },
+    { chemkit::Atom::Xenon, 1 },
+    { chemkit::Atom::Cesium, 1 },
+    { chemkit::Atom::Barium, 1 },
+    { chemkit::Atom::Lutetium, 1 },
+    { chemkit::Atom::Hafnium, 1 },
+    { chemkit::Atom::Tantalum, 1 },
+    { chemkit::Atom::Tungsten, 1 },
+    { chemkit::Atom::Rhenium, 1 },
+    { chemkit::Atom::Osmium, 1 },
+    { chemkit::Atom::Iridium, 1 },
+    { chemkit::Atom::Platinum, 1 },
+    { chemkit::Atom::Gold, 1 },
+    { chemkit::Atom::Mercury, 1 },
+    { chemkit::Atom::Thallium, 1 },
+    { chemkit::Atom::Lead, 1 },
+    { chemkit::Atom::Bismuth, 1 },
+    { chemkit::Atom::Lanthanum, 1 },
+    { chemkit::Atom::Cerium, 1 },
+    { chemkit::Atom::Praseodymium, 1 },
+    { chemkit::Atom::Neodymium, 1 },
+    { chemkit::Atom::Promethium, 1 },
+    { chemkit::Atom::Samarium, 1 },
+    { chemkit::Atom::Europium, 1 },
+    { chemkit::Atom::Gadolinium, 1 },
+    { chemkit::Atom::Terbium, 1 },
+    { chemkit::Atom::Dysprosium, 1 },
+    { chemkit::Atom::Holmium, 1 },
+    { chemkit::Atom::Erbium, 1 },
+    { chemkit::Atom::Thulium, 1 },
+    { chemkit::Atom::Ytterbium, 1 },
+    { chemkit::Atom::Technetium, 1 },
+    { chemkit::Atom::Uranium, 1 }
+};
 
-    size_t nitrogenCount = molecule->atomCount(chemkit::Atom::Nitrogen);
-    bitset[14] = nitrogenCount >= 1;
-    bitset[15] = nitrogenCount >= 2;
-    bitset[16] = nitrogenCount >= 4;
-    bitset[17] = nitrogenCount >= 8;
+// --- Section 3: Simple Atom Pairs ---------------------------------------- //
+struct AtomPairBit
+{
+    chemkit::Atom::AtomicNumberType first;
+    chemkit::Atom::AtomicNumberType second;
+};
 
-    size_t oxygenCount = molecule->atomCount(chemkit::Atom::Oxygen);
-    bitset[18] = oxygenCount >= 1;
-    bitset[19] = oxygenCount >= 2;
-    bitset[20] = oxygenCount >= 4;
-    bitset[21] = oxygenCount >= 8;
-    bitset[22] = oxygenCount >= 16;
+const size_t FirstAtomPairBit = 263;
 
-    size_t fluorineCount = molecule->atomCount(chemkit::Atom::Fluorine);
-    bitset[23] = fluorineCount >= 1;
-    bitset[24] = fluorineCount >= 2;
-    bitset[25] = fluorineCount >= 4;
+// The simple atom pair bits (263-326) in order. Each bit is set if
+// the molecule contains a bond between atoms of the two elements.
+const AtomPairBit atomPairBits[] = {
+    { chemkit::Atom::Lithium, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Lithium, chemkit::Atom::Lithium },
+    { chemkit::Atom::Lithium, chemkit::Atom::Boron },
+    { chemkit::Atom::Lithium, chemkit::Atom::Carbon },
+    { chemkit::Atom::Lithium, chemkit::Atom::Oxygen },
+    { chemkit::Atom::Lithium, chemkit::Atom::Fluorine },
+    { chemkit::Atom::Lithium, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Lithium, chemkit::Atom::Sulfur },
+    { chemkit::Atom::Lithium, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Boron, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Boron, chemkit::Atom::Boron },
+    { chemkit::Atom::Boron, chemkit::Atom::Carbon },
+    { chemkit::Atom::Boron, chemkit::Atom::Nitrogen },
+    { chemkit::Atom::Boron, chemkit::Atom::Oxygen },
+    { chemkit::Atom::Boron, chemkit::Atom::Fluorine },
+    { chemkit::Atom::Boron, chemkit::Atom::Silicon },
+    { chemkit::Atom::Boron, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Boron, chemkit::Atom::Sulfur },
+    { chemkit::Atom::Boron, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Boron, chemkit::Atom::Bromine },
+    { chemkit::Atom::Carbon, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Carbon, chemkit::Atom::Carbon },
+    { chemkit::Atom::Carbon, chemkit::Atom::Nitrogen },
+    { chemkit::Atom::Carbon, chemkit::Atom::Oxygen },
+    { chemkit::Atom::Carbon, chemkit::Atom::Fluorine },
+    { chemkit::Atom::Carbon, chemkit::Atom::Sodium },
+    { chemkit::Atom::Carbon, chemkit::Atom::Magnesium },
+    { chemkit::Atom::Carbon, chemkit::Atom::Aluminum },
+    { chemkit::Atom::Carbon, chemkit::Atom::Silicon },
+    { chemkit::Atom::Carbon, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Carbon, chemkit::Atom::Sulfur },
+    { chemkit::Atom::Carbon, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Carbon, chemkit::Atom::Arsenic },
+    { chemkit::Atom::Carbon, chemkit::Atom::Selenium },
+    { chemkit::Atom::Carbon, chemkit::Atom::Bromine },
+    { chemkit::Atom::Carbon, chemkit::Atom::Iodine },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Nitrogen },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Oxygen },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Fluorine },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Silicon },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Sulfur },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Nitrogen, chemkit::Atom::Bromine },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Oxygen },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Magnesium },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Sodium },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Aluminum },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Silicon },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Oxygen, chemkit::Atom::Potassium },
+    { chemkit::Atom::Fluorine, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Fluorine, chemkit::Atom::Sulfur },
+    { chemkit::Atom::Aluminum, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Aluminum, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Silicon, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Silicon, chemkit::Atom::Silicon },
+    { chemkit::Atom::Silicon, chemkit::Atom::Chlorine },
+    { chemkit::Atom::Phosphorus, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Phosphorus, chemkit::Atom::Phosphorus },
+    { chemkit::Atom::Arsenic, chemkit::Atom::Hydrogen },
+    { chemkit::Atom::Arsenic, chemkit::Atom::Arsenic }
+};
 
-    size_t sodiumCount = molecule->atomCount(chemkit::Atom::Sodium);
-    bitset[26] = sodiumCount >= 1;
-    bitset[27] = sodiumCount >= 2;
+// Returns a key for a pair of elements that is independent of the
+// order of the two elements.
+inline unsigned short atomPairKey(chemkit::Atom::AtomicNumberType a,
+                                  chemkit::Atom::AtomicNumberType b)
+{
+    return a < b ? static_cast<unsigned short>((a << 8) | b)
+                 : static_cast<unsigned short>((b << 8) | a);
+}
 
-    size_t siliconCount = molecule->atomCount(chemkit::Atom::Silicon);
-    bitset[28] = siliconCount >= 1;
-    bitset[29] = siliconCount >= 2;
+} // end anonymous namespace
 
-    size_t phosphorusCount = molecule->atomCount(chemkit::Atom::Phosphorus);
-    bitset[30] = phosphorusCount >= 1;
-    bitset[31] = phosphorusCount >= 2;
-    bitset[32] = phosphorusCount >= 4;
+PubChemFingerprint::PubChemFingerprint()
+    : chemkit::Fingerprint("pubchem")
+{
+}
 
-    size_t sulfurCount = molecule->atomCount(chemkit::Atom::Sulfur);
-    bitset[33] = sulfurCount >= 1;
-    bitset[34] = sulfurCount >= 2;
-    bitset[35] = sulfurCount >= 4;
-    bitset[36] = sulfurCount >= 8;
+PubChemFingerprint::~PubChemFingerprint()
+{
+}
 
-    size_t chlorineCount = molecule->atomCount(chemkit::Atom::Chlorine);
-    bitset[37] = chlorineCount >= 1;
-    bitset[38] = chlorineCount >= 2;
-    bitset[39] = chlorineCount >= 4;
-    bitset[40] = chlorineCount >= 8;
+chemkit::Bitset PubChemFingerprint::value(const chemkit::Molecule *molecule) const
+{
+    chemkit::Bitset bitset(FingerprintSize);
 
-    size_t potassiumCount = molecule->atomCount(chemkit::Atom::Potassium);
-    bitset[41] = potassiumCount >= 1;
-    bitset[42] = potassiumCount >= 2;
+    // count the atoms of each element
+    size_t elementCounts[256] = { 0 };
+    foreach(const chemkit::Atom *atom, molecule->atoms()){
+        elementCounts[atom->atomicNumber()]++;
+    }
 
-    size_t bromineCount = molecule->atomCount(chemkit::Atom::Bromine);
-    bitset[43] = bromineCount >= 1;
-    bitset[44] = bromineCount >= 2;
-    bitset[45] = bromineCount >= 4;
+    // find the pairs of elements that are bonded to each other
+    std::vector<unsigned short> atomPairs;
+    atomPairs.reserve(molecule->bondCount());
+    foreach(const chemkit::Bond *bond, molecule->bonds()){
+        atomPairs.push_back(atomPairKey(bond->atom1()->atomicNumber(),
+                                        bond->atom2()->atomicNumber()));
+    }
+    std::sort(atomPairs.begin(), atomPairs.end());
 
-    size_t iodineCount = molecule->atomCount(chemkit::Atom::Iodine);
-    bitset[46] = iodineCount >= 1;
-    bitset[47] = iodineCount >= 2;
-    bitset[48] = iodineCount >= 4;
+    // section 1 - hierarchic element counts
+    for(size_t i = 0; i < tableSize(elementCountBits); i++){
+        const ElementCountBit &entry = elementCountBits[i];
 
-    bitset[49] = molecule->contains(chemkit::Atom::Beryllium);
-    bitset[50] = molecule->contains(chemkit::Atom::Magnesium);
-    bitset[51] = molecule->contains(chemkit::Atom::Aluminum);
-    bitset[52] = molecule->contains(chemkit::Atom::Calcium);
-    bitset[53] = molecule->contains(chemkit::Atom::Scandium);
-    bitset[54] = molecule->contains(chemkit::Atom::Titanium);
-    bitset[55] = molecule->contains(chemkit::Atom::Vanadium);
-    bitset[56] = molecule->contains(chemkit::Atom::Chromium);
-    bitset[57] = molecule->contains(chemkit::Atom::Manganese);
-    bitset[58] = molecule->contains(chemkit::Atom::Iron);
-    bitset[59] = molecule->contains(chemkit::Atom::Cobalt);
-    bitset[60] = molecule->contains(chemkit::Atom::Nickel);
-    bitset[61] = molecule->contains(chemkit::Atom::Copper);
-    bitset[62] = molecule->contains(chemkit::Atom::Zinc);
-    bitset[63] = molecule->contains(chemkit::Atom::Gallium);
-    bitset[64] = molecule->contains(chemkit::Atom::Germanium);
-    bitset[65] = molecule->contains(chemkit::Atom::Arsenic);
-    bitset[66] = molecule->contains(chemkit::Atom::Selenium);
-    bitset[67] = molecule->contains(chemkit::Atom::Krypton);
-    bitset[68] = molecule->contains(chemkit::Atom::Rubidium);
-    bitset[69] = molecule->contains(chemkit::Atom::Strontium);
-    bitset[70] = molecule->contains(chemkit::Atom::Yttrium);
-    bitset[71] = molecule->contains(chemkit::Atom::Zirconium);
-    bitset[72] = molecule->contains(chemkit::Atom::Niobium);
-    bitset[73] = molecule->contains(chemkit::Atom::Molybdenum);
-    bitset[74] = molecule->contains(chemkit::Atom::Ruthenium);
-    bitset[75] = molecule->contains(chemkit::Atom::Rhodium);
-    bitset[76] = molecule->contains(chemkit::Atom::Palladium);
-    bitset[77] = molecule->contains(chemkit::Atom::Silver);
-    bitset[78] = molecule->contains(chemkit::Atom::Cadmium);
-    bitset[79] = molecule->contains(chemkit::Atom::Indium);
-    bitset[80] = molecule->contains(chemkit::Atom::Tin);
-    bitset[81] = molecule->contains(chemkit::Atom::Antimony);
-    bitset[82] = molecule->contains(chemkit::Atom::Tellurium);
-    bitset[83] = molecule->contains(chemkit::Atom::Xenon);
-    bitset[84] = molecule->contains(chemkit::Atom::Cesium);
-    bitset[85] = molecule->contains(chemkit::Atom::Barium);
-    bitset[86] = molecule->contains(chemkit::Atom::Lutetium);
-    bitset[87] = molecule->contains(chemkit::Atom::Hafnium);
-    bitset[88] = molecule->contains(chemkit::Atom::Tantalum);
-    bitset[89] = molecule->contains(chemkit::Atom::Tungsten);
-    bitset[90] = molecule->contains(chemkit::Atom::Rhenium);
-    bitset[91] = molecule->contains(chemkit::Atom::Osmium);
-    bitset[92] = molecule->contains(chemkit::Atom::Iridium);
-    bitset[93] = molecule->contains(chemkit::Atom::Platinum);
-    bitset[94] = molecule->contains(chemkit::Atom::Gold);
-    bitset[95] = molecule->contains(chemkit::Atom::Mercury);
-    bitset[96] = molecule->contains(chemkit::Atom::Thallium);
-    bitset[97] = molecule->contains(chemkit::Atom::Lead);
-    bitset[98] = molecule->contains(chemkit::Atom::Bismuth);
-    bitset[99] = molecule->contains(chemkit::Atom::Lanthanum);
-    bitset[100] = molecule->contains(chemkit::Atom::Cerium);
-    bitset[101] = molecule->contains(chemkit::Atom::Praseodymium);
-    bitset[102] = molecule->contains(chemkit::Atom::Neodymium);
-    bitset[103] = molecule->contains(chemkit::Atom::Promethium);
-    bitset[104] = molecule->contains(chemkit::Atom::Samarium);
-    bitset[105] = molecule->contains(chemkit::Atom::Europium);
-    bitset[106] = molecule->contains(chemkit::Atom::Gadolinium);
-    bitset[107] = molecule->contains(chemkit::Atom::Terbium);
-    bitset[108] = molecule->contains(chemkit::Atom::Dysprosium);
-    bitset[109] = molecule->contains(chemkit::Atom::Holmium);
-    bitset[110] = molecule->contains(chemkit::Atom::Erbium);
-    bitset[111] = molecule->contains(chemkit::Atom::Thulium);
-    bitset[112] = molecule->contains(chemkit::Atom::Ytterbium);
-    bitset[113] = molecule->contains(chemkit::Atom::Technetium);
-    bitset[114] = molecule->contains(chemkit::Atom::Uranium);
+        bitset[i] = elementCounts[entry.element] >= entry.minimumCount;
+    }
 
     // section 2 - ring counts
     // TODO
 
     // section 3 - simple atom pairs
-    foreach(const chemkit::Bond *bond, molecule->bonds()){
-        if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Hydrogen)){
-            bitset[263] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Lithium)){
-            bitset[264] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Boron)){
-            bitset[265] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Carbon)){
-            bitset[266] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Oxygen)){
-            bitset[267] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Fluorine)){
-            bitset[268] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Phosphorus)){
-            bitset[269] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Sulfur)){
-            bitset[270] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Lithium, chemkit::Atom::Chlorine)){
-            bitset[271] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Hydrogen)){
-            bitset[272] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Boron)){
-            bitset[273] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Carbon)){
-            bitset[274] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Nitrogen)){
-            bitset[275] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Oxygen)){
-            bitset[276] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Fluorine)){
-            bitset[277] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Silicon)){
-            bitset[278] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Phosphorus)){
-            bitset[279] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Sulfur)){
-            bitset[280] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Chlorine)){
-            bitset[281] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Boron, chemkit::Atom::Bromine)){
-            bitset[282] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Hydrogen)){
-            bitset[283] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Carbon)){
-            bitset[284] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Nitrogen)){
-            bitset[285] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Oxygen)){
-            bitset[286] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Fluorine)){
-            bitset[287] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Sodium)){
-            bitset[288] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Magnesium)){
-            bitset[289] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Aluminum)){
-            bitset[290] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Silicon)){
-            bitset[291] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Phosphorus)){
-            bitset[292] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Sulfur)){
-            bitset[293] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Chlorine)){
-            bitset[294] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Arsenic)){
-            bitset[295] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Selenium)){
-            bitset[296] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Bromine)){
-            bitset[297] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Carbon, chemkit::Atom::Iodine)){
-            bitset[298] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Hydrogen)){
-            bitset[299] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Nitrogen)){
-            bitset[300] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Oxygen)){
-            bitset[301] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Fluorine)){
-            bitset[302] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Silicon)){
-            bitset[303] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Phosphorus)){
-            bitset[304] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Sulfur)){
-            bitset[305] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Chlorine)){
-            bitset[306] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Nitrogen, chemkit::Atom::Bromine)){
-            bitset[307] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Hydrogen)){
-            bitset[308] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Oxygen)){
-            bitset[309] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Magnesium)){
-            bitset[310] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Sodium)){
-            bitset[311] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Aluminum)){
-            bitset[312] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Silicon)){
-            bitset[313] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Phosphorus)){
-            bitset[314] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Oxygen, chemkit::Atom::Potassium)){
-            bitset[315] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Fluorine, chemkit::Atom::Phosphorus)){
-            bitset[316] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Fluorine, chemkit::Atom::Sulfur)){
-            bitset[317] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Aluminum, chemkit::Atom::Hydrogen)){
-            bitset[318] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Aluminum, chemkit::Atom::Chlorine)){
-            bitset[319] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Silicon, chemkit::Atom::Hydrogen)){
-            bitset[320] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Silicon, chemkit::Atom::Silicon)){
-            bitset[321] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Silicon, chemkit::Atom::Chlorine)){
-            bitset[322] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Phosphorus, chemkit::Atom::Hydrogen)){
-            bitset[323] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Phosphorus, chemkit::Atom::Phosphorus)){
-            bitset[324] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Arsenic, chemkit::Atom::Hydrogen)){
-            bitset[325] = 1;
-        }
-        else if(bond->containsBoth(chemkit::Atom::Arsenic, chemkit::Atom::Arsenic)){
-            bitset[326] = 1;
-        }
+    for(size_t i = 0; i < tableSize(atomPairBits); i++){
+        const AtomPairBit &entry = atomPairBits[i];
+
+        bitset[FirstAtomPairBit + i] = std::binary_search(atomPairs.begin(),
+                                                          atomPairs.end(),
+                                                          atomPairKey(entry.first, entry.second));
     }
 
     // section 4 - simple atom nearest neighbors
@@ -51,6 +51,23 @@
 
 #include "smiles.h"
 
+namespace {
+
+// appends the decimal representation of value to string
+void appendInteger(std::string &string, unsigned int value)
+{
+    char digits[12];
+    char *position = digits + sizeof(digits);
+    do {
+        *--position = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while(value);
+
+    string.append(position, digits + sizeof(digits));
+}
+
+} // end anonymous namespace
+
 // === SmilesGraphNode ===================================================== //
 SmilesGraphNode::SmilesGraphNode(const chemkit::Atom *atom)
     : m_atom(atom),
@@ -105,10 +122,8 @@ void SmilesGraphNode::addRing(int ringNumber, int bondOrder)
     m_ringBondOrders.push_back(bondOrder);
 }
 
-std::string SmilesGraphNode::toString(bool kekulize) const
+void SmilesGraphNode::writeAtom(std::string &string, bool kekulize) const
 {
-    std::stringstream string;
-
     if(m_bondOrder == 0){
         // do nothing
     }
@@ -116,57 +131,57 @@ std::string SmilesGraphNode::toString(bool kekulize) const
         // do nothing
     }
     else if(m_bondOrder == chemkit::Bond::Double){
-        string << "=";
+        string += '=';
     }
     else if(m_bondOrder == chemkit::Bond::Triple){
-        string << "#";
+        string += '#';
     }
     else if(m_bondOrder == chemkit::Bond::Quadruple){
-        string << "$";
+        string += '$';
     }
 
     if(!kekulize && isAromaticAtom(m_atom)){
         if(m_atom->is(chemkit::Atom::Nitrogen) && m_atom->neighborCount(chemkit::Atom::Hydrogen) == 1){
-            string << "[nH]";
+            string += "[nH]";
         }
         else{
-            string << boost::to_lower_copy(m_atom->symbol());
+            string += boost::to_lower_copy(m_atom->symbol());
         }
     }
     else if(isOrganicAtom(m_atom)){
-        string << m_atom->symbol().c_str();
+        string += m_atom->symbol();
     }
     else{
-        string << "[";
+        string += '[';
 
         // mass number
         if(isIsotope(m_atom)){
-            string << m_atom->massNumber();
+            appendInteger(string, m_atom->massNumber());
         }
 
-        string << m_atom->symbol().c_str();
+        string += m_atom->symbol();
 
         if(m_hydrogenCount > 0){
-            string << "H";
+            string += 'H';
 
             if(m_hydrogenCount > 1){
-                string << m_hydrogenCount;
+                appendInteger(string, m_hydrogenCount);
             }
         }
 
         int charge = m_atom->formalCharge();
         if(charge > 0){
-            string << "+";
+            string += '+';
         }
         else if(charge < 0){
-            string << "-";
+            string += '-';
         }
 
         if(std::abs(charge) > 1){
-            string << std::abs(charge);
+            appendInteger(string, std::abs(charge));
         }
 
-        string << "]";
+        string += ']';
     }
 
     for(size_t i = 0; i < m_rings.size(); i++){
@@ -176,39 +191,34 @@ std::string SmilesGraphNode::toString(bool kekulize) const
         if(isAromaticAtom(m_atom)){
         }
         else if(bondOrder == chemkit::Bond::Double)
-            string << "=";
+            string += '=';
         else if(bondOrder == chemkit::Bond::Triple)
-            string << "#";
+            string += '#';
 
         if(ringNumber > 9){
-            string << "%";
+            string += '%';
         }
 
-        string << ringNumber;
+        appendInteger(string, ringNumber);
     }
-
-    return string.str();
 }
 
-void SmilesGraphNode::write(std::stringstream &string, bool kekulize) const
+void SmilesGraphNode::write(std::string &string, bool kekulize) const
 {
-    string << toString(kekulize);
+    writeAtom(string, kekulize);
 
     if(childCount() == 1){
         m_children[0]->write(string, kekulize);
     }
     else if(childCount() > 1){
-        std::vector<SmilesGraphNode *> children = m_children;
-        const SmilesGraphNode *firstChild = children[0];
-        children.erase(children.begin());
-
-        foreach(SmilesGraphNode *child, children){
-            string << "(";
-            child->write(string, kekulize);
-            string << ")";
+        // branches are written before the first child
+        for(size_t i = 1; i < m_children.size(); i++){
+            string += '(';
+            m_children[i]->write(string, kekulize);
+            string += ')';
         }
 
-        firstChild->write(string, kekulize);
+        m_children[0]->write(string, kekulize);
     }
 }
 
@@ -352,25 +362,16 @@ SmilesGraph::~SmilesGraph()
 
 std::string SmilesGraph::toString(bool kekulize) const
 {
-    if(m_rootNodes.empty()){
-        return std::string();
-    }
-    else if(m_rootNodes.size() == 1){
-        std::stringstream stream;
-        m_rootNodes.front()->write(stream, kekulize);
-        return stream.str();
-    }
-    else{
-        std::stringstream stream;
-        foreach(const SmilesGraphNode *rootNode, m_rootNodes){
-            rootNode->write(stream, kekulize);
-            stream << ".";
-        }
+    std::string string;
 
-        // remove trailing '.'
-        std::string string = stream.str();
-        string.erase(string.end()-1);
+    // disconnected fragments are separated by '.'
+    for(size_t i = 0; i < m_rootNodes.size(); i++){
+        if(i > 0){
+            string += '.';
+        }
 
-        return string;
+        m_rootNodes[i]->write(string, kekulize);
     }
+
+    return string;
 }
@@ -38,7 +38,6 @@
 
 #include <string>
 #include <vector>
-#include <sstream>
 
 #include <chemkit/atom.h>
 #include <chemkit/bond.h>
@@ -56,8 +55,8 @@ public:
     SmilesGraphNode* parent() const;
     int childCount() const;
     std::vector<SmilesGraphNode *> children() const;
-    std::string toString(bool kekulize) const;
-    void write(std::stringstream &string, bool kekulize) const;
+    void writeAtom(std::string &string, bool kekulize) const;
+    void write(std::string &string, bool kekulize) const;
 
     void setHydrogenCount(int hydrogenCount);
     int hydrogenCount() const;
@@ -218,11 +218,9 @@ chemkit::Molecule* SmilesLineFormat::read(const char *formula)
     chemkit::Bond *lastDoubleBond = 0;
     int bondOrder = 1;
     std::map<chemkit::Atom *, int> charges; // atom -> formal charge
-    std::vector<chemkit::Atom *> organicAtoms;
-    std::vector<chemkit::Bond *> aromaticBonds;
     bool aromatic = false;
     BranchState branchState;
-    std::stack<BranchState> branchRoots;
+    std::stack<BranchState, std::vector<BranchState> > branchRoots;
     RingState ringState;
     std::map<int, RingState> rings;
 
@@ -233,6 +231,13 @@ chemkit::Molecule* SmilesLineFormat::read(const char *formula)
 
     int bondStereo = 0;
 
+    // the atom and bond lists are kept between calls to avoid
+    // reallocating them for each formula
+    std::vector<chemkit::Atom *> &organicAtoms = m_organicAtoms;
+    std::vector<chemkit::Bond *> &aromaticBonds = m_aromaticBonds;
+    organicAtoms.clear();
+    aromaticBonds.clear();
+
     // create molecule
     chemkit::Molecule *molecule = new chemkit::Molecule;
 
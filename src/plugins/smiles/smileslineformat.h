@@ -36,6 +36,10 @@
 #ifndef SMILESLINEFORMAT_H
 #define SMILESLINEFORMAT_H
 
+#include <vector>
+
+#include <chemkit/atom.h>
+#include <chemkit/bond.h>
 #include <chemkit/lineformat.h>
 
 class SmilesLineFormat : public chemkit::LineFormat
@@ -51,6 +55,10 @@ public:
     chemkit::Molecule* read(const std::string &formula) CHEMKIT_OVERRIDE;
     chemkit::Molecule* read(const char *formula);
     std::string write(const chemkit::Molecule *molecule) CHEMKIT_OVERRIDE;
+
+private:
+    std::vector<chemkit::Atom *> m_organicAtoms;
+    std::vector<chemkit::Bond *> m_aromaticBonds;
 };
 
 #endif // SMILESLINEFORMAT_H
@@ -35,6 +35,9 @@
 
 #include "mol2fileformat.h"
 
+#include <cstring>
+#include <algorithm>
+
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -43,11 +46,58 @@
 #include <chemkit/foreach.h>
 #include <chemkit/molecule.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/linetokenizer.h>
+#include <chemkit/moleculefileindex.h>
 
 #include "sybylatomtyper.h"
 
+namespace {
+
+const char MoleculeRecordType[] = "@<TRIPOS>MOLECULE";
+const size_t MoleculeRecordTypeLength = sizeof(MoleculeRecordType) - 1;
+
+// Returns the offset of the next line at or after position that
+// starts a molecule record, or size if there are no more records.
+size_t nextMoleculeRecord(const char *data, size_t size, size_t position)
+{
+    while(position < size){
+        const char *match = static_cast<const char *>(memchr(data + position, '@', size - position));
+        if(!match){
+            break;
+        }
+
+        size_t offset = match - data;
+        if((offset == 0 || data[offset - 1] == '\n') &&
+           size - offset >= MoleculeRecordTypeLength &&
+           strncmp(match, MoleculeRecordType, MoleculeRecordTypeLength) == 0){
+            return offset;
+        }
+
+        position = offset + 1;
+    }
+
+    return size;
+}
+
+// Returns the line following the line at position.
+std::string nextLine(const char *data, size_t size, size_t position)
+{
+    const char *end = static_cast<const char *>(memchr(data + position, '\n', size - position));
+    if(!end){
+        return std::string();
+    }
+
+    const char *begin = end + 1;
+    end = static_cast<const char *>(memchr(begin, '\n', data + size - begin));
+
+    return std::string(begin, end ? end : data + size);
+}
+
+} // end anonymous namespace
+
 Mol2FileFormat::Mol2FileFormat()
-    : chemkit::MoleculeFileFormat("mol2")
+    : chemkit::MoleculeFileFormat("mol2"),
+      m_moleculeHeaderRead(false)
 {
 }
 
@@ -57,76 +107,199 @@ Mol2FileFormat::~Mol2FileFormat()
 
 bool Mol2FileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
 {
+    m_moleculeHeaderRead = false;
+
+    for(;;){
+        boost::shared_ptr<chemkit::Molecule> molecule;
+        if(!readMoleculeRecord(input, molecule)){
+            return false;
+        }
+        else if(!molecule){
+            break;
+        }
+
+        file->addMolecule(molecule);
+    }
+
+    return true;
+}
+
+bool Mol2FileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
+{
+    chemkit::TextWriter writer(output);
+
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file->molecules()){
+        writeMoleculeRecord(molecule.get(), writer);
+    }
+
+    return true;
+}
+
+bool Mol2FileFormat::readHeader(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
+
+    m_moleculeHeaderRead = false;
+
+    return true;
+}
+
+boost::shared_ptr<chemkit::Molecule> Mol2FileFormat::readMolecule(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
     boost::shared_ptr<chemkit::Molecule> molecule;
+    if(!readMoleculeRecord(input, molecule)){
+        molecule.reset();
+    }
+
+    return molecule;
+}
+
+bool Mol2FileFormat::writeHeader(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
 
+    // one writer buffers all of the molecules until writeFooter()
+    m_streamWriter.reset(new chemkit::TextWriter(output));
+
+    return true;
+}
+
+bool Mol2FileFormat::writeMolecule(chemkit::MoleculeFile *file,
+                                   const boost::shared_ptr<chemkit::Molecule> &molecule,
+                                   std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    if(!m_streamWriter || &m_streamWriter->output() != &output){
+        m_streamWriter.reset(new chemkit::TextWriter(output));
+    }
+
+    writeMoleculeRecord(molecule.get(), *m_streamWriter);
+
+    return true;
+}
+
+bool Mol2FileFormat::writeFooter(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    // destroying the writer flushes it
+    m_streamWriter.reset();
+
+    return true;
+}
+
+// Each record starts at a "@<TRIPOS>MOLECULE" line and is named by
+// the line following it.
+bool Mol2FileFormat::indexData(const char *data, size_t size, chemkit::MoleculeFileIndex *index)
+{
+    size_t position = nextMoleculeRecord(data, size, 0);
+    while(position < size){
+        size_t end = nextMoleculeRecord(data, size, position + MoleculeRecordTypeLength);
+
+        std::string name = nextLine(data, size, position);
+        boost::trim(name);
+
+        index->addRecord(position, end - position, name);
+
+        position = end;
+    }
+
+    return true;
+}
+
+// Reads the next molecule record from input. The molecule is set to
+// a null pointer if there are no more records. Returns false if the
+// record is invalid.
+bool Mol2FileFormat::readMoleculeRecord(std::istream &input, boost::shared_ptr<chemkit::Molecule> &molecule)
+{
     int atomCount = 0;
     int bondCount = 0;
 
-    while(!input.eof()){
-        std::string line;
-        std::getline(input, line);
+    std::string line;
+    chemkit::LineTokenizer tokenizer;
+    std::vector<boost::string_ref> tokens;
 
-        if(boost::starts_with(line, "@<TRIPOS>MOLECULE")){
-            if(molecule){
-                file->addMolecule(molecule);
-            }
+    // find the next molecule record
+    while(!molecule){
+        if(!m_moleculeHeaderRead){
+            std::getline(input, line);
+
+            if(!boost::starts_with(line, "@<TRIPOS>MOLECULE")){
+                if(input.eof()){
+                    return true;
+                }
 
-            std::string name;
-            std::getline(input, name);
-            boost::trim(name);
-
-            std::string countsLineString;
-            std::getline(input, countsLineString);
-            boost::trim_left(countsLineString);
-            std::vector<std::string> countsLine;
-            boost::split(countsLine,
-                         countsLineString,
-                         boost::is_any_of(" \t"),
-                         boost::token_compress_on);
-            if(countsLine.size() < 2){
                 continue;
             }
+        }
 
-            atomCount = boost::lexical_cast<int>(countsLine[0]);
-            bondCount = boost::lexical_cast<int>(countsLine[1]);
+        m_moleculeHeaderRead = false;
 
-            molecule = boost::make_shared<chemkit::Molecule>();
+        std::string name;
+        std::getline(input, name);
+        boost::trim(name);
 
-            if(!name.empty()){
-                molecule->setName(name);
-            }
-        }
-        else if(!molecule){
+        std::getline(input, line);
+        tokenizer.setLine(line);
+        if(!tokenizer.nextInteger(&atomCount) ||
+           !tokenizer.nextInteger(&bondCount)){
             continue;
         }
+
+        molecule = boost::make_shared<chemkit::Molecule>();
+
+        if(!name.empty()){
+            molecule->setName(name);
+        }
+    }
+
+    // read sections until the start of the next molecule record
+    while(!input.eof()){
+        std::getline(input, line);
+
+        if(boost::starts_with(line, "@<TRIPOS>MOLECULE")){
+            m_moleculeHeaderRead = true;
+            break;
+        }
         else if(boost::starts_with(line, "@<TRIPOS>")){
             boost::trim(line);
             std::string type = line.substr(9);
 
             if(type == "ATOM"){
                 while(atomCount--){
-                    std::string atomLineString;
-                    std::getline(input, atomLineString);
-                    boost::trim_left(atomLineString);
-                    std::vector<std::string> atomLine;
-                    boost::split(atomLine,
-                                 atomLineString,
-                                 boost::is_any_of(" \t"),
-                                 boost::token_compress_on);
-                    if(atomLine.size() < 6){
+                    std::getline(input, line);
+                    tokenizer.setLine(line);
+                    tokenizer.tokenize(tokens);
+
+                    chemkit::Real x, y, z;
+                    if(tokens.size() < 6 ||
+                       !chemkit::LineTokenizer::parseReal(tokens[2], &x) ||
+                       !chemkit::LineTokenizer::parseReal(tokens[3], &y) ||
+                       !chemkit::LineTokenizer::parseReal(tokens[4], &z)){
+                        setErrorString("Invalid atom line");
                         return false;
                     }
 
-                    chemkit::Element element;
-                    std::string symbol = atomLine[5];
-                    boost::to_lower(symbol);
-                    symbol[0] = toupper(symbol[0]);
-                    size_t dotPosition = symbol.find_first_of('.');
-                    if(dotPosition == std::string::npos){
-                        element = chemkit::Element::fromSymbol(symbol);
+                    // the element symbol is the part of the sybyl
+                    // type before the dot (e.g. "C" in "C.ar")
+                    const boost::string_ref &type = tokens[5];
+                    char symbol[2];
+                    size_t symbolLength = 0;
+                    while(symbolLength < std::min(type.size(), sizeof(symbol)) &&
+                          type[symbolLength] != '.'){
+                        symbol[symbolLength] = symbolLength == 0 ? toupper(type[symbolLength])
+                                                                 : tolower(type[symbolLength]);
+                        symbolLength++;
                     }
-                    else{
-                        element = chemkit::Element::fromSymbol(symbol.c_str(), dotPosition);
+
+                    chemkit::Element element;
+                    if(symbolLength == type.size() || type[symbolLength] == '.'){
+                        element = chemkit::Element::fromSymbol(symbol, symbolLength);
                     }
 
                     chemkit::Atom *atom = molecule->addAtom(element);
@@ -134,39 +307,35 @@ bool Mol2FileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
                         continue;
                     }
 
-                    atom->setPosition(boost::lexical_cast<chemkit::Real>(atomLine[2]),
-                                      boost::lexical_cast<chemkit::Real>(atomLine[3]),
-                                      boost::lexical_cast<chemkit::Real>(atomLine[4]));
+                    atom->setPosition(x, y, z);
 
-                    if(atomLine.size() >= 9){
-                        atom->setPartialCharge(boost::lexical_cast<chemkit::Real>(atomLine[8]));
+                    chemkit::Real charge;
+                    if(tokens.size() >= 9 &&
+                       chemkit::LineTokenizer::parseReal(tokens[8], &charge)){
+                        atom->setPartialCharge(charge);
                     }
                 }
             }
             else if(type == "BOND"){
                 while(bondCount--){
-                    std::string bondLineString;
-                    std::getline(input, bondLineString);
-                    boost::trim_left(bondLineString);
-                    std::vector<std::string> bondLine;
-                    boost::split(bondLine,
-                                 bondLineString,
-                                 boost::is_any_of(" \t"),
-                                 boost::token_compress_on);
-                    if(bondLine.size() < 4){
+                    std::getline(input, line);
+                    tokenizer.setLine(line);
+                    tokenizer.tokenize(tokens);
+
+                    int first, second;
+                    if(tokens.size() < 4 ||
+                       !chemkit::LineTokenizer::parseInteger(tokens[1], &first) ||
+                       !chemkit::LineTokenizer::parseInteger(tokens[2], &second)){
                         continue;
                     }
 
-                    chemkit::Atom *a1 = molecule->atom(boost::lexical_cast<int>(bondLine[1]) - 1);
-                    chemkit::Atom *a2 = molecule->atom(boost::lexical_cast<int>(bondLine[2]) - 1);
+                    chemkit::Atom *a1 = molecule->atom(first - 1);
+                    chemkit::Atom *a2 = molecule->atom(second - 1);
 
                     int bondOrder;
-                    std::string bondOrderString = bondLine[3];
+                    const boost::string_ref &bondOrderString = tokens[3];
 
-                    try {
-                        bondOrder = boost::lexical_cast<int>(bondOrderString);
-                    }
-                    catch(boost::bad_lexical_cast&){
+                    if(!chemkit::LineTokenizer::parseInteger(bondOrderString, &bondOrder)){
                         // aromatic bond
                         if(bondOrderString == "ar")
                             bondOrder = 1;
@@ -189,77 +358,64 @@ bool Mol2FileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
         }
     }
 
-    if(molecule){
-        file->addMolecule(molecule);
-    }
-
     return true;
 }
 
-bool Mol2FileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
+void Mol2FileFormat::writeMoleculeRecord(const chemkit::Molecule *molecule, chemkit::TextWriter &writer)
 {
-    char line[80];
-
-    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file->molecules()){
-        // perceive sybyl atom types
-        SybylAtomTyper atomTyper;
-        atomTyper.setMolecule(molecule.get());
-
-        output << "@<TRIPOS>MOLECULE\n";
-        output << molecule->name() << "\n";
-        sprintf(line,
-                "%4u%4u%3u%3u%3u\n",
-                static_cast<int>(molecule->atomCount()),
-                static_cast<int>(molecule->bondCount()),
-                0,
-                0,
-                0);
-        output << line;
-        output << "SMALL\n";
-        output << "GASTEIGER\n";
-        output << "\n";
-        output << "\n";
-
-        output << "@<TRIPOS>ATOM\n";
-        int atomNumber = 1;
-        foreach(chemkit::Atom *atom, molecule->atoms()){
-            // get atom type from the atom typer
-            std::string type = atomTyper.type(atom);
-
-            // use the atom's symbol if no type assigned
-            if(type.empty()){
-                type = atom->symbol();
-            }
-
-            sprintf(line,
-                    "%7u %2s %10.4g %10.4g %10.4g %6s %u  LIG1 %10.4g\n",
-                    atomNumber,
-                    atom->symbol().c_str(),
-                    atom->x(),
-                    atom->y(),
-                    atom->z(),
-                    type.c_str(),
-                    1,
-                    atom->partialCharge());
-
-            output << line;
-            atomNumber++;
+    // perceive sybyl atom types
+    SybylAtomTyper atomTyper;
+    atomTyper.setMolecule(molecule);
+
+    writer.write("@<TRIPOS>MOLECULE\n");
+    writer.write(molecule->name());
+    writer.write('\n');
+    writer.writeInteger(molecule->atomCount(), 4);
+    writer.writeInteger(molecule->bondCount(), 4);
+    writer.write("  0  0  0\n");
+    writer.write("SMALL\n");
+    writer.write("GASTEIGER\n");
+    writer.write("\n");
+    writer.write("\n");
+
+    writer.write("@<TRIPOS>ATOM\n");
+    int atomNumber = 1;
+    foreach(chemkit::Atom *atom, molecule->atoms()){
+        // get atom type from the atom typer
+        std::string type = atomTyper.type(atom);
+
+        // use the atom's symbol if no type assigned
+        if(type.empty()){
+            type = atom->symbol();
         }
 
-        output << "@<TRIPOS>BOND\n";
-        int bondNumber = 1;
-        foreach(chemkit::Bond *bond, molecule->bonds()){
-            sprintf(line,
-                    "%6u%6u%6u%6u\n",
-                    bondNumber,
-                    static_cast<int>(bond->atom1()->index()) + 1,
-                    static_cast<int>(bond->atom2()->index()) + 1,
-                    bond->order());
-
-            output << line;
-            bondNumber++;
-        }
+        writer.writeInteger(atomNumber, 7);
+        writer.write(' ');
+        writer.writePadded(atom->symbol(), 2);
+        writer.write(' ');
+        writer.writeGeneral(atom->x(), 4, 10);
+        writer.write(' ');
+        writer.writeGeneral(atom->y(), 4, 10);
+        writer.write(' ');
+        writer.writeGeneral(atom->z(), 4, 10);
+        writer.write(' ');
+        writer.writePadded(type, 6);
+        writer.write(" 1  LIG1 ");
+        writer.writeGeneral(atom->partialCharge(), 4, 10);
+        writer.write('\n');
+
+        atomNumber++;
     }
 
-    return true;
+    writer.write("@<TRIPOS>BOND\n");
+    int bondNumber = 1;
+    foreach(chemkit::Bond *bond, molecule->bonds()){
+        writer.writeInteger(bondNumber, 6);
+        writer.writeInteger(bond->atom1()->index() + 1, 6);
+        writer.writeInteger(bond->atom2()->index() + 1, 6);
+        writer.writeInteger(bond->order(), 6);
+        writer.write('\n');
+
+        bondNumber++;
+    }
 }
@@ -36,6 +36,9 @@
 #ifndef MOL2FILEFORMAT_H
 #define MOL2FILEFORMAT_H
 
+#include <boost/scoped_ptr.hpp>
+
+#include <chemkit/textwriter.h>
 #include <chemkit/moleculefileformat.h>
 
 class Mol2FileFormat : public chemkit::MoleculeFileFormat
@@ -46,6 +49,20 @@ public:
 
     bool read(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
     bool write(const chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool readHeader(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    boost::shared_ptr<chemkit::Molecule> readMolecule(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool writeHeader(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeMolecule(chemkit::MoleculeFile *file, const boost::shared_ptr<chemkit::Molecule> &molecule, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFooter(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool indexData(const char *data, size_t size, chemkit::MoleculeFileIndex *index) CHEMKIT_OVERRIDE;
+
+private:
+    bool readMoleculeRecord(std::istream &input, boost::shared_ptr<chemkit::Molecule> &molecule);
+    void writeMoleculeRecord(const chemkit::Molecule *molecule, chemkit::TextWriter &writer);
+
+private:
+    bool m_moleculeHeaderRead;
+    boost::scoped_ptr<chemkit::TextWriter> m_streamWriter;
 };
 
 #endif // MOL2FILEFORMAT_H
@@ -46,6 +46,7 @@
 #include <chemkit/foreach.h>
 #include <chemkit/molecule.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/linetokenizer.h>
 
 TxyzFileFormat::TxyzFileFormat()
     : chemkit::MoleculeFileFormat("txyz")
@@ -55,24 +56,12 @@ TxyzFileFormat::TxyzFileFormat()
 bool TxyzFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
 {
     // first line contains atom count and molecule name
-    std::string firstLine;
-    std::getline(input, firstLine);
-    boost::trim(firstLine);
-    std::vector<std::string> firstLineTokens;
-    boost::split(firstLineTokens,
-                 firstLine,
-                 boost::is_any_of(" "),
-                 boost::token_compress_on);
-    if(firstLineTokens.size() < 1){
-        setErrorString("First line of TXYZ file should contain number of atoms.");
-        return false;
-    }
+    std::string line;
+    std::getline(input, line);
+    chemkit::LineTokenizer tokenizer(line);
 
-    size_t atomCount = 0;
-    try {
-        atomCount = boost::lexical_cast<size_t>(firstLineTokens[0]);
-    }
-    catch(boost::bad_lexical_cast &e) {
+    int atomCount = 0;
+    if(!tokenizer.nextInteger(&atomCount) || atomCount < 0){
         setErrorString("First line of TXYZ file should contain number of atoms.");
         return false;
     }
@@ -81,25 +70,21 @@ bool TxyzFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
     boost::shared_ptr<chemkit::Molecule> molecule = boost::make_shared<chemkit::Molecule>();
 
     // set molecule name
-    if(firstLineTokens.size() >= 2){
-        molecule->setName(firstLineTokens[1]);
+    boost::string_ref name = tokenizer.nextToken();
+    if(!name.empty()){
+        molecule->setName(std::string(name.begin(), name.end()));
     }
 
     // reserve space for atoms
     molecule->setAtomCapacity(atomCount);
 
     std::vector<std::vector<size_t> > bondLists(atomCount);
+    std::vector<boost::string_ref> lineTokens;
 
-    for(size_t i = 0; i < atomCount; i++){
-        std::string line;
+    for(int i = 0; i < atomCount; i++){
         std::getline(input, line);
-        boost::trim(line);
-        std::vector<std::string> lineTokens;
-        boost::split(lineTokens,
-                     line,
-                     boost::is_any_of("\t "),
-                     boost::token_compress_on);
-        if(lineTokens.size() < 5){
+        tokenizer.setLine(line);
+        if(tokenizer.tokenize(lineTokens) < 5){
             // line too short
             continue;
         }
@@ -107,35 +92,37 @@ bool TxyzFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
         chemkit::Atom::AtomicNumberType atomicNumber;
 
         // if first character of line is a number then it is the atomic number
-        if(isdigit(lineTokens[1][0])){
-            atomicNumber = boost::lexical_cast<chemkit::Atom::AtomicNumberType>(lineTokens[1]);
+        if(chemkit::LineTokenizer::isDigit(lineTokens[1][0])){
+            int number = 0;
+            chemkit::LineTokenizer::parseInteger(lineTokens[1], &number);
+            atomicNumber = static_cast<chemkit::Atom::AtomicNumberType>(number);
         }
         // else we interpret it as an atomic symbol
         else{
-            atomicNumber = chemkit::Element(lineTokens[1]).atomicNumber();
+            atomicNumber = chemkit::Element(std::string(lineTokens[1].begin(), lineTokens[1].end())).atomicNumber();
         }
 
         // add the atom if we have a valid atomic number
         chemkit::Atom *atom = molecule->addAtom(atomicNumber);
         if(atom){
-            atom->setPosition(boost::lexical_cast<chemkit::Real>(lineTokens[2]),
-                              boost::lexical_cast<chemkit::Real>(lineTokens[3]),
-                              boost::lexical_cast<chemkit::Real>(lineTokens[4]));
+            chemkit::Real x = 0, y = 0, z = 0;
+            chemkit::LineTokenizer::parseReal(lineTokens[2], &x);
+            chemkit::LineTokenizer::parseReal(lineTokens[3], &y);
+            chemkit::LineTokenizer::parseReal(lineTokens[4], &z);
+            atom->setPosition(x, y, z);
         }
 
         // read bonds
         for(size_t j = 6; j < lineTokens.size(); j++){
-            try {
-                bondLists[i].push_back(boost::lexical_cast<size_t>(lineTokens[j]));
-            }
-            catch(boost::bad_lexical_cast &){
-                continue;
+            int neighbor;
+            if(chemkit::LineTokenizer::parseInteger(lineTokens[j], &neighbor) && neighbor > 0){
+                bondLists[i].push_back(neighbor);
             }
         }
     }
 
     // add bonds
-    for(size_t i = 0; i < atomCount; i++){
+    for(int i = 0; i < atomCount; i++){
         const std::vector<size_t> &neighbors = bondLists[i];
 
         foreach(size_t neighbor, neighbors){
@@ -35,7 +35,7 @@
 
 #include "xtcfileformat.h"
 
-#include <boost/filesystem.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/make_shared.hpp>
 
 #include <rpc/xdr.h>
@@ -49,6 +49,47 @@
 
 #include "../../3rdparty/xdrf/xdrf.h"
 
+namespace {
+
+const int XtcMagic = 1995;
+
+// magic, atom count, step, time, box and coordinate count
+const size_t FrameHeaderSize = 14 * 4;
+
+// precision, minimum and maximum integer coordinates, smallest
+// index and the size of the compressed coordinates
+const size_t CompressedHeaderSize = 9 * 4;
+
+// frames with this many atoms or less store uncompressed coordinates
+const int MaximumUncompressedAtoms = 9;
+
+// largest atom count accepted from a frame header. xdr3dfcoord()
+// allocates 3 * 1.2 ints per atom and sizes its buffers with ints, so
+// this keeps those sizes in range and bounds what a corrupt header can
+// make it allocate.
+const int MaximumAtomCount = 100000000;
+
+int readInt(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+    return static_cast<int>((static_cast<unsigned int>(bytes[0]) << 24) |
+                            (static_cast<unsigned int>(bytes[1]) << 16) |
+                            (static_cast<unsigned int>(bytes[2]) << 8) |
+                            (static_cast<unsigned int>(bytes[3])));
+}
+
+bool readBytes(std::istream &input, std::vector<char> &data, size_t size)
+{
+    size_t offset = data.size();
+    data.resize(offset + size);
+    input.read(&data[offset], size);
+
+    return static_cast<size_t>(input.gcount()) == size;
+}
+
+} // end anonymous namespace
+
 XtcFileFormat::XtcFileFormat()
     : chemkit::TrajectoryFileFormat("xtc")
 {
@@ -56,88 +97,153 @@ XtcFileFormat::XtcFileFormat()
 
 bool XtcFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
 {
-    // read data into temporary file
-    std::string tempFileName = (boost::filesystem::temp_directory_path() /
-                                boost::filesystem::unique_path()).string();
-
-    std::ofstream ostream(tempFileName.c_str());
-    ostream << input.rdbuf();
-    size_t dataSize = ostream.tellp();
-    ostream.close();
-
-    XDR xdrs;
-    xdropen(&xdrs, tempFileName.c_str(), "r");
+    if(!readHeader(input, file)){
+        return false;
+    }
 
     boost::shared_ptr<chemkit::Trajectory> trajectory = boost::make_shared<chemkit::Trajectory>();
 
-    while(xdr_getpos(&xdrs) < dataSize){
-        // read magic (should be '1995')
-        int magic = 0;
-        xdr_int(&xdrs, &magic);
-        if(magic != 1995){
+    for(;;){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+
+        if(!readFrame(input, file, frame)){
+            trajectory->removeFrame(frame);
             break;
         }
+    }
 
-        // read atom count
-        int atomCount = 0;
-        xdr_int(&xdrs, &atomCount);
+    if(!errorString().empty() || trajectory->isEmpty()){
+        return false;
+    }
 
-        // set trajectory size
-        if(trajectory->isEmpty() || trajectory->size() < size_t(atomCount)){
-            trajectory->resize(atomCount);
-        }
+    file->setTrajectory(trajectory);
 
-        // create new frame
-        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+    return true;
+}
 
-        // read frame number
-        int frameNumber = 0;
-        xdr_int(&xdrs, &frameNumber);
+bool XtcFileFormat::readHeader(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
 
-        // read time
-        float time = 0;
-        xdr_float(&xdrs, &time);
+    setErrorString(std::string());
 
-        // read unit cell
-        float box[3][3];
-        for(int i = 0; i < 3; i++){
-            for(int j = 0; j < 3; j++){
-                xdr_float(&xdrs, &box[i][j]);
-            }
+    return true;
+}
+
+// Reads the next frame into memory and decodes it. Only the bytes of
+// a single frame are buffered so the input does not need to be
+// seekable.
+bool XtcFileFormat::readFrame(std::istream &input, chemkit::TrajectoryFile *file, chemkit::TrajectoryFrame *frame)
+{
+    CHEMKIT_UNUSED(file);
+
+    m_frameData.clear();
+    if(!readBytes(input, m_frameData, FrameHeaderSize)){
+        if(input.gcount() != 0){
+            setErrorString("Truncated frame header.");
         }
 
-        chemkit::Vector3 x(box[0][0], box[0][1], box[0][2]);
-        chemkit::Vector3 y(box[1][0], box[1][1], box[1][2]);
-        chemkit::Vector3 z(box[2][0], box[2][1], box[2][2]);
+        return false;
+    }
 
-        frame->setUnitCell(new chemkit::UnitCell(x * 10, y * 10, z * 10));
+    int magic = readInt(&m_frameData[0]);
+    int atomCount = readInt(&m_frameData[4]);
+    int coordinateCount = readInt(&m_frameData[13 * 4]);
+    if(magic != XtcMagic){
+        setErrorString("Invalid frame header.");
+        return false;
+    }
+    else if(atomCount <= 0 || atomCount > MaximumAtomCount || coordinateCount != atomCount){
+        setErrorString("Invalid atom count.");
+        return false;
+    }
 
-        // read coordinates
-        std::vector<float> coordinateData(3 * atomCount);
-        float precision = 1000.0f;
-        xdr3dfcoord(&xdrs, &coordinateData[0], &atomCount, &precision);
+    if(atomCount <= MaximumUncompressedAtoms){
+        if(!readBytes(input, m_frameData, 3 * size_t(atomCount) * sizeof(float))){
+            setErrorString("Truncated frame.");
+            return false;
+        }
+    }
+    else{
+        if(!readBytes(input, m_frameData, CompressedHeaderSize)){
+            setErrorString("Truncated frame.");
+            return false;
+        }
 
-        for(int i = 0; i < atomCount; i++){
-            // multiply each coordinate by 10 to convert
-            // from nanometers to angstroms
-            chemkit::Point3 position(coordinateData[i*3+0] * 10,
-                                     coordinateData[i*3+1] * 10,
-                                     coordinateData[i*3+2] * 10);
+        // the compressed coordinates must fit in the buffer that
+        // xdr3dfcoord() allocates for them
+        int byteCount = readInt(&m_frameData[FrameHeaderSize + 8 * 4]);
+        boost::int64_t maximumByteCount = 4 * (static_cast<boost::int64_t>(3 * boost::int64_t(atomCount) * 1.2) - 3);
+        if(byteCount < 0 || byteCount > maximumByteCount){
+            setErrorString("Invalid compressed coordinate size.");
+            return false;
+        }
 
-            frame->setPosition(i, position);
+        // compressed data is padded to a multiple of four bytes
+        if(!readBytes(input, m_frameData, (byteCount + 3) & ~3)){
+            setErrorString("Truncated frame.");
+            return false;
         }
     }
 
-    xdrclose(&xdrs);
+    XDR xdrs;
+    if(!xdrmemopen(&xdrs, &m_frameData[0], m_frameData.size(), "r")){
+        setErrorString("Failed to open xdr stream.");
+        return false;
+    }
+
+    // skip magic, atom count and step
+    int value = 0;
+    xdr_int(&xdrs, &value);
+    xdr_int(&xdrs, &value);
+    xdr_int(&xdrs, &value);
+
+    // read time
+    float time = 0;
+    xdr_float(&xdrs, &time);
+
+    // read unit cell
+    float box[3][3];
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            xdr_float(&xdrs, &box[i][j]);
+        }
+    }
+
+    // read coordinates
+    m_coordinates.resize(3 * size_t(atomCount));
+    float precision = 1000.0f;
+    int ok = xdr3dfcoord(&xdrs, &m_coordinates[0], &atomCount, &precision);
 
-    // remove temp file
-    boost::filesystem::remove(tempFileName);
+    xdrclose(&xdrs);
 
-    if(trajectory->isEmpty()){
+    if(!ok){
+        setErrorString("Failed to decode coordinates.");
         return false;
     }
 
-    file->setTrajectory(trajectory);
+    if(frame->size() != size_t(atomCount)){
+        frame->trajectory()->resize(atomCount);
+    }
+
+    frame->setTime(time);
+
+    chemkit::Vector3 x(box[0][0], box[0][1], box[0][2]);
+    chemkit::Vector3 y(box[1][0], box[1][1], box[1][2]);
+    chemkit::Vector3 z(box[2][0], box[2][1], box[2][2]);
+
+    frame->setUnitCell(new chemkit::UnitCell(x * 10, y * 10, z * 10));
+
+    for(int i = 0; i < atomCount; i++){
+        // multiply each coordinate by 10 to convert
+        // from nanometers to angstroms
+        chemkit::Point3 position(m_coordinates[i*3+0] * 10,
+                                 m_coordinates[i*3+1] * 10,
+                                 m_coordinates[i*3+2] * 10);
+
+        frame->setPosition(i, position);
+    }
 
     return true;
 }
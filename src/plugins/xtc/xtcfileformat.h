@@ -36,6 +36,8 @@
 #ifndef XTCFILEFORMAT_H
 #define XTCFILEFORMAT_H
 
+#include <vector>
+
 #include <chemkit/trajectoryfileformat.h>
 
 class XtcFileFormat : public chemkit::TrajectoryFileFormat
@@ -43,7 +45,13 @@ class XtcFileFormat : public chemkit::TrajectoryFileFormat
 public:
     XtcFileFormat();
 
-    bool read(std::istream &input, chemkit::TrajectoryFile *file);
+    bool read(std::istream &input, chemkit::TrajectoryFile *file) CHEMKIT_OVERRIDE;
+    bool readHeader(std::istream &input, chemkit::TrajectoryFile *file) CHEMKIT_OVERRIDE;
+    bool readFrame(std::istream &input, chemkit::TrajectoryFile *file, chemkit::TrajectoryFrame *frame) CHEMKIT_OVERRIDE;
+
+private:
+    std::vector<char> m_frameData;
+    std::vector<float> m_coordinates;
 };
 
 #endif // XTCFILEFORMAT_H
@@ -45,108 +45,187 @@
 #include <chemkit/foreach.h>
 #include <chemkit/molecule.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/linetokenizer.h>
 
 XyzFileFormat::XyzFileFormat()
     : chemkit::MoleculeFileFormat("xyz")
 {
 }
 
+// Multiple molecules can be stored in a single file by concatenating
+// their records (atom count line, comment line and atom lines).
 bool XyzFileFormat::read(std::istream &input, chemkit::MoleculeFile *file)
 {
-    // atom count line
-    int atomCount = 0;
-    input >> atomCount;
-    input.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-
-    // comment line (unused)
-    std::string commentLine;
-    std::getline(input, commentLine);
-    CHEMKIT_UNUSED(commentLine);
+    for(;;){
+        boost::shared_ptr<chemkit::Molecule> molecule = readMolecule(input, file);
+        if(!molecule){
+            break;
+        }
 
-    // create molecule
-    boost::shared_ptr<chemkit::Molecule> molecule(new chemkit::Molecule);
+        // add molecule to file
+        file->addMolecule(molecule);
+    }
 
-    // read atoms and coordinates
-    for(int i = 0; i < atomCount; i++){
-        std::string symbol;
-        double x = 0;
-        double y = 0;
-        double z = 0;
-
-        input >> symbol >> x >> y >> z;
-        if(input.fail()){
-            input.clear();
+    if(file->isEmpty()){
+        if(errorString().empty()){
+            setErrorString("File is empty");
         }
 
-        // add atom from symbol or atomic number
-        chemkit::Atom *atom = 0;
-        if(symbol.empty()){
-            continue;
+        return false;
+    }
+
+    return true;
+}
+
+bool XyzFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file)
+{
+    const char *data = input.data();
+    size_t size = input.size();
+    size_t position = 0;
+
+    for(;;){
+        // skip blank lines between records
+        while(position < size && isspace(data[position])){
+            position++;
         }
-        else if(isdigit(symbol.at(0))){
-            int atomicNumber = boost::lexical_cast<int>(symbol);
-            atom = molecule->addAtom(atomicNumber);
+
+        if(position >= size){
+            break;
         }
-        else{
-            atom = molecule->addAtom(symbol);
+
+        // atom count line
+        unsigned int atomCount = 0;
+        int count = sscanf(&data[position], "%u", &atomCount);
+        if(count != 1){
+            setErrorString("Failed to read atom count line");
+            return false;
         }
 
-        // set atom position
-        if(atom){
-            atom->setPosition(x, y, z);
+        while(position < size && data[position++] != '\n');
+
+        // comment line
+        while(position < size && data[position++] != '\n');
+
+        // create molecule
+        boost::shared_ptr<chemkit::Molecule> molecule = boost::make_shared<chemkit::Molecule>();
+
+        // read atoms and coordinates
+        for(unsigned int i = 0; i < atomCount && position < size; i++){
+            char symbol[4];
+            double x, y, z;
+
+            count = sscanf(&data[position], "%3s %lf %lf %lf", symbol, &x, &y, &z);
+            while(position < size && data[position++] != '\n');
+            if(count != 4){
+                setErrorString("Failed to read atom line");
+                continue;
+            }
+
+            chemkit::Atom *atom = 0;
+            if(strlen(symbol) == 0){
+                continue;
+            }
+            else if(isdigit(symbol[0])){
+                chemkit::Element::AtomicNumberType atomicNumber =
+                    boost::lexical_cast<chemkit::Element::AtomicNumberType>(symbol);
+                atom = molecule->addAtom(atomicNumber);
+            }
+            else{
+                atom = molecule->addAtom(symbol);
+            }
+
+            // set atom position
+            if(atom){
+                atom->setPosition(x, y, z);
+            }
         }
+
+        // add molecule to file
+        file->addMolecule(molecule);
+    }
+
+    return true;
+}
+
+bool XyzFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
+{
+    if(file->isEmpty()){
+        setErrorString("No molecule in file.");
+        return false;
     }
 
-    // add molecule to file
-    file->addMolecule(molecule);
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file->molecules()){
+        writeMoleculeRecord(molecule.get(), output);
+    }
 
     return true;
 }
 
-bool XyzFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file)
+bool XyzFileFormat::readHeader(std::istream &input, chemkit::MoleculeFile *file)
 {
-    const char *data = input.data();
-    size_t position = 0;
+    CHEMKIT_UNUSED(input);
+    CHEMKIT_UNUSED(file);
 
-    // atom count line
-    unsigned int atomCount = 0;
-    int count = sscanf(&data[position], "%u", &atomCount);
-    if(count != 1){
-        setErrorString("Failed to read atom count line");
-        return false;
+    return true;
+}
+
+boost::shared_ptr<chemkit::Molecule> XyzFileFormat::readMolecule(std::istream &input, chemkit::MoleculeFile *file)
+{
+    CHEMKIT_UNUSED(file);
+
+    // atom count line (skipping blank lines between records)
+    std::string countLine;
+    while(countLine.find_first_not_of(" \t\r") == std::string::npos){
+        if(!std::getline(input, countLine)){
+            return boost::shared_ptr<chemkit::Molecule>();
+        }
     }
 
-    while(data[position++] != '\n');
+    chemkit::LineTokenizer tokenizer(countLine);
 
-    // comment line
-    while(data[position++] != '\n');
+    int atomCount = 0;
+    if(!tokenizer.nextInteger(&atomCount) || atomCount < 0){
+        setErrorString("Failed to read atom count line");
+        return boost::shared_ptr<chemkit::Molecule>();
+    }
+
+    // comment line (unused)
+    std::string commentLine;
+    std::getline(input, commentLine);
+    CHEMKIT_UNUSED(commentLine);
 
     // create molecule
-    boost::shared_ptr<chemkit::Molecule> molecule = boost::make_shared<chemkit::Molecule>();
+    boost::shared_ptr<chemkit::Molecule> molecule(new chemkit::Molecule);
 
     // read atoms and coordinates
-    for(unsigned int i = 0; i < atomCount; i++){
-        char symbol[4];
-        double x, y, z;
-
-        count = sscanf(&data[position], "%3s %lf %lf %lf", symbol, &x, &y, &z);
-        if(count != 4){
-            setErrorString("Failed to read atom line");
-            continue;
+    std::string line;
+    for(int i = 0; i < atomCount; i++){
+        if(!std::getline(input, line)){
+            break;
         }
-        while(data[position++] != '\n');
 
+        tokenizer.setLine(line);
+        boost::string_ref symbol = tokenizer.nextToken();
+
+        chemkit::Real x = 0;
+        chemkit::Real y = 0;
+        chemkit::Real z = 0;
+        tokenizer.nextReal(&x);
+        tokenizer.nextReal(&y);
+        tokenizer.nextReal(&z);
+
+        // add atom from symbol or atomic number
         chemkit::Atom *atom = 0;
-        if(strlen(symbol) == 0){
+        if(symbol.empty()){
             continue;
         }
-        else if(isdigit(symbol[0])){
-            chemkit::Element::AtomicNumberType atomicNumber =
-                boost::lexical_cast<chemkit::Element::AtomicNumberType>(symbol);
+        else if(chemkit::LineTokenizer::isDigit(symbol[0])){
+            int atomicNumber = 0;
+            chemkit::LineTokenizer::parseInteger(symbol, &atomicNumber);
             atom = molecule->addAtom(atomicNumber);
         }
         else{
-            atom = molecule->addAtom(symbol);
+            atom = molecule->addAtom(chemkit::Element::fromSymbol(symbol.data(), symbol.size()));
         }
 
         // set atom position
@@ -155,20 +234,38 @@ bool XyzFileFormat::readMappedFile(const boost::iostreams::mapped_file_source &i
         }
     }
 
-    // add molecule to file
-    file->addMolecule(molecule);
+    return molecule;
+}
+
+bool XyzFileFormat::writeHeader(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
 
     return true;
 }
 
-bool XyzFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &output)
+bool XyzFileFormat::writeMolecule(chemkit::MoleculeFile *file,
+                                  const boost::shared_ptr<chemkit::Molecule> &molecule,
+                                  std::ostream &output)
 {
-    boost::shared_ptr<chemkit::Molecule> molecule = file->molecule();
-    if(!molecule){
-        setErrorString("No molecule in file.");
-        return false;
-    }
+    CHEMKIT_UNUSED(file);
 
+    writeMoleculeRecord(molecule.get(), output);
+
+    return true;
+}
+
+bool XyzFileFormat::writeFooter(chemkit::MoleculeFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+    CHEMKIT_UNUSED(output);
+
+    return true;
+}
+
+void XyzFileFormat::writeMoleculeRecord(const chemkit::Molecule *molecule, std::ostream &output)
+{
     // atom count line
     output << molecule->atomCount() << "\n";
 
@@ -185,6 +282,4 @@ bool XyzFileFormat::write(const chemkit::MoleculeFile *file, std::ostream &outpu
                << std::setw(15) << std::setprecision(5) << atom->z()
                << "\n";
     }
-
-    return true;
 }
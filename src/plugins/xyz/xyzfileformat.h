@@ -46,6 +46,14 @@ public:
     bool read(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
     bool readMappedFile(const boost::iostreams::mapped_file_source &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
     bool write(const chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool readHeader(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    boost::shared_ptr<chemkit::Molecule> readMolecule(std::istream &input, chemkit::MoleculeFile *file) CHEMKIT_OVERRIDE;
+    bool writeHeader(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeMolecule(chemkit::MoleculeFile *file, const boost::shared_ptr<chemkit::Molecule> &molecule, std::ostream &output) CHEMKIT_OVERRIDE;
+    bool writeFooter(chemkit::MoleculeFile *file, std::ostream &output) CHEMKIT_OVERRIDE;
+
+private:
+    void writeMoleculeRecord(const chemkit::Molecule *molecule, std::ostream &output);
 };
 
 #endif // XYZFILEFORMAT_H
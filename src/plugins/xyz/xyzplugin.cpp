@@ -37,6 +37,10 @@
 
 #include "xyzfileformat.h"
 
+#ifdef CHEMKIT_WITH_MD_IO
+#include "xyztrajectoryfileformat.h"
+#endif
+
 class XyzPlugin : public chemkit::Plugin
 {
 public:
@@ -44,6 +48,10 @@ public:
         : chemkit::Plugin("xyz")
     {
         CHEMKIT_REGISTER_MOLECULE_FILE_FORMAT("xyz", XyzFileFormat);
+
+        #ifdef CHEMKIT_WITH_MD_IO
+        CHEMKIT_REGISTER_TRAJECTORY_FILE_FORMAT("xyz", XyzTrajectoryFileFormat);
+        #endif
     }
 };
 
@@ -0,0 +1,319 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "xyztrajectoryfileformat.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/make_shared.hpp>
+#include <boost/format.hpp>
+
+#include <chemkit/foreach.h>
+#include <chemkit/vector3.h>
+#include <chemkit/unitcell.h>
+#include <chemkit/topology.h>
+#include <chemkit/linetokenizer.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+
+// An xyz trajectory is a concatenation of xyz frames, each containing
+// an atom count line, a comment line and one "symbol x y z" line per
+// atom. The comment line may contain extended xyz properties giving
+// the unit cell as Lattice="ax ay az bx by bz cx cy cz" and the time
+// as Time=<time>. Both are written along with each frame.
+
+namespace {
+
+// returns the value of the key=value property in the comment line or
+// an empty string if the line does not contain it. quoted values are
+// returned without their quotes.
+boost::string_ref findProperty(const std::string &line, const char *key)
+{
+    size_t length = std::strlen(key);
+
+    size_t position = line.find(key);
+    while(position != std::string::npos){
+        if((position == 0 || chemkit::LineTokenizer::isSpace(line[position - 1])) &&
+           position + length < line.size() &&
+           line[position + length] == '='){
+            boost::string_ref value(line.c_str() + position + length + 1,
+                                    line.size() - position - length - 1);
+
+            if(!value.empty() && value[0] == '"'){
+                value.remove_prefix(1);
+                return value.substr(0, value.find('"'));
+            }
+
+            return value.substr(0, std::find_if(value.begin(), value.end(), chemkit::LineTokenizer::isSpace) - value.begin());
+        }
+
+        position = line.find(key, position + length);
+    }
+
+    return boost::string_ref();
+}
+
+} // end anonymous namespace
+
+XyzTrajectoryFileFormat::XyzTrajectoryFileFormat()
+    : chemkit::TrajectoryFileFormat("xyz"),
+      m_setTypes(false)
+{
+}
+
+bool XyzTrajectoryFileFormat::read(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    if(!readHeader(input, file)){
+        return false;
+    }
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory =
+        boost::make_shared<chemkit::Trajectory>();
+
+    for(;;){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+
+        if(!readFrame(input, file, frame)){
+            trajectory->removeFrame(frame);
+            break;
+        }
+    }
+
+    if(!errorString().empty()){
+        return false;
+    }
+
+    file->setTrajectory(trajectory);
+
+    return true;
+}
+
+bool XyzTrajectoryFileFormat::readHeader(std::istream &input, chemkit::TrajectoryFile *file)
+{
+    CHEMKIT_UNUSED(input);
+
+    setErrorString(std::string());
+
+    // the atom symbols from the first frame are used as the
+    // topology if the file does not already have one
+    m_setTypes = !file->topology();
+
+    return true;
+}
+
+// The atom lines are read before the frame is resized so that a
+// corrupt atom count fails at the end of the input instead of
+// allocating space for the atoms up front.
+bool XyzTrajectoryFileFormat::readFrame(std::istream &input,
+                                        chemkit::TrajectoryFile *file,
+                                        chemkit::TrajectoryFrame *frame)
+{
+    // atom count line, blank lines between frames are skipped
+    do {
+        if(!std::getline(input, m_line)){
+            return false;
+        }
+    } while(chemkit::LineTokenizer::trimmed(m_line).empty());
+
+    int size = 0;
+    if(!chemkit::LineTokenizer(m_line).nextInteger(&size) || size < 0){
+        setErrorString("Invalid atom count line.");
+        return false;
+    }
+
+    // comment line
+    std::getline(input, m_line);
+
+    chemkit::Real time = 0;
+    chemkit::LineTokenizer::parseReal(findProperty(m_line, "Time"), &time);
+
+    chemkit::UnitCell *cell = 0;
+    boost::string_ref lattice = findProperty(m_line, "Lattice");
+    if(!lattice.empty()){
+        chemkit::LineTokenizer tokenizer(lattice);
+        chemkit::Real values[9];
+
+        size_t count = 0;
+        while(count < 9 && tokenizer.nextReal(&values[count])){
+            count++;
+        }
+
+        if(count == 9){
+            cell = new chemkit::UnitCell(chemkit::Vector3(values[0], values[1], values[2]),
+                                         chemkit::Vector3(values[3], values[4], values[5]),
+                                         chemkit::Vector3(values[6], values[7], values[8]));
+        }
+    }
+
+    // atom lines
+    m_positions.clear();
+    m_types.clear();
+
+    chemkit::LineTokenizer tokenizer;
+    for(int i = 0; i < size; i++){
+        if(!std::getline(input, m_line)){
+            delete cell;
+            setErrorString("Unexpected end of frame.");
+            return false;
+        }
+
+        tokenizer.setLine(m_line);
+
+        boost::string_ref symbol = tokenizer.nextToken();
+        chemkit::Real x = 0, y = 0, z = 0;
+        if(symbol.empty() ||
+           !tokenizer.nextReal(&x) ||
+           !tokenizer.nextReal(&y) ||
+           !tokenizer.nextReal(&z)){
+            delete cell;
+            setErrorString("Invalid atom line.");
+            return false;
+        }
+
+        if(m_setTypes){
+            m_types.push_back(std::string(symbol.begin(), symbol.end()));
+        }
+
+        m_positions.push_back(chemkit::Point3(x, y, z));
+    }
+
+    if(frame->size() != m_positions.size()){
+        frame->trajectory()->resize(m_positions.size());
+    }
+
+    for(size_t i = 0; i < m_positions.size(); i++){
+        frame->setPosition(i, m_positions[i]);
+    }
+
+    frame->setUnitCell(cell);
+    frame->setTime(time);
+
+    // the atom symbols from the first frame are used as the topology
+    if(m_setTypes){
+        boost::shared_ptr<chemkit::Topology> topology =
+            boost::make_shared<chemkit::Topology>(m_types.size());
+
+        for(size_t i = 0; i < m_types.size(); i++){
+            topology->setType(i, m_types[i]);
+        }
+
+        file->setTopology(topology);
+        m_setTypes = false;
+    }
+
+    return true;
+}
+
+bool XyzTrajectoryFileFormat::write(const chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = file->trajectory();
+    if(!trajectory){
+        setErrorString("No trajectory to write.");
+        return false;
+    }
+
+    foreach(const chemkit::TrajectoryFrame *frame, trajectory->frames()){
+        writeFrameData(file, frame, output);
+    }
+
+    return !output.fail();
+}
+
+bool XyzTrajectoryFileFormat::writeHeader(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    return !output.fail();
+}
+
+bool XyzTrajectoryFileFormat::writeFrame(chemkit::TrajectoryFile *file,
+                                         const chemkit::TrajectoryFrame *frame,
+                                         std::ostream &output)
+{
+    writeFrameData(file, frame, output);
+
+    return !output.fail();
+}
+
+bool XyzTrajectoryFileFormat::writeFooter(chemkit::TrajectoryFile *file, std::ostream &output)
+{
+    CHEMKIT_UNUSED(file);
+
+    return !output.fail();
+}
+
+void XyzTrajectoryFileFormat::writeFrameData(const chemkit::TrajectoryFile *file,
+                                             const chemkit::TrajectoryFrame *frame,
+                                             std::ostream &output)
+{
+    // atom count line
+    output << frame->size() << "\n";
+
+    // comment line, with enough digits for the time and unit cell to
+    // be read back exactly
+    output << boost::format("Time=%.17g") % frame->time();
+
+    const chemkit::UnitCell *cell = frame->unitCell();
+    if(cell){
+        output << boost::format(" Lattice=\"%.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\"")
+                  % cell->x().x() % cell->x().y() % cell->x().z()
+                  % cell->y().x() % cell->y().y() % cell->y().z()
+                  % cell->z().x() % cell->z().y() % cell->z().z();
+    }
+
+    output << "\n";
+
+    // atom lines, using the topology types as the symbols
+    boost::shared_ptr<chemkit::Topology> topology = file->topology();
+    if(topology && topology->size() != frame->size()){
+        topology.reset();
+    }
+
+    char line[128];
+    for(size_t i = 0; i < frame->size(); i++){
+        std::string symbol = topology ? topology->type(i) : std::string();
+        if(symbol.empty()){
+            symbol = "X";
+        }
+
+        chemkit::Point3 position = frame->position(i);
+        int length = snprintf(line, sizeof(line), "%3s%15.5f%15.5f%15.5f\n",
+                              symbol.c_str(), position.x(), position.y(), position.z());
+        output.write(line, std::min(length, int(sizeof(line) - 1)));
+    }
+}
@@ -0,0 +1,187 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "similaritytest.h"
+
+const QString similarityApplication = "../../../../bin/chemkit-similarity";
+const QString testDataPath = "../../../data/";
+
+namespace {
+
+// runs the similarity application and returns each line of output.
+// if errors is not null it is set to each line of error output.
+QStringList runSimilarity(const QStringList &arguments, QStringList *errors = 0)
+{
+    QProcess process;
+    process.start(similarityApplication, arguments);
+    process.waitForFinished();
+
+    if(errors){
+        QString errorOutput = process.readAllStandardError();
+        *errors = errorOutput.split("\n", QString::SkipEmptyParts);
+    }
+
+    QString output = process.readAllStandardOutput();
+    return output.split("\n", QString::SkipEmptyParts);
+}
+
+} // end anonymous namespace
+
+void SimilarityTest::nearest()
+{
+    QStringList arguments;
+    arguments.append("--count");
+    arguments.append("3");
+    arguments.append("c1ccccc1O");
+    arguments.append(testDataPath + "pubchem_416_benzenes.sdf");
+
+    QStringList lines = runSimilarity(arguments);
+    QCOMPARE(lines.size(), 3);
+
+    QStringList fields = lines[0].split("\t");
+    QCOMPARE(fields.size(), 4);
+    QCOMPARE(fields[0], QString("c1ccccc1O"));
+    QCOMPARE(fields[1], QString("315"));
+    QCOMPARE(fields[2], QString("1483"));
+    QCOMPARE(fields[3], QString("0.5217"));
+
+    fields = lines[1].split("\t");
+    QCOMPARE(fields[1], QString("399"));
+    QCOMPARE(fields[2], QString("566"));
+    QCOMPARE(fields[3], QString("0.2917"));
+}
+
+void SimilarityTest::threshold()
+{
+    QStringList arguments;
+    arguments.append("--count");
+    arguments.append("0");
+    arguments.append("--threshold");
+    arguments.append("0.45");
+    arguments.append("c1ccccc1O");
+    arguments.append(testDataPath + "pubchem_416_benzenes.sdf");
+
+    QStringList lines = runSimilarity(arguments);
+    QCOMPARE(lines.size(), 1);
+    QCOMPARE(lines[0], QString("c1ccccc1O\t315\t1483\t0.5217"));
+}
+
+void SimilarityTest::index()
+{
+    QTemporaryFile indexFile;
+    indexFile.open();
+    indexFile.close();
+
+    // build and save the index
+    QStringList arguments;
+    arguments.append("--count");
+    arguments.append("2");
+    arguments.append("--save-index");
+    arguments.append(indexFile.fileName());
+    arguments.append("c1ccccc1O");
+    arguments.append(testDataPath + "pubchem_416_benzenes.sdf");
+
+    QStringList lines = runSimilarity(arguments);
+    QCOMPARE(lines.size(), 2);
+
+    // search the saved index without the molecule file
+    arguments.clear();
+    arguments.append("--count");
+    arguments.append("2");
+    arguments.append("--load-index");
+    arguments.append(indexFile.fileName());
+    arguments.append("c1ccccc1O");
+
+    lines = runSimilarity(arguments);
+    QCOMPARE(lines.size(), 2);
+    QCOMPARE(lines[0], QString("c1ccccc1O\t315\t1483\t0.5217"));
+    QCOMPARE(lines[1], QString("c1ccccc1O\t399\t566\t0.2917"));
+
+    // the index cannot be searched with a different fingerprint
+    arguments.append("--fingerprint");
+    arguments.append("ecfp");
+
+    QStringList errors;
+    lines = runSimilarity(arguments, &errors);
+    QCOMPARE(lines.size(), 0);
+    QCOMPARE(errors.size(), 1);
+    QVERIFY(errors[0].contains("does not contain ecfp fingerprints"));
+}
+
+void SimilarityTest::queryFile()
+{
+    QStringList arguments;
+    arguments.append("--count");
+    arguments.append("1");
+    arguments.append("--query-file");
+    arguments.append(testDataPath + "herg.smi");
+    arguments.append(testDataPath + "pubchem_416_benzenes.sdf");
+
+    // one match for each of the 31 molecules in the query file, in
+    // the same order as the file
+    QStringList lines = runSimilarity(arguments);
+    QCOMPARE(lines.size(), 31);
+    QCOMPARE(lines[0], QString("Amitriptyline\t386\t1224\t0.4222"));
+    QCOMPARE(lines[1], QString("Astemizole\t162\t2247\t1.0000"));
+    QVERIFY(lines[30].startsWith("Verapamil\t"));
+}
+
+void SimilarityTest::timings()
+{
+    QStringList arguments;
+    arguments.append("--count");
+    arguments.append("1");
+    arguments.append("--timings");
+    arguments.append("c1ccccc1O");
+    arguments.append(testDataPath + "pubchem_416_benzenes.sdf");
+
+    // the timings are written to standard error after the matches
+    QStringList errors;
+    QStringList lines = runSimilarity(arguments, &errors);
+    QCOMPARE(lines.size(), 1);
+    QCOMPARE(lines[0], QString("c1ccccc1O\t315\t1483\t0.5217"));
+
+    QCOMPARE(errors.size(), 7);
+    QCOMPARE(errors[0], QString("queries:     1"));
+    QCOMPARE(errors[1], QString("molecules:   416"));
+    QVERIFY(errors[2].startsWith("queries "));
+    QVERIFY(errors[3].startsWith("fingerprint "));
+    QVERIFY(errors[4].startsWith("search "));
+    QVERIFY(errors[5].startsWith("output "));
+    QVERIFY(errors[6].startsWith("total "));
+    QVERIFY(errors[6].endsWith(" s"));
+}
+
+QTEST_APPLESS_MAIN(SimilarityTest)
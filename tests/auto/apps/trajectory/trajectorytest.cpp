@@ -0,0 +1,133 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+// The TrajectoryTest class tests the chemkit-trajectory tool. Each
+// test case copies a trajectory with a selection or frame filter
+// applied and verifies the frames in the output file.
+
+#include "trajectorytest.h"
+
+#include <chemkit/topology.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+
+const std::string testDataPath = "../../../data/";
+const QString trajectoryApplication = "../../../../bin/chemkit-trajectory";
+
+void TrajectoryTest::selectElement()
+{
+    // setup output file
+    QTemporaryFile output("XXXXXX.xyz");
+    output.open();
+
+    // keep only the oxygen atoms
+    QStringList arguments;
+    arguments.append((testDataPath + "spc216.gro").c_str());
+    arguments.append(output.fileName());
+    arguments.append("--elements");
+    arguments.append("O");
+
+    // run chemkit-trajectory
+    QProcess process;
+    process.start(trajectoryApplication, arguments);
+    process.waitForFinished();
+    QCOMPARE(process.exitCode(), 0);
+    process.close();
+
+    // read and verify the output file
+    QByteArray outputFileName = output.fileName().toAscii();
+    chemkit::TrajectoryFile outputFile;
+    bool ok = outputFile.read(outputFileName.constData());
+    if(!ok){
+        qDebug() << outputFile.errorString().c_str();
+    }
+    QCOMPARE(ok, true);
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory = outputFile.trajectory();
+    QCOMPARE(trajectory->frameCount(), size_t(1));
+    QCOMPARE(trajectory->size(), size_t(216));
+    QVERIFY(trajectory->frame(0)->position(0).isApprox(chemkit::Point3(2.30, 6.28, 1.13)));
+
+    boost::shared_ptr<chemkit::Topology> topology = outputFile.topology();
+    for(size_t i = 0; i < topology->size(); i++){
+        QCOMPARE(topology->type(i), std::string("OW"));
+    }
+}
+
+void TrajectoryTest::strideAndTimeWindow()
+{
+    // setup output file
+    QTemporaryFile output("XXXXXX.ctrj");
+    output.open();
+
+    // every tenth frame from 5 ps to 15 ps of the first water, the
+    // times in the file are single precision
+    QStringList arguments;
+    arguments.append((testDataPath + "spc216.xtc").c_str());
+    arguments.append(output.fileName());
+    arguments.append("--atoms");
+    arguments.append("0-2");
+    arguments.append("--stride");
+    arguments.append("10");
+    arguments.append("--begin");
+    arguments.append("4.95");
+    arguments.append("--end");
+    arguments.append("15.05");
+
+    // run chemkit-trajectory
+    QProcess process;
+    process.start(trajectoryApplication, arguments);
+    process.waitForFinished();
+    QCOMPARE(process.exitCode(), 0);
+    process.close();
+
+    // read and verify the output file
+    QByteArray outputFileName = output.fileName().toAscii();
+    chemkit::TrajectoryFile outputFile;
+    bool ok = outputFile.read(outputFileName.constData());
+    if(!ok){
+        qDebug() << outputFile.errorString().c_str();
+    }
+    QCOMPARE(ok, true);
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory = outputFile.trajectory();
+    QCOMPARE(trajectory->size(), size_t(3));
+    QCOMPARE(trajectory->frameCount(), size_t(11));
+    QVERIFY(qAbs(trajectory->frame(0)->time() - 5.0) < 1e-4);
+    QVERIFY(qAbs(trajectory->frame(10)->time() - 15.0) < 1e-4);
+}
+
+QTEST_APPLESS_MAIN(TrajectoryTest)
@@ -40,6 +40,42 @@
 #include <chemkit/internalcoordinates.h>
 #include <chemkit/cartesiancoordinates.h>
 
+namespace {
+
+// creates a new set of three coordinates and counts the calls
+class CoordinatesLoader
+{
+public:
+    CoordinatesLoader(int *count)
+        : m_count(count)
+    {
+    }
+
+    chemkit::CartesianCoordinates* operator()() const
+    {
+        (*m_count)++;
+
+        chemkit::CartesianCoordinates *coordinates = new chemkit::CartesianCoordinates(3);
+        coordinates->setPosition(1, chemkit::Point3(1, 2, 3));
+        return coordinates;
+    }
+
+private:
+    int *m_count;
+};
+
+// fails to load any coordinates
+class FailingLoader
+{
+public:
+    chemkit::CartesianCoordinates* operator()() const
+    {
+        return 0;
+    }
+};
+
+} // end anonymous namespace
+
 void CoordinateSetTest::type()
 {
     chemkit::CoordinateSet coordinates;
@@ -111,4 +147,47 @@ void CoordinateSetTest::position()
     QCOMPARE(coordinates.position(2), chemkit::Point3(60, 75, 0));
 }
 
+void CoordinateSetTest::loadFunction()
+{
+    int count = 0;
+    chemkit::CoordinateSet coordinates((CoordinatesLoader(&count)));
+    QCOMPARE(coordinates.isLoaded(), false);
+    QCOMPARE(count, 0);
+
+    // copies share the load function until they are loaded
+    chemkit::CoordinateSet copy = coordinates;
+    QCOMPARE(copy.isLoaded(), false);
+
+    QCOMPARE(coordinates.size(), size_t(3));
+    QCOMPARE(coordinates.isLoaded(), true);
+    QCOMPARE(coordinates.position(1), chemkit::Point3(1, 2, 3));
+    QVERIFY(coordinates.cartesianCoordinates() != 0);
+    QVERIFY(coordinates.type() == chemkit::CoordinateSet::Cartesian);
+    QCOMPARE(count, 1);
+
+    QCOMPARE(copy.position(1), chemkit::Point3(1, 2, 3));
+    QCOMPARE(count, 2);
+
+    // clearing removes the load function
+    chemkit::CoordinateSet cleared((CoordinatesLoader(&count)));
+    cleared.clear();
+    QCOMPARE(cleared.isLoaded(), true);
+    QVERIFY(cleared.type() == chemkit::CoordinateSet::None);
+    QCOMPARE(cleared.size(), size_t(0));
+    QCOMPARE(count, 2);
+
+    // the type is checked by loading the coordinates and is none if
+    // they cannot be loaded
+    chemkit::CoordinateSet loaded((CoordinatesLoader(&count)));
+    QVERIFY(loaded.type() == chemkit::CoordinateSet::Cartesian);
+    QCOMPARE(loaded.isLoaded(), true);
+    QCOMPARE(count, 3);
+
+    chemkit::CoordinateSet failed((FailingLoader()));
+    QVERIFY(failed.type() == chemkit::CoordinateSet::None);
+    QCOMPARE(failed.isLoaded(), true);
+    QCOMPARE(failed.size(), size_t(0));
+    QVERIFY(failed.cartesianCoordinates() == 0);
+}
+
 QTEST_APPLESS_MAIN(CoordinateSetTest)
@@ -50,6 +50,7 @@ class CoordinateSetTest : public QObject
         void internalCoordinates();
         void diagramCoordinates();
         void position();
+        void loadFunction();
 };
 
 #endif // COORDINATESETTEST_H
@@ -35,6 +35,86 @@
 
 #include "fingerprinttest.h"
 
+#include <chemkit/atom.h>
+#include <chemkit/molecule.h>
 #include <chemkit/fingerprint.h>
 
+namespace {
+
+// fingerprint which sets the bit for the number of atoms in the
+// molecule and counts how many times it has been calculated
+class CountingFingerprint : public chemkit::Fingerprint
+{
+public:
+    CountingFingerprint()
+        : chemkit::Fingerprint("counting"),
+          m_calculations(0)
+    {
+    }
+
+    chemkit::Bitset value(const chemkit::Molecule *molecule) const
+    {
+        m_calculations++;
+
+        chemkit::Bitset fingerprint(8);
+        fingerprint.set(molecule->size() % 8);
+        return fingerprint;
+    }
+
+    int calculations() const
+    {
+        return m_calculations;
+    }
+
+private:
+    mutable int m_calculations;
+};
+
+} // end anonymous namespace
+
+void FingerprintTest::cachedValue()
+{
+    chemkit::Molecule molecule;
+    chemkit::Atom *C1 = molecule.addAtom("C");
+    chemkit::Atom *C2 = molecule.addAtom("C");
+
+    CountingFingerprint fingerprint;
+    QCOMPARE(fingerprint.cachedValue(&molecule).find_first(), size_t(2));
+    QCOMPARE(fingerprint.calculations(), 1);
+
+    // second call uses the cached value
+    QCOMPARE(fingerprint.cachedValue(&molecule).find_first(), size_t(2));
+    QCOMPARE(fingerprint.calculations(), 1);
+
+    // the cached value is also returned from molecule.fingerprint()
+    // even though there is no plugin for the fingerprint
+    QCOMPARE(molecule.fingerprint("counting").find_first(), size_t(2));
+
+    // changing the name keeps the cached value
+    molecule.setName("ethane");
+    fingerprint.cachedValue(&molecule);
+    QCOMPARE(fingerprint.calculations(), 1);
+
+    // adding a bond discards it
+    molecule.addBond(C1, C2);
+    QVERIFY(molecule.fingerprint("counting").none());
+    fingerprint.cachedValue(&molecule);
+    QCOMPARE(fingerprint.calculations(), 2);
+
+    // as does changing an atom
+    C1->setAtomicNumber(7);
+    fingerprint.cachedValue(&molecule);
+    QCOMPARE(fingerprint.calculations(), 3);
+
+    molecule.addAtom("O");
+    QCOMPARE(fingerprint.cachedValue(&molecule).find_first(), size_t(3));
+    QCOMPARE(fingerprint.calculations(), 4);
+
+    // fingerprints with options set are never cached
+    fingerprint.setOption("size", 8);
+    fingerprint.cachedValue(&molecule);
+    fingerprint.cachedValue(&molecule);
+    QCOMPARE(fingerprint.calculations(), 6);
+}
+
 QTEST_APPLESS_MAIN(FingerprintTest)
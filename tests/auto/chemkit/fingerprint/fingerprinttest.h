@@ -43,6 +43,7 @@ class FingerprintTest : public QObject
     Q_OBJECT
 
     private slots:
+        void cachedValue();
 };
 
 #endif // FINGERPRINTTEST_H
@@ -0,0 +1,252 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintclusteringtest.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+#include <chemkit/fingerprint.h>
+#include <chemkit/fingerprintindex.h>
+#include <chemkit/fingerprintclustering.h>
+
+namespace {
+
+// returns a bitset of size bits with about one in density bits set
+chemkit::Bitset randomBitset(size_t size, int density)
+{
+    chemkit::Bitset bitset(size);
+    for(size_t i = 0; i < size; i++){
+        if(std::rand() % density == 0){
+            bitset.set(i);
+        }
+    }
+
+    return bitset;
+}
+
+// returns a collection of fingerprints made up of groups of similar
+// fingerprints along with some random ones
+std::vector<chemkit::Bitset> randomBitsets(size_t count, size_t size)
+{
+    std::vector<chemkit::Bitset> bitsets;
+    for(size_t i = 0; i < count; i++){
+        if(i % 5 == 0 || bitsets.empty()){
+            bitsets.push_back(randomBitset(size, 2 + i % 7));
+        }
+        else{
+            // copy a recent fingerprint and flip a few bits
+            chemkit::Bitset bitset = bitsets[bitsets.size() - 1 - std::rand() % std::min(bitsets.size(), size_t(4))];
+            for(int j = 0; j < 8; j++){
+                bitset.flip(std::rand() % size);
+            }
+            bitsets.push_back(bitset);
+        }
+    }
+
+    return bitsets;
+}
+
+// returns the butina clusters calculated by scoring every pair of
+// fingerprints
+std::vector<chemkit::FingerprintClustering::Cluster> bruteForceButina(const std::vector<chemkit::Bitset> &fingerprints,
+                                                                      chemkit::Real threshold)
+{
+    size_t size = fingerprints.size();
+
+    std::vector<std::vector<std::pair<chemkit::Real, size_t> > > neighbors(size);
+    for(size_t i = 0; i < size; i++){
+        for(size_t j = 0; j < size; j++){
+            chemkit::Real coefficient = chemkit::Fingerprint::tanimotoCoefficient(fingerprints[i], fingerprints[j]);
+            if(i != j && coefficient >= threshold){
+                // sort by decreasing coefficient and then by index
+                neighbors[i].push_back(std::make_pair(-coefficient, j));
+            }
+        }
+
+        std::sort(neighbors[i].begin(), neighbors[i].end());
+    }
+
+    std::vector<std::pair<long, size_t> > order;
+    for(size_t i = 0; i < size; i++){
+        order.push_back(std::make_pair(-static_cast<long>(neighbors[i].size()), i));
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<bool> clustered(size, false);
+    std::vector<chemkit::FingerprintClustering::Cluster> clusters;
+    for(size_t i = 0; i < size; i++){
+        size_t centroid = order[i].second;
+        if(clustered[centroid]){
+            continue;
+        }
+
+        chemkit::FingerprintClustering::Cluster cluster;
+        cluster.push_back(centroid);
+        clustered[centroid] = true;
+
+        for(size_t j = 0; j < neighbors[centroid].size(); j++){
+            size_t neighbor = neighbors[centroid][j].second;
+            if(!clustered[neighbor]){
+                cluster.push_back(neighbor);
+                clustered[neighbor] = true;
+            }
+        }
+
+        clusters.push_back(cluster);
+    }
+
+    return clusters;
+}
+
+// returns the maxmin picks calculated by scoring every fingerprint
+// against each new pick
+std::vector<size_t> bruteForceMaxMin(const std::vector<chemkit::Bitset> &fingerprints,
+                                     size_t count,
+                                     size_t first)
+{
+    std::vector<chemkit::Real> similarities(fingerprints.size(), -1);
+    std::vector<bool> picked(fingerprints.size(), false);
+
+    std::vector<size_t> picks;
+    size_t pick = first;
+    for(;;){
+        picks.push_back(pick);
+        picked[pick] = true;
+
+        if(picks.size() == count){
+            break;
+        }
+
+        size_t best = fingerprints.size();
+        for(size_t i = 0; i < fingerprints.size(); i++){
+            if(picked[i]){
+                continue;
+            }
+
+            chemkit::Real coefficient = chemkit::Fingerprint::tanimotoCoefficient(fingerprints[pick], fingerprints[i]);
+            similarities[i] = std::max(similarities[i], coefficient);
+
+            if(best == fingerprints.size() || similarities[i] < similarities[best]){
+                best = i;
+            }
+        }
+
+        pick = best;
+    }
+
+    return picks;
+}
+
+} // end anonymous namespace
+
+void FingerprintClusteringTest::basic()
+{
+    chemkit::FingerprintIndex index(128);
+
+    chemkit::FingerprintClustering clustering(&index);
+    QVERIFY(clustering.index() == &index);
+    QVERIFY(clustering.threadCount() >= 1);
+    QVERIFY(clustering.butina(0.5).empty());
+    QVERIFY(clustering.maxMin(10).empty());
+
+    clustering.setThreadCount(0);
+    QCOMPARE(clustering.threadCount(), size_t(1));
+
+    index.addFingerprint(randomBitset(128, 4));
+    QCOMPARE(clustering.butina(0.5).size(), size_t(1));
+    QCOMPARE(clustering.maxMin(10).size(), size_t(1));
+    QVERIFY(clustering.maxMin(10, 1).empty());
+}
+
+void FingerprintClusteringTest::butina()
+{
+    std::srand(42);
+    std::vector<chemkit::Bitset> fingerprints = randomBitsets(300, 256);
+
+    chemkit::FingerprintIndex index(256);
+    for(size_t i = 0; i < fingerprints.size(); i++){
+        index.addFingerprint(fingerprints[i]);
+    }
+
+    for(size_t threadCount = 1; threadCount <= 4; threadCount *= 2){
+        chemkit::FingerprintClustering clustering(&index);
+        clustering.setThreadCount(threadCount);
+
+        chemkit::Real thresholds[] = { 0.6, 0.8, 1.0 };
+        for(size_t i = 0; i < 3; i++){
+            std::vector<chemkit::FingerprintClustering::Cluster> clusters = clustering.butina(thresholds[i]);
+            QVERIFY(clusters == bruteForceButina(fingerprints, thresholds[i]));
+
+            // every fingerprint is in exactly one cluster
+            std::vector<size_t> members;
+            for(size_t j = 0; j < clusters.size(); j++){
+                members.insert(members.end(), clusters[j].begin(), clusters[j].end());
+            }
+            std::sort(members.begin(), members.end());
+            QCOMPARE(members.size(), fingerprints.size());
+            for(size_t j = 0; j < members.size(); j++){
+                QCOMPARE(members[j], j);
+            }
+        }
+    }
+}
+
+void FingerprintClusteringTest::maxMin()
+{
+    std::srand(7);
+    std::vector<chemkit::Bitset> fingerprints = randomBitsets(5000, 512);
+
+    chemkit::FingerprintIndex index(512);
+    for(size_t i = 0; i < fingerprints.size(); i++){
+        index.addFingerprint(fingerprints[i]);
+    }
+
+    for(size_t threadCount = 1; threadCount <= 4; threadCount *= 2){
+        chemkit::FingerprintClustering clustering(&index);
+        clustering.setThreadCount(threadCount);
+
+        QVERIFY(clustering.maxMin(25) == bruteForceMaxMin(fingerprints, 25, 0));
+        QVERIFY(clustering.maxMin(25, 1234) == bruteForceMaxMin(fingerprints, 25, 1234));
+    }
+
+    // asking for more picks than fingerprints returns all of them
+    std::vector<size_t> picks = chemkit::FingerprintClustering(&index).maxMin(10000);
+    QCOMPARE(picks.size(), fingerprints.size());
+    std::sort(picks.begin(), picks.end());
+    QVERIFY(std::unique(picks.begin(), picks.end()) == picks.end());
+}
+
+QTEST_APPLESS_MAIN(FingerprintClusteringTest)
@@ -0,0 +1,357 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintindextest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+#include <chemkit/fingerprint.h>
+#include <chemkit/fingerprintindex.h>
+
+namespace {
+
+// returns a bitset of size bits with about one in density bits set
+chemkit::Bitset randomBitset(size_t size, int density)
+{
+    chemkit::Bitset bitset(size);
+    for(size_t i = 0; i < size; i++){
+        if(std::rand() % density == 0){
+            bitset.set(i);
+        }
+    }
+
+    return bitset;
+}
+
+// returns a collection of fingerprints with a wide range of bit counts
+std::vector<chemkit::Bitset> randomBitsets(size_t count, size_t size)
+{
+    std::vector<chemkit::Bitset> bitsets;
+    for(size_t i = 0; i < count; i++){
+        bitsets.push_back(randomBitset(size, 2 + i % 30));
+    }
+
+    return bitsets;
+}
+
+bool isBetterMatch(const chemkit::FingerprintIndex::Match &a, const chemkit::FingerprintIndex::Match &b)
+{
+    if(a.second != b.second){
+        return a.second > b.second;
+    }
+
+    return a.first < b.first;
+}
+
+// scores every fingerprint against query and returns the matches
+// sorted from most to least similar
+std::vector<chemkit::FingerprintIndex::Match> bruteForce(const chemkit::Bitset &query,
+                                                         const std::vector<chemkit::Bitset> &fingerprints,
+                                                         chemkit::Real threshold)
+{
+    std::vector<chemkit::FingerprintIndex::Match> matches;
+    for(size_t i = 0; i < fingerprints.size(); i++){
+        chemkit::Real coefficient = chemkit::Fingerprint::tanimotoCoefficient(query, fingerprints[i]);
+        if(coefficient >= threshold){
+            matches.push_back(chemkit::FingerprintIndex::Match(i, coefficient));
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), isBetterMatch);
+
+    return matches;
+}
+
+} // end anonymous namespace
+
+void FingerprintIndexTest::basic()
+{
+    chemkit::FingerprintIndex index(1021);
+    QCOMPARE(index.fingerprintSize(), size_t(1021));
+    QCOMPARE(index.size(), size_t(0));
+    QVERIFY(index.isEmpty());
+    QVERIFY(index.search(chemkit::Bitset(1021), 0.5).empty());
+    QVERIFY(index.nearest(chemkit::Bitset(1021), 5).empty());
+}
+
+void FingerprintIndexTest::addFingerprint()
+{
+    std::srand(0);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(100, 881);
+
+    chemkit::FingerprintIndex index(881);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        QCOMPARE(index.addFingerprint(bitsets[i]), i);
+    }
+    QCOMPARE(index.size(), size_t(100));
+    QVERIFY(!index.isEmpty());
+
+    // fingerprints keep their index after the index is sorted
+    index.search(bitsets[0], 0.5);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        QVERIFY(index.fingerprint(i) == bitsets[i]);
+    }
+
+    // add fingerprint from words
+    boost::uint64_t words[14] = { 0 };
+    words[0] = 0x5;
+    words[13] = ~boost::uint64_t(0);
+    QCOMPARE(index.addFingerprint(words), size_t(100));
+    chemkit::Bitset fingerprint = index.fingerprint(100);
+    QCOMPARE(fingerprint.size(), size_t(881));
+    QCOMPARE(fingerprint.count(), size_t(2 + 881 - 13 * 64));
+    QVERIFY(fingerprint[0]);
+    QVERIFY(!fingerprint[1]);
+    QVERIFY(fingerprint[2]);
+
+    index.clear();
+    QVERIFY(index.isEmpty());
+}
+
+void FingerprintIndexTest::search()
+{
+    std::srand(1);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(2000, 1021);
+
+    chemkit::FingerprintIndex index(1021);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    chemkit::Real thresholds[] = { 0.0, 0.3, 0.5, 0.7, 1.0 };
+    for(size_t i = 0; i < 20; i++){
+        const chemkit::Bitset &query = bitsets[i * 37];
+
+        for(size_t j = 0; j < 5; j++){
+            std::vector<chemkit::FingerprintIndex::Match> expected = bruteForce(query, bitsets, thresholds[j]);
+            std::vector<chemkit::FingerprintIndex::Match> matches = index.search(query, thresholds[j]);
+            QVERIFY(matches == expected);
+        }
+    }
+
+    // every fingerprint is identical to itself
+    std::vector<chemkit::FingerprintIndex::Match> matches = index.search(bitsets[5], 1.0);
+    QVERIFY(!matches.empty());
+    QCOMPARE(matches[0].first, size_t(5));
+    QCOMPARE(matches[0].second, chemkit::Real(1.0));
+
+    // empty query
+    QVERIFY(index.search(chemkit::Bitset(1021), 0.1).empty());
+    QCOMPARE(index.search(chemkit::Bitset(1021), 0.0).size(), bitsets.size());
+}
+
+void FingerprintIndexTest::neighbors()
+{
+    std::srand(5);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(1000, 512);
+
+    chemkit::FingerprintIndex index(512);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    // duplicate fingerprint
+    index.addFingerprint(bitsets[10]);
+    bitsets.push_back(bitsets[10]);
+
+    for(size_t i = 0; i < bitsets.size(); i += 13){
+        std::vector<chemkit::FingerprintIndex::Match> expected = bruteForce(bitsets[i], bitsets, 0.4);
+        for(size_t j = 0; j < expected.size(); j++){
+            if(expected[j].first == i){
+                expected.erase(expected.begin() + j);
+                break;
+            }
+        }
+
+        QVERIFY(index.neighbors(i, 0.4) == expected);
+    }
+
+    std::vector<chemkit::FingerprintIndex::Match> matches = index.neighbors(10, 1.0);
+    QCOMPARE(matches.size(), size_t(1));
+    QCOMPARE(matches[0].first, bitsets.size() - 1);
+}
+
+void FingerprintIndexTest::nearest()
+{
+    std::srand(2);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(2000, 1021);
+
+    chemkit::FingerprintIndex index(1021);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    size_t counts[] = { 1, 10, 100 };
+    for(size_t i = 0; i < 20; i++){
+        chemkit::Bitset query = randomBitset(1021, 2 + i);
+        std::vector<chemkit::FingerprintIndex::Match> all = bruteForce(query, bitsets, 0.0);
+
+        for(size_t j = 0; j < 3; j++){
+            std::vector<chemkit::FingerprintIndex::Match> expected(all.begin(), all.begin() + counts[j]);
+            std::vector<chemkit::FingerprintIndex::Match> matches = index.nearest(query, counts[j]);
+            QVERIFY(matches == expected);
+        }
+
+        // threshold limits the number of matches
+        std::vector<chemkit::FingerprintIndex::Match> expected = bruteForce(query, bitsets, 0.4);
+        if(expected.size() > 10){
+            expected.resize(10);
+        }
+        QVERIFY(index.nearest(query, 10, 0.4) == expected);
+    }
+
+    // more matches than fingerprints
+    QCOMPARE(index.nearest(bitsets[0], 5000).size(), bitsets.size());
+}
+
+void FingerprintIndexTest::batch()
+{
+    std::srand(3);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(1000, 166);
+    std::vector<chemkit::Bitset> queries = randomBitsets(50, 166);
+
+    chemkit::FingerprintIndex index(166);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    std::vector<std::vector<chemkit::FingerprintIndex::Match> > results = index.search(queries, 0.6);
+    QCOMPARE(results.size(), queries.size());
+    for(size_t i = 0; i < queries.size(); i++){
+        QVERIFY(results[i] == index.search(queries[i], 0.6));
+    }
+
+    results = index.nearest(queries, 5);
+    QCOMPARE(results.size(), queries.size());
+    for(size_t i = 0; i < queries.size(); i++){
+        QVERIFY(results[i] == index.nearest(queries[i], 5));
+    }
+}
+
+void FingerprintIndexTest::map()
+{
+    std::srand(4);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(500, 881);
+
+    chemkit::FingerprintIndex index(881);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    std::stringstream stream;
+    QVERIFY(index.write(stream));
+    std::string data = stream.str();
+    QCOMPARE(data.size() % 64, size_t(0));
+
+    // copy the data to a buffer aligned to 8 bytes
+    std::vector<boost::uint64_t> buffer(data.size() / 8);
+    std::memcpy(&buffer[0], data.data(), data.size());
+    const char *bufferData = reinterpret_cast<const char *>(&buffer[0]);
+
+    chemkit::FingerprintIndex mapped(1021);
+    QVERIFY(!mapped.map(bufferData, 32));
+    QVERIFY(!mapped.map(bufferData + 8, data.size() - 8));
+    QVERIFY(!mapped.map(bufferData, data.size() - 64));
+    QVERIFY(mapped.map(bufferData, data.size()));
+    QVERIFY(mapped.isMapped());
+    QCOMPARE(mapped.fingerprintSize(), size_t(881));
+    QCOMPARE(mapped.size(), bitsets.size());
+
+    for(size_t i = 0; i < bitsets.size(); i++){
+        QVERIFY(mapped.fingerprint(i) == bitsets[i]);
+    }
+    for(size_t i = 0; i < 10; i++){
+        QVERIFY(mapped.search(bitsets[i], 0.5) == index.search(bitsets[i], 0.5));
+        QVERIFY(mapped.nearest(bitsets[i], 5) == index.nearest(bitsets[i], 5));
+    }
+
+    // adding a fingerprint copies the mapped data
+    chemkit::Bitset bitset = randomBitset(881, 4);
+    QCOMPARE(mapped.addFingerprint(bitset), size_t(500));
+    QVERIFY(!mapped.isMapped());
+    std::memset(&buffer[0], 0, data.size());
+    QCOMPARE(mapped.size(), size_t(501));
+    QVERIFY(mapped.fingerprint(3) == bitsets[3]);
+    QCOMPARE(mapped.nearest(bitset, 1)[0].first, size_t(500));
+    QVERIFY(mapped.search(bitsets[7], 0.5) == index.search(bitsets[7], 0.5));
+}
+
+void FingerprintIndexTest::mapInvalid()
+{
+    std::srand(5);
+    std::vector<chemkit::Bitset> bitsets = randomBitsets(100, 881);
+
+    chemkit::FingerprintIndex index(881);
+    for(size_t i = 0; i < bitsets.size(); i++){
+        index.addFingerprint(bitsets[i]);
+    }
+
+    std::stringstream stream;
+    QVERIFY(index.write(stream));
+    std::string data = stream.str();
+
+    std::vector<boost::uint64_t> buffer(data.size() / 8);
+    const char *bufferData = reinterpret_cast<const char *>(&buffer[0]);
+
+    // the indices follow the 64-byte header and the offsets, which are
+    // padded to 7104 bytes for 881-bit fingerprints
+    boost::uint32_t *indices = reinterpret_cast<boost::uint32_t *>(&buffer[(64 + 7104) / 8]);
+
+    chemkit::FingerprintIndex mapped(881);
+    std::memcpy(&buffer[0], data.data(), data.size());
+    QVERIFY(mapped.map(bufferData, data.size()));
+
+    // sizes that would overflow
+    buffer[2] = ~boost::uint64_t(0);
+    QVERIFY(!mapped.map(bufferData, data.size()));
+    std::memcpy(&buffer[0], data.data(), data.size());
+    buffer[3] = boost::uint64_t(1) << 62;
+    QVERIFY(!mapped.map(bufferData, data.size()));
+
+    // index past the end
+    std::memcpy(&buffer[0], data.data(), data.size());
+    indices[5] = 100;
+    QVERIFY(!mapped.map(bufferData, data.size()));
+
+    // repeated index
+    std::memcpy(&buffer[0], data.data(), data.size());
+    indices[5] = indices[6];
+    QVERIFY(!mapped.map(bufferData, data.size()));
+}
+
+QTEST_APPLESS_MAIN(FingerprintIndexTest)
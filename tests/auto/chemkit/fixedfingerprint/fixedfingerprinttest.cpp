@@ -0,0 +1,180 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fixedfingerprinttest.h"
+
+#include <cstdlib>
+
+#include <chemkit/fingerprint.h>
+#include <chemkit/fixedfingerprint.h>
+
+namespace {
+
+// returns a bitset of size bits with about one in eight bits set
+chemkit::Bitset randomBitset(size_t size)
+{
+    chemkit::Bitset bitset(size);
+    for(size_t i = 0; i < size; i++){
+        if(std::rand() % 8 == 0){
+            bitset.set(i);
+        }
+    }
+
+    return bitset;
+}
+
+} // end anonymous namespace
+
+void FixedFingerprintTest::size()
+{
+    // fingerprints are padded to 512 bits and aligned to cache lines
+    QCOMPARE(sizeof(chemkit::Fp2FixedFingerprint), size_t(128));
+    QCOMPARE(sizeof(chemkit::PubChemFixedFingerprint), size_t(128));
+    QCOMPARE(sizeof(chemkit::FixedFingerprint<166>), size_t(64));
+    QCOMPARE(sizeof(chemkit::FixedFingerprint<2048>), size_t(256));
+
+    std::vector<chemkit::Fp2FixedFingerprint> fingerprints(3);
+    QCOMPARE(reinterpret_cast<size_t>(&fingerprints[0]) % 64, size_t(0));
+
+    chemkit::Fp2FixedFingerprint fp2;
+    QCOMPARE(fp2.size(), size_t(1021));
+    QCOMPARE(fp2.count(), size_t(0));
+    QVERIFY(fp2.isEmpty());
+
+    chemkit::PubChemFixedFingerprint pubchem;
+    QCOMPARE(pubchem.size(), size_t(881));
+}
+
+void FixedFingerprintTest::bits()
+{
+    chemkit::Fp2FixedFingerprint fingerprint;
+    fingerprint.set(0);
+    fingerprint.set(63);
+    fingerprint.set(64);
+    fingerprint.set(1020);
+    QCOMPARE(fingerprint.count(), size_t(4));
+    QVERIFY(!fingerprint.isEmpty());
+    QVERIFY(fingerprint.test(0));
+    QVERIFY(fingerprint[63]);
+    QVERIFY(fingerprint.test(64));
+    QVERIFY(!fingerprint.test(65));
+    QVERIFY(fingerprint.test(1020));
+    QCOMPARE(fingerprint.words()[0], boost::uint64_t(0x8000000000000001ULL));
+    QCOMPARE(fingerprint.words()[1], boost::uint64_t(1));
+
+    fingerprint.set(63, false);
+    QVERIFY(!fingerprint.test(63));
+    QCOMPARE(fingerprint.count(), size_t(3));
+
+    chemkit::Fp2FixedFingerprint other = fingerprint;
+    QVERIFY(other == fingerprint);
+    other.set(500);
+    QVERIFY(other != fingerprint);
+
+    fingerprint.reset();
+    QVERIFY(fingerprint.isEmpty());
+}
+
+void FixedFingerprintTest::bitset()
+{
+    std::srand(1);
+    chemkit::Bitset bitset = randomBitset(881);
+
+    chemkit::PubChemFixedFingerprint fingerprint(bitset);
+    QCOMPARE(fingerprint.count(), bitset.count());
+    QVERIFY(fingerprint.toBitset() == bitset);
+
+    // bits past the end of the fingerprint are ignored
+    chemkit::Bitset larger(1024);
+    larger.set(880);
+    larger.set(881);
+    larger.set(1023);
+    QCOMPARE(chemkit::PubChemFixedFingerprint(larger).count(), size_t(1));
+}
+
+void FixedFingerprintTest::tanimotoCoefficient()
+{
+    std::srand(2);
+
+    for(int i = 0; i < 100; i++){
+        chemkit::Bitset a = randomBitset(1021);
+        chemkit::Bitset b = randomBitset(1021);
+        chemkit::Fp2FixedFingerprint fixedA(a);
+        chemkit::Fp2FixedFingerprint fixedB(b);
+
+        QCOMPARE(chemkit::Fp2FixedFingerprint::intersectionCount(fixedA, fixedB), (a & b).count());
+        QCOMPARE(chemkit::Fp2FixedFingerprint::unionCount(fixedA, fixedB), (a | b).count());
+        QCOMPARE(chemkit::Fp2FixedFingerprint::tanimotoCoefficient(fixedA, fixedB),
+                 chemkit::Fingerprint::tanimotoCoefficient(a, b));
+    }
+
+    chemkit::Fp2FixedFingerprint a;
+    QCOMPARE(chemkit::Fp2FixedFingerprint::tanimotoCoefficient(a, a), chemkit::Real(0));
+    a.set(10);
+    QCOMPARE(chemkit::Fp2FixedFingerprint::tanimotoCoefficient(a, a), chemkit::Real(1));
+}
+
+void FixedFingerprintTest::tanimotoCoefficients()
+{
+    std::srand(3);
+
+    std::vector<chemkit::PubChemFixedFingerprint> fingerprints;
+    for(int i = 0; i < 1000; i++){
+        fingerprints.push_back(chemkit::PubChemFixedFingerprint(randomBitset(881)));
+    }
+
+    const chemkit::PubChemFixedFingerprint &query = fingerprints[42];
+    std::vector<chemkit::Real> coefficients =
+        chemkit::PubChemFixedFingerprint::tanimotoCoefficients(query, fingerprints);
+    QCOMPARE(coefficients.size(), fingerprints.size());
+    QCOMPARE(coefficients[42], chemkit::Real(1));
+
+    for(size_t i = 0; i < fingerprints.size(); i++){
+        QCOMPARE(coefficients[i], chemkit::PubChemFixedFingerprint::tanimotoCoefficient(query, fingerprints[i]));
+    }
+
+    // fingerprints with a width that is not specialized
+    std::vector<chemkit::FixedFingerprint<2048> > large(10);
+    large[3].set(2000);
+    large[5].set(2000);
+    large[5].set(7);
+    std::vector<chemkit::Real> largeCoefficients =
+        chemkit::FixedFingerprint<2048>::tanimotoCoefficients(large[3], large);
+    QCOMPARE(largeCoefficients[0], chemkit::Real(0));
+    QCOMPARE(largeCoefficients[3], chemkit::Real(1));
+    QCOMPARE(largeCoefficients[5], chemkit::Real(0.5));
+}
+
+QTEST_APPLESS_MAIN(FixedFingerprintTest)
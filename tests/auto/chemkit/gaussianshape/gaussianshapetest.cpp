@@ -0,0 +1,204 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "gaussianshapetest.h"
+
+#include <Eigen/Geometry>
+
+#include <chemkit/atom.h>
+#include <chemkit/molecule.h>
+#include <chemkit/constants.h>
+#include <chemkit/gaussianshape.h>
+
+namespace {
+
+// returns a small asymmetric shape
+chemkit::GaussianShape testShape()
+{
+    chemkit::GaussianShape shape;
+    shape.addGaussian(chemkit::Point3(0.0, 0.0, 0.0), 1.7);
+    shape.addGaussian(chemkit::Point3(1.5, 0.0, 0.0), 1.7);
+    shape.addGaussian(chemkit::Point3(2.2, 1.3, 0.0), 1.52);
+    shape.addGaussian(chemkit::Point3(-0.7, 1.2, 0.3), 1.55);
+    shape.addGaussian(chemkit::Point3(3.6, 1.4, 0.6), 1.7);
+    shape.addGaussian(chemkit::Point3(4.3, 2.5, -0.4), 1.8);
+
+    return shape;
+}
+
+} // end anonymous namespace
+
+void GaussianShapeTest::basic()
+{
+    chemkit::GaussianShape shape;
+    QCOMPARE(shape.size(), size_t(0));
+    QCOMPARE(shape.isEmpty(), true);
+    QCOMPARE(shape.volume(), chemkit::Real(0));
+
+    shape.addGaussian(chemkit::Point3(1, 2, 3), 1.5);
+    QCOMPARE(shape.size(), size_t(1));
+    QCOMPARE(shape.isEmpty(), false);
+    QVERIFY(shape.position(0).isApprox(chemkit::Point3(1, 2, 3)));
+    QCOMPARE(shape.radius(0), chemkit::Real(1.5));
+
+    chemkit::GaussianShape copy = shape;
+    QCOMPARE(copy.size(), size_t(1));
+
+    shape.clear();
+    QCOMPARE(shape.isEmpty(), true);
+    QCOMPARE(copy.size(), size_t(1));
+}
+
+void GaussianShapeTest::molecule()
+{
+    chemkit::Molecule molecule;
+    chemkit::Atom *C1 = molecule.addAtom("C");
+    chemkit::Atom *O2 = molecule.addAtom("O");
+    chemkit::Atom *H3 = molecule.addAtom("H");
+    C1->setPosition(0, 0, 0);
+    O2->setPosition(1.2, 0, 0);
+    H3->setPosition(-0.5, 0.9, 0);
+
+    // hydrogens are not included
+    chemkit::GaussianShape shape(&molecule);
+    QCOMPARE(shape.size(), size_t(2));
+    QVERIFY(shape.position(1).isApprox(O2->position()));
+    QCOMPARE(shape.radius(0), C1->vanDerWaalsRadius());
+}
+
+void GaussianShapeTest::volume()
+{
+    // the volume of a single gaussian is the volume of its sphere
+    chemkit::GaussianShape shape;
+    shape.addGaussian(chemkit::Point3(0, 0, 0), 1.7);
+
+    chemkit::Real sphereVolume = (4.0 / 3.0) * chemkit::constants::Pi * 1.7 * 1.7 * 1.7;
+    QVERIFY(qAbs(shape.volume() - sphereVolume) < 1e-6);
+
+    // gaussians far apart add their volumes
+    shape.addGaussian(chemkit::Point3(50, 0, 0), 1.7);
+    QVERIFY(qAbs(shape.volume() - 2 * sphereVolume) < 1e-6);
+
+    // the volume is the self overlap so overlapping gaussians also
+    // add the overlap between them
+    shape.addGaussian(chemkit::Point3(51, 0, 0), 1.7);
+    chemkit::GaussianShape a;
+    a.addGaussian(chemkit::Point3(50, 0, 0), 1.7);
+    chemkit::GaussianShape b;
+    b.addGaussian(chemkit::Point3(51, 0, 0), 1.7);
+    QVERIFY(a.overlap(&b) > 0);
+    QVERIFY(qAbs(shape.volume() - (3 * sphereVolume + 2 * a.overlap(&b))) < 1e-6);
+}
+
+void GaussianShapeTest::overlap()
+{
+    chemkit::GaussianShape a = testShape();
+    chemkit::GaussianShape b = testShape();
+
+    // identical shapes
+    QVERIFY(qAbs(a.overlap(&b) - a.volume()) < 1e-6);
+    QVERIFY(qAbs(a.tanimotoCoefficient(&b) - 1.0) < 1e-6);
+
+    // overlap is symmetric
+    b.transform(Eigen::Matrix<chemkit::Real, 3, 3>::Identity(), chemkit::Vector3(1.0, 0.5, 0));
+    QVERIFY(qAbs(a.overlap(&b) - b.overlap(&a)) < 1e-6);
+    QVERIFY(a.tanimotoCoefficient(&b) < 1.0);
+    QVERIFY(a.tanimotoCoefficient(&b) > 0.0);
+
+    // distant shapes do not overlap
+    b.transform(Eigen::Matrix<chemkit::Real, 3, 3>::Identity(), chemkit::Vector3(100, 0, 0));
+    QVERIFY(a.overlap(&b) < 1e-6);
+    QVERIFY(a.tanimotoCoefficient(&b) < 1e-6);
+
+    // empty shapes
+    chemkit::GaussianShape empty;
+    QCOMPARE(a.overlap(&empty), chemkit::Real(0));
+    QCOMPARE(a.tanimotoCoefficient(&empty), chemkit::Real(0));
+}
+
+void GaussianShapeTest::transform()
+{
+    chemkit::GaussianShape shape = testShape();
+    chemkit::Real volume = shape.volume();
+
+    Eigen::Matrix<chemkit::Real, 3, 3> rotation =
+        Eigen::AngleAxis<chemkit::Real>(0.8, chemkit::Vector3(1, 2, 3).normalized()).toRotationMatrix();
+    chemkit::Vector3 translation(2, -1, 4);
+
+    shape.transform(rotation, translation);
+    shape.transform(rotation.transpose(), chemkit::Vector3(1, 1, 1));
+
+    // volume does not change when the shape is moved
+    QVERIFY(qAbs(shape.volume() - volume) < 1e-6);
+
+    // the accumulated transform maps the original positions
+    chemkit::GaussianShape original = testShape();
+    for(size_t i = 0; i < shape.size(); i++){
+        chemkit::Point3 position = shape.rotationMatrix() * original.position(i) + shape.displacementVector();
+        QVERIFY(position.isApprox(shape.position(i), 1e-9));
+    }
+}
+
+void GaussianShapeTest::align()
+{
+    chemkit::GaussianShape query = testShape();
+
+    // move a copy of the shape away from the query
+    chemkit::GaussianShape shape = testShape();
+    Eigen::Matrix<chemkit::Real, 3, 3> rotation =
+        Eigen::AngleAxis<chemkit::Real>(2.1, chemkit::Vector3(-1, 0.5, 2).normalized()).toRotationMatrix();
+    shape.transform(rotation, chemkit::Vector3(3, -2, 5));
+    QVERIFY(shape.tanimotoCoefficient(&query) < 0.5);
+
+    // aligning should recover the original positions
+    chemkit::Real tanimoto = shape.align(&query);
+    QVERIFY(tanimoto > 0.99);
+    QVERIFY(qAbs(tanimoto - shape.tanimotoCoefficient(&query)) < 1e-9);
+
+    for(size_t i = 0; i < shape.size(); i++){
+        QVERIFY((shape.position(i) - query.position(i)).norm() < 0.1);
+    }
+
+    // a different shape aligns with a lower similarity
+    chemkit::GaussianShape other;
+    other.addGaussian(chemkit::Point3(0, 0, 0), 1.7);
+    other.addGaussian(chemkit::Point3(1.5, 0, 0), 1.7);
+    other.addGaussian(chemkit::Point3(2.2, 1.3, 0), 1.52);
+    tanimoto = other.align(&query);
+    QVERIFY(tanimoto > 0.3);
+    QVERIFY(tanimoto < 0.9);
+}
+
+QTEST_APPLESS_MAIN(GaussianShapeTest)
@@ -103,6 +103,7 @@ void MoleculeTest::data()
     chemkit::Molecule molecule;
     molecule.setData("boilingPoint", 38);
     QCOMPARE(molecule.data("boilingPoint").toInt(), 38);
+    QVERIFY(molecule.dataNames() == std::vector<std::string>(1, "boilingPoint"));
 }
 
 void MoleculeTest::addAtom()
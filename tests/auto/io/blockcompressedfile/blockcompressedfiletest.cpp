@@ -0,0 +1,251 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "blockcompressedfiletest.h"
+
+#include <vector>
+#include <sstream>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <chemkit/blockcompressor.h>
+#include <chemkit/decompressionsource.h>
+#include <chemkit/blockcompressedfile.h>
+
+namespace {
+
+// returns test data with a line for each of count numbers
+std::string createData(size_t count)
+{
+    std::stringstream data;
+    for(size_t i = 0; i < count; i++){
+        data << "line " << i << " " << i * i << "\n";
+    }
+
+    return data.str();
+}
+
+std::string compress(const std::string &data)
+{
+    std::stringstream output;
+
+    boost::iostreams::filtering_ostream stream;
+    stream.push(chemkit::BlockCompressor());
+    stream.push(output);
+    stream.write(data.data(), data.size());
+    stream.reset();
+
+    return output.str();
+}
+
+// writes the data to a temporary file and opens it
+bool writeFile(QTemporaryFile &tempFile, const std::string &data, chemkit::BlockCompressedFile &file)
+{
+    if(!tempFile.open()){
+        return false;
+    }
+
+    tempFile.write(data.data(), data.size());
+    tempFile.close();
+
+    return file.open(tempFile.fileName().toStdString());
+}
+
+} // end anonymous namespace
+
+void BlockCompressedFileTest::compressBlock()
+{
+    std::string data = createData(1000);
+
+    std::string block;
+    QVERIFY(chemkit::BlockCompressedFile::compressBlock(data.data(), data.size(), block));
+    QVERIFY(chemkit::BlockCompressedFile::isBlockHeader(block.data(), block.size()));
+    QCOMPARE(chemkit::BlockCompressedFile::blockSize(block.data(), block.size()), block.size());
+    QCOMPARE(chemkit::BlockCompressedFile::blockDataSize(block.data(), block.size()), data.size());
+
+    std::string output;
+    QVERIFY(chemkit::BlockCompressedFile::decompressBlocks(block.data(), block.size(), output));
+    QCOMPARE(output, data);
+
+    // blocks hold at most MaximumDataSize bytes
+    std::string large(chemkit::BlockCompressedFile::MaximumDataSize + 1, 'c');
+    QVERIFY(!chemkit::BlockCompressedFile::compressBlock(large.data(), large.size(), block));
+}
+
+void BlockCompressedFileTest::read()
+{
+    std::string data = createData(100000);
+
+    QTemporaryFile tempFile("XXXXXX.bgz");
+    chemkit::BlockCompressedFile file;
+    QVERIFY(writeFile(tempFile, compress(data), file));
+    QVERIFY(chemkit::BlockCompressedFile::isBlockCompressed(file.fileName()));
+
+    // find the start of each block's data
+    std::vector<std::pair<size_t, boost::uint64_t> > blocks;
+    size_t dataSize = 0;
+    for(boost::uint64_t offset = 0; offset < file.size(); offset += file.blockSize(offset)){
+        QVERIFY(file.blockSize(offset) > 0);
+        blocks.push_back(std::make_pair(dataSize, offset));
+        dataSize += file.blockDataSize(offset);
+    }
+    QCOMPARE(dataSize, data.size());
+    QVERIFY(blocks.size() > 10);
+
+    // read ranges within a block and across several blocks
+    size_t positions[] = { 0, 10, 65279, 65280, 100000, 500000, data.size() - 20 };
+    for(size_t i = 0; i < sizeof(positions) / sizeof(size_t); i++){
+        size_t position = positions[i];
+
+        size_t block = 0;
+        while(block + 1 < blocks.size() && blocks[block + 1].first <= position){
+            block++;
+        }
+
+        boost::uint64_t offset = chemkit::BlockCompressedFile::virtualOffset(blocks[block].second,
+                                                                             position - blocks[block].first);
+
+        std::string range;
+        size_t size = std::min(size_t(200000), data.size() - position);
+        QVERIFY(file.read(offset, size, range));
+        QCOMPARE(range, data.substr(position, size));
+    }
+
+    // reading past the end fails
+    std::string range;
+    QVERIFY(!file.read(chemkit::BlockCompressedFile::virtualOffset(blocks.back().second, 0), data.size(), range));
+}
+
+void BlockCompressedFileTest::readBlocks()
+{
+    std::string data = createData(100000);
+
+    QTemporaryFile tempFile("XXXXXX.bgz");
+    chemkit::BlockCompressedFile file;
+    QVERIFY(writeFile(tempFile, compress(data), file));
+
+    // read all of the blocks, including the empty end of file block
+    size_t blockCount = 0;
+    for(boost::uint64_t offset = 0; offset < file.size(); offset += file.blockSize(offset)){
+        blockCount++;
+    }
+    QCOMPARE(file.blockDataSize(file.size() - 28), size_t(0));
+
+    std::string output;
+    QVERIFY(file.readBlocks(0, blockCount, output));
+    QCOMPARE(output, data);
+
+    // read the blocks after the first
+    output.clear();
+    QVERIFY(file.readBlocks(file.blockSize(0), blockCount - 1, output));
+    QCOMPARE(output, data.substr(file.blockDataSize(0)));
+
+    QVERIFY(!file.readBlocks(0, blockCount + 1, output));
+}
+
+void BlockCompressedFileTest::gzipCompatible()
+{
+    std::string data = createData(20000);
+    std::string compressed = compress(data);
+
+    // block compressed data can be read as a regular gzip stream
+    std::stringstream input(compressed);
+    boost::iostreams::filtering_istream gzipStream;
+    gzipStream.push(boost::iostreams::gzip_decompressor());
+    gzipStream.push(input);
+
+    std::stringstream gzipOutput;
+    boost::iostreams::copy(gzipStream, gzipOutput);
+    QCOMPARE(gzipOutput.str(), data);
+
+    // the decompression source detects the blocks
+    std::stringstream blockInput(compressed);
+    boost::iostreams::filtering_istream blockStream;
+    blockStream.push(chemkit::DecompressionSource(blockInput, "gz", 1000, 3));
+
+    std::stringstream blockOutput;
+    blockOutput << blockStream.rdbuf();
+    QCOMPARE(blockOutput.str(), data);
+}
+
+void BlockCompressedFileTest::invalid()
+{
+    // regular gzip files are not block compressed
+    std::stringstream output;
+    boost::iostreams::filtering_ostream stream;
+    stream.push(boost::iostreams::gzip_compressor());
+    stream.push(output);
+    stream << createData(100);
+    stream.reset();
+
+    QTemporaryFile tempFile("XXXXXX.gz");
+    chemkit::BlockCompressedFile file;
+    QVERIFY(!writeFile(tempFile, output.str(), file));
+    QVERIFY(!file.isOpen());
+    QVERIFY(!chemkit::BlockCompressedFile::isBlockCompressed(tempFile.fileName().toStdString()));
+
+    // corrupted blocks fail to decompress
+    std::string data = compress(createData(100));
+    data[30] = ~data[30];
+
+    std::string decompressed;
+    QVERIFY(!chemkit::BlockCompressedFile::decompressBlocks(data.data(), data.size(), decompressed));
+    QVERIFY(decompressed.empty());
+
+    // uncompressed sizes larger than a block are rejected before
+    // any memory is allocated for them
+    std::string block;
+    std::string blockData = createData(100);
+    QVERIFY(chemkit::BlockCompressedFile::compressBlock(blockData.data(), blockData.size(), block));
+
+    std::string huge = block;
+    huge.replace(huge.size() - 4, 4, std::string(4, static_cast<char>(0xff)));
+    QCOMPARE(chemkit::BlockCompressedFile::blockSize(huge.data(), huge.size()), size_t(0));
+    QVERIFY(!chemkit::BlockCompressedFile::decompressBlocks(huge.data(), huge.size(), decompressed));
+    QVERIFY(decompressed.empty());
+
+    // the inflated data must match the uncompressed size exactly
+    std::string small = block;
+    small[small.size() - 4] = static_cast<char>(blockData.size() - 1);
+    QVERIFY(!chemkit::BlockCompressedFile::decompressBlocks(small.data(), small.size(), decompressed));
+    QVERIFY(decompressed.empty());
+
+    QVERIFY(chemkit::BlockCompressedFile::decompressBlocks(block.data(), block.size(), decompressed));
+    QCOMPARE(decompressed, blockData);
+}
+
+QTEST_APPLESS_MAIN(BlockCompressedFileTest)
@@ -0,0 +1,152 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "decompressionsourcetest.h"
+
+#include <sstream>
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <chemkit/decompressionsource.h>
+
+namespace {
+
+// returns test data with a line for each of count numbers
+std::string createData(size_t count)
+{
+    std::stringstream data;
+    for(size_t i = 0; i < count; i++){
+        data << "line " << i << " " << i * i << "\n";
+    }
+
+    return data.str();
+}
+
+std::string compress(const std::string &data, const std::string &format)
+{
+    std::stringstream input(data);
+    std::stringstream output;
+
+    boost::iostreams::filtering_ostream stream;
+    if(format == "gz"){
+        stream.push(boost::iostreams::gzip_compressor());
+    }
+    else{
+        stream.push(boost::iostreams::bzip2_compressor());
+    }
+    stream.push(output);
+
+    boost::iostreams::copy(input, stream);
+
+    return output.str();
+}
+
+// decompresses data using small buffers so that the ring of buffers
+// wraps around many times
+std::string decompress(const std::string &data, const std::string &format)
+{
+    std::stringstream input(data);
+
+    boost::iostreams::filtering_istream stream;
+    stream.push(chemkit::DecompressionSource(input, format, 1000, 3));
+
+    std::stringstream output;
+    output << stream.rdbuf();
+
+    return output.str();
+}
+
+} // end anonymous namespace
+
+void DecompressionSourceTest::gzip()
+{
+    QVERIFY(chemkit::DecompressionSource::isSupported("gz"));
+
+    std::string data = createData(10000);
+    QCOMPARE(decompress(compress(data, "gz"), "gz"), data);
+}
+
+void DecompressionSourceTest::bzip2()
+{
+    QVERIFY(chemkit::DecompressionSource::isSupported("bz2"));
+
+    std::string data = createData(10000);
+    QCOMPARE(decompress(compress(data, "bz2"), "bz2"), data);
+}
+
+void DecompressionSourceTest::multipleMembers()
+{
+    std::string first = createData(500);
+    std::string second = createData(2000);
+
+    // concatenated compressed members decompress to the concatenated data
+    QCOMPARE(decompress(compress(first, "gz") + compress(second, "gz"), "gz"), first + second);
+    QCOMPARE(decompress(compress(first, "bz2") + compress(second, "bz2"), "bz2"), first + second);
+}
+
+void DecompressionSourceTest::invalid()
+{
+    QVERIFY(!chemkit::DecompressionSource::isSupported("zip"));
+
+    std::stringstream input("this is not compressed data");
+    boost::iostreams::filtering_istream stream;
+    stream.push(chemkit::DecompressionSource(input, "gz"));
+
+    std::string line;
+    std::getline(stream, line);
+    QVERIFY(stream.bad() || stream.fail());
+}
+
+void DecompressionSourceTest::destroy()
+{
+    std::string data = compress(createData(100000), "gz");
+
+    // destroying the source while the decompression thread is waiting
+    // for a free buffer stops the thread
+    for(int i = 0; i < 10; i++){
+        std::stringstream input(data);
+        boost::iostreams::filtering_istream stream;
+        stream.push(chemkit::DecompressionSource(input, "gz", 100, 2));
+
+        std::string line;
+        std::getline(stream, line);
+        QCOMPARE(line, std::string("line 0 0"));
+    }
+}
+
+QTEST_APPLESS_MAIN(DecompressionSourceTest)
@@ -0,0 +1,266 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintdatabasetest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <fstream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <chemkit/fingerprintindex.h>
+#include <chemkit/fingerprintdatabase.h>
+
+namespace {
+
+const char fpsData[] =
+    "#FPS1\n"
+    "#num_bits=16\n"
+    "#type=Example/1\n"
+    "#software=chemkit\n"
+    "0100\tfirst\n"
+    "ff80\tsecond\textra\n"
+    "\n"
+    "0000\tthird\r\n";
+
+// returns a bitset of size bits with about one in eight bits set
+chemkit::Bitset randomBitset(size_t size)
+{
+    chemkit::Bitset bitset(size);
+    for(size_t i = 0; i < size; i++){
+        if(std::rand() % 8 == 0){
+            bitset.set(i);
+        }
+    }
+
+    return bitset;
+}
+
+} // end anonymous namespace
+
+void FingerprintDatabaseTest::basic()
+{
+    chemkit::FingerprintDatabase database;
+    QVERIFY(database.isEmpty());
+    QCOMPARE(database.size(), size_t(0));
+    QVERIFY(!database.isMapped());
+
+    chemkit::Bitset fingerprint(166);
+    fingerprint.set(3);
+    QCOMPARE(database.addFingerprint(fingerprint, "methane"), size_t(0));
+    QCOMPARE(database.addFingerprint(chemkit::Bitset(166), "ethane"), size_t(1));
+    QCOMPARE(database.size(), size_t(2));
+    QCOMPARE(database.fingerprintSize(), size_t(166));
+    QCOMPARE(database.name(1), std::string("ethane"));
+    QVERIFY(database.fingerprint(0) == fingerprint);
+    QCOMPARE(database.index()->size(), size_t(2));
+
+    database.setType("Example/1");
+    QCOMPARE(database.type(), std::string("Example/1"));
+
+    database.clear();
+    QVERIFY(database.isEmpty());
+}
+
+void FingerprintDatabaseTest::readFps()
+{
+    chemkit::FingerprintDatabase database;
+    std::stringstream input(fpsData);
+    QVERIFY(database.readFps(input));
+    QCOMPARE(database.size(), size_t(3));
+    QCOMPARE(database.fingerprintSize(), size_t(16));
+    QCOMPARE(database.type(), std::string("Example/1"));
+    QCOMPARE(database.name(0), std::string("first"));
+    QCOMPARE(database.name(1), std::string("second"));
+    QCOMPARE(database.name(2), std::string("third"));
+
+    // the first byte holds the first eight bits
+    chemkit::Bitset first = database.fingerprint(0);
+    QCOMPARE(first.count(), size_t(1));
+    QVERIFY(first[0]);
+
+    chemkit::Bitset second = database.fingerprint(1);
+    QCOMPARE(second.count(), size_t(9));
+    QVERIFY(second[7]);
+    QVERIFY(second[15]);
+    QVERIFY(!second[8]);
+
+    QCOMPARE(database.fingerprint(2).count(), size_t(0));
+
+    // the size is taken from the fingerprints without a header
+    chemkit::FingerprintDatabase headerless;
+    std::stringstream headerlessInput("0f0f0f\tone\nf0f0f0\ttwo\n");
+    QVERIFY(headerless.readFps(headerlessInput));
+    QCOMPARE(headerless.size(), size_t(2));
+    QCOMPARE(headerless.fingerprintSize(), size_t(24));
+    QCOMPARE(headerless.fingerprint(1).count(), size_t(12));
+}
+
+void FingerprintDatabaseTest::writeFps()
+{
+    chemkit::FingerprintDatabase database;
+    std::stringstream input(fpsData);
+    QVERIFY(database.readFps(input));
+
+    std::stringstream output;
+    QVERIFY(database.writeFps(output));
+
+    std::string fps = output.str();
+    QVERIFY(fps.find("#FPS1\n#num_bits=16\n#type=Example/1\n") == 0);
+    QVERIFY(fps.find("\n0100\tfirst\nff80\tsecond\n0000\tthird\n") != std::string::npos);
+
+    chemkit::FingerprintDatabase copy;
+    std::stringstream copyInput(fps);
+    QVERIFY(copy.readFps(copyInput));
+    QCOMPARE(copy.size(), size_t(3));
+    for(size_t i = 0; i < copy.size(); i++){
+        QVERIFY(copy.fingerprint(i) == database.fingerprint(i));
+        QCOMPARE(copy.name(i), database.name(i));
+    }
+}
+
+void FingerprintDatabaseTest::readWrite()
+{
+    std::srand(0);
+
+    chemkit::FingerprintDatabase database;
+    database.setType("chemkit-FP2/1");
+    for(size_t i = 0; i < 1000; i++){
+        database.addFingerprint(randomBitset(1021), "molecule" + boost::lexical_cast<std::string>(i));
+    }
+
+    std::string fileName = "fingerprintdatabasetest.fpdb";
+    QVERIFY(database.write(fileName));
+
+    // binary files are mapped and searched in place
+    chemkit::FingerprintDatabase mapped(fileName);
+    QVERIFY(mapped.read());
+    QVERIFY(mapped.isMapped());
+    QVERIFY(mapped.index()->isMapped());
+    QCOMPARE(mapped.size(), size_t(1000));
+    QCOMPARE(mapped.fingerprintSize(), size_t(1021));
+    QCOMPARE(mapped.type(), std::string("chemkit-FP2/1"));
+    QCOMPARE(mapped.name(0), std::string("molecule0"));
+    QCOMPARE(mapped.name(999), std::string("molecule999"));
+
+    for(size_t i = 0; i < 1000; i += 97){
+        QVERIFY(mapped.fingerprint(i) == database.fingerprint(i));
+
+        chemkit::Bitset query = database.fingerprint(i);
+        QVERIFY(mapped.index()->search(query, 0.3) == database.index()->search(query, 0.3));
+        QVERIFY(mapped.index()->nearest(query, 3) == database.index()->nearest(query, 3));
+    }
+
+    // adding a fingerprint loads the database into memory
+    QCOMPARE(mapped.addFingerprint(randomBitset(1021), "extra"), size_t(1000));
+    QVERIFY(!mapped.isMapped());
+    QCOMPARE(mapped.name(500), std::string("molecule500"));
+    QCOMPARE(mapped.name(1000), std::string("extra"));
+
+    // fps files are chosen by extension
+    std::string fpsFileName = "fingerprintdatabasetest.fps";
+    QVERIFY(mapped.write(fpsFileName));
+
+    chemkit::FingerprintDatabase fps;
+    QVERIFY(fps.read(fpsFileName));
+    QVERIFY(!fps.isMapped());
+    QCOMPARE(fps.size(), size_t(1001));
+    QCOMPARE(fps.type(), std::string("chemkit-FP2/1"));
+    QCOMPARE(fps.name(1000), std::string("extra"));
+    QVERIFY(fps.fingerprint(123) == database.fingerprint(123));
+
+    std::remove(fileName.c_str());
+    std::remove(fpsFileName.c_str());
+
+    QVERIFY(!fps.read(fileName));
+    QVERIFY(fps.isEmpty());
+}
+
+void FingerprintDatabaseTest::invalid()
+{
+    chemkit::FingerprintDatabase database;
+
+    std::stringstream badHex("#FPS1\n#num_bits=16\n01zz\tfirst\n");
+    QVERIFY(!database.readFps(badHex));
+    QVERIFY(!database.errorString().empty());
+
+    std::stringstream badSize("#FPS1\n#num_bits=16\n010203\tfirst\n");
+    QVERIFY(!database.readFps(badSize));
+
+    std::stringstream badBits("#FPS1\n#num_bits=-16\n0102\tfirst\n");
+    QVERIFY(!database.readFps(badBits));
+
+    std::stringstream textBits("#FPS1\n#num_bits=many\n0102\tfirst\n");
+    QVERIFY(!database.readFps(textBits));
+
+    // truncated binary file
+    chemkit::FingerprintDatabase valid;
+    valid.addFingerprint(randomBitset(881), "one");
+    std::string fileName = "fingerprintdatabasetest_invalid.fpdb";
+    QVERIFY(valid.write(fileName));
+
+    std::ifstream file(fileName.c_str(), std::ios_base::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    std::ofstream truncated(fileName.c_str(), std::ios_base::binary);
+    truncated.write(data.data(), data.size() / 2);
+    truncated.close();
+
+    QVERIFY(!database.read(fileName));
+    QVERIFY(database.isEmpty());
+    QVERIFY(!database.isMapped());
+
+    // section offsets which wrap around when added to their sizes
+    for(size_t field = 16; field <= 48; field += 16){
+        std::string corrupt = data;
+        for(size_t i = 0; i < 8; i++){
+            corrupt[field + i] = static_cast<char>(i == 0 ? 0xc0 : 0xff);
+        }
+
+        std::ofstream output(fileName.c_str(), std::ios_base::binary);
+        output.write(corrupt.data(), corrupt.size());
+        output.close();
+
+        QVERIFY(!database.read(fileName));
+        QVERIFY(database.isEmpty());
+    }
+
+    std::remove(fileName.c_str());
+}
+
+QTEST_APPLESS_MAIN(FingerprintDatabaseTest)
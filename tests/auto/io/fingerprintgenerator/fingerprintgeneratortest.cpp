@@ -0,0 +1,196 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "fingerprintgeneratortest.h"
+
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <chemkit/foreach.h>
+#include <chemkit/molecule.h>
+#include <chemkit/fingerprint.h>
+#include <chemkit/moleculefile.h>
+#include <chemkit/fingerprintgenerator.h>
+
+namespace {
+
+const char *smiles[] = {
+    "c1ccccc1",
+    "O=C1NC=CC(=O)N1",
+    "CC(=O)Oc1ccccc1C(=O)O",
+    "CN1C=NC2=C1C(=O)N(C(=O)N2C)C",
+    "C1CCCCC1",
+    "CCO",
+    "N[C@@H](C)C(=O)O",
+    "c1ccc2ccccc2c1"
+};
+
+const size_t smilesCount = sizeof(smiles) / sizeof(*smiles);
+
+std::vector<boost::shared_ptr<chemkit::Molecule> > createMolecules()
+{
+    std::vector<boost::shared_ptr<chemkit::Molecule> > molecules;
+
+    // repeat the molecules so that there are several blocks per thread
+    for(size_t i = 0; i < 64; i++){
+        molecules.push_back(boost::shared_ptr<chemkit::Molecule>(
+            new chemkit::Molecule(smiles[i % smilesCount], "smiles")));
+    }
+
+    return molecules;
+}
+
+void appendMolecule(std::vector<boost::shared_ptr<chemkit::Molecule> > &molecules,
+                    const boost::shared_ptr<chemkit::Molecule> &molecule)
+{
+    molecules.push_back(molecule);
+}
+
+} // end anonymous namespace
+
+void FingerprintGeneratorTest::basic()
+{
+    chemkit::FingerprintGenerator generator;
+    QVERIFY(generator.fingerprints().empty());
+    QVERIFY(generator.threadCount() >= 1);
+    QCOMPARE(generator.batchSize(), size_t(1024));
+
+    generator.addFingerprint("fp2");
+    generator.addFingerprint("ecfp");
+    QCOMPARE(generator.fingerprints().size(), size_t(2));
+    QCOMPARE(generator.fingerprints()[0], std::string("fp2"));
+    QCOMPARE(generator.fingerprints()[1], std::string("ecfp"));
+
+    generator.setThreadCount(0);
+    QCOMPARE(generator.threadCount(), size_t(1));
+    generator.setBatchSize(16);
+    QCOMPARE(generator.batchSize(), size_t(16));
+}
+
+void FingerprintGeneratorTest::generate()
+{
+    std::vector<std::string> names;
+    names.push_back("fp2");
+    names.push_back("ecfp");
+
+    boost::scoped_ptr<chemkit::Fingerprint> fp2(chemkit::Fingerprint::create("fp2"));
+    boost::scoped_ptr<chemkit::Fingerprint> ecfp(chemkit::Fingerprint::create("ecfp"));
+    QVERIFY(fp2 != 0);
+    QVERIFY(ecfp != 0);
+
+    for(size_t threadCount = 1; threadCount <= 4; threadCount *= 2){
+        std::vector<boost::shared_ptr<chemkit::Molecule> > molecules = createMolecules();
+
+        chemkit::FingerprintGenerator generator(names);
+        generator.setThreadCount(threadCount);
+        QVERIFY(generator.generate(molecules));
+
+        foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, molecules){
+            QVERIFY(molecule->fingerprint("fp2") == fp2->value(molecule.get()));
+            QVERIFY(molecule->fingerprint("ecfp") == ecfp->value(molecule.get()));
+        }
+    }
+
+    // empty list of molecules
+    chemkit::FingerprintGenerator generator("fp2");
+    QVERIFY(generator.generate(std::vector<boost::shared_ptr<chemkit::Molecule> >()));
+}
+
+void FingerprintGeneratorTest::stream()
+{
+    std::stringstream input;
+    for(size_t i = 0; i < 50; i++){
+        input << smiles[i % smilesCount] << "\n";
+    }
+
+    chemkit::MoleculeFile file;
+    QVERIFY(file.setFormat("smi"));
+    QVERIFY(file.open(input));
+
+    chemkit::FingerprintGenerator generator("ecfp");
+    generator.setBatchSize(16);
+
+    std::vector<boost::shared_ptr<chemkit::Molecule> > molecules;
+    QVERIFY(generator.generate(&file, boost::bind(appendMolecule, boost::ref(molecules), _1)));
+    QCOMPARE(molecules.size(), size_t(50));
+
+    // molecules are passed to the callback in the order they were read
+    boost::scoped_ptr<chemkit::Fingerprint> ecfp(chemkit::Fingerprint::create("ecfp"));
+    for(size_t i = 0; i < molecules.size(); i++){
+        chemkit::Molecule molecule(smiles[i % smilesCount], "smiles");
+        QVERIFY(molecules[i]->fingerprint("ecfp") == ecfp->value(&molecule));
+    }
+}
+
+void FingerprintGeneratorTest::invalid()
+{
+    std::vector<boost::shared_ptr<chemkit::Molecule> > molecules = createMolecules();
+
+    chemkit::FingerprintGenerator generator("fp2");
+    generator.addFingerprint("invalid_fingerprint");
+    QVERIFY(!generator.generate(molecules));
+    QVERIFY(!generator.errorString().empty());
+
+    chemkit::MoleculeFile file("invalid_file.smi");
+    QVERIFY(!generator.generate(&file, chemkit::FingerprintGenerator::Callback()));
+    QVERIFY(!generator.errorString().empty());
+
+    // a malformed record after the first molecule is an error rather
+    // than the end of the file
+    const char waterBlock[] =
+        "water\n\n\n"
+        "  3  2  0  0  0  0  0  0  0  0999 V2000\n"
+        "    0.0000    0.0000    0.0000 O   0  0  0  0  0  0  0  0  0  0  0  0\n"
+        "    0.9572    0.0000    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+        "   -0.2400    0.9266    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+        "  1  2  1  0  0  0  0\n"
+        "  1  3  1  0  0  0  0\n";
+
+    std::stringstream truncatedInput;
+    truncatedInput << waterBlock << "M  END\n$$$$\n" << waterBlock;
+
+    chemkit::MoleculeFile truncatedFile;
+    QVERIFY(truncatedFile.setFormat("sdf"));
+    QVERIFY(truncatedFile.open(truncatedInput));
+
+    chemkit::FingerprintGenerator fp2("fp2");
+    std::vector<boost::shared_ptr<chemkit::Molecule> > read;
+    QVERIFY(!fp2.generate(&truncatedFile, boost::bind(appendMolecule, boost::ref(read), _1)));
+    QVERIFY(!fp2.errorString().empty());
+}
+
+QTEST_APPLESS_MAIN(FingerprintGeneratorTest)
@@ -0,0 +1,155 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#include "linetokenizertest.h"
+
+#include <cstdlib>
+
+#include <chemkit/linetokenizer.h>
+
+void LineTokenizerTest::nextToken()
+{
+    std::string line = "  ATOM\t1  C1 \r";
+    chemkit::LineTokenizer tokenizer(line);
+    QVERIFY(!tokenizer.atEnd());
+    QVERIFY(tokenizer.nextToken() == "ATOM");
+    QVERIFY(tokenizer.nextToken() == "1");
+    QVERIFY(tokenizer.nextToken() == "C1");
+    QVERIFY(tokenizer.atEnd());
+    QVERIFY(tokenizer.nextToken().empty());
+
+    tokenizer.setPosition(7);
+    QVERIFY(tokenizer.nextToken() == "1");
+
+    tokenizer.setLine(std::string());
+    QVERIFY(tokenizer.atEnd());
+    QVERIFY(tokenizer.nextToken().empty());
+}
+
+void LineTokenizerTest::tokenize()
+{
+    std::string line = "1 C1 -1.25 0.5e1 C.ar";
+    chemkit::LineTokenizer tokenizer(line);
+
+    std::vector<boost::string_ref> tokens;
+    QCOMPARE(tokenizer.tokenize(tokens), size_t(5));
+    QVERIFY(tokens[0] == "1");
+    QVERIFY(tokens[2] == "-1.25");
+    QVERIFY(tokens[4] == "C.ar");
+
+    // tokens after the current position only
+    tokenizer.setPosition(5);
+    QCOMPARE(tokenizer.tokenize(tokens), size_t(3));
+    QVERIFY(tokens[0] == "-1.25");
+}
+
+void LineTokenizerTest::column()
+{
+    std::string line = "ATOM      1  N   MET A   1      27.340  24.430   2.614";
+    chemkit::LineTokenizer tokenizer(line);
+    QVERIFY(tokenizer.column(0, 6) == "ATOM");
+    QVERIFY(tokenizer.column(17, 3) == "MET");
+
+    int id = 0;
+    QVERIFY(tokenizer.columnInteger(6, 5, &id));
+    QCOMPARE(id, 1);
+
+    chemkit::Real x = 0, y = 0, z = 0;
+    QVERIFY(tokenizer.columnReal(30, 8, &x));
+    QVERIFY(tokenizer.columnReal(38, 8, &y));
+    QVERIFY(tokenizer.columnReal(46, 8, &z));
+    QCOMPARE(x, chemkit::Real(27.340));
+    QCOMPARE(y, chemkit::Real(24.430));
+    QCOMPARE(z, chemkit::Real(2.614));
+
+    // columns past the end of the line are clipped
+    QVERIFY(tokenizer.column(46, 20) == "2.614");
+    QVERIFY(tokenizer.column(80, 2).empty());
+    QVERIFY(!tokenizer.columnReal(80, 8, &x));
+}
+
+void LineTokenizerTest::parseInteger()
+{
+    int value = 0;
+    QVERIFY(chemkit::LineTokenizer::parseInteger("42", &value));
+    QCOMPARE(value, 42);
+    QVERIFY(chemkit::LineTokenizer::parseInteger("  -7 ", &value));
+    QCOMPARE(value, -7);
+    QVERIFY(chemkit::LineTokenizer::parseInteger("+3", &value));
+    QCOMPARE(value, 3);
+    QVERIFY(chemkit::LineTokenizer::parseInteger("-2147483648", &value));
+    QCOMPARE(value, -2147483647 - 1);
+
+    value = 5;
+    QVERIFY(!chemkit::LineTokenizer::parseInteger("", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseInteger("-", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseInteger("12a", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseInteger("1.0", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseInteger("2147483648", &value));
+    QCOMPARE(value, 5);
+}
+
+void LineTokenizerTest::parseReal()
+{
+    const char *numbers[] = {
+        "0", "-0.0", "1.5", "-27.340", "+.5", "5.", "0.1", "1e3",
+        "1.25E-4", "-6.02214e+23", "123456789.123456789",
+        "0.000000000000000000000000000001", "1.7976931348623157e308"
+    };
+
+    for(size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); i++){
+        chemkit::Real value = 0;
+        QVERIFY(chemkit::LineTokenizer::parseReal(numbers[i], &value));
+
+        // results must be identical to strtod()
+        QVERIFY(value == std::strtod(numbers[i], 0));
+    }
+
+    chemkit::Real value = 2;
+    QVERIFY(chemkit::LineTokenizer::parseReal(" 3.5\t", &value));
+    QCOMPARE(value, chemkit::Real(3.5));
+
+    value = 2;
+    QVERIFY(!chemkit::LineTokenizer::parseReal("", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseReal(".", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseReal("-", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseReal("1e", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseReal("1.0x", &value));
+    QVERIFY(!chemkit::LineTokenizer::parseReal("1,5", &value));
+    QCOMPARE(value, chemkit::Real(2));
+}
+
+QTEST_APPLESS_MAIN(LineTokenizerTest)
@@ -0,0 +1,190 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "moleculefileindextest.h"
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <iterator>
+
+#include <boost/lexical_cast.hpp>
+
+#include <chemkit/moleculefileindex.h>
+
+namespace {
+
+std::string readFile(const std::string &fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+
+    return std::string((std::istreambuf_iterator<char>(file)),
+                       std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string &fileName, const std::string &data)
+{
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    file.write(data.data(), data.size());
+}
+
+void setUInt64(std::string &data, size_t offset, boost::uint64_t value)
+{
+    for(int i = 0; i < 8; i++){
+        data[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+} // end anonymous namespace
+
+void MoleculeFileIndexTest::basic()
+{
+    chemkit::MoleculeFileIndex index;
+    QVERIFY(index.isEmpty());
+    QCOMPARE(index.size(), size_t(0));
+    QCOMPARE(index.find("ethanol"), size_t(0));
+
+    index.addRecord(0, 120, "methanol");
+    index.addRecord(120, 200, "ethanol");
+    QVERIFY(!index.isEmpty());
+    QCOMPARE(index.size(), size_t(2));
+    QCOMPARE(index.offset(1), boost::uint64_t(120));
+    QCOMPARE(index.length(1), boost::uint64_t(200));
+    QCOMPARE(index.name(0), std::string("methanol"));
+
+    index.clear();
+    QVERIFY(index.isEmpty());
+}
+
+void MoleculeFileIndexTest::find()
+{
+    chemkit::MoleculeFileIndex index;
+
+    for(size_t i = 0; i < 1000; i++){
+        index.addRecord(i * 10, 10, "molecule" + boost::lexical_cast<std::string>(i));
+    }
+
+    // duplicate names return the first record
+    index.addRecord(10000, 10, "molecule500");
+    index.addRecord(10010, 10, "");
+
+    QCOMPARE(index.size(), size_t(1002));
+    QCOMPARE(index.find("molecule0"), size_t(0));
+    QCOMPARE(index.find("molecule500"), size_t(500));
+    QCOMPARE(index.find("molecule999"), size_t(999));
+    QCOMPARE(index.find(""), size_t(1001));
+    QCOMPARE(index.find("molecule1000"), index.size());
+}
+
+void MoleculeFileIndexTest::readWrite()
+{
+    chemkit::MoleculeFileIndex index;
+    index.setFileSize(12345);
+    index.setFileTime(67890);
+    index.addRecord(0, 5000, "benzene");
+    index.addRecord(5000, 7345, "toluene");
+
+    std::string fileName = "moleculefileindextest.index";
+    QVERIFY(index.write(fileName));
+
+    chemkit::MoleculeFileIndex copy;
+    QVERIFY(copy.read(fileName));
+    QCOMPARE(copy.size(), size_t(2));
+    QCOMPARE(copy.fileSize(), boost::uint64_t(12345));
+    QCOMPARE(copy.fileTime(), boost::uint64_t(67890));
+    QCOMPARE(copy.offset(1), boost::uint64_t(5000));
+    QCOMPARE(copy.length(1), boost::uint64_t(7345));
+    QCOMPARE(copy.name(1), std::string("toluene"));
+    QCOMPARE(copy.find("benzene"), size_t(0));
+    QCOMPARE(copy.find("toluene"), size_t(1));
+
+    std::remove(fileName.c_str());
+
+    // missing files are not valid indexes
+    QVERIFY(!copy.read(fileName));
+    QVERIFY(copy.isEmpty());
+}
+
+void MoleculeFileIndexTest::invalid()
+{
+    chemkit::MoleculeFileIndex index;
+    index.addRecord(0, 5000, "benzene");
+
+    std::string fileName = "moleculefileindextest-invalid.index";
+    QVERIFY(index.write(fileName));
+    std::string data = readFile(fileName);
+
+    // header is 48 bytes followed by one 28 byte record and 16 buckets
+    QCOMPARE(data.size(), size_t(48 + 28 + 16 * 4 + 7));
+
+    // a full hash table would make find() probe forever
+    std::string full = data;
+    for(size_t i = 0; i < 16; i++){
+        full.replace(48 + 28 + i * 4, 4, std::string(4, '\0'));
+    }
+    writeFile(fileName, full);
+
+    chemkit::MoleculeFileIndex copy;
+    QVERIFY(!copy.read(fileName));
+    QVERIFY(copy.isEmpty());
+
+    // bucket count which overflows the file size calculation
+    std::string overflow = data;
+    setUInt64(overflow, 32, boost::uint64_t(1) << 62);
+    writeFile(fileName, overflow);
+    QVERIFY(!copy.read(fileName));
+
+    // bucket count equal to the record count
+    std::string small = data;
+    setUInt64(small, 32, 1);
+    small.erase(48 + 28 + 4, 15 * 4);
+    writeFile(fileName, small);
+    QVERIFY(!copy.read(fileName));
+
+    // name offset which wraps around when added to the name length
+    std::string wrapped = data;
+    setUInt64(wrapped, 48 + 16, ~boost::uint64_t(0));
+    writeFile(fileName, wrapped);
+    QVERIFY(!copy.read(fileName));
+
+    // the original data is still valid
+    writeFile(fileName, data);
+    QVERIFY(copy.read(fileName));
+    QCOMPARE(copy.find("toluene"), size_t(1));
+
+    std::remove(fileName.c_str());
+}
+
+QTEST_APPLESS_MAIN(MoleculeFileIndexTest)
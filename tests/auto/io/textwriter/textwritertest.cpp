@@ -0,0 +1,200 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "textwritertest.h"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+#include <chemkit/textwriter.h>
+
+namespace {
+
+// values with many digits, rounding ties and the edges of the
+// directly formatted ranges
+const double values[] = {
+    0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 1.5, 2.5, 0.125, 0.00005,
+    -0.00001, 0.1, 0.2, 0.3, 1.2345, 1.23456, -1.23455, 9.99995,
+    99.99995, 999.99995, 9999.5, 0.00099999, 0.0001, 0.00001,
+    123456.789, 214748.3647, 214748.3648, 1e10, -1e15, 1e20, 1e-20,
+    6.02214e23, 3.14159265358979, -2.71828182845905, 1.0 / 3.0,
+    std::numeric_limits<double>::max(), std::numeric_limits<double>::min(),
+    std::numeric_limits<double>::denorm_min()
+};
+
+const size_t valueCount = sizeof(values) / sizeof(*values);
+
+// returns pseudo-random coordinates and charges in [-range, range]
+double randomValue(unsigned int *state, double range)
+{
+    *state = *state * 1103515245 + 12345;
+    return ((*state >> 8) / double(1 << 24) * 2 - 1) * range;
+}
+
+std::string printed(const char *format, int width, int precision, double value)
+{
+    char buffer[512];
+    snprintf(buffer, sizeof(buffer), format, width, precision, value);
+    return buffer;
+}
+
+std::string written(bool general, int width, int precision, double value)
+{
+    std::stringstream stream;
+    chemkit::TextWriter writer(stream);
+    if(general){
+        writer.writeGeneral(value, precision, width);
+    }
+    else{
+        writer.writeFixed(value, precision, width);
+    }
+    writer.flush();
+
+    return stream.str();
+}
+
+} // end anonymous namespace
+
+void TextWriterTest::write()
+{
+    std::stringstream stream;
+    chemkit::TextWriter writer(stream);
+    writer.write("@<TRIPOS>");
+    writer.write(std::string("ATOM"));
+    writer.write('\n');
+    writer.write("C.ar ", 1);
+    writer.writePadded("C", 3);
+    writer.writePadded("Cl", 1);
+    QCOMPARE(writer.size(), size_t(20));
+    QVERIFY(stream.str().empty());
+
+    writer.flush();
+    QCOMPARE(writer.size(), size_t(0));
+    QCOMPARE(stream.str(), std::string("@<TRIPOS>ATOM\nC  CCl"));
+}
+
+void TextWriterTest::writeInteger()
+{
+    const long long integers[] = {
+        0, 1, -1, 9, 10, 99, 999, 1000, -1000, 123456789,
+        std::numeric_limits<long long>::max(),
+        std::numeric_limits<long long>::min()
+    };
+
+    for(size_t i = 0; i < sizeof(integers) / sizeof(*integers); i++){
+        for(int width = 0; width < 8; width++){
+            std::stringstream stream;
+            chemkit::TextWriter writer(stream);
+            writer.writeInteger(integers[i], width);
+            writer.flush();
+
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "%*lld", width, integers[i]);
+            QCOMPARE(stream.str(), std::string(buffer));
+        }
+    }
+}
+
+void TextWriterTest::writeFixed()
+{
+    // results must be identical to printf()
+    for(size_t i = 0; i < valueCount; i++){
+        for(int precision = 0; precision < 12; precision++){
+            QCOMPARE(written(false, 10, precision, values[i]),
+                     printed("%*.*f", 10, precision, values[i]));
+        }
+    }
+
+    unsigned int state = 42;
+    for(int i = 0; i < 100000; i++){
+        double value = randomValue(&state, i % 2 ? 100.0 : 1.0e6);
+        QCOMPARE(written(false, 10, 4, value), printed("%*.*f", 10, 4, value));
+        QCOMPARE(written(false, 0, 3, value), printed("%*.*f", 0, 3, value));
+    }
+
+    QCOMPARE(written(false, 10, 4, std::numeric_limits<double>::infinity()),
+             printed("%*.*f", 10, 4, std::numeric_limits<double>::infinity()));
+    QCOMPARE(written(false, 10, 4, std::numeric_limits<double>::quiet_NaN()),
+             printed("%*.*f", 10, 4, std::numeric_limits<double>::quiet_NaN()));
+}
+
+void TextWriterTest::writeGeneral()
+{
+    // results must be identical to printf()
+    for(size_t i = 0; i < valueCount; i++){
+        for(int precision = 0; precision < 12; precision++){
+            QCOMPARE(written(true, 10, precision, values[i]),
+                     printed("%*.*g", 10, precision, values[i]));
+        }
+    }
+
+    unsigned int state = 42;
+    for(int i = 0; i < 100000; i++){
+        double range = std::pow(10.0, i % 12 - 6);
+        double value = randomValue(&state, range);
+        QCOMPARE(written(true, 10, 4, value), printed("%*.*g", 10, 4, value));
+        QCOMPARE(written(true, 0, 6, value), printed("%*.*g", 0, 6, value));
+    }
+}
+
+void TextWriterTest::flush()
+{
+    std::stringstream stream;
+
+    {
+        chemkit::TextWriter writer(stream, 8);
+        QCOMPARE(writer.bufferSize(), size_t(8));
+
+        // text is flushed when the buffer is full
+        writer.write("SMALL\n");
+        QVERIFY(stream.str().empty());
+        writer.write("C.ar\n");
+        QCOMPARE(stream.str(), std::string("SMALL\n"));
+
+        // text larger than the buffer is written directly
+        writer.write(std::string(20, 'x'));
+        QCOMPARE(stream.str(), std::string("SMALL\nC.ar\n") + std::string(20, 'x'));
+
+        writer.writeFixed(1.5, 4, 10);
+        QCOMPARE(writer.size(), size_t(6));
+    }
+
+    // remaining text is flushed when the writer is destroyed
+    QCOMPARE(stream.str(), std::string("SMALL\nC.ar\n") + std::string(20, 'x') + "    1.5000");
+}
+
+QTEST_APPLESS_MAIN(TextWriterTest)
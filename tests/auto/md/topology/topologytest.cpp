@@ -46,4 +46,16 @@ void TopologyTest::size()
     QCOMPARE(topology.size(), size_t(100));
 }
 
+void TopologyTest::residueName()
+{
+    chemkit::Topology topology(3);
+    QCOMPARE(topology.residueName(0), std::string());
+
+    topology.setResidueName(0, "SOL");
+    topology.setResidueName(2, "ALA");
+    QCOMPARE(topology.residueName(0), std::string("SOL"));
+    QCOMPARE(topology.residueName(1), std::string());
+    QCOMPARE(topology.residueName(2), std::string("ALA"));
+}
+
 QTEST_APPLESS_MAIN(TopologyTest)
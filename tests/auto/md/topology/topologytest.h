@@ -46,6 +46,7 @@ class TopologyTest : public QObject
 
     private slots:
         void size();
+        void residueName();
 };
 
 #endif // TOPOLOGYTEST_H
@@ -0,0 +1,230 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+
+#include "trajectoryanalyzertest.h"
+
+#include <sstream>
+
+#include <chemkit/vector3.h>
+#include <chemkit/geometry.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryframe.h>
+#include <chemkit/trajectoryanalyzer.h>
+
+namespace {
+
+// Fills trajectory with frames of a four atom molecule that is
+// rotated and translated by a different amount in each frame.
+void createRigidTrajectory(chemkit::Trajectory *trajectory, size_t frameCount)
+{
+    trajectory->resize(4);
+
+    chemkit::Point3 positions[4] = {
+        chemkit::Point3(0, 0, 0),
+        chemkit::Point3(1.5, 0, 0),
+        chemkit::Point3(1.5, 1.5, 0),
+        chemkit::Point3(1.5, 1.5, 1.5)
+    };
+
+    for(size_t i = 0; i < frameCount; i++){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+        frame->setTime(i * 2.0);
+
+        chemkit::Vector3 axis(1, 2, 3);
+        chemkit::Vector3 displacement(i, -2.0 * i, 0.5 * i);
+
+        for(size_t j = 0; j < 4; j++){
+            chemkit::Point3 position = chemkit::geometry::rotate(positions[j], axis.normalized(), 10.0 * i);
+            frame->setPosition(j, position + displacement);
+        }
+    }
+}
+
+} // end anonymous namespace
+
+void TrajectoryAnalyzerTest::rigidMotion()
+{
+    chemkit::Trajectory trajectory;
+    createRigidTrajectory(&trajectory, 10);
+
+    chemkit::TrajectoryAnalyzer analyzer;
+    analyzer.analyze(&trajectory);
+    QCOMPARE(analyzer.frameCount(), size_t(10));
+
+    std::vector<chemkit::Real> times = analyzer.times();
+    QCOMPARE(times.size(), size_t(10));
+    QCOMPARE(times[5], chemkit::Real(10.0));
+
+    // rigid motions are removed by the superposition
+    std::vector<chemkit::Real> rmsd = analyzer.rmsd();
+    QCOMPARE(rmsd.size(), size_t(10));
+    for(size_t i = 0; i < rmsd.size(); i++){
+        QVERIFY(rmsd[i] < 1e-6);
+    }
+
+    std::vector<chemkit::Real> radiusOfGyration = analyzer.radiusOfGyration();
+    QCOMPARE(radiusOfGyration.size(), size_t(10));
+    for(size_t i = 1; i < radiusOfGyration.size(); i++){
+        QVERIFY(qAbs(radiusOfGyration[i] - radiusOfGyration[0]) < 1e-6);
+    }
+
+    std::vector<chemkit::Real> rmsf = analyzer.rmsf();
+    QCOMPARE(rmsf.size(), size_t(4));
+    for(size_t i = 0; i < rmsf.size(); i++){
+        QVERIFY(rmsf[i] < 1e-6);
+    }
+}
+
+void TrajectoryAnalyzerTest::rmsf()
+{
+    chemkit::Trajectory trajectory(3);
+
+    // the third atom moves back and forth along the y axis
+    for(size_t i = 0; i < 4; i++){
+        chemkit::TrajectoryFrame *frame = trajectory.addFrame();
+        frame->setPosition(0, chemkit::Point3(0, 0, 0));
+        frame->setPosition(1, chemkit::Point3(4, 0, 0));
+        frame->setPosition(2, chemkit::Point3(2, i % 2 ? 4 : 2, 0));
+    }
+
+    chemkit::TrajectoryAnalyzer analyzer;
+    std::vector<size_t> selection;
+    selection.push_back(0);
+    selection.push_back(1);
+    analyzer.setSelection(selection);
+    analyzer.analyze(&trajectory);
+
+    std::vector<chemkit::Real> rmsf = analyzer.rmsf();
+    QCOMPARE(rmsf.size(), size_t(2));
+    QVERIFY(rmsf[0] < 1e-6);
+    QVERIFY(rmsf[1] < 1e-6);
+
+    std::vector<chemkit::Real> radiusOfGyration = analyzer.radiusOfGyration();
+    QVERIFY(qAbs(radiusOfGyration[0] - 2.0) < 1e-6);
+
+    // fit on all atoms
+    analyzer.setSelection(std::vector<size_t>());
+    analyzer.clear();
+    analyzer.analyze(&trajectory);
+
+    rmsf = analyzer.rmsf();
+    QCOMPARE(rmsf.size(), size_t(3));
+    QVERIFY(qAbs(rmsf[2] - 2.0 / 3.0) < 1e-6);
+    QVERIFY(rmsf[0] < rmsf[2]);
+}
+
+void TrajectoryAnalyzerTest::measurements()
+{
+    chemkit::Trajectory trajectory;
+    createRigidTrajectory(&trajectory, 3);
+
+    chemkit::TrajectoryAnalyzer analyzer;
+    analyzer.addDistance(0, 1);
+    analyzer.addAngle(0, 1, 2);
+    analyzer.addTorsionAngle(0, 1, 2, 3);
+    QCOMPARE(analyzer.measurementCount(), size_t(3));
+    QCOMPARE(analyzer.measurementName(0), std::string("distance(0,1)"));
+    QCOMPARE(analyzer.measurementName(1), std::string("angle(0,1,2)"));
+    QCOMPARE(analyzer.measurementName(2), std::string("torsion(0,1,2,3)"));
+
+    analyzer.analyze(&trajectory);
+
+    std::vector<chemkit::Real> distances = analyzer.measurement(0);
+    QCOMPARE(distances.size(), size_t(3));
+    QCOMPARE(qRound(distances[2] * 10), 15);
+
+    std::vector<chemkit::Real> angles = analyzer.measurement(1);
+    QCOMPARE(qRound(angles[1]), 90);
+
+    std::vector<chemkit::Real> torsions = analyzer.measurement(2);
+    QCOMPARE(qRound(qAbs(torsions[0])), 90);
+
+    std::stringstream output;
+    QVERIFY(analyzer.write(output));
+
+    std::string header;
+    std::getline(output, header);
+    QCOMPARE(header, std::string("#frame\ttime\trmsd\trgyr\tdistance(0,1)\tangle(0,1,2)\ttorsion(0,1,2,3)"));
+}
+
+void TrajectoryAnalyzerTest::threadCount()
+{
+    chemkit::Trajectory trajectory;
+    createRigidTrajectory(&trajectory, 50);
+
+    // displace one atom in every third frame
+    for(size_t i = 0; i < trajectory.frameCount(); i += 3){
+        chemkit::TrajectoryFrame *frame = trajectory.frame(i);
+        frame->setPosition(3, frame->position(3) + chemkit::Vector3(0.3, 0, 0));
+    }
+
+    chemkit::TrajectoryAnalyzer serial;
+    serial.setThreadCount(1);
+    QCOMPARE(serial.threadCount(), size_t(1));
+    serial.analyze(&trajectory);
+
+    chemkit::TrajectoryAnalyzer parallel;
+    parallel.setThreadCount(4);
+    parallel.analyze(&trajectory);
+
+    QVERIFY(serial.rmsd() == parallel.rmsd());
+    QVERIFY(serial.radiusOfGyration() == parallel.radiusOfGyration());
+    QVERIFY(serial.rmsf() == parallel.rmsf());
+}
+
+void TrajectoryAnalyzerTest::blocks()
+{
+    chemkit::Trajectory trajectory;
+    createRigidTrajectory(&trajectory, 12);
+
+    chemkit::TrajectoryAnalyzer whole;
+    whole.analyze(&trajectory);
+
+    // analyze the same frames in blocks of five
+    chemkit::TrajectoryAnalyzer streamed;
+    std::vector<chemkit::TrajectoryFrame *> frames = trajectory.frames();
+    for(size_t i = 0; i < frames.size(); i += 5){
+        std::vector<chemkit::TrajectoryFrame *> block(frames.begin() + i,
+                                                      frames.begin() + std::min(i + 5, frames.size()));
+        streamed.analyze(block);
+    }
+
+    QCOMPARE(streamed.frameCount(), size_t(12));
+    QVERIFY(streamed.times() == whole.times());
+    QVERIFY(streamed.rmsd() == whole.rmsd());
+}
+
+QTEST_APPLESS_MAIN(TrajectoryAnalyzerTest)
@@ -46,6 +46,13 @@
 #include <chemkit/moleculardescriptor.h>
 
 #ifdef CHEMKIT_WITH_MD_IO
+#include <sstream>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <chemkit/unitcell.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
 #include <chemkit/trajectoryfileformat.h>
 #endif
 
@@ -204,4 +211,107 @@ void AmberTest::water()
     delete forceField;
 }
 
+void AmberTest::mdcrd()
+{
+#ifdef CHEMKIT_WITH_MD_IO
+    // create a trajectory with a periodic box in its second frame
+    boost::shared_ptr<chemkit::Topology> topology(new chemkit::Topology(5));
+    boost::shared_ptr<chemkit::Trajectory> trajectory(new chemkit::Trajectory(5));
+
+    for(int i = 0; i < 3; i++){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+
+        for(int j = 0; j < 5; j++){
+            frame->setPosition(j, chemkit::Point3(j + 0.125 * i, -10.5 * j, 1000.25 - i));
+        }
+    }
+
+    trajectory->frame(1)->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(30, 0, 0),
+                                                            chemkit::Vector3(0, 40, 0),
+                                                            chemkit::Vector3(0, 0, 50)));
+
+    chemkit::TrajectoryFile output;
+    output.setTrajectory(trajectory);
+
+    std::stringstream buffer;
+    bool ok = output.write(buffer, "mdcrd");
+    QVERIFY(ok);
+
+    std::string text = buffer.str();
+    std::string firstFrameLine = text.substr(text.find('\n') + 1, 81);
+    QCOMPARE(firstFrameLine, std::string("   0.000  -0.0001000.250   1.000 -10.5001000.250   2.000 -21.0001000.250   3.000\n"));
+
+    // read the whole trajectory
+    chemkit::TrajectoryFile input;
+    input.setTopology(topology);
+    ok = input.read(buffer, "mdcrd");
+    if(!ok)
+        qDebug() << input.errorString().c_str();
+    QVERIFY(ok);
+    QCOMPARE(input.trajectory()->frameCount(), size_t(3));
+    QCOMPARE(input.trajectory()->size(), size_t(5));
+    QVERIFY(input.trajectory()->frame(0)->unitCell() == 0);
+    QVERIFY(input.trajectory()->frame(1)->unitCell() != 0);
+    QCOMPARE(input.trajectory()->frame(1)->unitCell()->y().y(), chemkit::Real(40));
+    QVERIFY(input.trajectory()->frame(2)->unitCell() == 0);
+    QCOMPARE(input.trajectory()->frame(2)->position(4), chemkit::Point3(4.25, -42, 998.25));
+
+    // stream the frames one at a time
+    std::stringstream streamBuffer(text);
+    chemkit::TrajectoryFile streamFile;
+    streamFile.setFormat("mdcrd");
+    streamFile.setTopology(topology);
+    QVERIFY(streamFile.open(streamBuffer));
+
+    chemkit::Trajectory streamed;
+    chemkit::TrajectoryFrame *frame = streamed.addFrame();
+    size_t frameCount = 0;
+    while(streamFile.readFrame(frame)){
+        QCOMPARE(frame->position(3), input.trajectory()->frame(frameCount)->position(3));
+        QCOMPARE(frame->unitCell() != 0, frameCount == 1);
+        frameCount++;
+    }
+    QCOMPARE(frameCount, size_t(3));
+    QCOMPARE(streamed.size(), size_t(5));
+
+    // read from a memory mapped file
+    std::string fileName = (boost::filesystem::temp_directory_path() /
+                            boost::filesystem::unique_path()).string();
+    std::ofstream tempFile(fileName.c_str());
+    tempFile << text;
+    tempFile.close();
+
+    {
+        boost::iostreams::mapped_file_source mappedFile(fileName);
+        chemkit::TrajectoryFile mappedInput;
+        mappedInput.setTopology(topology);
+        ok = mappedInput.read(mappedFile, "mdcrd");
+        QVERIFY(ok);
+        QCOMPARE(mappedInput.trajectory()->frameCount(), size_t(3));
+        QVERIFY(mappedInput.trajectory()->frame(1)->unitCell() != 0);
+        QCOMPARE(mappedInput.trajectory()->frame(2)->position(4), chemkit::Point3(4.25, -42, 998.25));
+    }
+
+    boost::filesystem::remove(fileName);
+
+    // writing frames one at a time gives the same output
+    std::stringstream streamOutput;
+    chemkit::TrajectoryFile streamWriteFile;
+    streamWriteFile.setFormat("mdcrd");
+    QVERIFY(streamWriteFile.create(streamOutput));
+    for(size_t i = 0; i < trajectory->frameCount(); i++){
+        QVERIFY(streamWriteFile.writeFrame(trajectory->frame(i)));
+    }
+    QVERIFY(streamWriteFile.close());
+    QVERIFY(streamOutput.str() == text);
+
+    // a topology is required
+    chemkit::TrajectoryFile noTopology;
+    std::stringstream noTopologyBuffer(text);
+    QVERIFY(!noTopology.read(noTopologyBuffer, "mdcrd"));
+#else
+    QSKIP("chemkit-md-io is not enabled", SkipAll);
+#endif
+}
+
 QTEST_APPLESS_MAIN(AmberTest)
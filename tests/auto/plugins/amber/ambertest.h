@@ -47,6 +47,7 @@ class AmberTest : public QObject
         void adenosine();
         void serine();
         void water();
+        void mdcrd();
 };
 
 #endif // AMBERTEST_H
@@ -35,6 +35,8 @@
 
 #include "cmltest.h"
 
+#include <sstream>
+
 #include <boost/range/algorithm.hpp>
 
 #include <chemkit/molecule.h>
@@ -137,4 +139,49 @@ void CmlTest::ethanol()
     QCOMPARE(qRound(molecule->data("boiling point").toReal()), 78);
 }
 
+void CmlTest::stream()
+{
+    std::stringstream buffer;
+    buffer << "<?xml version=\"1.0\"?>\n"
+           << "<cml>\n"
+           << "<molecule id=\"m1\">\n"
+           << "  <name>water</name>\n"
+           << "  <atomArray>\n"
+           << "    <atom id=\"a1\" elementType=\"O\"/>\n"
+           << "    <atom id=\"a2\" elementType=\"H\"/>\n"
+           << "    <atom id=\"a3\" elementType=\"H\"/>\n"
+           << "  </atomArray>\n"
+           << "  <bondArray>\n"
+           << "    <bond atomRefs2=\"a1 a2\" order=\"1\"/>\n"
+           << "    <bond atomRefs2=\"a1 a3\" order=\"1\"/>\n"
+           << "  </bondArray>\n"
+           << "</molecule>\n"
+           << "<molecule><name>empty</name></molecule>\n"
+           << "<molecule id=\"m3\">\n"
+           << "  <atomArray><atom id=\"a1\" elementType=\"C\"/></atomArray>\n"
+           << "</molecule>\n"
+           << "</cml>\n";
+
+    chemkit::MoleculeFile file;
+    file.setFormat("cml");
+    QVERIFY(file.open(buffer));
+
+    boost::shared_ptr<chemkit::Molecule> molecule = file.readMolecule();
+    QVERIFY(molecule != 0);
+    QCOMPARE(molecule->name(), std::string("water"));
+    QCOMPARE(molecule->formula(), std::string("H2O"));
+    QCOMPARE(molecule->bondCount(), size_t(2));
+
+    molecule = file.readMolecule();
+    QVERIFY(molecule != 0);
+    QCOMPARE(molecule->name(), std::string("empty"));
+    QCOMPARE(molecule->atomCount(), size_t(0));
+
+    molecule = file.readMolecule();
+    QVERIFY(molecule != 0);
+    QCOMPARE(molecule->formula(), std::string("C"));
+
+    QVERIFY(file.readMolecule() == 0);
+}
+
 QTEST_APPLESS_MAIN(CmlTest)
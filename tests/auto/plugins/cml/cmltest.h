@@ -48,6 +48,7 @@ class CmlTest : public QObject
         void read();
         void glucose();
         void ethanol();
+        void stream();
 };
 
 #endif // CMLTEST_H
@@ -0,0 +1,299 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "cmoltest.h"
+
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+
+#include <boost/range/algorithm.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <chemkit/atom.h>
+#include <chemkit/bond.h>
+#include <chemkit/molecule.h>
+#include <chemkit/moleculefile.h>
+#include <chemkit/coordinateset.h>
+#include <chemkit/moleculefileformat.h>
+#include <chemkit/diagramcoordinates.h>
+#include <chemkit/cartesiancoordinates.h>
+
+const std::string dataPath = "../../../data/";
+
+namespace {
+
+// returns true if the molecules have identical atoms, bonds,
+// coordinates and data
+bool isSameMolecule(const chemkit::Molecule *a, const chemkit::Molecule *b)
+{
+    if(a->name() != b->name() ||
+       a->atomCount() != b->atomCount() ||
+       a->bondCount() != b->bondCount() ||
+       a->coordinateSetCount() != b->coordinateSetCount() ||
+       a->dataNames() != b->dataNames()){
+        return false;
+    }
+
+    for(size_t i = 0; i < a->atomCount(); i++){
+        const chemkit::Atom *atomA = a->atom(i);
+        const chemkit::Atom *atomB = b->atom(i);
+
+        if(atomA->atomicNumber() != atomB->atomicNumber() ||
+           atomA->massNumber() != atomB->massNumber() ||
+           atomA->partialCharge() != atomB->partialCharge() ||
+           atomA->type() != atomB->type() ||
+           atomA->chirality() != atomB->chirality() ||
+           atomA->position() != atomB->position()){
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < a->bondCount(); i++){
+        const chemkit::Bond *bondA = a->bond(i);
+        const chemkit::Bond *bondB = b->bond(i);
+
+        if(bondA->atom1()->index() != bondB->atom1()->index() ||
+           bondA->atom2()->index() != bondB->atom2()->index() ||
+           bondA->order() != bondB->order() ||
+           bondA->stereochemistry() != bondB->stereochemistry()){
+            return false;
+        }
+    }
+
+    foreach(const std::string &name, a->dataNames()){
+        chemkit::Variant valueA = a->data(name);
+        chemkit::Variant valueB = b->data(name);
+
+        if(valueA.type() != valueB.type()){
+            return false;
+        }
+        else if(valueA.type() == chemkit::Variant::String ? valueA.toString() != valueB.toString()
+                                                           : valueA.toDouble() != valueB.toDouble()){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// writes file in the cmol format and reads it back
+bool roundTrip(const chemkit::MoleculeFile &file, chemkit::MoleculeFile &output)
+{
+    std::stringstream buffer;
+    chemkit::MoleculeFile input;
+    input.setFormat("cmol");
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file.molecules()){
+        input.addMolecule(molecule);
+    }
+
+    if(!input.write(buffer)){
+        return false;
+    }
+
+    return output.read(buffer, "cmol");
+}
+
+} // end anonymous namespace
+
+void CmolTest::initTestCase()
+{
+    // verify that the cmol plugin registered itself correctly
+    QVERIFY(boost::count(chemkit::MoleculeFileFormat::formats(), "cmol") == 1);
+}
+
+void CmolTest::roundTrip_benzenes()
+{
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    chemkit::MoleculeFile output;
+    bool ok = roundTrip(file, output);
+    if(!ok)
+        qDebug() << output.errorString().c_str();
+    QVERIFY(ok);
+
+    QCOMPARE(output.moleculeCount(), file.moleculeCount());
+    for(size_t i = 0; i < file.moleculeCount(); i++){
+        QVERIFY(isSameMolecule(output.molecule(i).get(), file.molecule(i).get()));
+        QCOMPARE(output.molecule(i)->formula(), file.molecule(i)->formula());
+    }
+
+    QCOMPARE(output.molecule(0)->data("PUBCHEM_COMPOUND_CID").toString(), std::string("2750"));
+}
+
+void CmolTest::roundTrip_hypervalent()
+{
+    chemkit::MoleculeFile file(dataPath + "MMFF94_hypervalent.mol2");
+    QVERIFY(file.read());
+
+    chemkit::MoleculeFile output;
+    QVERIFY(roundTrip(file, output));
+
+    QCOMPARE(output.moleculeCount(), file.moleculeCount());
+    for(size_t i = 0; i < file.moleculeCount(); i++){
+        QVERIFY(isSameMolecule(output.molecule(i).get(), file.molecule(i).get()));
+    }
+}
+
+void CmolTest::roundTrip_properties()
+{
+    boost::shared_ptr<chemkit::Molecule> molecule(new chemkit::Molecule);
+    molecule->setName("bromochlorofluoromethane");
+
+    chemkit::Atom *C1 = molecule->addAtom("C");
+    chemkit::Atom *Br2 = molecule->addAtom("Br");
+    chemkit::Atom *Cl3 = molecule->addAtom("Cl");
+    chemkit::Atom *F4 = molecule->addAtom("F");
+    chemkit::Atom *H5 = molecule->addAtom("H");
+    molecule->addBond(C1, Br2);
+    molecule->addBond(C1, Cl3);
+    molecule->addBond(C1, F4);
+    molecule->addBond(C1, H5);
+
+    C1->setChirality(chemkit::Stereochemistry::R);
+    C1->setMassNumber(13);
+    C1->setType("C.3");
+    Br2->setPartialCharge(-0.125);
+    H5->setPosition(1.5, -2.25, 0.1);
+
+    chemkit::DiagramCoordinates *diagram = new chemkit::DiagramCoordinates(5);
+    diagram->setPosition(2, 1.0f, 2.5f);
+    molecule->addCoordinateSet(diagram);
+
+    molecule->setData("flag", true);
+    molecule->setData("count", 42);
+    molecule->setData("energy", -12.5);
+    molecule->setData("comment", std::string("made up"));
+
+    chemkit::MoleculeFile file;
+    file.addMolecule(molecule);
+
+    chemkit::MoleculeFile output;
+    QVERIFY(roundTrip(file, output));
+    QCOMPARE(output.moleculeCount(), size_t(1));
+
+    boost::shared_ptr<chemkit::Molecule> copy = output.molecule();
+    QVERIFY(isSameMolecule(copy.get(), molecule.get()));
+    QCOMPARE(copy->atom(0)->chirality(), chemkit::Stereochemistry::R);
+    QCOMPARE(copy->atom(0)->massNumber(), chemkit::Atom::MassNumberType(13));
+    QCOMPARE(copy->atom(0)->type(), std::string("C.3"));
+    QCOMPARE(copy->atom(1)->partialCharge(), chemkit::Real(-0.125));
+    QCOMPARE(copy->coordinateSetCount(), size_t(2));
+    QCOMPARE(copy->coordinateSet(1)->type(), chemkit::CoordinateSet::Diagram);
+    QCOMPARE(copy->coordinateSet(1)->diagramCoordinates()->position(2).y(), 2.5f);
+    QCOMPARE(copy->data("flag").toBool(), true);
+    QCOMPARE(copy->data("count").toInt(), 42);
+    QCOMPARE(copy->data("energy").toDouble(), -12.5);
+    QCOMPARE(copy->data("comment").toString(), std::string("made up"));
+}
+
+void CmolTest::stream()
+{
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    // write one molecule at a time
+    std::stringstream buffer;
+    chemkit::MoleculeFile output;
+    output.setFormat("cmol");
+    QVERIFY(output.create(buffer));
+    foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file.molecules()){
+        QVERIFY(output.writeMolecule(molecule));
+    }
+    QVERIFY(output.close());
+
+    // read one molecule at a time
+    chemkit::MoleculeFile input;
+    input.setFormat("cmol");
+    QVERIFY(input.open(buffer));
+
+    size_t count = 0;
+    while(boost::shared_ptr<chemkit::Molecule> molecule = input.readMolecule()){
+        QVERIFY(count < file.moleculeCount());
+        QVERIFY(isSameMolecule(molecule.get(), file.molecule(count).get()));
+        count++;
+    }
+    QCOMPARE(count, file.moleculeCount());
+    QVERIFY(input.errorString().empty());
+}
+
+void CmolTest::mapped()
+{
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    std::string fileName = "cmoltest_benzenes.cmol";
+    QVERIFY(file.write(fileName, "cmol"));
+
+    boost::shared_ptr<chemkit::MoleculeFile> mappedFile(new chemkit::MoleculeFile);
+    {
+        boost::iostreams::mapped_file_source input(fileName);
+        bool ok = mappedFile->read(input, "cmol");
+        if(!ok)
+            qDebug() << mappedFile->errorString().c_str();
+        QVERIFY(ok);
+    }
+    std::remove(fileName.c_str());
+
+    QCOMPARE(mappedFile->moleculeCount(), file.moleculeCount());
+    for(size_t i = 0; i < file.moleculeCount(); i++){
+        QVERIFY(isSameMolecule(mappedFile->molecule(i).get(), file.molecule(i).get()));
+    }
+}
+
+void CmolTest::invalid()
+{
+    chemkit::MoleculeFile file(dataPath + "guanine.mol");
+    QVERIFY(file.read());
+
+    chemkit::MoleculeFile output;
+    output.addMolecule(file.molecule());
+
+    std::stringstream buffer;
+    QVERIFY(output.write(buffer, "cmol"));
+    std::string data = buffer.str();
+
+    // truncated record
+    std::stringstream truncated(data.substr(0, data.size() - 10));
+    chemkit::MoleculeFile input;
+    QVERIFY(!input.read(truncated, "cmol"));
+
+    // wrong magic number
+    std::stringstream invalid("CMOX" + data.substr(4));
+    QVERIFY(!input.read(invalid, "cmol"));
+}
+
+QTEST_APPLESS_MAIN(CmolTest)
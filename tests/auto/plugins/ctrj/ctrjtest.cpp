@@ -0,0 +1,298 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "ctrjtest.h"
+
+#include <cmath>
+#include <sstream>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/range/algorithm.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <chemkit/vector3.h>
+#include <chemkit/unitcell.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+#include <chemkit/trajectoryfileformat.h>
+
+namespace {
+
+// creates a trajectory with 250 frames of 20 atoms, which spans three
+// chunks, with a unit cell in every tenth frame
+boost::shared_ptr<chemkit::Trajectory> createTrajectory()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory(new chemkit::Trajectory(20));
+
+    for(int i = 0; i < 250; i++){
+        chemkit::TrajectoryFrame *frame = trajectory->addFrame();
+        frame->setTime(0.5 * i);
+
+        for(int j = 0; j < 20; j++){
+            frame->setPosition(j, chemkit::Point3(j + std::sin(0.1 * i + j),
+                                                  -2.0 * j + std::cos(0.37 * i),
+                                                  1.0 / (j + 1) + 0.001 * i));
+        }
+
+        if(i % 10 == 0){
+            frame->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(30, 0, 0),
+                                                     chemkit::Vector3(0, 40 + i, 0),
+                                                     chemkit::Vector3(0, 0, 50)));
+        }
+    }
+
+    return trajectory;
+}
+
+std::string writeTrajectory(const boost::shared_ptr<chemkit::Trajectory> &trajectory,
+                            double precision = 0)
+{
+    chemkit::TrajectoryFile file;
+    file.setTrajectory(trajectory);
+    if(precision > 0){
+        file.setData("precision", precision);
+    }
+
+    std::stringstream buffer;
+    bool ok = file.write(buffer, "ctrj");
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+
+    return ok ? buffer.str() : std::string();
+}
+
+} // end anonymous namespace
+
+void CtrjTest::initTestCase()
+{
+    // verify that the ctrj plugin registered itself correctly
+    QVERIFY(boost::count(chemkit::TrajectoryFileFormat::formats(), "ctrj") == 1);
+}
+
+void CtrjTest::exact()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string data = writeTrajectory(trajectory);
+    QVERIFY(!data.empty());
+
+    chemkit::TrajectoryFile file;
+    std::stringstream buffer(data);
+    bool ok = file.read(buffer, "ctrj");
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+
+    // the coordinates are stored exactly by default
+    boost::shared_ptr<chemkit::Trajectory> result = file.trajectory();
+    QCOMPARE(result->size(), size_t(20));
+    QCOMPARE(result->frameCount(), size_t(250));
+
+    for(size_t i = 0; i < 250; i++){
+        const chemkit::TrajectoryFrame *expected = trajectory->frame(i);
+        const chemkit::TrajectoryFrame *frame = result->frame(i);
+
+        QCOMPARE(frame->time(), expected->time());
+        QCOMPARE(frame->unitCell() != 0, i % 10 == 0);
+
+        for(size_t j = 0; j < 20; j++){
+            QVERIFY(frame->position(j) == expected->position(j));
+        }
+    }
+
+    QCOMPARE(result->frame(120)->unitCell()->y().y(), chemkit::Real(160));
+}
+
+void CtrjTest::quantized()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string exactData = writeTrajectory(trajectory);
+    std::string data = writeTrajectory(trajectory, 0.001);
+    QVERIFY(!data.empty());
+    QVERIFY(data.size() < exactData.size());
+
+    chemkit::TrajectoryFile file;
+    std::stringstream buffer(data);
+    QVERIFY(file.read(buffer, "ctrj"));
+
+    boost::shared_ptr<chemkit::Trajectory> result = file.trajectory();
+    QCOMPARE(result->frameCount(), size_t(250));
+
+    for(size_t i = 0; i < 250; i++){
+        for(size_t j = 0; j < 20; j++){
+            chemkit::Vector3 error = result->frame(i)->position(j) - trajectory->frame(i)->position(j);
+            QVERIFY(error.cwiseAbs().maxCoeff() <= 0.0005 + 1e-9);
+        }
+    }
+}
+
+void CtrjTest::stream()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::stringstream buffer(writeTrajectory(trajectory));
+
+    chemkit::TrajectoryFile file;
+    file.setFormat("ctrj");
+    QVERIFY(file.open(buffer));
+
+    chemkit::Trajectory streamed;
+    chemkit::TrajectoryFrame *frame = streamed.addFrame();
+
+    size_t frameCount = 0;
+    while(file.readFrame(frame)){
+        QCOMPARE(frame->time(), trajectory->frame(frameCount)->time());
+        QVERIFY(frame->position(7) == trajectory->frame(frameCount)->position(7));
+        QCOMPARE(frame->unitCell() != 0, frameCount % 10 == 0);
+        frameCount++;
+    }
+
+    QVERIFY(file.errorString().empty());
+    QCOMPARE(frameCount, size_t(250));
+    QCOMPARE(streamed.size(), size_t(20));
+}
+
+void CtrjTest::streamWrite()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+
+    // writing frames one at a time gives the same file as write()
+    std::stringstream buffer;
+    chemkit::TrajectoryFile file;
+    file.setFormat("ctrj");
+    QVERIFY(file.create(buffer));
+    QVERIFY(file.isCreated());
+
+    for(size_t i = 0; i < trajectory->frameCount(); i++){
+        QVERIFY(file.writeFrame(trajectory->frame(i)));
+    }
+
+    QVERIFY(file.close());
+    QVERIFY(!file.isCreated());
+    QVERIFY(buffer.str() == writeTrajectory(trajectory));
+}
+
+void CtrjTest::mapped()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string data = writeTrajectory(trajectory);
+
+    std::string fileName = (boost::filesystem::temp_directory_path() /
+                            boost::filesystem::unique_path()).string();
+    std::ofstream tempFile(fileName.c_str(), std::ios_base::binary);
+    tempFile << data;
+    tempFile.close();
+
+    {
+        boost::iostreams::mapped_file_source mappedFile(fileName);
+        chemkit::TrajectoryFile file;
+        QVERIFY(file.read(mappedFile, "ctrj"));
+        QCOMPARE(file.trajectory()->frameCount(), size_t(250));
+        QVERIFY(file.trajectory()->frame(249)->position(19) == trajectory->frame(249)->position(19));
+    }
+
+    boost::filesystem::remove(fileName);
+}
+
+void CtrjTest::missingIndex()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string data = writeTrajectory(trajectory);
+
+    // without the trailer the chunks are found by scanning the file
+    std::stringstream buffer(data.substr(0, data.size() - 12));
+    chemkit::TrajectoryFile file;
+    QVERIFY(file.read(buffer, "ctrj"));
+    QCOMPARE(file.trajectory()->frameCount(), size_t(250));
+    QVERIFY(file.trajectory()->frame(200)->position(3) == trajectory->frame(200)->position(3));
+
+    // a corrupted chunk is an error
+    data[100] = ~data[100];
+    std::stringstream corruptBuffer(data);
+    chemkit::TrajectoryFile corruptFile;
+    QVERIFY(!corruptFile.read(corruptBuffer, "ctrj"));
+}
+
+void CtrjTest::invalidChunkSize()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string data = writeTrajectory(trajectory);
+
+    // set the compressed size of the first chunk far beyond the end of the file
+    for(int i = 0; i < 8; i++){
+        data[32 + 8 + i] = static_cast<char>(0x7f);
+    }
+
+    std::stringstream buffer(data);
+    chemkit::TrajectoryFile file;
+    file.setFormat("ctrj");
+    QVERIFY(file.open(buffer));
+
+    chemkit::Trajectory streamed;
+    chemkit::TrajectoryFrame *frame = streamed.addFrame();
+    QVERIFY(!file.readFrame(frame));
+    QVERIFY(!file.errorString().empty());
+}
+
+void CtrjTest::invalidFrameCount()
+{
+    boost::shared_ptr<chemkit::Trajectory> trajectory = createTrajectory();
+    std::string data = writeTrajectory(trajectory);
+
+    // a chunk claiming far more frames than its data can hold is
+    // rejected before any frames are created
+    std::string frameData = data;
+    for(int i = 0; i < 4; i++){
+        frameData[32 + 4 + i] = static_cast<char>(0xff);
+    }
+
+    std::stringstream frameBuffer(frameData);
+    chemkit::TrajectoryFile frameFile;
+    QVERIFY(!frameFile.read(frameBuffer, "ctrj"));
+    QVERIFY(!frameFile.errorString().empty());
+
+    // as is a header with an impossible number of atoms
+    std::string atomData = data;
+    for(int i = 0; i < 8; i++){
+        atomData[8 + i] = static_cast<char>(i == 7 ? 0x0f : 0xff);
+    }
+
+    std::stringstream atomBuffer(atomData);
+    chemkit::TrajectoryFile atomFile;
+    QVERIFY(!atomFile.read(atomBuffer, "ctrj"));
+    QVERIFY(!atomFile.errorString().empty());
+}
+
+QTEST_APPLESS_MAIN(CtrjTest)
@@ -0,0 +1,201 @@
+/******************************************************************************
+**
+** Copyright (C) 2009-2012 Kyle Lutz <kyle.r.lutz@gmail.com>
+** All rights reserved.
+**
+** This file is a part of the chemkit project. For more information
+** see <http://www.chemkit.org>.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+**   * Redistributions of source code must retain the above copyright
+**     notice, this list of conditions and the following disclaimer.
+**   * Redistributions in binary form must reproduce the above copyright
+**     notice, this list of conditions and the following disclaimer in the
+**     documentation and/or other materials provided with the distribution.
+**   * Neither the name of the chemkit project nor the names of its
+**     contributors may be used to endorse or promote products derived
+**     from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+******************************************************************************/
+
+#include "ecfptest.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/range/algorithm.hpp>
+
+#include <chemkit/molecule.h>
+#include <chemkit/fingerprint.h>
+
+void EcfpTest::initTestCase()
+{
+    // verify that the ecfp plugin registered itself correctly
+    QVERIFY(boost::count(chemkit::Fingerprint::fingerprints(), "ecfp") == 1);
+}
+
+void EcfpTest::name()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+    QVERIFY(fingerprint != 0);
+    QCOMPARE(fingerprint->name(), std::string("ecfp"));
+}
+
+void EcfpTest::size()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+    QCOMPARE(fingerprint->size(), size_t(2048));
+    QCOMPARE(fingerprint->option("radius").toInt(), 2);
+
+    fingerprint->setOption("size", 1024);
+    QCOMPARE(fingerprint->size(), size_t(1024));
+
+    chemkit::Molecule molecule("CCO", "smiles");
+    QCOMPARE(fingerprint->value(&molecule).size(), size_t(1024));
+    QCOMPARE(fingerprint->counts(&molecule).size(), size_t(1024));
+
+    // sizes which are not positive give empty fingerprints
+    fingerprint->setOption("size", 0);
+    QCOMPARE(fingerprint->size(), size_t(0));
+    QCOMPARE(fingerprint->value(&molecule).size(), size_t(0));
+    QCOMPARE(fingerprint->counts(&molecule).size(), size_t(0));
+
+    fingerprint->setOption("size", -1);
+    QCOMPARE(fingerprint->size(), size_t(0));
+    QCOMPARE(fingerprint->value(&molecule).size(), size_t(0));
+}
+
+void EcfpTest::value()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+
+    // empty molecule
+    chemkit::Molecule empty;
+    QCOMPARE(fingerprint->value(&empty).count(), size_t(0));
+
+    // methane has one heavy atom and the same environment at each radius
+    chemkit::Molecule methane("C", "smiles");
+    QCOMPARE(fingerprint->value(&methane).count(), size_t(3));
+
+    // both carbons in ethane are equivalent
+    chemkit::Molecule ethane("CC", "smiles");
+    QCOMPARE(fingerprint->value(&ethane).count(), size_t(3));
+
+    // ethanol and propanol share some environments but not all
+    chemkit::Molecule ethanol("CCO", "smiles");
+    chemkit::Molecule propanol("CCCO", "smiles");
+    chemkit::Bitset ethanolFingerprint = fingerprint->value(&ethanol);
+    chemkit::Bitset propanolFingerprint = fingerprint->value(&propanol);
+    QVERIFY(ethanolFingerprint.intersects(propanolFingerprint));
+    QVERIFY(ethanolFingerprint != propanolFingerprint);
+
+    // aromatic and kekule forms of benzene are the same
+    chemkit::Molecule benzene("c1ccccc1", "smiles");
+    chemkit::Molecule kekuleBenzene("C1=CC=CC=C1", "smiles");
+    QVERIFY(fingerprint->value(&benzene) == fingerprint->value(&kekuleBenzene));
+    QCOMPARE(fingerprint->value(&benzene).count(), size_t(3));
+
+    // charged atoms have different environments
+    chemkit::Molecule acetate("CC(=O)[O-]", "smiles");
+    chemkit::Molecule aceticAcid("CC(=O)O", "smiles");
+    QVERIFY(fingerprint->value(&acetate) != fingerprint->value(&aceticAcid));
+}
+
+void EcfpTest::counts()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+
+    // six equivalent atoms at each of three radii
+    chemkit::Molecule benzene("c1ccccc1", "smiles");
+    std::vector<size_t> counts = fingerprint->counts(&benzene);
+    QCOMPARE(boost::count(counts, 6), std::ptrdiff_t(3));
+    QCOMPARE(boost::count(counts, 0), std::ptrdiff_t(2045));
+
+    // the set bits match the nonzero counts
+    chemkit::Molecule molecule("CN1C=NC2=C1C(=O)N(C(=O)N2C)C", "smiles");
+    chemkit::Bitset value = fingerprint->value(&molecule);
+    counts = fingerprint->counts(&molecule);
+
+    size_t total = 0;
+    for(size_t i = 0; i < counts.size(); i++){
+        QCOMPARE(value[i], counts[i] != 0);
+        total += counts[i];
+    }
+
+    // one identifier for each heavy atom at each radius
+    QCOMPARE(total, size_t(14 * 3));
+}
+
+void EcfpTest::features()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+
+    chemkit::Molecule molecule("CC(=O)Oc1ccccc1C(=O)O", "smiles");
+    chemkit::Fingerprint::FeatureCounts features = fingerprint->features(&molecule);
+    QVERIFY(!features.empty());
+
+    // features are sorted and unique
+    size_t total = 0;
+    for(size_t i = 0; i < features.size(); i++){
+        if(i > 0){
+            QVERIFY(features[i - 1].first < features[i].first);
+        }
+
+        total += features[i].second;
+    }
+    QCOMPARE(total, size_t(13 * 3));
+
+    // folding the features gives the fingerprint value
+    chemkit::Bitset folded(fingerprint->size());
+    for(size_t i = 0; i < features.size(); i++){
+        folded.set(features[i].first % folded.size());
+    }
+    QVERIFY(folded == fingerprint->value(&molecule));
+}
+
+void EcfpTest::radius()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+    chemkit::Molecule molecule("CCCCCCCCO", "smiles");
+
+    fingerprint->setOption("radius", 0);
+    chemkit::Bitset ecfp0 = fingerprint->value(&molecule);
+    QCOMPARE(fingerprint->features(&molecule).size(), size_t(3));
+
+    fingerprint->setOption("radius", 3);
+    chemkit::Bitset ecfp6 = fingerprint->value(&molecule);
+    QVERIFY(ecfp6.count() > ecfp0.count());
+    QVERIFY(ecfp0.is_subset_of(ecfp6));
+
+    // a negative radius has no environments
+    fingerprint->setOption("radius", -2);
+    QCOMPARE(fingerprint->value(&molecule).size(), size_t(2048));
+    QCOMPARE(fingerprint->value(&molecule).count(), size_t(0));
+    QCOMPARE(fingerprint->features(&molecule).size(), size_t(0));
+}
+
+void EcfpTest::atomOrder()
+{
+    boost::scoped_ptr<chemkit::Fingerprint> fingerprint(chemkit::Fingerprint::create("ecfp"));
+
+    // the fingerprint does not depend on the order of the atoms
+    chemkit::Molecule a("OC(=O)c1ccccc1OC(C)=O", "smiles");
+    chemkit::Molecule b("CC(=O)Oc1ccccc1C(=O)O", "smiles");
+    QVERIFY(fingerprint->value(&a) == fingerprint->value(&b));
+    QVERIFY(fingerprint->features(&a) == fingerprint->features(&b));
+}
+
+QTEST_APPLESS_MAIN(EcfpTest)
@@ -35,11 +35,18 @@
 
 #include "gromacstest.h"
 
+#include <sstream>
+
 #include <boost/range/algorithm.hpp>
 
+#include <chemkit/unitcell.h>
 #include <chemkit/topology.h>
+#include <chemkit/trajectory.h>
 #include <chemkit/topologyfile.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
 #include <chemkit/topologyfileformat.h>
+#include <chemkit/trajectoryfileformat.h>
 
 const std::string dataPath = "../../../data/";
 
@@ -48,6 +55,7 @@ void GromacsTest::initTestCase()
     // verify that the gromacs plugin registered itself correctly
     QVERIFY(boost::count(chemkit::TopologyFileFormat::formats(), "gro") == 1);
     QVERIFY(boost::count(chemkit::TopologyFileFormat::formats(), "top") == 1);
+    QVERIFY(boost::count(chemkit::TrajectoryFileFormat::formats(), "gro") == 1);
 }
 
 void GromacsTest::spc216()
@@ -66,6 +74,7 @@ void GromacsTest::spc216()
         QCOMPARE(topology->type(i+0), std::string("OW"));
         QCOMPARE(topology->type(i+1), std::string("HW1"));
         QCOMPARE(topology->type(i+2), std::string("HW2"));
+        QCOMPARE(topology->residueName(i), std::string("SOL"));
     }
 }
 
@@ -82,4 +91,77 @@ void GromacsTest::ubiquitin()
     QCOMPARE(topology->size(), size_t(1231));
 }
 
+void GromacsTest::trajectory()
+{
+    chemkit::TrajectoryFile file(dataPath + "spc216.gro");
+    bool ok = file.read();
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory = file.trajectory();
+    QVERIFY(trajectory != 0);
+    QCOMPARE(trajectory->size(), size_t(648));
+    QCOMPARE(trajectory->frameCount(), size_t(1));
+
+    // coordinates and box are converted from nanometers to angstroms
+    const chemkit::TrajectoryFrame *frame = trajectory->frame(0);
+    QVERIFY(frame->position(0).isApprox(chemkit::Point3(2.30, 6.28, 1.13)));
+    QVERIFY(frame->position(647).isApprox(chemkit::Point3(8.43, -1.45, 3.99)));
+    QVERIFY(frame->unitCell() != 0);
+    QCOMPARE(frame->unitCell()->x().x(), chemkit::Real(18.6206));
+
+    // the atom names are used as the topology
+    boost::shared_ptr<chemkit::Topology> topology = file.topology();
+    QVERIFY(topology != 0);
+    QCOMPARE(topology->size(), size_t(648));
+    QCOMPARE(topology->type(0), std::string("OW"));
+    QCOMPARE(topology->type(647), std::string("HW2"));
+    QCOMPARE(topology->residueName(647), std::string("SOL"));
+}
+
+void GromacsTest::streamTrajectory()
+{
+    std::stringstream input(
+        "water t=   0.50000 step= 10\n"
+        "    3\n"
+        "    1SOL     OW    1   0.12345   1.00000  -0.50000\n"
+        "    1SOL    HW1    2   0.20000   1.10000-100.50000\n"
+        "    1SOL    HW2    3   0.30000   1.20000  -0.70000\n"
+        "   2.00000   2.00000   2.00000\n"
+        "water t=   1.00000 step= 20\n"
+        "    3\n"
+        "    1SOL     OW    1   0.200   1.000  -0.500\n"
+        "    1SOL    HW1    2   0.300   1.100  -0.600\n"
+        "    1SOL    HW2    3   0.400   1.200  -0.700\n"
+        "   2.00000   3.00000   4.00000   0.00000   0.00000   1.00000   0.00000   0.50000   0.25000\n");
+
+    chemkit::TrajectoryFile file;
+    file.setFormat("gro");
+    QVERIFY(file.open(input));
+
+    chemkit::Trajectory trajectory;
+    chemkit::TrajectoryFrame *frame = trajectory.addFrame();
+
+    // first frame with five decimal places and a rectangular box
+    QVERIFY(file.readFrame(frame));
+    QCOMPARE(trajectory.size(), size_t(3));
+    QCOMPARE(frame->time(), chemkit::Real(0.5));
+    QVERIFY(frame->position(0).isApprox(chemkit::Point3(1.2345, 10, -5)));
+    QVERIFY(frame->position(1).isApprox(chemkit::Point3(2, 11, -1005)));
+    QVERIFY(frame->unitCell()->y().isApprox(chemkit::Vector3(0, 20, 0)));
+
+    // second frame with three decimal places and a triclinic box
+    QVERIFY(file.readFrame(frame));
+    QCOMPARE(frame->time(), chemkit::Real(1.0));
+    QVERIFY(frame->position(2).isApprox(chemkit::Point3(4, 12, -7)));
+    QVERIFY(frame->unitCell()->x().isApprox(chemkit::Vector3(20, 0, 0)));
+    QVERIFY(frame->unitCell()->y().isApprox(chemkit::Vector3(10, 30, 0)));
+    QVERIFY(frame->unitCell()->z().isApprox(chemkit::Vector3(5, 2.5, 40)));
+
+    QVERIFY(!file.readFrame(frame));
+    QVERIFY(file.errorString().empty());
+    QCOMPARE(file.topology()->type(1), std::string("HW1"));
+}
+
 QTEST_APPLESS_MAIN(GromacsTest)
@@ -46,6 +46,8 @@ class GromacsTest : public QObject
         void initTestCase();
         void spc216();
         void ubiquitin();
+        void trajectory();
+        void streamTrajectory();
 };
 
 #endif // GROMACSTEST_H
@@ -35,10 +35,20 @@
 
 #include "mdltest.h"
 
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+
 #include <boost/range/algorithm.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include <chemkit/molecule.h>
+#include <chemkit/blockcompressedfile.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/moleculefileindex.h>
 #include <chemkit/moleculefileformat.h>
 
 const std::string dataPath = "../../../data/";
@@ -143,4 +153,314 @@ void MdlTest::read_serine()
     QCOMPARE(molecule->formula(), std::string("C3H7NO3"));
 }
 
+void MdlTest::stream_benzenes()
+{
+    chemkit::MoleculeFile file;
+    bool ok = file.open(dataPath + "pubchem_416_benzenes.sdf");
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+    QVERIFY(file.isOpen());
+
+    // write each molecule as it is read
+    std::stringstream buffer;
+    chemkit::MoleculeFile output;
+    output.setFormat("sdf");
+    QVERIFY(output.create(buffer));
+
+    size_t count = 0;
+    while(boost::shared_ptr<chemkit::Molecule> molecule = file.readMolecule()){
+        QCOMPARE(molecule->name(), molecule->data("PUBCHEM_COMPOUND_CID").toString());
+        QVERIFY(output.writeMolecule(molecule));
+        count++;
+    }
+    QCOMPARE(count, size_t(416));
+    QVERIFY(file.isEmpty());
+    QVERIFY(output.close());
+
+    // read the written molecules back
+    chemkit::MoleculeFile input;
+    QVERIFY(input.read(buffer, "sdf"));
+    QCOMPARE(input.moleculeCount(), size_t(416));
+    QCOMPARE(input.molecule(0)->name(), std::string("2750"));
+}
+
+void MdlTest::stream_invalid()
+{
+    // an empty file is an error
+    std::stringstream emptyBuffer;
+    chemkit::MoleculeFile emptyFile;
+    emptyFile.setFormat("sdf");
+    QVERIFY(emptyFile.open(emptyBuffer));
+    QVERIFY(emptyFile.readMolecule() == 0);
+    QVERIFY(!emptyFile.errorString().empty());
+
+    // a record without its "M  END" line is an error
+    std::stringstream truncatedBuffer("water\n\n\n"
+                                      "  3  2  0  0  0  0  0  0  0  0999 V2000\n"
+                                      "    0.0000    0.0000    0.0000 O   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                                      "    0.9572    0.0000    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                                      "   -0.2400    0.9266    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                                      "  1  2  1  0  0  0  0\n"
+                                      "  1  3  1  0  0  0  0\n");
+    chemkit::MoleculeFile truncatedFile;
+    truncatedFile.setFormat("sdf");
+    QVERIFY(truncatedFile.open(truncatedBuffer));
+    QVERIFY(truncatedFile.readMolecule() == 0);
+    QVERIFY(!truncatedFile.errorString().empty());
+
+    // the end of a valid file is not an error
+    chemkit::MoleculeFile file;
+    QVERIFY(file.open(dataPath + "pubchem_416_benzenes.sdf"));
+    size_t count = 0;
+    while(file.readMolecule()){
+        count++;
+    }
+    QCOMPARE(count, size_t(416));
+    QVERIFY(file.errorString().empty());
+}
+
+void MdlTest::read_benzenesGzipMembers()
+{
+    std::vector<std::string> compressionFormats = chemkit::MoleculeFile::compressionFormats();
+    if(std::find(compressionFormats.begin(),
+                 compressionFormats.end(),
+                 "gz") == compressionFormats.end()){
+        QSKIP("Gzip compression not supported", SkipSingle);
+    }
+
+    std::ifstream input((dataPath + "pubchem_416_benzenes.sdf").c_str(), std::ios_base::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)),
+                         std::istreambuf_iterator<char>());
+
+    // compress each half of the file as a separate gzip member
+    QTemporaryFile tempFile("XXXXXX.sdf.gz");
+    QVERIFY(tempFile.open());
+    for(int i = 0; i < 2; i++){
+        std::stringstream member;
+        boost::iostreams::filtering_ostream stream;
+        stream.push(boost::iostreams::gzip_compressor());
+        stream.push(member);
+        stream << (i == 0 ? contents.substr(0, contents.size() / 2) : contents.substr(contents.size() / 2));
+        stream.reset();
+
+        tempFile.write(member.str().data(), member.str().size());
+    }
+    tempFile.close();
+
+    chemkit::MoleculeFile file(tempFile.fileName().toStdString());
+    bool ok = file.read();
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+    QCOMPARE(file.compressionFormat(), std::string("gz"));
+    QCOMPARE(file.moleculeCount(), size_t(416));
+    QCOMPARE(file.molecule(415)->name(), file.molecule(415)->data("PUBCHEM_COMPOUND_CID").toString());
+
+    // read the file one molecule at a time
+    chemkit::MoleculeFile stream(tempFile.fileName().toStdString());
+    QVERIFY(stream.open());
+
+    size_t count = 0;
+    while(boost::shared_ptr<chemkit::Molecule> molecule = stream.readMolecule()){
+        QCOMPARE(molecule->name(), file.molecule(count)->name());
+        count++;
+    }
+    QCOMPARE(count, size_t(416));
+}
+
+void MdlTest::readMappedFile_benzenes()
+{
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    boost::iostreams::mapped_file_source input(dataPath + "pubchem_416_benzenes.sdf");
+    chemkit::MoleculeFile mappedFile;
+    bool ok = mappedFile.read(input, "sdf");
+    if(!ok)
+        qDebug() << mappedFile.errorString().c_str();
+    QVERIFY(ok);
+
+    // check that the molecules are read in the same order
+    QCOMPARE(mappedFile.moleculeCount(), file.moleculeCount());
+    for(size_t i = 0; i < file.moleculeCount(); i++){
+        boost::shared_ptr<chemkit::Molecule> molecule = mappedFile.molecule(i);
+        QCOMPARE(molecule->name(), file.molecule(i)->name());
+        QCOMPARE(molecule->formula(), file.molecule(i)->formula());
+        QCOMPARE(molecule->bondCount(), file.molecule(i)->bondCount());
+        QCOMPARE(molecule->data("PUBCHEM_COMPOUND_CID").toString(), molecule->name());
+    }
+}
+
+void MdlTest::readMappedFile_invalid()
+{
+    const std::string water = "water\n\n\n"
+                              "  3  2  0  0  0  0  0  0  0  0999 V2000\n"
+                              "    0.0000    0.0000    0.0000 O   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                              "    0.9572    0.0000    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                              "   -0.2400    0.9266    0.0000 H   0  0  0  0  0  0  0  0  0  0  0  0\n"
+                              "  1  2  1  0  0  0  0\n"
+                              "  1  3  1  0  0  0  0\n";
+    const std::string fileName = "mdltest-invalid.sdf";
+
+    // a record without its "M  END" line is reported by each reader
+    // and the molecules before it are kept
+    {
+        std::ofstream output(fileName.c_str());
+        output << water << "M  END\n$$$$\n" << water << "$$$$\n" << water << "M  END\n$$$$\n";
+    }
+
+    chemkit::MoleculeFile file(fileName);
+    QVERIFY(!file.read());
+    QCOMPARE(file.moleculeCount(), size_t(1));
+    QCOMPARE(file.errorString(), std::string("Missing \"M  END\" line."));
+
+    {
+        boost::iostreams::mapped_file_source input(fileName);
+        chemkit::MoleculeFile mappedFile;
+        QVERIFY(!mappedFile.read(input, "sdf"));
+        QCOMPARE(mappedFile.moleculeCount(), size_t(1));
+        QCOMPARE(mappedFile.errorString(), file.errorString());
+    }
+
+    chemkit::MoleculeFile streamFile;
+    QVERIFY(streamFile.open(fileName));
+    QVERIFY(streamFile.readMolecule() != 0);
+    QVERIFY(streamFile.readMolecule() == 0);
+    QCOMPARE(streamFile.errorString(), file.errorString());
+    streamFile.close();
+
+    // delimiters preceded by white space separate records in both the
+    // mapped and streaming readers
+    {
+        std::ofstream output(fileName.c_str());
+        output << water << "M  END\n  $$$$\n" << water << "M  END\n  $$$$\n";
+    }
+
+    chemkit::MoleculeFile indentedFile(fileName);
+    QVERIFY(indentedFile.read());
+    QCOMPARE(indentedFile.moleculeCount(), size_t(2));
+
+    {
+        boost::iostreams::mapped_file_source input(fileName);
+        chemkit::MoleculeFile mappedFile;
+        QVERIFY(mappedFile.read(input, "sdf"));
+        QCOMPARE(mappedFile.moleculeCount(), size_t(2));
+    }
+
+    std::remove(fileName.c_str());
+}
+
+void MdlTest::fetchMolecule_benzenes()
+{
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    // copy the file so that the index is not written to the data directory
+    std::ifstream input((dataPath + "pubchem_416_benzenes.sdf").c_str(), std::ios_base::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)),
+                         std::istreambuf_iterator<char>());
+
+    QTemporaryFile tempFile("XXXXXX.sdf");
+    QVERIFY(tempFile.open());
+    tempFile.write(contents.data(), contents.size());
+    tempFile.close();
+
+    std::string fileName = tempFile.fileName().toStdString();
+    std::string indexFileName = chemkit::MoleculeFile::indexFileName(fileName);
+
+    // the first fetch creates and stores the index
+    chemkit::MoleculeFile indexedFile(fileName);
+    boost::shared_ptr<chemkit::Molecule> molecule = indexedFile.fetchMolecule(415);
+    if(!molecule)
+        qDebug() << indexedFile.errorString().c_str();
+    QVERIFY(molecule);
+    QCOMPARE(molecule->name(), file.molecule(415)->name());
+    QCOMPARE(molecule->formula(), file.molecule(415)->formula());
+    QVERIFY(std::ifstream(indexFileName.c_str()).is_open());
+    QCOMPARE(indexedFile.index()->size(), size_t(416));
+
+    // a new file object uses the stored index
+    chemkit::MoleculeFile storedFile(fileName);
+    QVERIFY(storedFile.openIndex());
+    QCOMPARE(storedFile.index()->size(), size_t(416));
+    for(size_t i = 0; i < file.moleculeCount(); i += 37){
+        molecule = storedFile.fetchMolecule(i);
+        QVERIFY(molecule);
+        QCOMPARE(molecule->name(), file.molecule(i)->name());
+        QCOMPARE(molecule->formula(), file.molecule(i)->formula());
+        QCOMPARE(molecule->bondCount(), file.molecule(i)->bondCount());
+        QCOMPARE(molecule->data("PUBCHEM_COMPOUND_CID").toString(), molecule->name());
+    }
+
+    // fetch by name
+    molecule = storedFile.fetchMolecule(file.molecule(200)->name());
+    QVERIFY(molecule);
+    QCOMPARE(molecule->formula(), file.molecule(200)->formula());
+    QVERIFY(!storedFile.fetchMolecule("not a molecule"));
+    QVERIFY(!storedFile.fetchMolecule(416));
+
+    std::remove(indexFileName.c_str());
+}
+
+void MdlTest::fetchMolecule_benzenesBlockCompressed()
+{
+    std::vector<std::string> compressionFormats = chemkit::MoleculeFile::compressionFormats();
+    if(std::find(compressionFormats.begin(),
+                 compressionFormats.end(),
+                 "bgz") == compressionFormats.end()){
+        QSKIP("Block compression not supported", SkipSingle);
+    }
+
+    chemkit::MoleculeFile file(dataPath + "pubchem_416_benzenes.sdf");
+    QVERIFY(file.read());
+
+    // write the molecules three times so that the file is indexed in
+    // several pieces
+    chemkit::MoleculeFile output;
+    for(int i = 0; i < 3; i++){
+        foreach(const boost::shared_ptr<chemkit::Molecule> &molecule, file.molecules()){
+            output.addMolecule(molecule);
+        }
+    }
+
+    QTemporaryFile tempFile("XXXXXX.sdf.bgz");
+    QVERIFY(tempFile.open());
+    tempFile.close();
+
+    std::string fileName = tempFile.fileName().toStdString();
+    std::string indexFileName = chemkit::MoleculeFile::indexFileName(fileName);
+    QVERIFY(output.write(fileName));
+    QVERIFY(chemkit::BlockCompressedFile::isBlockCompressed(fileName));
+
+    // the whole file can be read like a gzip file
+    chemkit::MoleculeFile compressedFile(fileName);
+    QVERIFY(compressedFile.read());
+    QCOMPARE(compressedFile.compressionFormat(), std::string("bgz"));
+    QCOMPARE(compressedFile.moleculeCount(), size_t(1248));
+
+    // fetch molecules from the compressed file
+    chemkit::MoleculeFile indexedFile(fileName);
+    QVERIFY(indexedFile.openIndex());
+    QCOMPARE(indexedFile.index()->size(), size_t(1248));
+    for(size_t i = 0; i < 1248; i += 29){
+        boost::shared_ptr<chemkit::Molecule> molecule = indexedFile.fetchMolecule(i);
+        QVERIFY(molecule);
+        QCOMPARE(molecule->name(), file.molecule(i % 416)->name());
+        QCOMPARE(molecule->formula(), file.molecule(i % 416)->formula());
+    }
+
+    boost::shared_ptr<chemkit::Molecule> molecule = indexedFile.fetchMolecule(1247);
+    QVERIFY(molecule);
+    QCOMPARE(molecule->name(), file.molecule(415)->name());
+
+    // a new file object uses the stored index
+    chemkit::MoleculeFile storedFile(fileName);
+    molecule = storedFile.fetchMolecule(file.molecule(300)->name());
+    QVERIFY(molecule);
+    QCOMPARE(molecule->formula(), file.molecule(300)->formula());
+
+    std::remove(indexFileName.c_str());
+}
+
 QTEST_APPLESS_MAIN(MdlTest)
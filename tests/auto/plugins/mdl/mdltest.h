@@ -48,6 +48,13 @@ class MdlTest : public QObject
         void read_guanine();
         void read_benzenes();
         void read_serine();
+        void stream_benzenes();
+        void stream_invalid();
+        void read_benzenesGzipMembers();
+        void readMappedFile_benzenes();
+        void readMappedFile_invalid();
+        void fetchMolecule_benzenes();
+        void fetchMolecule_benzenesBlockCompressed();
 };
 
 #endif // MDLTEST_H
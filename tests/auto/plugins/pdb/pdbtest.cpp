@@ -36,8 +36,11 @@
 #include "pdbtest.h"
 
 #include <boost/range/algorithm.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
+#include <chemkit/atom.h>
 #include <chemkit/polymer.h>
+#include <chemkit/coordinateset.h>
 #include <chemkit/polymerfile.h>
 #include <chemkit/polymerchain.h>
 #include <chemkit/polymerfileformat.h>
@@ -262,4 +265,52 @@ void PdbTest::read_fmc()
     QCOMPARE(molecule->atomCount(), size_t(2596));
 }
 
+void PdbTest::readMappedFile_1D3Z()
+{
+    // read the nmr ensemble from a stream
+    chemkit::PolymerFile streamFile(dataPath + "1D3Z.pdb");
+    bool ok = streamFile.read();
+    if(!ok)
+        qDebug() << "Failed to read file: " << streamFile.errorString().c_str();
+    QVERIFY(ok);
+
+    // read the nmr ensemble from a mapped file
+    chemkit::PolymerFile mappedFile;
+    {
+        boost::iostreams::mapped_file_source input(dataPath + "1D3Z.pdb");
+        ok = mappedFile.read(input, "pdb");
+        if(!ok)
+            qDebug() << "Failed to read file: " << mappedFile.errorString().c_str();
+        QVERIFY(ok);
+    }
+
+    QCOMPARE(mappedFile.polymerCount(), size_t(1));
+    const boost::shared_ptr<chemkit::Polymer> &expected = streamFile.polymer();
+    const boost::shared_ptr<chemkit::Polymer> &polymer = mappedFile.polymer();
+    QCOMPARE(polymer->name(), expected->name());
+    QCOMPARE(polymer->size(), expected->size());
+    QCOMPARE(polymer->chain(0)->sequenceString(), expected->chain(0)->sequenceString());
+
+    // the atom positions are from the first model and the other
+    // nine models are only decoded when first accessed
+    QCOMPARE(polymer->coordinateSetCount(), size_t(10));
+    QCOMPARE(expected->coordinateSetCount(), size_t(10));
+    QVERIFY(!polymer->coordinateSet(5)->isLoaded());
+
+    for(size_t i = 0; i < polymer->size(); i++){
+        QVERIFY(polymer->atom(i)->position() == expected->atom(i)->position());
+    }
+
+    for(size_t i = 0; i < polymer->coordinateSetCount(); i++){
+        boost::shared_ptr<chemkit::CoordinateSet> coordinates = polymer->coordinateSet(i);
+        boost::shared_ptr<chemkit::CoordinateSet> expectedCoordinates = expected->coordinateSet(i);
+        QCOMPARE(coordinates->size(), expectedCoordinates->size());
+        QVERIFY(coordinates->isLoaded());
+
+        for(size_t j = 0; j < coordinates->size(); j++){
+            QVERIFY(coordinates->position(j) == expectedCoordinates->position(j));
+        }
+    }
+}
+
 QTEST_APPLESS_MAIN(PdbTest)
@@ -51,6 +51,7 @@ class PdbTest : public QObject
         void read_2DHB_pdbml();
         void read_alphabet();
         void read_fmc();
+        void readMappedFile_1D3Z();
 };
 
 #endif // PDBTEST_H
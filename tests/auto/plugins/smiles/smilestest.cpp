@@ -35,6 +35,8 @@
 
 #include "smilestest.h"
 
+#include <fstream>
+
 #include <boost/make_shared.hpp>
 #include <boost/range/algorithm.hpp>
 
@@ -1348,4 +1350,54 @@ void SmilesTest::cox2()
     QCOMPARE(file.molecule(127)->formula(), std::string("C21H19NO5S"));
 }
 
+void SmilesTest::readBatch()
+{
+    std::vector<std::string> formulas;
+
+    std::ifstream file((dataPath + "cox2.smi").c_str());
+    std::string line;
+    while(std::getline(file, line)){
+        formulas.push_back(line.substr(0, line.find(' ')));
+    }
+    QCOMPARE(formulas.size(), size_t(128));
+
+    // add invalid formulas
+    formulas.insert(formulas.begin() + 100, "C*C");
+    formulas.insert(formulas.begin() + 5, "CCX");
+
+    chemkit::LineFormat *format = chemkit::LineFormat::create("smiles");
+    QVERIFY(format);
+
+    format->setOption("add-implicit-hydrogens", false);
+    std::vector<chemkit::Molecule *> molecules = format->readBatch(formulas);
+    QCOMPARE(molecules.size(), size_t(130));
+    QVERIFY(molecules[5] == 0);
+    QVERIFY(molecules[101] == 0);
+
+    // the error is reported for the first invalid formula
+    std::string errorString = format->errorString();
+    delete format->read("CCX");
+    QCOMPARE(errorString, format->errorString());
+
+    // molecules are in the same order as the formulas and are read
+    // with the same options
+    for(size_t i = 0; i < molecules.size(); i++){
+        if(i == 5 || i == 101){
+            continue;
+        }
+
+        chemkit::Molecule *molecule = format->read(formulas[i]);
+        QVERIFY(molecules[i] != 0);
+        QCOMPARE(molecules[i]->formula(), molecule->formula());
+        QCOMPARE(molecules[i]->atomCount(), molecule->atomCount());
+
+        delete molecule;
+        delete molecules[i];
+    }
+
+    QVERIFY(format->readBatch(std::vector<std::string>()).empty());
+
+    delete format;
+}
+
 QTEST_APPLESS_MAIN(SmilesTest)
@@ -171,6 +171,7 @@ class SmilesTest : public QObject
         // file tests
         void herg();
         void cox2();
+        void readBatch();
 
     private:
         void COMPARE_SMILES(const chemkit::Molecule *molecule, const std::string &smiles);
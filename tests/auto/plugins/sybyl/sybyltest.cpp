@@ -35,11 +35,16 @@
 
 #include "sybyltest.h"
 
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
 #include <boost/range/algorithm.hpp>
 
 #include <chemkit/molecule.h>
 #include <chemkit/atomtyper.h>
 #include <chemkit/moleculefile.h>
+#include <chemkit/moleculefileindex.h>
 #include <chemkit/moleculefileformat.h>
 
 const std::string dataPath = "../../../data/";
@@ -79,4 +84,71 @@ void SybylTest::readMol2()
     QCOMPARE(molecule->formula().c_str(), formula.constData());
 }
 
+void SybylTest::streamMol2()
+{
+    chemkit::MoleculeFile file(dataPath + "MMFF94_hypervalent.mol2");
+    QVERIFY(file.read());
+
+    chemkit::MoleculeFile stream;
+    bool ok = stream.open(dataPath + "MMFF94_hypervalent.mol2");
+    if(!ok)
+        qDebug() << stream.errorString().c_str();
+    QVERIFY(ok);
+
+    size_t count = 0;
+    while(boost::shared_ptr<chemkit::Molecule> molecule = stream.readMolecule()){
+        QVERIFY(count < file.moleculeCount());
+        QCOMPARE(molecule->name(), file.molecule(count)->name());
+        QCOMPARE(molecule->formula(), file.molecule(count)->formula());
+        QCOMPARE(molecule->bondCount(), file.molecule(count)->bondCount());
+        count++;
+    }
+
+    QCOMPARE(count, file.moleculeCount());
+    stream.close();
+    QVERIFY(!stream.isOpen());
+}
+
+void SybylTest::fetchMol2()
+{
+    chemkit::MoleculeFile file(dataPath + "MMFF94_hypervalent.mol2");
+    QVERIFY(file.read());
+
+    // copy the file so that the index is not written to the data directory
+    std::ifstream input((dataPath + "MMFF94_hypervalent.mol2").c_str(), std::ios_base::binary);
+    std::string contents((std::istreambuf_iterator<char>(input)),
+                         std::istreambuf_iterator<char>());
+
+    QTemporaryFile tempFile("XXXXXX.mol2");
+    QVERIFY(tempFile.open());
+    tempFile.write(contents.data(), contents.size());
+    tempFile.close();
+
+    std::string fileName = tempFile.fileName().toStdString();
+
+    chemkit::MoleculeFile indexedFile(fileName);
+    bool ok = indexedFile.openIndex();
+    if(!ok)
+        qDebug() << indexedFile.errorString().c_str();
+    QVERIFY(ok);
+    QCOMPARE(indexedFile.index()->size(), file.moleculeCount());
+
+    // fetch each molecule in reverse order
+    for(size_t i = file.moleculeCount(); i > 0; i--){
+        boost::shared_ptr<chemkit::Molecule> molecule = indexedFile.fetchMolecule(i - 1);
+        QVERIFY(molecule);
+        QCOMPARE(molecule->name(), file.molecule(i - 1)->name());
+        QCOMPARE(molecule->formula(), file.molecule(i - 1)->formula());
+        QCOMPARE(molecule->bondCount(), file.molecule(i - 1)->bondCount());
+    }
+
+    // fetch by name
+    boost::shared_ptr<chemkit::Molecule> last = file.molecule(file.moleculeCount() - 1);
+    boost::shared_ptr<chemkit::Molecule> molecule = indexedFile.fetchMolecule(last->name());
+    QVERIFY(molecule);
+    QCOMPARE(molecule->formula(), last->formula());
+
+    std::remove(chemkit::MoleculeFile::indexFileName(fileName).c_str());
+}
+
 QTEST_APPLESS_MAIN(SybylTest)
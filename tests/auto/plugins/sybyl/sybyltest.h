@@ -46,6 +46,8 @@ class SybylTest : public QObject
         void initTestCase();
         void readMol2_data();
         void readMol2();
+        void streamMol2();
+        void fetchMol2();
 };
 
 #endif // SYBYLTEST_H
@@ -35,6 +35,9 @@
 
 #include "xtctest.h"
 
+#include <fstream>
+#include <sstream>
+
 #include <boost/range/algorithm.hpp>
 
 #include <chemkit/trajectory.h>
@@ -64,4 +67,80 @@ void XtcTest::spc216()
     QCOMPARE(trajectory->frameCount(), size_t(201));
 }
 
+void XtcTest::stream()
+{
+    chemkit::TrajectoryFile file(dataPath + "spc216.xtc");
+    bool ok = file.open();
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+    QVERIFY(file.isOpen());
+
+    chemkit::Trajectory trajectory;
+    chemkit::TrajectoryFrame *frame = trajectory.addFrame();
+
+    size_t frameCount = 0;
+    while(file.readFrame(frame)){
+        frameCount++;
+    }
+
+    QCOMPARE(frameCount, size_t(201));
+    QCOMPARE(trajectory.size(), size_t(648));
+    QCOMPARE(frame->size(), size_t(648));
+    QVERIFY(file.trajectory() == 0);
+
+    file.close();
+    QVERIFY(!file.isOpen());
+}
+
+void XtcTest::truncated()
+{
+    std::ifstream input((dataPath + "spc216.xtc").c_str(), std::ios::in | std::ios::binary);
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    // cut the data in the middle of the second frame
+    std::string data = buffer.str();
+    std::istringstream truncatedInput(data.substr(0, data.size() / 201 + 100));
+
+    chemkit::TrajectoryFile file;
+    file.setFormat("xtc");
+    QVERIFY(file.open(truncatedInput));
+
+    chemkit::Trajectory trajectory;
+    chemkit::TrajectoryFrame *frame = trajectory.addFrame();
+
+    QVERIFY(file.readFrame(frame));
+    QCOMPARE(frame->size(), size_t(648));
+    QVERIFY(!file.readFrame(frame));
+    QVERIFY(!file.errorString().empty());
+}
+
+void XtcTest::invalidAtomCount()
+{
+    std::ifstream input((dataPath + "spc216.xtc").c_str(), std::ios::in | std::ios::binary);
+    std::stringstream buffer;
+    buffer << input.rdbuf();
+
+    // set the atom count in the first frame header to 2^30
+    std::string data = buffer.str();
+    const size_t offsets[] = { 4, 13 * 4 };
+    for(size_t i = 0; i < 2; i++){
+        data[offsets[i] + 0] = 0x40;
+        data[offsets[i] + 1] = 0;
+        data[offsets[i] + 2] = 0;
+        data[offsets[i] + 3] = 0;
+    }
+
+    std::istringstream corruptInput(data);
+    chemkit::TrajectoryFile file;
+    file.setFormat("xtc");
+    QVERIFY(file.open(corruptInput));
+
+    chemkit::Trajectory trajectory;
+    chemkit::TrajectoryFrame *frame = trajectory.addFrame();
+    QVERIFY(!file.readFrame(frame));
+    QVERIFY(!file.errorString().empty());
+}
+
 QTEST_APPLESS_MAIN(XtcTest)
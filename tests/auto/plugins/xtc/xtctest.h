@@ -45,6 +45,9 @@ class XtcTest : public QObject
     private slots:
         void initTestCase();
         void spc216();
+        void stream();
+        void truncated();
+        void invalidAtomCount();
 };
 
 #endif // XTCTEST_H
@@ -35,12 +35,24 @@
 
 #include "xyztest.h"
 
+#include <sstream>
+
 #include <boost/range/algorithm.hpp>
 
+#include <chemkit/atom.h>
 #include <chemkit/molecule.h>
 #include <chemkit/moleculefile.h>
 #include <chemkit/moleculefileformat.h>
 
+#ifdef CHEMKIT_WITH_MD_IO
+#include <chemkit/unitcell.h>
+#include <chemkit/topology.h>
+#include <chemkit/trajectory.h>
+#include <chemkit/trajectoryfile.h>
+#include <chemkit/trajectoryframe.h>
+#include <chemkit/trajectoryfileformat.h>
+#endif
+
 const std::string dataPath = "../../../data/";
 
 void XyzTest::initTestCase()
@@ -147,4 +159,146 @@ void XyzTest::readWriteReadLoop()
     QCOMPARE(molecule->formula().c_str(), formula.constData());
 }
 
+void XyzTest::trajectory()
+{
+#ifdef CHEMKIT_WITH_MD_IO
+    QVERIFY(boost::count(chemkit::TrajectoryFileFormat::formats(), "xyz") == 1);
+
+    std::string text =
+        "2\n"
+        "frame 1 Time=2.5 Lattice=\"10 0 0 0 11 0 0 0 12\"\n"
+        "O    0.000   1.000   2.000\n"
+        "H    0.500   1.500  -2.500\n"
+        "\n"
+        "2\n"
+        "frame 2\n"
+        "O    0.100   1.100   2.100\n"
+        "H    0.600   1.600  -2.600\n";
+
+    // read the whole trajectory
+    std::stringstream buffer(text);
+    chemkit::TrajectoryFile file;
+    bool ok = file.read(buffer, "xyz");
+    if(!ok)
+        qDebug() << file.errorString().c_str();
+    QVERIFY(ok);
+
+    boost::shared_ptr<chemkit::Trajectory> trajectory = file.trajectory();
+    QCOMPARE(trajectory->size(), size_t(2));
+    QCOMPARE(trajectory->frameCount(), size_t(2));
+    QCOMPARE(trajectory->frame(0)->time(), chemkit::Real(2.5));
+    QVERIFY(trajectory->frame(0)->unitCell() != 0);
+    QCOMPARE(trajectory->frame(0)->unitCell()->z().z(), chemkit::Real(12));
+    QVERIFY(trajectory->frame(1)->unitCell() == 0);
+    QVERIFY(trajectory->frame(1)->position(1).isApprox(chemkit::Point3(0.6, 1.6, -2.6)));
+
+    // all frames share a single topology
+    QVERIFY(file.topology() != 0);
+    QCOMPARE(file.topology()->type(0), std::string("O"));
+    QCOMPARE(file.topology()->type(1), std::string("H"));
+
+    // stream the frames one at a time
+    std::stringstream streamBuffer(text);
+    chemkit::TrajectoryFile streamFile;
+    streamFile.setFormat("xyz");
+    QVERIFY(streamFile.open(streamBuffer));
+
+    chemkit::Trajectory streamed;
+    chemkit::TrajectoryFrame *frame = streamed.addFrame();
+    size_t frameCount = 0;
+    while(streamFile.readFrame(frame)){
+        QVERIFY(frame->position(0).isApprox(trajectory->frame(frameCount)->position(0)));
+        frameCount++;
+    }
+    QCOMPARE(frameCount, size_t(2));
+    QVERIFY(streamFile.errorString().empty());
+
+    // write and read back the trajectory
+    std::stringstream writeBuffer;
+    QVERIFY(file.write(writeBuffer, "xyz"));
+
+    chemkit::TrajectoryFile readBack;
+    QVERIFY(readBack.read(writeBuffer, "xyz"));
+    QCOMPARE(readBack.trajectory()->frameCount(), size_t(2));
+    QCOMPARE(readBack.trajectory()->frame(0)->time(), chemkit::Real(2.5));
+    QCOMPARE(readBack.trajectory()->frame(0)->unitCell()->y().y(), chemkit::Real(11));
+    QVERIFY(readBack.trajectory()->frame(1)->unitCell() == 0);
+    QVERIFY(readBack.trajectory()->frame(1)->position(1).isApprox(chemkit::Point3(0.6, 1.6, -2.6)));
+    QCOMPARE(readBack.topology()->type(0), std::string("O"));
+
+    // truncated frames are an error
+    std::stringstream truncatedBuffer(text.substr(0, text.size() - 20));
+    chemkit::TrajectoryFile truncatedFile;
+    QVERIFY(!truncatedFile.read(truncatedBuffer, "xyz"));
+
+    // times and unit cells are written with enough digits to be read
+    // back exactly
+    chemkit::TrajectoryFrame *preciseFrame = trajectory->frame(0);
+    preciseFrame->setTime(1234567.5);
+    preciseFrame->setUnitCell(new chemkit::UnitCell(chemkit::Vector3(10.123456789, 0.1, 0),
+                                                    chemkit::Vector3(0, 11.000000001, 0),
+                                                    chemkit::Vector3(0, 0, 1.0 / 3.0)));
+
+    std::stringstream preciseBuffer;
+    QVERIFY(file.write(preciseBuffer, "xyz"));
+
+    chemkit::TrajectoryFile preciseFile;
+    QVERIFY(preciseFile.read(preciseBuffer, "xyz"));
+    const chemkit::TrajectoryFrame *readFrame = preciseFile.trajectory()->frame(0);
+    QVERIFY(readFrame->time() == chemkit::Real(1234567.5));
+    QVERIFY(readFrame->unitCell()->x() == preciseFrame->unitCell()->x());
+    QVERIFY(readFrame->unitCell()->y() == preciseFrame->unitCell()->y());
+    QVERIFY(readFrame->unitCell()->z() == preciseFrame->unitCell()->z());
+
+    // negative and impossibly large atom counts are an error
+    std::stringstream negativeBuffer("-1\nframe\nO 0 0 0\n");
+    chemkit::TrajectoryFile negativeFile;
+    QVERIFY(!negativeFile.read(negativeBuffer, "xyz"));
+    QVERIFY(!negativeFile.errorString().empty());
+
+    std::stringstream largeBuffer("2000000000\nframe\nO 0 0 0\n");
+    chemkit::TrajectoryFile largeFile;
+    QVERIFY(!largeFile.read(largeBuffer, "xyz"));
+    QVERIFY(!largeFile.errorString().empty());
+#else
+    QSKIP("chemkit-md-io is not enabled", SkipAll);
+#endif
+}
+
+void XyzTest::stream()
+{
+    std::stringstream buffer;
+    buffer << "3\n"
+           << "water\n"
+           << "O  0.000  0.000  0.000\n"
+           << "H  0.757  0.586  0.000\n"
+           << "H -0.757  0.586  0.000\n"
+           << "\n"
+           << "1\n"
+           << "\n"
+           << "6  1.0  2.0  3.0\n";
+
+    chemkit::MoleculeFile file;
+    file.setFormat("xyz");
+    QVERIFY(file.open(buffer));
+
+    boost::shared_ptr<chemkit::Molecule> molecule = file.readMolecule();
+    QVERIFY(molecule != 0);
+    QCOMPARE(molecule->formula(), std::string("H2O"));
+
+    molecule = file.readMolecule();
+    QVERIFY(molecule != 0);
+    QCOMPARE(molecule->formula(), std::string("C"));
+    QCOMPARE(molecule->atom(0)->z(), chemkit::Real(3.0));
+
+    QVERIFY(file.readMolecule() == 0);
+
+    // both records are read by read()
+    buffer.clear();
+    buffer.seekg(0);
+    chemkit::MoleculeFile all;
+    QVERIFY(all.read(buffer, "xyz"));
+    QCOMPARE(all.moleculeCount(), size_t(2));
+}
+
 QTEST_APPLESS_MAIN(XyzTest)
@@ -49,6 +49,8 @@ class XyzTest : public QObject
         void readMappedFile();
         void readWriteReadLoop_data();
         void readWriteReadLoop();
+        void stream();
+        void trajectory();
 };
 
 #endif // XYZTEST_H